@@ -1817,12 +1817,31 @@ CREATE TABLE config_autoreg_tls (
 	PRIMARY KEY (autoreg_tlsid)
 );
 CREATE UNIQUE INDEX config_autoreg_tls_1 ON config_autoreg_tls (tls_psk_identity);
+CREATE TABLE changelog (
+	changelogid              bigint                                    NOT NULL	GENERATED ALWAYS AS IDENTITY (START WITH 1 INCREMENT BY 1),
+	object                   integer         WITH DEFAULT '0'          NOT NULL,
+	objectid                 bigint                                    NOT NULL,
+	clock                    integer         WITH DEFAULT '0'          NOT NULL,
+	PRIMARY KEY (changelogid)
+);
 CREATE TABLE dbversion (
 	mandatory                integer         WITH DEFAULT '0'          NOT NULL,
 	optional                 integer         WITH DEFAULT '0'          NOT NULL
 );
-INSERT INTO dbversion VALUES ('4040000','4040000');
+INSERT INTO dbversion VALUES ('4040002','4040002');
 ALTER TABLE hosts ADD CONSTRAINT c_hosts_1 FOREIGN KEY (proxy_hostid) REFERENCES hosts (hostid);
+CREATE TRIGGER items_insert AFTER INSERT ON items REFERENCING NEW AS n FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (1,n.itemid,(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT TIMESTAMP - CURRENT TIMEZONE));
+CREATE TRIGGER items_update AFTER UPDATE ON items REFERENCING NEW AS n FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (1,n.itemid,(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT TIMESTAMP - CURRENT TIMEZONE));
+CREATE TRIGGER items_delete AFTER DELETE ON items REFERENCING OLD AS o FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (1,o.itemid,(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT TIMESTAMP - CURRENT TIMEZONE));
+CREATE TRIGGER item_preproc_insert AFTER INSERT ON item_preproc REFERENCING NEW AS n FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (1,n.itemid,(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT TIMESTAMP - CURRENT TIMEZONE));
+CREATE TRIGGER item_preproc_update AFTER UPDATE ON item_preproc REFERENCING NEW AS n FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (1,n.itemid,(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT TIMESTAMP - CURRENT TIMEZONE));
+CREATE TRIGGER item_preproc_delete AFTER DELETE ON item_preproc REFERENCING OLD AS o FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (1,o.itemid,(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT TIMESTAMP - CURRENT TIMEZONE));
+CREATE TRIGGER triggers_insert AFTER INSERT ON triggers REFERENCING NEW AS n FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (2,n.triggerid,(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT TIMESTAMP - CURRENT TIMEZONE));
+CREATE TRIGGER triggers_update AFTER UPDATE OF description,expression,priority,type,status,recovery_mode,recovery_expression,correlation_mode,correlation_tag,opdata,flags ON triggers REFERENCING NEW AS n FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (2,n.triggerid,(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT TIMESTAMP - CURRENT TIMEZONE));
+CREATE TRIGGER triggers_delete AFTER DELETE ON triggers REFERENCING OLD AS o FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (2,o.triggerid,(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT TIMESTAMP - CURRENT TIMEZONE));
+CREATE TRIGGER functions_insert AFTER INSERT ON functions REFERENCING NEW AS n FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (2,n.triggerid,(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT TIMESTAMP - CURRENT TIMEZONE));
+CREATE TRIGGER functions_update AFTER UPDATE ON functions REFERENCING NEW AS n FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (2,n.triggerid,(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT TIMESTAMP - CURRENT TIMEZONE));
+CREATE TRIGGER functions_delete AFTER DELETE ON functions REFERENCING OLD AS o FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (2,o.triggerid,(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT TIMESTAMP - CURRENT TIMEZONE));
 ALTER TABLE hosts ADD CONSTRAINT c_hosts_2 FOREIGN KEY (maintenanceid) REFERENCES maintenances (maintenanceid);
 ALTER TABLE hosts ADD CONSTRAINT c_hosts_3 FOREIGN KEY (templateid) REFERENCES hosts (hostid) ON DELETE CASCADE;
 ALTER TABLE group_prototype ADD CONSTRAINT c_group_prototype_1 FOREIGN KEY (hostid) REFERENCES hosts (hostid) ON DELETE CASCADE;
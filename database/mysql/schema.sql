@@ -1817,12 +1817,31 @@ CREATE TABLE `config_autoreg_tls` (
 	PRIMARY KEY (autoreg_tlsid)
 ) ENGINE=InnoDB;
 CREATE UNIQUE INDEX `config_autoreg_tls_1` ON `config_autoreg_tls` (`tls_psk_identity`);
+CREATE TABLE `changelog` (
+	`changelogid`            bigint unsigned                           NOT NULL auto_increment,
+	`object`                 integer         DEFAULT '0'               NOT NULL,
+	`objectid`               bigint unsigned                           NOT NULL,
+	`clock`                  integer         DEFAULT '0'               NOT NULL,
+	PRIMARY KEY (changelogid)
+) ENGINE=InnoDB;
 CREATE TABLE `dbversion` (
 	`mandatory`              integer         DEFAULT '0'               NOT NULL,
 	`optional`               integer         DEFAULT '0'               NOT NULL
 ) ENGINE=InnoDB;
-INSERT INTO dbversion VALUES ('4040000','4040000');
+INSERT INTO dbversion VALUES ('4040002','4040002');
 ALTER TABLE `hosts` ADD CONSTRAINT `c_hosts_1` FOREIGN KEY (`proxy_hostid`) REFERENCES `hosts` (`hostid`);
+CREATE TRIGGER items_insert AFTER INSERT ON items FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (1,new.itemid,unix_timestamp());
+CREATE TRIGGER items_update AFTER UPDATE ON items FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (1,new.itemid,unix_timestamp());
+CREATE TRIGGER items_delete AFTER DELETE ON items FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (1,old.itemid,unix_timestamp());
+CREATE TRIGGER item_preproc_insert AFTER INSERT ON item_preproc FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (1,new.itemid,unix_timestamp());
+CREATE TRIGGER item_preproc_update AFTER UPDATE ON item_preproc FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (1,new.itemid,unix_timestamp());
+CREATE TRIGGER item_preproc_delete AFTER DELETE ON item_preproc FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (1,old.itemid,unix_timestamp());
+CREATE TRIGGER triggers_insert AFTER INSERT ON triggers FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (2,new.triggerid,unix_timestamp());
+CREATE TRIGGER triggers_update AFTER UPDATE ON triggers FOR EACH ROW INSERT INTO changelog (object,objectid,clock) SELECT 2,new.triggerid,unix_timestamp() FROM dual WHERE old.description<>new.description OR old.expression<>new.expression OR old.priority<>new.priority OR old.type<>new.type OR old.status<>new.status OR old.recovery_mode<>new.recovery_mode OR old.recovery_expression<>new.recovery_expression OR old.correlation_mode<>new.correlation_mode OR old.correlation_tag<>new.correlation_tag OR old.opdata<>new.opdata OR old.flags<>new.flags;
+CREATE TRIGGER triggers_delete AFTER DELETE ON triggers FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (2,old.triggerid,unix_timestamp());
+CREATE TRIGGER functions_insert AFTER INSERT ON functions FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (2,new.triggerid,unix_timestamp());
+CREATE TRIGGER functions_update AFTER UPDATE ON functions FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (2,new.triggerid,unix_timestamp());
+CREATE TRIGGER functions_delete AFTER DELETE ON functions FOR EACH ROW INSERT INTO changelog (object,objectid,clock) VALUES (2,old.triggerid,unix_timestamp());
 ALTER TABLE `hosts` ADD CONSTRAINT `c_hosts_2` FOREIGN KEY (`maintenanceid`) REFERENCES `maintenances` (`maintenanceid`);
 ALTER TABLE `hosts` ADD CONSTRAINT `c_hosts_3` FOREIGN KEY (`templateid`) REFERENCES `hosts` (`hostid`) ON DELETE CASCADE;
 ALTER TABLE `group_prototype` ADD CONSTRAINT `c_group_prototype_1` FOREIGN KEY (`hostid`) REFERENCES `hosts` (`hostid`) ON DELETE CASCADE;
@@ -1817,11 +1817,18 @@ CREATE TABLE config_autoreg_tls (
 	PRIMARY KEY (autoreg_tlsid)
 );
 CREATE UNIQUE INDEX config_autoreg_tls_1 ON config_autoreg_tls (tls_psk_identity);
+CREATE TABLE changelog (
+	changelogid              number(20)                                NOT NULL,
+	object                   number(10)      DEFAULT '0'               NOT NULL,
+	objectid                 number(20)                                NOT NULL,
+	clock                    number(10)      DEFAULT '0'               NOT NULL,
+	PRIMARY KEY (changelogid)
+);
 CREATE TABLE dbversion (
 	mandatory                number(10)      DEFAULT '0'               NOT NULL,
 	optional                 number(10)      DEFAULT '0'               NOT NULL
 );
-INSERT INTO dbversion VALUES ('4040000','4040000');
+INSERT INTO dbversion VALUES ('4040002','4040002');
 CREATE SEQUENCE proxy_history_seq
 START WITH 1
 INCREMENT BY 1
@@ -1858,6 +1865,102 @@ BEGIN
 SELECT proxy_autoreg_host_seq.nextval INTO :new.id FROM dual;
 END;
 /
+CREATE SEQUENCE changelog_seq
+START WITH 1
+INCREMENT BY 1
+NOMAXVALUE
+/
+CREATE TRIGGER changelog_tr
+BEFORE INSERT ON changelog
+FOR EACH ROW
+BEGIN
+SELECT changelog_seq.nextval INTO :new.changelogid FROM dual;
+END;
+/
+CREATE TRIGGER items_insert
+AFTER INSERT ON items
+FOR EACH ROW
+BEGIN
+INSERT INTO changelog (object,objectid,clock) VALUES (1,:new.itemid,(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);
+END;
+/
+CREATE TRIGGER items_update
+AFTER UPDATE ON items
+FOR EACH ROW
+BEGIN
+INSERT INTO changelog (object,objectid,clock) VALUES (1,:new.itemid,(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);
+END;
+/
+CREATE TRIGGER items_delete
+AFTER DELETE ON items
+FOR EACH ROW
+BEGIN
+INSERT INTO changelog (object,objectid,clock) VALUES (1,:old.itemid,(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);
+END;
+/
+CREATE TRIGGER item_preproc_insert
+AFTER INSERT ON item_preproc
+FOR EACH ROW
+BEGIN
+INSERT INTO changelog (object,objectid,clock) VALUES (1,:new.itemid,(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);
+END;
+/
+CREATE TRIGGER item_preproc_update
+AFTER UPDATE ON item_preproc
+FOR EACH ROW
+BEGIN
+INSERT INTO changelog (object,objectid,clock) VALUES (1,:new.itemid,(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);
+END;
+/
+CREATE TRIGGER item_preproc_delete
+AFTER DELETE ON item_preproc
+FOR EACH ROW
+BEGIN
+INSERT INTO changelog (object,objectid,clock) VALUES (1,:old.itemid,(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);
+END;
+/
+CREATE TRIGGER triggers_insert
+AFTER INSERT ON triggers
+FOR EACH ROW
+BEGIN
+INSERT INTO changelog (object,objectid,clock) VALUES (2,:new.triggerid,(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);
+END;
+/
+CREATE TRIGGER triggers_update
+AFTER UPDATE OF description,expression,priority,type,status,recovery_mode,recovery_expression,correlation_mode,correlation_tag,opdata,flags ON triggers
+FOR EACH ROW
+BEGIN
+INSERT INTO changelog (object,objectid,clock) VALUES (2,:new.triggerid,(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);
+END;
+/
+CREATE TRIGGER triggers_delete
+AFTER DELETE ON triggers
+FOR EACH ROW
+BEGIN
+INSERT INTO changelog (object,objectid,clock) VALUES (2,:old.triggerid,(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);
+END;
+/
+CREATE TRIGGER functions_insert
+AFTER INSERT ON functions
+FOR EACH ROW
+BEGIN
+INSERT INTO changelog (object,objectid,clock) VALUES (2,:new.triggerid,(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);
+END;
+/
+CREATE TRIGGER functions_update
+AFTER UPDATE ON functions
+FOR EACH ROW
+BEGIN
+INSERT INTO changelog (object,objectid,clock) VALUES (2,:new.triggerid,(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);
+END;
+/
+CREATE TRIGGER functions_delete
+AFTER DELETE ON functions
+FOR EACH ROW
+BEGIN
+INSERT INTO changelog (object,objectid,clock) VALUES (2,:old.triggerid,(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);
+END;
+/
 ALTER TABLE hosts ADD CONSTRAINT c_hosts_1 FOREIGN KEY (proxy_hostid) REFERENCES hosts (hostid);
 ALTER TABLE hosts ADD CONSTRAINT c_hosts_2 FOREIGN KEY (maintenanceid) REFERENCES maintenances (maintenanceid);
 ALTER TABLE hosts ADD CONSTRAINT c_hosts_3 FOREIGN KEY (templateid) REFERENCES hosts (hostid) ON DELETE CASCADE;
@@ -1817,12 +1817,71 @@ CREATE TABLE config_autoreg_tls (
 	PRIMARY KEY (autoreg_tlsid)
 );
 CREATE UNIQUE INDEX config_autoreg_tls_1 ON config_autoreg_tls (tls_psk_identity);
+CREATE TABLE changelog (
+	changelogid              bigserial                                 NOT NULL,
+	object                   integer         DEFAULT '0'               NOT NULL,
+	objectid                 bigint                                    NOT NULL,
+	clock                    integer         DEFAULT '0'               NOT NULL,
+	PRIMARY KEY (changelogid)
+);
 CREATE TABLE dbversion (
 	mandatory                integer         DEFAULT '0'               NOT NULL,
 	optional                 integer         DEFAULT '0'               NOT NULL
 );
-INSERT INTO dbversion VALUES ('4040000','4040000');
+INSERT INTO dbversion VALUES ('4040002','4040002');
 ALTER TABLE ONLY hosts ADD CONSTRAINT c_hosts_1 FOREIGN KEY (proxy_hostid) REFERENCES hosts (hostid);
+CREATE FUNCTION changelog_items() RETURNS trigger LANGUAGE plpgsql AS $$
+BEGIN
+IF TG_OP = 'DELETE' THEN
+INSERT INTO changelog (object,objectid,clock) VALUES (1,old.itemid,cast(extract(epoch from now()) as integer));
+RETURN old;
+END IF;
+INSERT INTO changelog (object,objectid,clock) VALUES (1,new.itemid,cast(extract(epoch from now()) as integer));
+RETURN new;
+END;
+$$;
+CREATE TRIGGER items_insert AFTER INSERT ON items FOR EACH ROW EXECUTE PROCEDURE changelog_items();
+CREATE TRIGGER items_update AFTER UPDATE ON items FOR EACH ROW EXECUTE PROCEDURE changelog_items();
+CREATE TRIGGER items_delete AFTER DELETE ON items FOR EACH ROW EXECUTE PROCEDURE changelog_items();
+CREATE FUNCTION changelog_item_preproc() RETURNS trigger LANGUAGE plpgsql AS $$
+BEGIN
+IF TG_OP = 'DELETE' THEN
+INSERT INTO changelog (object,objectid,clock) VALUES (1,old.itemid,cast(extract(epoch from now()) as integer));
+RETURN old;
+END IF;
+INSERT INTO changelog (object,objectid,clock) VALUES (1,new.itemid,cast(extract(epoch from now()) as integer));
+RETURN new;
+END;
+$$;
+CREATE TRIGGER item_preproc_insert AFTER INSERT ON item_preproc FOR EACH ROW EXECUTE PROCEDURE changelog_item_preproc();
+CREATE TRIGGER item_preproc_update AFTER UPDATE ON item_preproc FOR EACH ROW EXECUTE PROCEDURE changelog_item_preproc();
+CREATE TRIGGER item_preproc_delete AFTER DELETE ON item_preproc FOR EACH ROW EXECUTE PROCEDURE changelog_item_preproc();
+CREATE FUNCTION changelog_triggers() RETURNS trigger LANGUAGE plpgsql AS $$
+BEGIN
+IF TG_OP = 'DELETE' THEN
+INSERT INTO changelog (object,objectid,clock) VALUES (2,old.triggerid,cast(extract(epoch from now()) as integer));
+RETURN old;
+END IF;
+INSERT INTO changelog (object,objectid,clock) VALUES (2,new.triggerid,cast(extract(epoch from now()) as integer));
+RETURN new;
+END;
+$$;
+CREATE TRIGGER triggers_insert AFTER INSERT ON triggers FOR EACH ROW EXECUTE PROCEDURE changelog_triggers();
+CREATE TRIGGER triggers_update AFTER UPDATE OF description,expression,priority,type,status,recovery_mode,recovery_expression,correlation_mode,correlation_tag,opdata,flags ON triggers FOR EACH ROW EXECUTE PROCEDURE changelog_triggers();
+CREATE TRIGGER triggers_delete AFTER DELETE ON triggers FOR EACH ROW EXECUTE PROCEDURE changelog_triggers();
+CREATE FUNCTION changelog_functions() RETURNS trigger LANGUAGE plpgsql AS $$
+BEGIN
+IF TG_OP = 'DELETE' THEN
+INSERT INTO changelog (object,objectid,clock) VALUES (2,old.triggerid,cast(extract(epoch from now()) as integer));
+RETURN old;
+END IF;
+INSERT INTO changelog (object,objectid,clock) VALUES (2,new.triggerid,cast(extract(epoch from now()) as integer));
+RETURN new;
+END;
+$$;
+CREATE TRIGGER functions_insert AFTER INSERT ON functions FOR EACH ROW EXECUTE PROCEDURE changelog_functions();
+CREATE TRIGGER functions_update AFTER UPDATE ON functions FOR EACH ROW EXECUTE PROCEDURE changelog_functions();
+CREATE TRIGGER functions_delete AFTER DELETE ON functions FOR EACH ROW EXECUTE PROCEDURE changelog_functions();
 ALTER TABLE ONLY hosts ADD CONSTRAINT c_hosts_2 FOREIGN KEY (maintenanceid) REFERENCES maintenances (maintenanceid);
 ALTER TABLE ONLY hosts ADD CONSTRAINT c_hosts_3 FOREIGN KEY (templateid) REFERENCES hosts (hostid) ON DELETE CASCADE;
 ALTER TABLE ONLY group_prototype ADD CONSTRAINT c_group_prototype_1 FOREIGN KEY (hostid) REFERENCES hosts (hostid) ON DELETE CASCADE;
@@ -1814,8 +1814,26 @@ CREATE TABLE config_autoreg_tls (
 	PRIMARY KEY (autoreg_tlsid)
 );
 CREATE UNIQUE INDEX config_autoreg_tls_1 ON config_autoreg_tls (tls_psk_identity);
+CREATE TABLE changelog (
+	changelogid              integer                                   NOT NULL PRIMARY KEY AUTOINCREMENT,
+	object                   integer         DEFAULT '0'               NOT NULL,
+	objectid                 bigint                                    NOT NULL,
+	clock                    integer         DEFAULT '0'               NOT NULL
+);
 CREATE TABLE dbversion (
 	mandatory                integer         DEFAULT '0'               NOT NULL,
 	optional                 integer         DEFAULT '0'               NOT NULL
 );
-INSERT INTO dbversion VALUES ('4040000','4040000');
+INSERT INTO dbversion VALUES ('4040002','4040002');
+CREATE TRIGGER items_insert AFTER INSERT ON items FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (1,new.itemid,cast(strftime('%s','now') as integer)); END;
+CREATE TRIGGER items_update AFTER UPDATE ON items FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (1,new.itemid,cast(strftime('%s','now') as integer)); END;
+CREATE TRIGGER items_delete AFTER DELETE ON items FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (1,old.itemid,cast(strftime('%s','now') as integer)); END;
+CREATE TRIGGER item_preproc_insert AFTER INSERT ON item_preproc FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (1,new.itemid,cast(strftime('%s','now') as integer)); END;
+CREATE TRIGGER item_preproc_update AFTER UPDATE ON item_preproc FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (1,new.itemid,cast(strftime('%s','now') as integer)); END;
+CREATE TRIGGER item_preproc_delete AFTER DELETE ON item_preproc FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (1,old.itemid,cast(strftime('%s','now') as integer)); END;
+CREATE TRIGGER triggers_insert AFTER INSERT ON triggers FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (2,new.triggerid,cast(strftime('%s','now') as integer)); END;
+CREATE TRIGGER triggers_update AFTER UPDATE OF description,expression,priority,type,status,recovery_mode,recovery_expression,correlation_mode,correlation_tag,opdata,flags ON triggers FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (2,new.triggerid,cast(strftime('%s','now') as integer)); END;
+CREATE TRIGGER triggers_delete AFTER DELETE ON triggers FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (2,old.triggerid,cast(strftime('%s','now') as integer)); END;
+CREATE TRIGGER functions_insert AFTER INSERT ON functions FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (2,new.triggerid,cast(strftime('%s','now') as integer)); END;
+CREATE TRIGGER functions_update AFTER UPDATE ON functions FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (2,new.triggerid,cast(strftime('%s','now') as integer)); END;
+CREATE TRIGGER functions_delete AFTER DELETE ON functions FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (2,old.triggerid,cast(strftime('%s','now') as integer)); END;
@@ -977,6 +977,10 @@ class CHelpItems {
 					'key' => 'treegix[java,,<param>]',
 					'description' => _('Returns information associated with Treegix Java gateway. Valid params are: ping, version.')
 				],
+				[
+					'key' => 'treegix[preprocessing_cache,<type>,<mode>]',
+					'description' => _('Compiled expression cache statistics of preprocessing workers. Valid types are: jsonpath and regexp. Valid modes are: hits and misses.')
+				],
 				[
 					'key' => 'treegix[process,<type>,<mode>,<state>]',
 					'description' => _('Time a particular Treegix process or a group of processes (identified by <type> and <mode>) spent in <state> in percentage.')
@@ -995,7 +999,7 @@ class CHelpItems {
 				],
 				[
 					'key' => 'treegix[rcache,<cache>,<mode>]',
-					'description' => _('Configuration cache statistics. Cache - buffer (modes: pfree, total, used, free).')
+					'description' => _('Configuration cache statistics. Cache - buffer (modes: pfree, total, used, free), lock (modes: max).')
 				],
 				[
 					'key' => 'treegix[requiredperformance]',
@@ -1040,6 +1044,10 @@ class CHelpItems {
 				[
 					'key' => 'treegix[wcache,<cache>,<mode>]',
 					'description' => _('Data cache statistics. Cache - one of values (modes: all, float, uint, str, log, text), history (modes: pfree, total, used, free), trend (modes: pfree, total, used, free), text (modes: pfree, total, used, free).')
+				],
+				[
+					'key' => 'treegix[wcache,sync,<mode>]',
+					'description' => _('History syncer statistics averaged over all history syncers. Valid modes are: batch (number of items in history sync batch, default) and latency (time of writing the last batch to database in seconds).')
 				]
 			],
 			ITEM_TYPE_DB_MONITOR => [
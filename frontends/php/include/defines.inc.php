@@ -4,7 +4,7 @@
 define('TREEGIX_VERSION',		'3.0');
 define('TREEGIX_API_VERSION',	'3.0');
 define('TREEGIX_EXPORT_VERSION',	'3.0');
-define('TREEGIX_DB_VERSION',		4040000);
+define('TREEGIX_DB_VERSION',		4040002);
 
 define('TRX_LOGIN_ATTEMPTS',	5);
 define('TRX_LOGIN_BLOCK',		30); // sec
@@ -521,7 +521,9 @@ const char	*get_program_type_string(unsigned char program_type);
 #define TRX_PROCESS_TYPE_LLDMANAGER	28
 #define TRX_PROCESS_TYPE_LLDWORKER	29
 #define TRX_PROCESS_TYPE_ALERTSYNCER	30
-#define TRX_PROCESS_TYPE_COUNT		31	/* number of process types */
+#define TRX_PROCESS_TYPE_AGENTPOLLER	31
+#define TRX_PROCESS_TYPE_HTTPAGENT_POLLER	32
+#define TRX_PROCESS_TYPE_COUNT		33	/* number of process types */
 #define TRX_PROCESS_TYPE_UNKNOWN	255
 const char	*get_process_type_string(unsigned char process_type);
 int		get_process_type_by_name(const char *proc_type_str);
@@ -99,6 +99,9 @@ void	trx_getip_by_host(const char *host, char *ip, size_t iplen);
 int	trx_tcp_connect(trx_socket_t *s, const char *source_ip, const char *ip, unsigned short port, int timeout,
 		unsigned int tls_connect, const char *tls_arg1, const char *tls_arg2);
 
+#define TRX_TCP_HEADER_DATA		"TRXD"
+#define TRX_TCP_HEADER_LEN		TRX_CONST_STRLEN(TRX_TCP_HEADER_DATA)
+
 #define TRX_TCP_PROTOCOL		0x01
 #define TRX_TCP_COMPRESS		0x02
 
@@ -147,6 +150,22 @@ int	trx_udp_send(trx_socket_t *s, const char *data, size_t data_len, int timeout
 int	trx_udp_recv(trx_socket_t *s, int timeout);
 void	trx_udp_close(trx_socket_t *s);
 
+#define TRX_SOCKET_WANT_READ	0x01	/* repeat non-blocking operation when socket becomes readable */
+#define TRX_SOCKET_WANT_WRITE	0x02	/* repeat non-blocking operation when socket becomes writable */
+
+#ifndef _WINDOWS
+int	trx_tcp_connect_nonblocking(trx_socket_t *s, const char *source_ip, const struct sockaddr *addr,
+		socklen_t addrlen, const char *peer);
+int	trx_tcp_connect_check(trx_socket_t *s);
+int	trx_tcp_tls_connect_nonblocking(trx_socket_t *s, unsigned int tls_connect, const char *tls_arg1,
+		const char *tls_arg2, int *want);
+ssize_t	trx_tcp_write_nonblocking(trx_socket_t *s, const char *buf, size_t len, int *want);
+ssize_t	trx_tcp_read_nonblocking(trx_socket_t *s, char *buf, size_t len, int *want);
+#endif
+
+void	trx_tcp_pack_message(char **buf, size_t *buf_alloc, size_t *buf_offset, const char *data, size_t len);
+int	trx_tcp_unpack_message(const char *buf, size_t buf_len, size_t *message_len, char **data, size_t *data_len);
+
 #define TRX_DEFAULT_FTP_PORT		21
 #define TRX_DEFAULT_SSH_PORT		22
 #define TRX_DEFAULT_TELNET_PORT		23
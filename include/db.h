@@ -468,6 +468,13 @@ void	DBdeinit(void);
 int	DBconnect(int flag);
 void	DBclose(void);
 
+#ifdef HAVE_POSTGRESQL
+int	DBasync_connect(int flag);
+void	DBasync_close(void);
+int	DBasync_execute(const char *sql);
+int	DBasync_wait(void);
+#endif
+
 #ifdef HAVE_ORACLE
 void	DBstatement_prepare(const char *sql);
 #endif
@@ -654,6 +661,8 @@ typedef struct
 	trx_vector_ptr_t	rows;
 	/* index of autoincrement field */
 	int			autoincrement;
+	/* 1 - the string values are not escaped and the rows are inserted with COPY (PostgreSQL) */
+	unsigned char		copy;
 }
 trx_db_insert_t;
 
@@ -662,7 +671,11 @@ void	trx_db_insert_prepare_dyn(trx_db_insert_t *self, const TRX_TABLE *table, co
 void	trx_db_insert_prepare(trx_db_insert_t *self, const char *table, ...);
 void	trx_db_insert_add_values_dyn(trx_db_insert_t *self, const trx_db_value_t **values, int values_num);
 void	trx_db_insert_add_values(trx_db_insert_t *self, ...);
+void	trx_db_insert_use_copy(trx_db_insert_t *self);
 int	trx_db_insert_execute(trx_db_insert_t *self);
+#ifdef HAVE_POSTGRESQL
+void	trx_db_insert_format(const trx_db_insert_t *self, char **sql, size_t *sql_alloc, size_t *sql_offset);
+#endif
 void	trx_db_insert_clean(trx_db_insert_t *self);
 void	trx_db_insert_autoincrement(trx_db_insert_t *self, const char *field_name);
 int	trx_db_get_database_type(void);
@@ -17,7 +17,9 @@
 #define	TRX_POLLER_TYPE_IPMI		2
 #define	TRX_POLLER_TYPE_PINGER		3
 #define	TRX_POLLER_TYPE_JAVA		4
-#define	TRX_POLLER_TYPE_COUNT		5	/* number of poller types */
+#define	TRX_POLLER_TYPE_AGENT		5
+#define	TRX_POLLER_TYPE_HTTPAGENT	6
+#define	TRX_POLLER_TYPE_COUNT		7	/* number of poller types */
 
 #define MAX_JAVA_ITEMS		32
 #define MAX_SNMP_ITEMS		128
@@ -36,12 +38,17 @@ extern int	CONFIG_TIMEOUT;
 extern trx_uint64_t	CONFIG_CONF_CACHE_SIZE;
 extern trx_uint64_t	CONFIG_HISTORY_CACHE_SIZE;
 extern trx_uint64_t	CONFIG_HISTORY_INDEX_CACHE_SIZE;
+extern int		CONFIG_HISTORY_CACHE_SHARDS;
+extern trx_uint64_t	CONFIG_HISTORY_RING_SIZE;
+extern int		CONFIG_HISTORY_PIPELINING;
 extern trx_uint64_t	CONFIG_TRENDS_CACHE_SIZE;
 
 extern int	CONFIG_POLLER_FORKS;
 extern int	CONFIG_UNREACHABLE_POLLER_FORKS;
 extern int	CONFIG_IPMIPOLLER_FORKS;
 extern int	CONFIG_JAVAPOLLER_FORKS;
+extern int	CONFIG_AGENTPOLLER_FORKS;
+extern int	CONFIG_HTTPAGENT_POLLER_FORKS;
 extern int	CONFIG_PINGER_FORKS;
 extern int	CONFIG_UNAVAILABLE_DELAY;
 extern int	CONFIG_UNREACHABLE_PERIOD;
@@ -574,6 +581,8 @@ typedef struct
 	trx_uint64_t	index_total;
 	trx_uint64_t	trend_free;
 	trx_uint64_t	trend_total;
+	trx_uint64_t	sync_batch;	/* the average history syncer batch size */
+	double		sync_latency;	/* the average history syncer batch write time */
 }
 trx_wcache_info_t;
 
@@ -611,6 +620,8 @@ void	free_database_cache(void);
 #define TRX_STATS_HISTORY_INDEX_FREE	19
 #define TRX_STATS_HISTORY_INDEX_PUSED	20
 #define TRX_STATS_HISTORY_INDEX_PFREE	21
+#define TRX_STATS_HISTORY_SYNC_BATCH	22
+#define TRX_STATS_HISTORY_SYNC_LATENCY	23
 void	*DCget_stats(int request);
 void	DCget_stats_all(trx_wcache_info_t *wcache_info);
 
@@ -634,6 +645,7 @@ void	DCconfig_get_hosts_by_itemids(DC_HOST *hosts, const trx_uint64_t *itemids,
 void	DCconfig_get_items_by_keys(DC_ITEM *items, trx_host_key_t *keys, int *errcodes, size_t num);
 void	DCconfig_get_items_by_itemids(DC_ITEM *items, const trx_uint64_t *itemids, int *errcodes, size_t num);
 void	DCconfig_get_preprocessable_items(trx_hashset_t *items, int *timestamp);
+void	DCconfig_get_preprocessable_itemids(trx_hashset_t *itemids, int *timestamp);
 void	DCconfig_get_functions_by_functionids(DC_FUNCTION *functions,
 		trx_uint64_t *functionids, int *errcodes, size_t num);
 void	DCconfig_clean_functions(DC_FUNCTION *functions, int *errcodes, size_t num);
@@ -651,6 +663,7 @@ int	DCconfig_get_interface_by_type(DC_INTERFACE *interface, trx_uint64_t hostid,
 int	DCconfig_get_interface(DC_INTERFACE *interface, trx_uint64_t hostid, trx_uint64_t itemid);
 int	DCconfig_get_poller_nextcheck(unsigned char poller_type);
 int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items);
+int	DCconfig_get_async_poller_items(unsigned char poller_type, DC_ITEM *items, int items_num);
 int	DCconfig_get_ipmi_poller_items(int now, DC_ITEM *items, int items_num, int *nextcheck);
 int	DCconfig_get_snmp_interfaceids_by_addr(const char *addr, trx_uint64_t **interfaceids);
 size_t	DCconfig_get_snmp_items_by_interfaceid(trx_uint64_t interfaceid, DC_ITEM **items);
@@ -689,6 +702,7 @@ int	DCget_host_inventory_value_by_hostid(trx_uint64_t hostid, char **replace_to,
 #define TRX_CONFSTATS_BUFFER_FREE	3
 #define TRX_CONFSTATS_BUFFER_PUSED	4
 #define TRX_CONFSTATS_BUFFER_PFREE	5
+#define TRX_CONFSTATS_SYNC_LOCK_MAX	6
 void	*DCconfig_get_stats(int request);
 
 int	DCconfig_get_last_sync_time(void);
@@ -26,6 +26,9 @@ typedef enum
 	TRX_MUTEX_SQLITE3,
 	TRX_MUTEX_PROCSTAT,
 	TRX_MUTEX_PROXY_HISTORY,
+	/* history cache shards, see HistoryCacheShards configuration parameter */
+	TRX_MUTEX_CACHE_SHARD_FIRST,
+	TRX_MUTEX_CACHE_SHARD_LAST = TRX_MUTEX_CACHE_SHARD_FIRST + 15,
 	TRX_MUTEX_COUNT
 }
 trx_mutex_name_t;
@@ -15,12 +15,24 @@ typedef struct
 }
 trx_preproc_result_t;
 
+/* compiled expression cache statistics of preprocessing workers */
+typedef struct
+{
+	trx_uint64_t	jsonpath_hits;
+	trx_uint64_t	jsonpath_misses;
+	trx_uint64_t	regexp_hits;
+	trx_uint64_t	regexp_misses;
+}
+trx_preproc_cache_stats_t;
+
 /* the following functions are implemented differently for server and proxy */
 
 void	trx_preprocess_item_value(trx_uint64_t itemid, unsigned char item_value_type, unsigned char item_flags,
 		AGENT_RESULT *result, trx_timespec_t *ts, unsigned char state, char *error);
 void	trx_preprocessor_flush(void);
+int	trx_preprocessor_init_rings(char **error);
 trx_uint64_t	trx_preprocessor_get_queue_size(void);
+void	trx_preprocessor_get_cache_stats(trx_preproc_cache_stats_t *stats);
 
 void	trx_preproc_op_free(trx_preproc_op_t *op);
 void	trx_preproc_result_free(trx_preproc_result_t *result);
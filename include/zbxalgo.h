@@ -13,11 +13,13 @@ trx_hash_t	trx_hash_modfnv(const void *data, size_t len, trx_hash_t seed);
 trx_hash_t	trx_hash_murmur2(const void *data, size_t len, trx_hash_t seed);
 trx_hash_t	trx_hash_sdbm(const void *data, size_t len, trx_hash_t seed);
 trx_hash_t	trx_hash_djb2(const void *data, size_t len, trx_hash_t seed);
+trx_hash_t	trx_hash_wyhash(const void *data, size_t len, trx_hash_t seed);
+trx_hash_t	trx_hash_uint64(trx_uint64_t value, trx_hash_t seed);
 
-#define TRX_DEFAULT_HASH_ALGO		trx_hash_modfnv
-#define TRX_DEFAULT_PTR_HASH_ALGO	trx_hash_modfnv
-#define TRX_DEFAULT_UINT64_HASH_ALGO	trx_hash_modfnv
-#define TRX_DEFAULT_STRING_HASH_ALGO	trx_hash_modfnv
+#define TRX_DEFAULT_HASH_ALGO		trx_hash_wyhash
+#define TRX_DEFAULT_PTR_HASH_ALGO	trx_hash_wyhash
+#define TRX_DEFAULT_UINT64_HASH_ALGO	trx_hash_wyhash
+#define TRX_DEFAULT_STRING_HASH_ALGO	trx_hash_wyhash
 
 typedef trx_hash_t (*trx_hash_func_t)(const void *data);
 
@@ -104,6 +106,17 @@ TRX_HASHSET_ENTRY_T
 	char			data[1];
 };
 
+/* the open addressing hashset slot, the entry identifier is kept in slot to avoid accessing entry data */
+typedef struct
+{
+	trx_uint64_t	id;
+	void		*data;
+}
+trx_hashset_slot_t;
+
+#define TRX_HASHSET_TYPE_CHAINED	0
+#define TRX_HASHSET_TYPE_UINT64		1
+
 typedef struct
 {
 	TRX_HASHSET_ENTRY_T	**slots;
@@ -115,6 +128,11 @@ typedef struct
 	trx_mem_malloc_func_t	mem_malloc_func;
 	trx_mem_realloc_func_t	mem_realloc_func;
 	trx_mem_free_func_t	mem_free_func;
+	/* the open addressing slots of TRX_HASHSET_TYPE_UINT64 hashset */
+	trx_hashset_slot_t	*id_slots;
+	/* the number of deleted open addressing slots */
+	int			num_deleted;
+	unsigned char		type;
 }
 trx_hashset_t;
 
@@ -128,6 +146,11 @@ void	trx_hashset_create_ext(trx_hashset_t *hs, size_t init_size,
 				trx_mem_malloc_func_t mem_malloc_func,
 				trx_mem_realloc_func_t mem_realloc_func,
 				trx_mem_free_func_t mem_free_func);
+void	trx_hashset_create_uint64_ext(trx_hashset_t *hs, size_t init_size,
+				trx_clean_func_t clean_func,
+				trx_mem_malloc_func_t mem_malloc_func,
+				trx_mem_realloc_func_t mem_realloc_func,
+				trx_mem_free_func_t mem_free_func);
 void	trx_hashset_destroy(trx_hashset_t *hs);
 
 int	trx_hashset_reserve(trx_hashset_t *hs, int num_slots_req);
@@ -388,6 +411,37 @@ void	trx_queue_ptr_push(trx_queue_ptr_t *queue, void *value);
 void	*trx_queue_ptr_pop(trx_queue_ptr_t *queue);
 void	trx_queue_ptr_remove_value(trx_queue_ptr_t *queue, const void *value);
 
+/* lock-free ring buffer of variable size records for multiple producers and a single consumer */
+#if defined(__ATOMIC_ACQUIRE)
+#	define HAVE_TRX_RINGBUF	1
+
+typedef struct
+{
+	/* the producer position, updated atomically by producers */
+	trx_uint64_t	reserved;
+	char		pad1[64 - sizeof(trx_uint64_t)];
+
+	/* the position of the first unreleased record, updated by consumer */
+	trx_uint64_t	released;
+	/* the consumer read position */
+	trx_uint64_t	read;
+	/* the data size, power of 2 */
+	trx_uint64_t	size;
+	char		pad2[64 - 3 * sizeof(trx_uint64_t)];
+}
+trx_ringbuf_t;
+
+size_t		trx_ringbuf_required_size(size_t size);
+trx_ringbuf_t	*trx_ringbuf_init(void *mem, size_t size);
+void		*trx_ringbuf_reserve(trx_ringbuf_t *ring, size_t size);
+void		trx_ringbuf_commit(void *data);
+void		*trx_ringbuf_read(trx_ringbuf_t *ring, size_t *size);
+void		trx_ringbuf_release(trx_ringbuf_t *ring);
+void		trx_ringbuf_rewind(trx_ringbuf_t *ring);
+trx_uint64_t	trx_ringbuf_get_reserved(trx_ringbuf_t *ring);
+int		trx_ringbuf_is_released(trx_ringbuf_t *ring, trx_uint64_t pos);
+#endif
+
 
 
 #endif
@@ -63,6 +63,14 @@ void	trx_db_deinit(void);
 int	trx_db_connect(char *host, char *user, char *password, char *dbname, char *dbschema, char *dbsocket, int port);
 void	trx_db_close(void);
 
+#ifdef HAVE_POSTGRESQL
+int	trx_db_async_connect(char *host, char *user, char *password, char *dbname, char *dbschema, char *dbsocket,
+		int port);
+void	trx_db_async_close(void);
+int	trx_db_async_execute(const char *sql);
+int	trx_db_async_wait(void);
+#endif
+
 int	trx_db_begin(void);
 int	trx_db_commit(void);
 int	trx_db_rollback(void);
@@ -96,6 +104,9 @@ void		trx_db_clean_bind_context(trx_db_bind_context_t *context);
 int		trx_db_statement_execute(int iters);
 #endif
 int		trx_db_vexecute(const char *fmt, va_list args);
+#ifdef HAVE_POSTGRESQL
+int		trx_db_copy(const char *sql, const char *data, size_t data_len);
+#endif
 DB_RESULT	trx_db_vselect(const char *fmt, va_list args);
 DB_RESULT	trx_db_select_n(const char *query, int n);
 
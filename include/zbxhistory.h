@@ -32,8 +32,11 @@ int	trx_history_init(char **error);
 void	trx_history_destroy(void);
 
 int	trx_history_add_values(const trx_vector_ptr_t *values);
+int	trx_history_sync(void);
 int	trx_history_get_values(trx_uint64_t itemid, int value_type, int start, int count, int end,
 		trx_vector_history_record_t *values);
+int	trx_history_get_values_multi(const trx_uint64_t *itemids, int itemids_num, int value_type, int start, int end,
+		trx_vector_history_record_t *values);
 
 int	trx_history_requires_trends(int value_type);
 
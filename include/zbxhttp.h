@@ -13,6 +13,7 @@ int	trx_http_prepare_ssl(CURL *easyhandle, const char *ssl_cert_file, const char
 		const char *ssl_key_password, unsigned char verify_peer, unsigned char verify_host, char **error);
 int	trx_http_prepare_auth(CURL *easyhandle, unsigned char authtype, const char *username, const char *password,
 		char **error);
+int	trx_http_prepare_share(CURL *easyhandle, char **error);
 char	*trx_http_get_header(char **headers);
 #endif
 
@@ -107,6 +107,31 @@ int	trx_ipc_async_socket_check_unsent(trx_ipc_async_socket_t *asocket);
 int	trx_ipc_async_exchange(const char *service_name, trx_uint32_t code, int timeout, const unsigned char *data,
 		trx_uint32_t size, unsigned char **out, char **error);
 
+#ifdef HAVE_TRX_RINGBUF
+/* Shared memory ring transport. Messages are packed into ring by the processes connected */
+/* to IPC service instead of being written to the socket, which is used only to wake up   */
+/* the service process. The service process reads the messages from the ring.             */
+typedef struct
+{
+	/* set by producer when consumer is notified, reset by consumer when reading messages */
+	trx_uint32_t	notified;
+	char		pad[64 - sizeof(trx_uint32_t)];
+
+	/* the ring buffer, must be the last member because the ring data follows it */
+	trx_ringbuf_t	ring;
+}
+trx_ipc_ring_t;
+
+size_t		trx_ipc_ring_required_size(size_t size);
+trx_ipc_ring_t	*trx_ipc_ring_init(void *mem, size_t size);
+int		trx_ipc_ring_reserve(trx_ipc_ring_t *ring, trx_ipc_socket_t *csocket, trx_uint32_t notify_code,
+		trx_uint32_t code, trx_uint32_t size, unsigned char **data);
+void		trx_ipc_ring_commit(unsigned char *data);
+int		trx_ipc_ring_notify(trx_ipc_ring_t *ring, trx_ipc_socket_t *csocket, trx_uint32_t notify_code);
+int		trx_ipc_ring_flush(trx_ipc_ring_t *ring, trx_ipc_socket_t *csocket, trx_uint32_t notify_code);
+unsigned char	*trx_ipc_ring_read(trx_ipc_ring_t *ring, trx_uint32_t *code, trx_uint32_t *size);
+void		trx_ipc_ring_release(trx_ipc_ring_t *ring);
+#endif
 
 void	trx_ipc_message_free(trx_ipc_message_t *message);
 void	trx_ipc_message_clean(trx_ipc_message_t *message);
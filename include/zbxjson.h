@@ -110,6 +110,7 @@
 #define TRX_PROTO_VALUE_SUCCESS		"success"
 
 #define TRX_PROTO_VALUE_GET_ACTIVE_CHECKS	"active checks"
+#define TRX_PROTO_VALUE_PASSIVE_CHECKS		"passive checks"
 #define TRX_PROTO_VALUE_PROXY_CONFIG		"proxy config"
 #define TRX_PROTO_VALUE_PROXY_HEARTBEAT		"proxy heartbeat"
 #define TRX_PROTO_VALUE_SENDER_DATA		"sender data"
@@ -222,8 +223,15 @@ typedef struct
 }
 trx_jsonpath_t;
 
+typedef struct trx_jsonpath_index trx_jsonpath_index_t;
+
 void	trx_jsonpath_clear(trx_jsonpath_t *jsonpath);
 int	trx_jsonpath_compile(const char *path, trx_jsonpath_t *jsonpath);
 int	trx_jsonpath_query(const struct trx_json_parse *jp, const char *path, char **output);
+int	trx_jsonpath_query_compiled(const struct trx_json_parse *jp, trx_jsonpath_t *jsonpath,
+		trx_jsonpath_index_t *doc_index, char **output);
+
+trx_jsonpath_index_t	*trx_jsonpath_index_create(void);
+void	trx_jsonpath_index_free(trx_jsonpath_index_t *doc_index);
 
 #endif /* TREEGIX_ZJSON_H */
@@ -211,6 +211,139 @@ trx_hash_t	trx_hash_djb2(const void *data, size_t len, trx_hash_t seed)
 	return hash;
 }
 
+/*
+ * wyhash style hash function (see https://github.com/wangyi-fudan/wyhash)
+ *
+ * Processes 8 bytes per read instead of single byte and long keys in three
+ * independent lanes. The 64 bit result is folded into trx_hash_t.
+ */
+#define WY_P0	__UINT64_C(0xa0761d6478bd642f)
+#define WY_P1	__UINT64_C(0xe7037ed1a0b428db)
+#define WY_P2	__UINT64_C(0x8ebc6af09c88c6e3)
+#define WY_P3	__UINT64_C(0x589965cc75374cc3)
+
+static trx_uint64_t	wy_mix(trx_uint64_t a, trx_uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+	__uint128_t	r = (__uint128_t)a * b;
+
+	return (trx_uint64_t)r ^ (trx_uint64_t)(r >> 64);
+#else
+	trx_uint64_t	ha = a >> 32, hb = b >> 32, la = (trx_uint32_t)a, lb = (trx_uint32_t)b, rh, rm0, rm1, rl, t, lo;
+	int		c;
+
+	rh = ha * hb;
+	rm0 = ha * lb;
+	rm1 = hb * la;
+	rl = la * lb;
+	t = rl + (rm0 << 32);
+	c = t < rl;
+	lo = t + (rm1 << 32);
+	c += lo < t;
+
+	return lo ^ (rh + (rm0 >> 32) + (rm1 >> 32) + c);
+#endif
+}
+
+static trx_uint64_t	wy_read8(const uchar *p)
+{
+	trx_uint64_t	v;
+
+	memcpy(&v, p, sizeof(v));
+
+	return v;
+}
+
+static trx_uint64_t	wy_read4(const uchar *p)
+{
+	trx_uint32_t	v;
+
+	memcpy(&v, p, sizeof(v));
+
+	return v;
+}
+
+static trx_hash_t	wy_fold(trx_uint64_t hash)
+{
+	return (trx_hash_t)(hash ^ (hash >> 32));
+}
+
+static trx_hash_t	wy_hash_uint64(trx_uint64_t value, trx_hash_t seed)
+{
+	return wy_fold(wy_mix(wy_mix(value ^ WY_P0, (trx_uint64_t)seed ^ WY_P1) ^ WY_P0, WY_P1));
+}
+
+trx_hash_t	trx_hash_wyhash(const void *data, size_t len, trx_hash_t seed)
+{
+	const uchar	*p = (const uchar *)data;
+	trx_uint64_t	a, b, hash;
+	size_t		i;
+
+	/* identifiers are the most common keys, hash them without the generic overhead */
+	if (sizeof(trx_uint64_t) == len)
+		return wy_hash_uint64(wy_read8(p), seed);
+
+	hash = wy_mix((trx_uint64_t)seed ^ WY_P0, WY_P1);
+
+	if (16 >= len)
+	{
+		if (4 <= len)
+		{
+			a = (wy_read4(p) << 32) | wy_read4(p + ((len >> 3) << 2));
+			b = (wy_read4(p + len - 4) << 32) | wy_read4(p + len - 4 - ((len >> 3) << 2));
+		}
+		else if (0 < len)
+		{
+			a = ((trx_uint64_t)p[0] << 16) | ((trx_uint64_t)p[len >> 1] << 8) | p[len - 1];
+			b = 0;
+		}
+		else
+			a = b = 0;
+	}
+	else
+	{
+		i = len;
+
+		if (48 < i)
+		{
+			trx_uint64_t	lane1 = hash, lane2 = hash;
+
+			do
+			{
+				hash = wy_mix(wy_read8(p) ^ WY_P1, wy_read8(p + 8) ^ hash);
+				lane1 = wy_mix(wy_read8(p + 16) ^ WY_P2, wy_read8(p + 24) ^ lane1);
+				lane2 = wy_mix(wy_read8(p + 32) ^ WY_P3, wy_read8(p + 40) ^ lane2);
+				p += 48;
+				i -= 48;
+			}
+			while (48 < i);
+
+			hash ^= lane1 ^ lane2;
+		}
+
+		while (16 < i)
+		{
+			hash = wy_mix(wy_read8(p) ^ WY_P1, wy_read8(p + 8) ^ hash);
+			p += 16;
+			i -= 16;
+		}
+
+		a = wy_read8(p + i - 16);
+		b = wy_read8(p + i - 8);
+	}
+
+	return wy_fold(wy_mix(wy_mix(a ^ WY_P1, b ^ hash) ^ WY_P0 ^ len, WY_P1));
+}
+
+/*
+ * hash function specialized for 64 bit unsigned integer keys, returns the same
+ * hash as trx_hash_wyhash() for the integer data
+ */
+trx_hash_t	trx_hash_uint64(trx_uint64_t value, trx_hash_t seed)
+{
+	return wy_hash_uint64(value, seed);
+}
+
 /* default hash functions */
 
 trx_hash_t	trx_default_ptr_hash_func(const void *data)
@@ -220,7 +353,7 @@ trx_hash_t	trx_default_ptr_hash_func(const void *data)
 
 trx_hash_t	trx_default_uint64_hash_func(const void *data)
 {
-	return TRX_DEFAULT_UINT64_HASH_ALGO(data, sizeof(trx_uint64_t), TRX_DEFAULT_HASH_SEED);
+	return wy_hash_uint64(*(const trx_uint64_t *)data, TRX_DEFAULT_HASH_SEED);
 }
 
 trx_hash_t	trx_default_string_hash_func(const void *data)
@@ -234,8 +367,8 @@ trx_hash_t	trx_default_uint64_pair_hash_func(const void *data)
 
 	trx_hash_t		hash;
 
-	hash = TRX_DEFAULT_UINT64_HASH_FUNC(&pair->first);
-	hash = TRX_DEFAULT_UINT64_HASH_ALGO(&pair->second, sizeof(pair->second), hash);
+	hash = wy_hash_uint64(pair->first, TRX_DEFAULT_HASH_SEED);
+	hash = wy_hash_uint64(pair->second, hash);
 
 	return hash;
 }
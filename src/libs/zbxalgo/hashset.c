@@ -44,6 +44,172 @@ static int	trx_hashset_init_slots(trx_hashset_t *hs, size_t init_size)
 	return SUCCEED;
 }
 
+/* private open addressing hashset functions */
+
+/*
+ * The TRX_HASHSET_TYPE_UINT64 hashsets store entries with trx_uint64_t key at the start of entry data
+ * (the same entries as chained hashsets with TRX_DEFAULT_UINT64_HASH_FUNC and
+ * TRX_DEFAULT_UINT64_COMPARE_FUNC functions) in a linear probing slot array. Each slot holds the entry
+ * key and data pointer, so lookups read only the slot array and do not follow entry chains. The entry
+ * data is still allocated separately, so pointers to entries stay valid when the slot array is resized.
+ * Removed entries are marked as deleted and are dropped when the slot array is rebuilt, so entries are
+ * never moved during iteration.
+ */
+
+#define	ID_SLOTS_LOAD_FACTOR	3/4
+#define ID_SLOTS_MIN		16
+
+static const char	id_slot_deleted;
+
+#define	ID_SLOT_DELETED		((void *)&id_slot_deleted)
+
+static int	id_slots_find(const trx_hashset_t *hs, trx_uint64_t id)
+{
+	int			i, mask = hs->num_slots - 1;
+	trx_hashset_slot_t	*slot;
+
+	for (i = trx_hash_uint64(id, TRX_DEFAULT_HASH_SEED) & mask;; i = (i + 1) & mask)
+	{
+		slot = &hs->id_slots[i];
+
+		if (NULL == slot->data)
+			return FAIL;
+
+		if (slot->id == id && ID_SLOT_DELETED != slot->data)
+			return i;
+	}
+}
+
+static int	id_slots_find_data(const trx_hashset_t *hs, const void *data)
+{
+	int	i, mask = hs->num_slots - 1;
+
+	for (i = trx_hash_uint64(*(const trx_uint64_t *)data, TRX_DEFAULT_HASH_SEED) & mask;; i = (i + 1) & mask)
+	{
+		if (NULL == hs->id_slots[i].data)
+			return FAIL;
+
+		if (data == hs->id_slots[i].data)
+			return i;
+	}
+}
+
+static int	id_slots_rebuild(trx_hashset_t *hs, int num_slots)
+{
+	int			i, j, mask = num_slots - 1;
+	trx_hashset_slot_t	*slots;
+
+	if (NULL == (slots = (trx_hashset_slot_t *)hs->mem_malloc_func(NULL, num_slots * sizeof(trx_hashset_slot_t))))
+		return FAIL;
+
+	memset(slots, 0, num_slots * sizeof(trx_hashset_slot_t));
+
+	for (i = 0; i < hs->num_slots; i++)
+	{
+		if (NULL == hs->id_slots[i].data || ID_SLOT_DELETED == hs->id_slots[i].data)
+			continue;
+
+		for (j = trx_hash_uint64(hs->id_slots[i].id, TRX_DEFAULT_HASH_SEED) & mask; NULL != slots[j].data;
+				j = (j + 1) & mask)
+			;
+
+		slots[j] = hs->id_slots[i];
+	}
+
+	if (NULL != hs->id_slots)
+		hs->mem_free_func(hs->id_slots);
+
+	hs->id_slots = slots;
+	hs->num_slots = num_slots;
+	hs->num_deleted = 0;
+
+	return SUCCEED;
+}
+
+static int	id_slots_reserve(trx_hashset_t *hs, int num_data_req)
+{
+	int	num_slots;
+
+	if (0 != hs->num_slots && num_data_req + hs->num_deleted < hs->num_slots * ID_SLOTS_LOAD_FACTOR)
+		return SUCCEED;
+
+	for (num_slots = ID_SLOTS_MIN; num_data_req >= num_slots * ID_SLOTS_LOAD_FACTOR; num_slots *= 2)
+		;
+
+	/* slot array of the same size is rebuilt to drop deleted slots */
+	return id_slots_rebuild(hs, MAX(num_slots, hs->num_slots));
+}
+
+static void	id_slots_free_entry(trx_hashset_t *hs, int index)
+{
+	void	*data = hs->id_slots[index].data;
+
+	hs->id_slots[index].data = ID_SLOT_DELETED;
+	hs->num_data--;
+	hs->num_deleted++;
+
+	if (NULL != hs->clean_func)
+		hs->clean_func(data);
+
+	hs->mem_free_func(data);
+}
+
+static void	id_slots_clear(trx_hashset_t *hs)
+{
+	int	i;
+
+	for (i = 0; i < hs->num_slots; i++)
+	{
+		if (NULL != hs->id_slots[i].data && ID_SLOT_DELETED != hs->id_slots[i].data)
+			id_slots_free_entry(hs, i);
+	}
+
+	if (0 != hs->num_slots)
+		memset(hs->id_slots, 0, hs->num_slots * sizeof(trx_hashset_slot_t));
+
+	hs->num_data = 0;
+	hs->num_deleted = 0;
+}
+
+static void	*id_slots_insert(trx_hashset_t *hs, const void *data, size_t size, size_t offset)
+{
+	trx_uint64_t	id = *(const trx_uint64_t *)data;
+	int		i, mask;
+	void		*entry;
+
+	if (0 != hs->num_slots && FAIL != (i = id_slots_find(hs, id)))
+		return hs->id_slots[i].data;
+
+	if (SUCCEED != id_slots_reserve(hs, hs->num_data + 1))
+		return NULL;
+
+	if (NULL == (entry = hs->mem_malloc_func(NULL, size)))
+		return NULL;
+
+	memcpy((char *)entry + offset, (const char *)data + offset, size - offset);
+
+	mask = hs->num_slots - 1;
+
+	/* the key is not in hashset, so the first free or deleted slot can be used */
+	for (i = trx_hash_uint64(id, TRX_DEFAULT_HASH_SEED) & mask;; i = (i + 1) & mask)
+	{
+		if (NULL == hs->id_slots[i].data)
+			break;
+
+		if (ID_SLOT_DELETED == hs->id_slots[i].data)
+		{
+			hs->num_deleted--;
+			break;
+		}
+	}
+
+	hs->id_slots[i].id = id;
+	hs->id_slots[i].data = entry;
+	hs->num_data++;
+
+	return entry;
+}
+
 /* public hashset interface */
 
 void	trx_hashset_create(trx_hashset_t *hs, size_t init_size,
@@ -70,16 +236,73 @@ void	trx_hashset_create_ext(trx_hashset_t *hs, size_t init_size,
 	hs->mem_malloc_func = mem_malloc_func;
 	hs->mem_realloc_func = mem_realloc_func;
 	hs->mem_free_func = mem_free_func;
+	hs->id_slots = NULL;
+	hs->num_deleted = 0;
+	hs->type = TRX_HASHSET_TYPE_CHAINED;
 
 	trx_hashset_init_slots(hs, init_size);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_hashset_create_uint64_ext                                    *
+ *                                                                            *
+ * Purpose: creates open addressing hashset of entries with trx_uint64_t key  *
+ *                                                                            *
+ * Parameters: hs               - [OUT] the hashset                           *
+ *             init_size        - [IN] the initial number of entries          *
+ *             clean_func       - [IN] the entry cleanup function, optional   *
+ *             mem_malloc_func  - [IN] the memory allocation functions        *
+ *             mem_realloc_func                                               *
+ *             mem_free_func                                                  *
+ *                                                                            *
+ * Comments: The entries must start with trx_uint64_t key. The hashset works  *
+ *           as a hashset created with TRX_DEFAULT_UINT64_HASH_FUNC and       *
+ *           TRX_DEFAULT_UINT64_COMPARE_FUNC functions, but the keys are      *
+ *           compared in slot array without accessing entry data.             *
+ *           Use it for large hashsets with frequent lookups.                 *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_hashset_create_uint64_ext(trx_hashset_t *hs, size_t init_size,
+				trx_clean_func_t clean_func,
+				trx_mem_malloc_func_t mem_malloc_func,
+				trx_mem_realloc_func_t mem_realloc_func,
+				trx_mem_free_func_t mem_free_func)
+{
+	hs->hash_func = TRX_DEFAULT_UINT64_HASH_FUNC;
+	hs->compare_func = TRX_DEFAULT_UINT64_COMPARE_FUNC;
+	hs->clean_func = clean_func;
+	hs->mem_malloc_func = mem_malloc_func;
+	hs->mem_realloc_func = mem_realloc_func;
+	hs->mem_free_func = mem_free_func;
+	hs->slots = NULL;
+	hs->id_slots = NULL;
+	hs->num_slots = 0;
+	hs->num_data = 0;
+	hs->num_deleted = 0;
+	hs->type = TRX_HASHSET_TYPE_UINT64;
+
+	if (0 < init_size)
+		id_slots_reserve(hs, (int)init_size);
+}
+
 void	trx_hashset_destroy(trx_hashset_t *hs)
 {
 	int			i;
 	TRX_HASHSET_ENTRY_T	*entry, *next_entry;
 
-	for (i = 0; i < hs->num_slots; i++)
+	if (TRX_HASHSET_TYPE_UINT64 == hs->type)
+	{
+		id_slots_clear(hs);
+
+		if (NULL != hs->id_slots)
+		{
+			hs->mem_free_func(hs->id_slots);
+			hs->id_slots = NULL;
+		}
+	}
+
+	for (i = 0; i < hs->num_slots && NULL != hs->slots; i++)
 	{
 		entry = hs->slots[i];
 
@@ -119,6 +342,9 @@ void	trx_hashset_destroy(trx_hashset_t *hs)
  ******************************************************************************/
 int	trx_hashset_reserve(trx_hashset_t *hs, int num_slots_req)
 {
+	if (TRX_HASHSET_TYPE_UINT64 == hs->type)
+		return id_slots_reserve(hs, num_slots_req);
+
 	if (0 == hs->num_slots)
 	{
 		/* correction for prevent the second relocation in the case that requires the same number of slots */
@@ -184,6 +410,9 @@ void	*trx_hashset_insert_ext(trx_hashset_t *hs, const void *data, size_t size, s
 	trx_hash_t		hash;
 	TRX_HASHSET_ENTRY_T	*entry;
 
+	if (TRX_HASHSET_TYPE_UINT64 == hs->type)
+		return id_slots_insert(hs, data, size, offset);
+
 	if (0 == hs->num_slots && SUCCEED != trx_hashset_init_slots(hs, TRX_HASHSET_DEFAULT_SLOTS))
 		return NULL;
 
@@ -230,6 +459,14 @@ void	*trx_hashset_search(trx_hashset_t *hs, const void *data)
 	if (0 == hs->num_slots)
 		return NULL;
 
+	if (TRX_HASHSET_TYPE_UINT64 == hs->type)
+	{
+		if (FAIL == (slot = id_slots_find(hs, *(const trx_uint64_t *)data)))
+			return NULL;
+
+		return hs->id_slots[slot].data;
+	}
+
 	hash = hs->hash_func(data);
 
 	slot = hash % hs->num_slots;
@@ -260,6 +497,14 @@ void	trx_hashset_remove(trx_hashset_t *hs, const void *data)
 	if (0 == hs->num_slots)
 		return;
 
+	if (TRX_HASHSET_TYPE_UINT64 == hs->type)
+	{
+		if (FAIL != (slot = id_slots_find(hs, *(const trx_uint64_t *)data)))
+			id_slots_free_entry(hs, slot);
+
+		return;
+	}
+
 	hash = hs->hash_func(data);
 
 	slot = hash % hs->num_slots;
@@ -311,6 +556,14 @@ void	trx_hashset_remove_direct(trx_hashset_t *hs, const void *data)
 	if (0 == hs->num_slots)
 		return;
 
+	if (TRX_HASHSET_TYPE_UINT64 == hs->type)
+	{
+		if (FAIL != (slot = id_slots_find_data(hs, data)))
+			id_slots_free_entry(hs, slot);
+
+		return;
+	}
+
 	data_entry = (TRX_HASHSET_ENTRY_T *)((const char *)data - offsetof(TRX_HASHSET_ENTRY_T, data));
 
 	slot = data_entry->hash % hs->num_slots;
@@ -347,6 +600,12 @@ void	trx_hashset_clear(trx_hashset_t *hs)
 	int			slot;
 	TRX_HASHSET_ENTRY_T	*entry;
 
+	if (TRX_HASHSET_TYPE_UINT64 == hs->type)
+	{
+		id_slots_clear(hs);
+		return;
+	}
+
 	for (slot = 0; slot < hs->num_slots; slot++)
 	{
 		while (NULL != hs->slots[slot])
@@ -374,6 +633,22 @@ void	*trx_hashset_iter_next(trx_hashset_iter_t *iter)
 	if (ITER_FINISH == iter->slot)
 		return NULL;
 
+	if (TRX_HASHSET_TYPE_UINT64 == iter->hashset->type)
+	{
+		const trx_hashset_slot_t	*slot;
+
+		while (++iter->slot < iter->hashset->num_slots)
+		{
+			slot = &iter->hashset->id_slots[iter->slot];
+
+			if (NULL != slot->data && ID_SLOT_DELETED != slot->data)
+				return slot->data;
+		}
+
+		iter->slot = ITER_FINISH;
+		return NULL;
+	}
+
 	if (ITER_START != iter->slot && NULL != iter->entry && NULL != iter->entry->next)
 	{
 		iter->entry = iter->entry->next;
@@ -400,6 +675,19 @@ void	*trx_hashset_iter_next(trx_hashset_iter_t *iter)
 
 void	trx_hashset_iter_remove(trx_hashset_iter_t *iter)
 {
+	if (TRX_HASHSET_TYPE_UINT64 == iter->hashset->type)
+	{
+		if (ITER_START == iter->slot || ITER_FINISH == iter->slot ||
+				ID_SLOT_DELETED == iter->hashset->id_slots[iter->slot].data)
+		{
+			treegix_log(LOG_LEVEL_CRIT, "removing a hashset entry through a bad iterator");
+			exit(EXIT_FAILURE);
+		}
+
+		id_slots_free_entry(iter->hashset, iter->slot);
+		return;
+	}
+
 	if (ITER_START == iter->slot || ITER_FINISH == iter->slot || NULL == iter->entry)
 	{
 		treegix_log(LOG_LEVEL_CRIT, "removing a hashset entry through a bad iterator");
@@ -0,0 +1,281 @@
+#include "common.h"
+#include "trxalgo.h"
+
+#ifdef HAVE_TRX_RINGBUF
+
+#define TRX_RINGBUF_RECORD_FREE		0
+#define TRX_RINGBUF_RECORD_DATA		1
+#define TRX_RINGBUF_RECORD_PADDING	2
+
+/* ring buffer record header, the record data follows the header */
+typedef struct
+{
+	/* the record size including header */
+	trx_uint32_t	size;
+	/* the record state, set by producer when record is committed and reset by consumer when it's released */
+	trx_uint32_t	state;
+}
+trx_ringbuf_record_t;
+
+#define TRX_RINGBUF_ALIGN(size)	(((size) + 7) & ~(size_t)7)
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ringbuf_record_at                                                *
+ *                                                                            *
+ * Purpose: returns record header at the specified ring buffer position       *
+ *                                                                            *
+ ******************************************************************************/
+static trx_ringbuf_record_t	*ringbuf_record_at(trx_ringbuf_t *ring, trx_uint64_t pos)
+{
+	return (trx_ringbuf_record_t *)((unsigned char *)(ring + 1) + (pos & (ring->size - 1)));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_ringbuf_required_size                                        *
+ *                                                                            *
+ * Purpose: calculates memory size required to store ring buffer with the     *
+ *          specified data size                                               *
+ *                                                                            *
+ * Parameters: size - [IN] the ring buffer data size, must be power of 2      *
+ *                                                                            *
+ * Return value: The required memory size                                     *
+ *                                                                            *
+ ******************************************************************************/
+size_t	trx_ringbuf_required_size(size_t size)
+{
+	return sizeof(trx_ringbuf_t) + size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_ringbuf_init                                                 *
+ *                                                                            *
+ * Purpose: initializes ring buffer in the specified memory                   *
+ *                                                                            *
+ * Parameters: mem  - [IN] the memory to store ring buffer, 8 byte aligned    *
+ *             size - [IN] the ring buffer data size, must be power of 2      *
+ *                                                                            *
+ * Return value: The initialized ring buffer                                  *
+ *                                                                            *
+ * Comments: The memory must be at least trx_ringbuf_required_size(size)      *
+ *           bytes large. When placed in shared memory the ring buffer can be *
+ *           used by multiple producer processes and a single consumer        *
+ *           process.                                                         *
+ *                                                                            *
+ ******************************************************************************/
+trx_ringbuf_t	*trx_ringbuf_init(void *mem, size_t size)
+{
+	trx_ringbuf_t	*ring = (trx_ringbuf_t *)mem;
+
+	memset(ring, 0, trx_ringbuf_required_size(size));
+	ring->size = size;
+
+	return ring;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_ringbuf_reserve                                              *
+ *                                                                            *
+ * Purpose: reserves a record in ring buffer                                  *
+ *                                                                            *
+ * Parameters: ring - [IN] the ring buffer                                    *
+ *             size - [IN] the record data size                               *
+ *                                                                            *
+ * Return value: Pointer to the record data or NULL if ring buffer does not   *
+ *               have enough free space.                                      *
+ *                                                                            *
+ * Comments: Records are never split - if the record does not fit at the end  *
+ *           of ring buffer, the remaining space is reserved as padding and   *
+ *           record is placed at the start of ring buffer.                    *
+ *           The reserved record must be committed with trx_ringbuf_commit()  *
+ *           after the data is written. Consumer will not see the following   *
+ *           records until this record is committed.                          *
+ *                                                                            *
+ ******************************************************************************/
+void	*trx_ringbuf_reserve(trx_ringbuf_t *ring, size_t size)
+{
+	trx_uint64_t		pos, offset, padding, record_size;
+	trx_ringbuf_record_t	*record;
+
+	record_size = TRX_RINGBUF_ALIGN(sizeof(trx_ringbuf_record_t) + size);
+
+	if (record_size > ring->size)
+		return NULL;
+
+	pos = __atomic_load_n(&ring->reserved, __ATOMIC_RELAXED);
+
+	do
+	{
+		offset = pos & (ring->size - 1);
+		padding = (offset + record_size > ring->size ? ring->size - offset : 0);
+
+		/* acquire ordering ensures consumer has finished with the released records */
+		if (pos + padding + record_size - __atomic_load_n(&ring->released, __ATOMIC_ACQUIRE) > ring->size)
+			return NULL;
+	}
+	while (0 == __atomic_compare_exchange_n(&ring->reserved, &pos, pos + padding + record_size, 1,
+			__ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+	if (0 != padding)
+	{
+		record = ringbuf_record_at(ring, pos);
+		record->size = (trx_uint32_t)padding;
+		__atomic_store_n(&record->state, TRX_RINGBUF_RECORD_PADDING, __ATOMIC_RELEASE);
+		pos += padding;
+	}
+
+	record = ringbuf_record_at(ring, pos);
+	record->size = (trx_uint32_t)record_size;
+
+	return record + 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_ringbuf_commit                                               *
+ *                                                                            *
+ * Purpose: makes reserved record visible to consumer                         *
+ *                                                                            *
+ * Parameters: data - [IN] the record data returned by trx_ringbuf_reserve()  *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_ringbuf_commit(void *data)
+{
+	trx_ringbuf_record_t	*record = (trx_ringbuf_record_t *)data - 1;
+
+	__atomic_store_n(&record->state, TRX_RINGBUF_RECORD_DATA, __ATOMIC_RELEASE);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_ringbuf_read                                                 *
+ *                                                                            *
+ * Purpose: reads the next committed record from ring buffer                  *
+ *                                                                            *
+ * Parameters: ring - [IN] the ring buffer                                    *
+ *             size - [OUT] the record data size (aligned to 8 bytes)         *
+ *                                                                            *
+ * Return value: Pointer to the record data or NULL if there are no more      *
+ *               committed records.                                           *
+ *                                                                            *
+ * Comments: The returned record stays valid until it's released with         *
+ *           trx_ringbuf_release() function.                                  *
+ *           This function must be called only by the consumer process.       *
+ *                                                                            *
+ ******************************************************************************/
+void	*trx_ringbuf_read(trx_ringbuf_t *ring, size_t *size)
+{
+	trx_ringbuf_record_t	*record;
+
+	while (1)
+	{
+		/* the whole ring buffer is read, but not yet released */
+		if (ring->read - ring->released >= ring->size)
+			return NULL;
+
+		record = ringbuf_record_at(ring, ring->read);
+
+		switch (__atomic_load_n(&record->state, __ATOMIC_ACQUIRE))
+		{
+			case TRX_RINGBUF_RECORD_FREE:
+				return NULL;
+			case TRX_RINGBUF_RECORD_PADDING:
+				ring->read += record->size;
+				continue;
+		}
+
+		ring->read += record->size;
+		*size = record->size - sizeof(trx_ringbuf_record_t);
+
+		return record + 1;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_ringbuf_release                                              *
+ *                                                                            *
+ * Purpose: frees the records read by consumer for reuse by producers         *
+ *                                                                            *
+ * Parameters: ring - [IN] the ring buffer                                    *
+ *                                                                            *
+ * Comments: This function must be called only by the consumer process.       *
+ *           Released records are zeroed because records of different sizes   *
+ *           will be reserved over them and any stale data at the new record  *
+ *           header positions would be read as committed records.             *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_ringbuf_release(trx_ringbuf_t *ring)
+{
+	trx_uint64_t		pos;
+	trx_ringbuf_record_t	*record;
+	trx_uint32_t		size;
+
+	for (pos = ring->released; pos != ring->read; pos += size)
+	{
+		record = ringbuf_record_at(ring, pos);
+		size = record->size;
+		memset(record, 0, size);
+	}
+
+	__atomic_store_n(&ring->released, ring->read, __ATOMIC_RELEASE);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_ringbuf_rewind                                               *
+ *                                                                            *
+ * Purpose: moves consumer read position back to the first unreleased record  *
+ *                                                                            *
+ * Parameters: ring - [IN] the ring buffer                                    *
+ *                                                                            *
+ * Comments: The records read but not released are returned again by the      *
+ *           following trx_ringbuf_read() calls.                              *
+ *           This function must be called only by the consumer process.       *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_ringbuf_rewind(trx_ringbuf_t *ring)
+{
+	ring->read = ring->released;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_ringbuf_get_reserved                                         *
+ *                                                                            *
+ * Purpose: returns the ring buffer position after the last reserved record   *
+ *                                                                            *
+ * Parameters: ring - [IN] the ring buffer                                    *
+ *                                                                            *
+ * Return value: The ring buffer position                                     *
+ *                                                                            *
+ ******************************************************************************/
+trx_uint64_t	trx_ringbuf_get_reserved(trx_ringbuf_t *ring)
+{
+	return __atomic_load_n(&ring->reserved, __ATOMIC_ACQUIRE);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_ringbuf_is_released                                          *
+ *                                                                            *
+ * Purpose: checks if consumer has released all records before the specified  *
+ *          position                                                          *
+ *                                                                            *
+ * Parameters: ring - [IN] the ring buffer                                    *
+ *             pos  - [IN] the position returned by                           *
+ *                         trx_ringbuf_get_reserved() function                *
+ *                                                                            *
+ * Return value: SUCCEED - the records are released                           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_ringbuf_is_released(trx_ringbuf_t *ring, trx_uint64_t pos)
+{
+	return pos <= __atomic_load_n(&ring->released, __ATOMIC_ACQUIRE) ? SUCCEED : FAIL;
+}
+
+#endif
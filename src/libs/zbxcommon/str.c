@@ -1233,6 +1233,10 @@ const char	*get_process_type_string(unsigned char proc_type)
 			return "lld worker";
 		case TRX_PROCESS_TYPE_ALERTSYNCER:
 			return "alert syncer";
+		case TRX_PROCESS_TYPE_AGENTPOLLER:
+			return "agent poller";
+		case TRX_PROCESS_TYPE_HTTPAGENT_POLLER:
+			return "http agent poller";
 	}
 
 	THIS_SHOULD_NEVER_HAPPEN;
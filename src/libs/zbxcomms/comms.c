@@ -803,9 +803,6 @@ static ssize_t	trx_tcp_write(trx_socket_t *s, const char *buf, size_t len)
  *                                                                            *
  ******************************************************************************/
 
-#define TRX_TCP_HEADER_DATA	"TRXD"
-#define TRX_TCP_HEADER_LEN	TRX_CONST_STRLEN(TRX_TCP_HEADER_DATA)
-
 int	trx_tcp_send_ext(trx_socket_t *s, const char *data, size_t len, unsigned char flags, int timeout)
 {
 #define TRX_TLS_MAX_REC_LEN	16384
@@ -2000,6 +1997,443 @@ out:
 	return (TRX_PROTO_ERROR == nbytes ? FAIL : (ssize_t)(s->read_bytes));
 }
 
+#ifndef _WINDOWS
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_tcp_connect_nonblocking                                      *
+ *                                                                            *
+ * Purpose: start connecting non-blocking socket to the specified address     *
+ *                                                                            *
+ * Parameters: s         - [OUT] socket descriptor                            *
+ *             source_ip - [IN] the source address to bind to, optional       *
+ *             addr      - [IN] the address to connect to                     *
+ *             addrlen   - [IN] the length of addr structure                  *
+ *             peer      - [IN] peer name for diagnostics                     *
+ *                                                                            *
+ * Return value: SUCCEED - connection is established or in progress, call     *
+ *                         trx_tcp_connect_check() when socket becomes        *
+ *                         writable                                           *
+ *               FAIL    - an error occurred                                  *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_tcp_connect_nonblocking(trx_socket_t *s, const char *source_ip, const struct sockaddr *addr,
+		socklen_t addrlen, const char *peer)
+{
+	int	flags;
+
+	trx_socket_clean(s);
+	trx_strlcpy(s->peer, peer, sizeof(s->peer));
+
+	if (TRX_SOCKET_ERROR == (s->socket = socket(addr->sa_family, SOCK_STREAM | SOCK_CLOEXEC, 0)))
+	{
+		trx_set_socket_strerror("cannot create socket [%s]: %s", peer,
+				strerror_from_system(trx_socket_last_error()));
+		return FAIL;
+	}
+#if !SOCK_CLOEXEC
+	fcntl(s->socket, F_SETFD, FD_CLOEXEC);
+#endif
+	if (-1 == (flags = fcntl(s->socket, F_GETFL, 0)) || -1 == fcntl(s->socket, F_SETFL, flags | O_NONBLOCK))
+	{
+		trx_set_socket_strerror("cannot set non-blocking mode for socket [%s]: %s", peer,
+				strerror_from_system(trx_socket_last_error()));
+		goto fail;
+	}
+
+	if (NULL != source_ip)
+	{
+#ifdef HAVE_IPV6
+		struct addrinfo	*ai_bind = NULL, hints;
+
+		memset(&hints, 0x00, sizeof(struct addrinfo));
+		hints.ai_family = PF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_flags = AI_NUMERICHOST;
+
+		if (0 != getaddrinfo(source_ip, NULL, &hints, &ai_bind))
+		{
+			trx_set_socket_strerror("invalid source IP address [%s]", source_ip);
+			goto fail;
+		}
+
+		if (TRX_PROTO_ERROR == trx_bind(s->socket, ai_bind->ai_addr, ai_bind->ai_addrlen))
+		{
+			trx_set_socket_strerror("bind() failed: %s", strerror_from_system(trx_socket_last_error()));
+			freeaddrinfo(ai_bind);
+			goto fail;
+		}
+
+		freeaddrinfo(ai_bind);
+#else
+		TRX_SOCKADDR	source_addr;
+
+		memset(&source_addr, 0, sizeof(source_addr));
+
+		source_addr.sin_family = AF_INET;
+		source_addr.sin_addr.s_addr = inet_addr(source_ip);
+		source_addr.sin_port = 0;
+
+		if (TRX_PROTO_ERROR == bind(s->socket, (struct sockaddr *)&source_addr, sizeof(source_addr)))
+		{
+			trx_set_socket_strerror("bind() failed: %s", strerror_from_system(trx_socket_last_error()));
+			goto fail;
+		}
+#endif
+	}
+
+	if (TRX_PROTO_ERROR == connect(s->socket, addr, addrlen) && EINPROGRESS != trx_socket_last_error())
+	{
+		trx_set_socket_strerror("cannot connect to [%s]: %s", peer,
+				strerror_from_system(trx_socket_last_error()));
+		goto fail;
+	}
+
+	s->connection_type = TRX_TCP_SEC_UNENCRYPTED;
+
+	return SUCCEED;
+fail:
+	trx_socket_close(s->socket);
+	s->socket = TRX_SOCKET_ERROR;
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_tcp_connect_check                                            *
+ *                                                                            *
+ * Purpose: check result of non-blocking connect                              *
+ *                                                                            *
+ * Parameters: s - [IN] socket descriptor, writable after                     *
+ *                      trx_tcp_connect_nonblocking()                         *
+ *                                                                            *
+ * Return value: SUCCEED - connection is established                          *
+ *               FAIL    - connection failed                                  *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_tcp_connect_check(trx_socket_t *s)
+{
+	int		socket_error = 0;
+	socklen_t	socket_error_len = sizeof(socket_error);
+
+	if (TRX_PROTO_ERROR == getsockopt(s->socket, SOL_SOCKET, SO_ERROR, &socket_error, &socket_error_len))
+	{
+		trx_set_socket_strerror("cannot connect to [%s]: cannot obtain error code: %s", s->peer,
+				strerror_from_system(trx_socket_last_error()));
+		return FAIL;
+	}
+
+	if (0 != socket_error)
+	{
+		trx_set_socket_strerror("cannot connect to [%s]: %s", s->peer, trx_strerror(socket_error));
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_tcp_tls_connect_nonblocking                                  *
+ *                                                                            *
+ * Purpose: advance TLS handshake over connected non-blocking socket          *
+ *                                                                            *
+ * Parameters: s           - [IN] socket descriptor                           *
+ *             tls_connect - [IN] TRX_TCP_SEC_TLS_CERT or TRX_TCP_SEC_TLS_PSK *
+ *             tls_arg1    - [IN] issuer or PSK identity                      *
+ *             tls_arg2    - [IN] subject or PSK                              *
+ *             want        - [OUT] TRX_SOCKET_WANT_READ or                    *
+ *                                 TRX_SOCKET_WANT_WRITE if the handshake is  *
+ *                                 in progress, 0 if it is completed          *
+ *                                                                            *
+ * Return value: SUCCEED - the handshake is completed or in progress          *
+ *               FAIL    - an error occurred                                  *
+ *                                                                            *
+ * Comments: Only OpenSSL build supports non-blocking TLS connections,        *
+ *           callers must use blocking trx_tcp_connect() with other TLS       *
+ *           libraries.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_tcp_tls_connect_nonblocking(trx_socket_t *s, unsigned int tls_connect, const char *tls_arg1,
+		const char *tls_arg2, int *want)
+{
+#if defined(HAVE_OPENSSL)
+	char	*error = NULL;
+
+	if (SUCCEED != trx_tls_connect_nonblocking(s, tls_connect, tls_arg1, tls_arg2, want, &error))
+	{
+		trx_set_socket_strerror("TCP successful, cannot establish TLS to [%s]: %s", s->peer, error);
+		trx_free(error);
+		return FAIL;
+	}
+
+	return SUCCEED;
+#else
+	TRX_UNUSED(tls_connect);
+	TRX_UNUSED(tls_arg1);
+	TRX_UNUSED(tls_arg2);
+
+	*want = 0;
+	trx_set_socket_strerror("TCP successful, cannot establish TLS to [%s]: non-blocking TLS connections are"
+			" supported only with OpenSSL", s->peer);
+
+	return FAIL;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_tcp_write_nonblocking                                        *
+ *                                                                            *
+ * Purpose: write data to non-blocking socket                                 *
+ *                                                                            *
+ * Parameters: s    - [IN] socket descriptor                                  *
+ *             buf  - [IN] the data                                           *
+ *             len  - [IN] the data length                                    *
+ *             want - [OUT] TRX_SOCKET_WANT_READ or TRX_SOCKET_WANT_WRITE if  *
+ *                          nothing could be written now                      *
+ *                                                                            *
+ * Return value: number of bytes written, 0 if the write must be repeated     *
+ *               (see want) or TRX_PROTO_ERROR                                *
+ *                                                                            *
+ ******************************************************************************/
+ssize_t	trx_tcp_write_nonblocking(trx_socket_t *s, const char *buf, size_t len, int *want)
+{
+	ssize_t	res;
+	int	err;
+
+	*want = 0;
+#if defined(HAVE_OPENSSL)
+	if (NULL != s->tls_ctx)
+	{
+		char	*error = NULL;
+
+		if (TRX_PROTO_ERROR == (res = trx_tls_write_nonblocking(s, buf, len, want, &error)))
+		{
+			trx_set_socket_strerror("%s", error);
+			trx_free(error);
+		}
+
+		return res;
+	}
+#endif
+	if (TRX_PROTO_ERROR == (res = TRX_TCP_WRITE(s->socket, buf, len)))
+	{
+		if (EAGAIN == (err = trx_socket_last_error()) || EWOULDBLOCK == err || TRX_PROTO_AGAIN == err)
+		{
+			*want = TRX_SOCKET_WANT_WRITE;
+			return 0;
+		}
+
+		trx_set_socket_strerror("TRX_TCP_WRITE() failed: %s", strerror_from_system(err));
+	}
+
+	return res;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_tcp_read_nonblocking                                         *
+ *                                                                            *
+ * Purpose: read data from non-blocking socket                                *
+ *                                                                            *
+ * Parameters: s    - [IN] socket descriptor                                  *
+ *             buf  - [OUT] the buffer                                        *
+ *             len  - [IN] the buffer size                                    *
+ *             want - [OUT] TRX_SOCKET_WANT_READ or TRX_SOCKET_WANT_WRITE if  *
+ *                          nothing could be read now                         *
+ *                                                                            *
+ * Return value: number of bytes read, 0 if the read must be repeated (want   *
+ *               is set) or connection was closed by peer (want is 0) or      *
+ *               TRX_PROTO_ERROR                                              *
+ *                                                                            *
+ ******************************************************************************/
+ssize_t	trx_tcp_read_nonblocking(trx_socket_t *s, char *buf, size_t len, int *want)
+{
+	ssize_t	res;
+	int	err;
+
+	*want = 0;
+#if defined(HAVE_OPENSSL)
+	if (NULL != s->tls_ctx)
+	{
+		char	*error = NULL;
+
+		if (TRX_PROTO_ERROR == (res = trx_tls_read_nonblocking(s, buf, len, want, &error)))
+		{
+			trx_set_socket_strerror("%s", error);
+			trx_free(error);
+		}
+
+		return res;
+	}
+#endif
+	if (TRX_PROTO_ERROR == (res = TRX_TCP_READ(s->socket, buf, len)))
+	{
+		if (EAGAIN == (err = trx_socket_last_error()) || EWOULDBLOCK == err || TRX_PROTO_AGAIN == err)
+		{
+			*want = TRX_SOCKET_WANT_READ;
+			return 0;
+		}
+
+		trx_set_socket_strerror("TRX_TCP_READ() failed: %s", strerror_from_system(err));
+	}
+
+	return res;
+}
+#endif	/* _WINDOWS */
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_tcp_pack_message                                             *
+ *                                                                            *
+ * Purpose: append Treegix protocol message to the buffer                     *
+ *                                                                            *
+ * Parameters: buf        - [IN/OUT] the buffer                               *
+ *             buf_alloc  - [IN/OUT] the buffer size                          *
+ *             buf_offset - [IN/OUT] the used buffer size                     *
+ *             data       - [IN] the message data                             *
+ *             len        - [IN] the message data length                      *
+ *                                                                            *
+ * Comments: The message is packed the same way as trx_tcp_send() sends it -  *
+ *           protocol header, data length and uncompressed data.              *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_tcp_pack_message(char **buf, size_t *buf_alloc, size_t *buf_offset, const char *data, size_t len)
+{
+	trx_uint32_t	len32_le;
+	size_t		need;
+
+	need = *buf_offset + TRX_TCP_HEADER_LEN + 1 + 2 * sizeof(trx_uint32_t) + len;
+
+	if (need > *buf_alloc)
+	{
+		while (need > *buf_alloc)
+			*buf_alloc = (0 == *buf_alloc ? TRX_STAT_BUF_LEN : *buf_alloc * 2);
+
+		*buf = (char *)trx_realloc(*buf, *buf_alloc);
+	}
+
+	memcpy(*buf + *buf_offset, TRX_TCP_HEADER_DATA, TRX_TCP_HEADER_LEN);
+	*buf_offset += TRX_TCP_HEADER_LEN;
+
+	(*buf)[(*buf_offset)++] = TRX_TCP_PROTOCOL;
+
+	len32_le = trx_htole_uint32((trx_uint32_t)len);
+	memcpy(*buf + *buf_offset, &len32_le, sizeof(len32_le));
+	*buf_offset += sizeof(len32_le);
+
+	len32_le = 0;
+	memcpy(*buf + *buf_offset, &len32_le, sizeof(len32_le));
+	*buf_offset += sizeof(len32_le);
+
+	memcpy(*buf + *buf_offset, data, len);
+	*buf_offset += len;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_tcp_unpack_message                                           *
+ *                                                                            *
+ * Purpose: extract Treegix protocol message from received data               *
+ *                                                                            *
+ * Parameters: buf         - [IN] the received data                           *
+ *             buf_len     - [IN] the received data length                    *
+ *             message_len - [OUT] length of the message including header,    *
+ *                                 0 if more data must be received            *
+ *             data        - [OUT] the message data, uncompressed and         *
+ *                                 terminated with '\0', must be freed by     *
+ *                                 caller                                     *
+ *             data_len    - [OUT] the message data length                    *
+ *                                                                            *
+ * Return value: SUCCEED - a complete message was extracted or more data must *
+ *                         be received (message_len is 0)                     *
+ *               FAIL    - the data is not a valid message, error message is  *
+ *                         available with trx_socket_strerror()               *
+ *                                                                            *
+ * Comments: Receiver of non-blocking socket accumulates data and calls this  *
+ *           function after each read, it does not wait for connection to be  *
+ *           closed when message length is known.                             *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_tcp_unpack_message(const char *buf, size_t buf_len, size_t *message_len, char **data, size_t *data_len)
+{
+	const size_t	header_len = TRX_TCP_HEADER_LEN + 1 + 2 * sizeof(trx_uint32_t);
+	trx_uint32_t	expected_len, reserved;
+	unsigned char	protocol_version;
+
+	*message_len = 0;
+
+	if (TRX_TCP_HEADER_LEN > buf_len)
+	{
+		if (0 != strncmp(buf, TRX_TCP_HEADER_DATA, buf_len))
+			goto header;
+
+		return SUCCEED;
+	}
+
+	if (0 != strncmp(buf, TRX_TCP_HEADER_DATA, TRX_TCP_HEADER_LEN))
+		goto header;
+
+	if (header_len > buf_len)
+		return SUCCEED;
+
+	protocol_version = (unsigned char)buf[TRX_TCP_HEADER_LEN];
+
+	if (0 == (protocol_version & TRX_TCP_PROTOCOL) || protocol_version > (TRX_TCP_PROTOCOL | TRX_TCP_COMPRESS))
+	{
+		trx_set_socket_strerror("unsupported protocol version \"%d\"", (int)protocol_version);
+		return FAIL;
+	}
+
+	memcpy(&expected_len, buf + TRX_TCP_HEADER_LEN + 1, sizeof(trx_uint32_t));
+	expected_len = trx_letoh_uint32(expected_len);
+
+	memcpy(&reserved, buf + TRX_TCP_HEADER_LEN + 1 + sizeof(trx_uint32_t), sizeof(trx_uint32_t));
+	reserved = trx_letoh_uint32(reserved);
+
+	if (TRX_MAX_RECV_DATA_SIZE < expected_len ||
+			(0 != (protocol_version & TRX_TCP_COMPRESS) && TRX_MAX_RECV_DATA_SIZE < reserved))
+	{
+		trx_set_socket_strerror("message size exceeds the maximum size " TRX_FS_UI64 " bytes",
+				(trx_uint64_t)TRX_MAX_RECV_DATA_SIZE);
+		return FAIL;
+	}
+
+	if (header_len + expected_len > buf_len)
+		return SUCCEED;
+
+	if (0 != (protocol_version & TRX_TCP_COMPRESS))
+	{
+		size_t	out_size = reserved;
+
+		*data = (char *)trx_malloc(NULL, reserved + 1);
+
+		if (FAIL == trx_uncompress(buf + header_len, expected_len, *data, &out_size) || out_size != reserved)
+		{
+			trx_free(*data);
+			trx_set_socket_strerror("cannot uncompress data: %s", trx_compress_strerror());
+			return FAIL;
+		}
+
+		*data_len = reserved;
+	}
+	else
+	{
+		*data = (char *)trx_malloc(NULL, expected_len + 1);
+		memcpy(*data, buf + header_len, expected_len);
+		*data_len = expected_len;
+	}
+
+	(*data)[*data_len] = '\0';
+	*message_len = header_len + expected_len;
+
+	return SUCCEED;
+header:
+	trx_set_socket_strerror("message is missing header");
+	return FAIL;
+}
+
 static int	subnet_match(int af, unsigned int prefix_size, const void *address1, const void *address2)
 {
 	unsigned char	netmask[16] = {0};
@@ -4247,17 +4247,27 @@ out1:
 	return ret;
 }
 #elif defined(HAVE_OPENSSL)
-int	trx_tls_connect(trx_socket_t *s, unsigned int tls_connect, const char *tls_arg1, const char *tls_arg2,
-		char **error)
+/******************************************************************************
+ *                                                                            *
+ * Function: tls_connect_init                                                 *
+ *                                                                            *
+ * Purpose: create TLS connection context over an established TCP connection  *
+ *                                                                            *
+ * Parameters: s           - [IN] socket with opened connection               *
+ *             tls_connect - [IN] TRX_TCP_SEC_TLS_CERT or TRX_TCP_SEC_TLS_PSK *
+ *             tls_arg1    - [IN] see trx_tls_connect()                       *
+ *             tls_arg2    - [IN] see trx_tls_connect()                       *
+ *             error       - [OUT] dynamically allocated memory with error    *
+ *                                 message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the context was created and attached to socket     *
+ *               FAIL    - an error occurred                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	tls_connect_init(trx_socket_t *s, unsigned int tls_connect, const char *tls_arg1,
+		const char *tls_arg2, char **error)
 {
-	int	ret = FAIL, res;
 	size_t	error_alloc = 0, error_offset = 0;
-#if defined(_WINDOWS)
-	double	sec;
-#endif
-#if defined(HAVE_OPENSSL_WITH_PSK)
-	char	psk_buf[HOST_TLS_PSK_LEN / 2];
-#endif
 
 	s->tls_ctx = trx_malloc(s->tls_ctx, sizeof(trx_tls_context_t));
 	s->tls_ctx->ctx = NULL;
@@ -4298,43 +4308,6 @@ int	trx_tls_connect(trx_socket_t *s, unsigned int tls_connect, const char *tls_a
 			trx_tls_error_msg(error, &error_alloc, &error_offset);
 			goto out;
 		}
-
-		if (NULL == tls_arg2)	/* PSK is not set from DB */
-		{
-			/* Set up PSK global variables from a configuration file (always in agentd and a case when */
-			/* active proxy connects to server). Here we set it only in case of active proxy */
-			/* because for other programs it has already been set in trx_tls_init_child(). */
-
-			if (0 != (program_type & TRX_PROGRAM_TYPE_PROXY_ACTIVE))
-			{
-				psk_identity_for_cb = my_psk_identity;
-				psk_identity_len_for_cb = my_psk_identity_len;
-				psk_for_cb = my_psk;
-				psk_len_for_cb = my_psk_len;
-			}
-		}
-		else
-		{
-			/* PSK comes from a database (case for a server/proxy when it connects to an agent for */
-			/* passive checks, for a server when it connects to a passive proxy) */
-
-			int	psk_len;
-
-			if (0 >= (psk_len = trx_psk_hex2bin((const unsigned char *)tls_arg2, (unsigned char *)psk_buf,
-					sizeof(psk_buf))))
-			{
-				*error = trx_strdup(*error, "invalid PSK");
-				goto out;
-			}
-
-			/* some data reside in stack but it will be available at the time when a PSK client callback */
-			/* function copies the data into buffers provided by OpenSSL within the callback */
-			psk_identity_for_cb = tls_arg1;			/* string is on stack */
-			/* NULL check to silence analyzer warning */
-			psk_identity_len_for_cb = (NULL == tls_arg1 ? 0 : strlen(tls_arg1));
-			psk_for_cb = psk_buf;				/* buffer is on stack */
-			psk_len_for_cb = (size_t)psk_len;
-		}
 #else
 		*error = trx_strdup(*error, "cannot connect with TLS and PSK: support for PSK was not compiled in");
 		goto out;
@@ -4344,7 +4317,7 @@ int	trx_tls_connect(trx_socket_t *s, unsigned int tls_connect, const char *tls_a
 	{
 		*error = trx_strdup(*error, "invalid connection parameters");
 		THIS_SHOULD_NEVER_HAPPEN;
-		goto out1;
+		goto out;
 	}
 
 	/* set our connected TCP socket to TLS context */
@@ -4354,95 +4327,193 @@ int	trx_tls_connect(trx_socket_t *s, unsigned int tls_connect, const char *tls_a
 		goto out;
 	}
 
-	/* TLS handshake */
+	return SUCCEED;
+out:
+	if (NULL != s->tls_ctx->ctx)
+		SSL_free(s->tls_ctx->ctx);
 
-	info_buf[0] = '\0';	/* empty buffer for trx_openssl_info_cb() messages */
-#if defined(_WINDOWS)
-	trx_alarm_flag_clear();
-	sec = trx_time();
-#endif
-	if (1 != (res = SSL_connect(s->tls_ctx->ctx)))
+	trx_free(s->tls_ctx);
+
+	return FAIL;
+}
+
+#if defined(HAVE_OPENSSL_WITH_PSK)
+/******************************************************************************
+ *                                                                            *
+ * Function: tls_connect_set_psk                                              *
+ *                                                                            *
+ * Purpose: set up PSK global variables for PSK client callback function      *
+ *                                                                            *
+ * Parameters: tls_arg1     - [IN] PSK identity                               *
+ *             tls_arg2     - [IN] PSK in hex-string or NULL if PSK is not    *
+ *                                 set from database                          *
+ *             psk_buf      - [OUT] buffer for PSK in binary form             *
+ *             psk_buf_size - [IN] size of psk_buf                            *
+ *             error        - [OUT] dynamically allocated memory with error   *
+ *                                  message                                   *
+ *                                                                            *
+ * Return value: SUCCEED - PSK variables were set                             *
+ *               FAIL    - invalid PSK                                        *
+ *                                                                            *
+ * Comments: PSK identity and psk_buf must be available while the handshake   *
+ *           step with SSL_connect() is performed.                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	tls_connect_set_psk(const char *tls_arg1, const char *tls_arg2, char *psk_buf, size_t psk_buf_size,
+		char **error)
+{
+	if (NULL == tls_arg2)	/* PSK is not set from DB */
 	{
-		int	result_code;
+		/* Set up PSK global variables from a configuration file (always in agentd and a case when */
+		/* active proxy connects to server). Here we set it only in case of active proxy */
+		/* because for other programs it has already been set in trx_tls_init_child(). */
 
-#if defined(_WINDOWS)
-		if (s->timeout < trx_time() - sec)
-			trx_alarm_flag_set();
-#endif
-		if (SUCCEED == trx_alarm_timed_out())
+		if (0 != (program_type & TRX_PROGRAM_TYPE_PROXY_ACTIVE))
 		{
-			*error = trx_strdup(*error, "SSL_connect() timed out");
-			goto out;
+			psk_identity_for_cb = my_psk_identity;
+			psk_identity_len_for_cb = my_psk_identity_len;
+			psk_for_cb = my_psk;
+			psk_len_for_cb = my_psk_len;
 		}
+	}
+	else
+	{
+		/* PSK comes from a database (case for a server/proxy when it connects to an agent for */
+		/* passive checks, for a server when it connects to a passive proxy) */
 
-		if (TRX_TCP_SEC_TLS_CERT == tls_connect)
-		{
-			long	verify_result;
+		int	psk_len;
 
-			/* In case of certificate error SSL_get_verify_result() provides more helpful diagnostics */
-			/* than other methods. Include it as first but continue with other diagnostics. */
-			if (X509_V_OK != (verify_result = SSL_get_verify_result(s->tls_ctx->ctx)))
-			{
-				trx_snprintf_alloc(error, &error_alloc, &error_offset, "%s: ",
-						X509_verify_cert_error_string(verify_result));
-			}
+		if (0 >= (psk_len = trx_psk_hex2bin((const unsigned char *)tls_arg2, (unsigned char *)psk_buf,
+				psk_buf_size)))
+		{
+			*error = trx_strdup(*error, "invalid PSK");
+			return FAIL;
 		}
 
-		result_code = SSL_get_error(s->tls_ctx->ctx, res);
+		/* some data reside in stack but it will be available at the time when a PSK client callback */
+		/* function copies the data into buffers provided by OpenSSL within the callback */
+		psk_identity_for_cb = tls_arg1;			/* string is on stack */
+		/* NULL check to silence analyzer warning */
+		psk_identity_len_for_cb = (NULL == tls_arg1 ? 0 : strlen(tls_arg1));
+		psk_for_cb = psk_buf;				/* buffer is on stack */
+		psk_len_for_cb = (size_t)psk_len;
+	}
 
-		switch (result_code)
+	return SUCCEED;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: tls_connect_strerror                                             *
+ *                                                                            *
+ * Purpose: describe failed SSL_connect() call                                *
+ *                                                                            *
+ * Parameters: s           - [IN] socket with TLS context                     *
+ *             tls_connect - [IN] TRX_TCP_SEC_TLS_CERT or TRX_TCP_SEC_TLS_PSK *
+ *             res         - [IN] value returned by SSL_connect()             *
+ *             error       - [OUT] dynamically allocated memory with error    *
+ *                                 message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - SSL_connect() reported no error                    *
+ *               FAIL    - the handshake failed                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	tls_connect_strerror(const trx_socket_t *s, unsigned int tls_connect, int res, char **error)
+{
+	int	result_code;
+	size_t	error_alloc = 0, error_offset = 0;
+
+	if (TRX_TCP_SEC_TLS_CERT == tls_connect)
+	{
+		long	verify_result;
+
+		/* In case of certificate error SSL_get_verify_result() provides more helpful diagnostics */
+		/* than other methods. Include it as first but continue with other diagnostics. */
+		if (X509_V_OK != (verify_result = SSL_get_verify_result(s->tls_ctx->ctx)))
 		{
-			case SSL_ERROR_NONE:		/* handshake successful */
-				break;
-			case SSL_ERROR_ZERO_RETURN:
-				trx_snprintf_alloc(error, &error_alloc, &error_offset,
-						"TLS connection has been closed during handshake");
-				goto out;
-			case SSL_ERROR_SYSCALL:
-				if (0 == ERR_peek_error())
+			trx_snprintf_alloc(error, &error_alloc, &error_offset, "%s: ",
+					X509_verify_cert_error_string(verify_result));
+		}
+	}
+
+	result_code = SSL_get_error(s->tls_ctx->ctx, res);
+
+	switch (result_code)
+	{
+		case SSL_ERROR_NONE:		/* handshake successful */
+			return SUCCEED;
+		case SSL_ERROR_ZERO_RETURN:
+			trx_snprintf_alloc(error, &error_alloc, &error_offset,
+					"TLS connection has been closed during handshake");
+			break;
+		case SSL_ERROR_SYSCALL:
+			if (0 == ERR_peek_error())
+			{
+				if (0 == res)
 				{
-					if (0 == res)
-					{
-						trx_snprintf_alloc(error, &error_alloc, &error_offset,
-								"connection closed by peer");
-					}
-					else if (-1 == res)
-					{
-						trx_snprintf_alloc(error, &error_alloc, &error_offset, "SSL_connect()"
-								" I/O error: %s",
-								strerror_from_system(trx_socket_last_error()));
-					}
-					else
-					{
-						/* "man SSL_get_error" describes only res == 0 and res == -1 for */
-						/* SSL_ERROR_SYSCALL case */
-						trx_snprintf_alloc(error, &error_alloc, &error_offset, "SSL_connect()"
-								" returned undocumented code %d", res);
-					}
+					trx_snprintf_alloc(error, &error_alloc, &error_offset,
+							"connection closed by peer");
+				}
+				else if (-1 == res)
+				{
+					trx_snprintf_alloc(error, &error_alloc, &error_offset, "SSL_connect()"
+							" I/O error: %s",
+							strerror_from_system(trx_socket_last_error()));
 				}
 				else
 				{
-					trx_snprintf_alloc(error, &error_alloc, &error_offset, "SSL_connect() set"
-							" result code to SSL_ERROR_SYSCALL:");
-					trx_tls_error_msg(error, &error_alloc, &error_offset);
-					trx_snprintf_alloc(error, &error_alloc, &error_offset, "%s", info_buf);
+					/* "man SSL_get_error" describes only res == 0 and res == -1 for */
+					/* SSL_ERROR_SYSCALL case */
+					trx_snprintf_alloc(error, &error_alloc, &error_offset, "SSL_connect()"
+							" returned undocumented code %d", res);
 				}
-				goto out;
-			case SSL_ERROR_SSL:
+			}
+			else
+			{
 				trx_snprintf_alloc(error, &error_alloc, &error_offset, "SSL_connect() set"
-						" result code to SSL_ERROR_SSL:");
+						" result code to SSL_ERROR_SYSCALL:");
 				trx_tls_error_msg(error, &error_alloc, &error_offset);
 				trx_snprintf_alloc(error, &error_alloc, &error_offset, "%s", info_buf);
-				goto out;
-			default:
-				trx_snprintf_alloc(error, &error_alloc, &error_offset, "SSL_connect() set result code"
-						" to %d", result_code);
-				trx_tls_error_msg(error, &error_alloc, &error_offset);
-				trx_snprintf_alloc(error, &error_alloc, &error_offset, "%s", info_buf);
-				goto out;
-		}
+			}
+			break;
+		case SSL_ERROR_SSL:
+			trx_snprintf_alloc(error, &error_alloc, &error_offset, "SSL_connect() set"
+					" result code to SSL_ERROR_SSL:");
+			trx_tls_error_msg(error, &error_alloc, &error_offset);
+			trx_snprintf_alloc(error, &error_alloc, &error_offset, "%s", info_buf);
+			break;
+		default:
+			trx_snprintf_alloc(error, &error_alloc, &error_offset, "SSL_connect() set result code"
+					" to %d", result_code);
+			trx_tls_error_msg(error, &error_alloc, &error_offset);
+			trx_snprintf_alloc(error, &error_alloc, &error_offset, "%s", info_buf);
+			break;
 	}
 
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: tls_connect_verify                                               *
+ *                                                                            *
+ * Purpose: verify peer after successful TLS handshake                        *
+ *                                                                            *
+ * Parameters: s           - [IN] socket with TLS context                     *
+ *             tls_connect - [IN] TRX_TCP_SEC_TLS_CERT or TRX_TCP_SEC_TLS_PSK *
+ *             tls_arg1    - [IN] see trx_tls_connect()                       *
+ *             tls_arg2    - [IN] see trx_tls_connect()                       *
+ *             error       - [OUT] dynamically allocated memory with error    *
+ *                                 message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the peer was verified, TLS connection established  *
+ *               FAIL    - verification failed, TLS connection closed         *
+ *                                                                            *
+ ******************************************************************************/
+static int	tls_connect_verify(trx_socket_t *s, unsigned int tls_connect, const char *tls_arg1,
+		const char *tls_arg2, char **error)
+{
 	if (TRX_TCP_SEC_TLS_CERT == tls_connect)
 	{
 		long	verify_result;
@@ -4453,22 +4524,72 @@ int	trx_tls_connect(trx_socket_t *s, unsigned int tls_connect, const char *tls_a
 		/* perform basic verification of peer certificate */
 		if (X509_V_OK != (verify_result = SSL_get_verify_result(s->tls_ctx->ctx)))
 		{
-			trx_snprintf_alloc(error, &error_alloc, &error_offset, "%s",
-					X509_verify_cert_error_string(verify_result));
+			*error = trx_dsprintf(*error, "%s", X509_verify_cert_error_string(verify_result));
 			trx_tls_close(s);
-			goto out1;
+			return FAIL;
 		}
 
 		/* if required verify peer certificate Issuer and Subject */
 		if (SUCCEED != trx_verify_issuer_subject(s->tls_ctx, tls_arg1, tls_arg2, error))
 		{
 			trx_tls_close(s);
-			goto out1;
+			return FAIL;
 		}
 	}
 
 	s->connection_type = tls_connect;
 
+	return SUCCEED;
+}
+
+int	trx_tls_connect(trx_socket_t *s, unsigned int tls_connect, const char *tls_arg1, const char *tls_arg2,
+		char **error)
+{
+	int	ret = FAIL, res;
+#if defined(_WINDOWS)
+	double	sec;
+#endif
+#if defined(HAVE_OPENSSL_WITH_PSK)
+	char	psk_buf[HOST_TLS_PSK_LEN / 2];
+#endif
+
+	if (SUCCEED != tls_connect_init(s, tls_connect, tls_arg1, tls_arg2, error))
+		goto out1;
+
+#if defined(HAVE_OPENSSL_WITH_PSK)
+	if (TRX_TCP_SEC_TLS_PSK == tls_connect &&
+			SUCCEED != tls_connect_set_psk(tls_arg1, tls_arg2, psk_buf, sizeof(psk_buf), error))
+	{
+		goto out;
+	}
+#endif
+
+	/* TLS handshake */
+
+	info_buf[0] = '\0';	/* empty buffer for trx_openssl_info_cb() messages */
+#if defined(_WINDOWS)
+	trx_alarm_flag_clear();
+	sec = trx_time();
+#endif
+	if (1 != (res = SSL_connect(s->tls_ctx->ctx)))
+	{
+#if defined(_WINDOWS)
+		if (s->timeout < trx_time() - sec)
+			trx_alarm_flag_set();
+#endif
+		if (SUCCEED == trx_alarm_timed_out())
+		{
+			*error = trx_strdup(*error, "SSL_connect() timed out");
+			goto out;
+		}
+
+		if (SUCCEED != tls_connect_strerror(s, tls_connect, res, error))
+			goto out;
+	}
+
+	if (SUCCEED != tls_connect_verify(s, tls_connect, tls_arg1, tls_arg2, error))
+		goto out1;
+
 	treegix_log(LOG_LEVEL_DEBUG, "End of %s():SUCCEED (established %s %s)", __func__,
 			SSL_get_version(s->tls_ctx->ctx), SSL_get_cipher(s->tls_ctx->ctx));
 
@@ -4484,6 +4605,83 @@ out1:
 			TRX_NULL2EMPTY_STR(*error));
 	return ret;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_tls_connect_nonblocking                                      *
+ *                                                                            *
+ * Purpose: advance TLS handshake over a non-blocking TCP connection          *
+ *                                                                            *
+ * Parameters: s           - [IN] socket with opened non-blocking connection  *
+ *             tls_connect - [IN] TRX_TCP_SEC_TLS_CERT or TRX_TCP_SEC_TLS_PSK *
+ *             tls_arg1    - [IN] see trx_tls_connect()                       *
+ *             tls_arg2    - [IN] see trx_tls_connect()                       *
+ *             want        - [OUT] TRX_SOCKET_WANT_READ or                    *
+ *                                 TRX_SOCKET_WANT_WRITE if the handshake     *
+ *                                 must be continued when socket becomes      *
+ *                                 readable or writable, 0 when it is done    *
+ *             error       - [OUT] dynamically allocated memory with error    *
+ *                                 message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the handshake is completed or in progress          *
+ *               FAIL    - an error occurred, TLS context is destroyed        *
+ *                                                                            *
+ * Comments: The same arguments must be passed on every call. PSK variables   *
+ *           are set up before each handshake step because handshakes of      *
+ *           several connections are interleaved within one thread.           *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_tls_connect_nonblocking(trx_socket_t *s, unsigned int tls_connect, const char *tls_arg1,
+		const char *tls_arg2, int *want, char **error)
+{
+	int	res;
+#if defined(HAVE_OPENSSL_WITH_PSK)
+	char	psk_buf[HOST_TLS_PSK_LEN / 2];
+#endif
+
+	*want = 0;
+
+	if (NULL == s->tls_ctx && SUCCEED != tls_connect_init(s, tls_connect, tls_arg1, tls_arg2, error))
+		return FAIL;
+
+#if defined(HAVE_OPENSSL_WITH_PSK)
+	if (TRX_TCP_SEC_TLS_PSK == tls_connect &&
+			SUCCEED != tls_connect_set_psk(tls_arg1, tls_arg2, psk_buf, sizeof(psk_buf), error))
+	{
+		goto out;
+	}
+#endif
+	info_buf[0] = '\0';	/* empty buffer for trx_openssl_info_cb() messages */
+
+	if (1 != (res = SSL_connect(s->tls_ctx->ctx)))
+	{
+		switch (SSL_get_error(s->tls_ctx->ctx, res))
+		{
+			case SSL_ERROR_WANT_READ:
+				*want = TRX_SOCKET_WANT_READ;
+				return SUCCEED;
+			case SSL_ERROR_WANT_WRITE:
+				*want = TRX_SOCKET_WANT_WRITE;
+				return SUCCEED;
+		}
+
+		if (SUCCEED != tls_connect_strerror(s, tls_connect, res, error))
+			goto out;
+	}
+
+	if (SUCCEED != tls_connect_verify(s, tls_connect, tls_arg1, tls_arg2, error))
+		return FAIL;
+
+	treegix_log(LOG_LEVEL_DEBUG, "%s() established %s %s with %s", __func__, SSL_get_version(s->tls_ctx->ctx),
+			SSL_get_cipher(s->tls_ctx->ctx), s->peer);
+
+	return SUCCEED;
+out:
+	SSL_free(s->tls_ctx->ctx);
+	trx_free(s->tls_ctx);
+
+	return FAIL;
+}
 #endif
 
 /******************************************************************************
@@ -5234,6 +5432,44 @@ out1:
 /* SSL_MODE_AUTO_RETRY flag in trx_tls_init_child() */
 #endif
 
+#if defined(HAVE_OPENSSL)
+/******************************************************************************
+ *                                                                            *
+ * Function: tls_rw_strerror                                                  *
+ *                                                                            *
+ * Purpose: describe failed SSL_read() or SSL_write() call                    *
+ *                                                                            *
+ * Parameters: s         - [IN] socket with TLS context                       *
+ *             res       - [IN] value returned by SSL_read() or SSL_write()   *
+ *             operation - [IN] "read" or "write"                             *
+ *             error     - [OUT] dynamically allocated memory with error      *
+ *                               message                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	tls_rw_strerror(const trx_socket_t *s, int res, const char *operation, char **error)
+{
+	int	result_code;
+
+	result_code = SSL_get_error(s->tls_ctx->ctx, res);
+
+	if (0 == res && SSL_ERROR_ZERO_RETURN == result_code)
+	{
+		*error = trx_dsprintf(*error, "connection closed during %s", operation);
+	}
+	else
+	{
+		char	*err = NULL;
+		size_t	error_alloc = 0, error_offset = 0;
+
+		trx_snprintf_alloc(&err, &error_alloc, &error_offset, "TLS %s set result code to %d:", operation,
+				result_code);
+		trx_tls_error_msg(&err, &error_alloc, &error_offset);
+		*error = trx_dsprintf(*error, "%s%s", err, info_buf);
+		trx_free(err);
+	}
+}
+#endif
+
 ssize_t	trx_tls_write(trx_socket_t *s, const char *buf, size_t len, char **error)
 {
 #if defined(_WINDOWS)
@@ -5290,26 +5526,7 @@ ssize_t	trx_tls_write(trx_socket_t *s, const char *buf, size_t len, char **error
 #elif defined(HAVE_OPENSSL)
 	if (0 >= res)
 	{
-		int	result_code;
-
-		result_code = SSL_get_error(s->tls_ctx->ctx, res);
-
-		if (0 == res && SSL_ERROR_ZERO_RETURN == result_code)
-		{
-			*error = trx_strdup(*error, "connection closed during write");
-		}
-		else
-		{
-			char	*err = NULL;
-			size_t	error_alloc = 0, error_offset = 0;
-
-			trx_snprintf_alloc(&err, &error_alloc, &error_offset, "TLS write set result code to"
-					" %d:", result_code);
-			trx_tls_error_msg(&err, &error_alloc, &error_offset);
-			*error = trx_dsprintf(*error, "%s%s", err, info_buf);
-			trx_free(err);
-		}
-
+		tls_rw_strerror(s, res, "write", error);
 		return TRX_PROTO_ERROR;
 	}
 #endif
@@ -5374,33 +5591,110 @@ ssize_t	trx_tls_read(trx_socket_t *s, char *buf, size_t len, char **error)
 #elif defined(HAVE_OPENSSL)
 	if (0 >= res)
 	{
-		int	result_code;
+		tls_rw_strerror(s, res, "read", error);
+		return TRX_PROTO_ERROR;
+	}
+#endif
 
-		result_code = SSL_get_error(s->tls_ctx->ctx, res);
+	return (ssize_t)res;
+}
 
-		if (0 == res && SSL_ERROR_ZERO_RETURN == result_code)
-		{
-			*error = trx_strdup(*error, "connection closed during read");
-		}
-		else
-		{
-			char	*err = NULL;
-			size_t	error_alloc = 0, error_offset = 0;
+#if defined(HAVE_OPENSSL)
+/******************************************************************************
+ *                                                                            *
+ * Function: tls_nonblocking_want                                             *
+ *                                                                            *
+ * Purpose: check if failed SSL_read() or SSL_write() must be repeated when   *
+ *          non-blocking socket becomes ready                                 *
+ *                                                                            *
+ * Parameters: s    - [IN] socket with TLS context                            *
+ *             res  - [IN] value returned by SSL_read() or SSL_write()        *
+ *             want - [OUT] TRX_SOCKET_WANT_READ or TRX_SOCKET_WANT_WRITE     *
+ *                                                                            *
+ * Return value: SUCCEED - the operation must be repeated                     *
+ *               FAIL    - the operation failed                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	tls_nonblocking_want(const trx_socket_t *s, int res, int *want)
+{
+	switch (SSL_get_error(s->tls_ctx->ctx, res))
+	{
+		case SSL_ERROR_WANT_READ:
+			*want = TRX_SOCKET_WANT_READ;
+			return SUCCEED;
+		case SSL_ERROR_WANT_WRITE:
+			*want = TRX_SOCKET_WANT_WRITE;
+			return SUCCEED;
+	}
 
-			trx_snprintf_alloc(&err, &error_alloc, &error_offset, "TLS read set result code to"
-					" %d:", result_code);
-			trx_tls_error_msg(&err, &error_alloc, &error_offset);
-			*error = trx_dsprintf(*error, "%s%s", err, info_buf);
-			trx_free(err);
-		}
+	return FAIL;
+}
 
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_tls_write_nonblocking                                        *
+ *                                                                            *
+ * Purpose: write data over TLS connection with non-blocking socket           *
+ *                                                                            *
+ * Return value: number of bytes written, 0 with 'want' set if the write must *
+ *               be repeated when socket becomes ready or TRX_PROTO_ERROR     *
+ *                                                                            *
+ * Comments: OpenSSL requires to repeat the write with the same arguments.    *
+ *                                                                            *
+ ******************************************************************************/
+ssize_t	trx_tls_write_nonblocking(trx_socket_t *s, const char *buf, size_t len, int *want, char **error)
+{
+	int	res;
+
+	*want = 0;
+	info_buf[0] = '\0';	/* empty buffer for trx_openssl_info_cb() messages */
+
+	if (0 >= (res = SSL_write(s->tls_ctx->ctx, buf, (int)len)))
+	{
+		if (SUCCEED == tls_nonblocking_want(s, res, want))
+			return 0;
+
+		tls_rw_strerror(s, res, "write", error);
 		return TRX_PROTO_ERROR;
 	}
-#endif
 
 	return (ssize_t)res;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_tls_read_nonblocking                                         *
+ *                                                                            *
+ * Purpose: read data from TLS connection with non-blocking socket            *
+ *                                                                            *
+ * Return value: number of bytes read, 0 with 'want' set if the read must be  *
+ *               repeated when socket becomes ready, 0 without 'want' set if  *
+ *               the connection was closed by peer or TRX_PROTO_ERROR         *
+ *                                                                            *
+ ******************************************************************************/
+ssize_t	trx_tls_read_nonblocking(trx_socket_t *s, char *buf, size_t len, int *want, char **error)
+{
+	int	res;
+
+	*want = 0;
+	info_buf[0] = '\0';	/* empty buffer for trx_openssl_info_cb() messages */
+
+	if (0 >= (res = SSL_read(s->tls_ctx->ctx, buf, (int)len)))
+	{
+		if (SUCCEED == tls_nonblocking_want(s, res, want))
+			return 0;
+
+		if (0 == res && SSL_ERROR_ZERO_RETURN == SSL_get_error(s->tls_ctx->ctx, res))
+			return 0;
+
+		tls_rw_strerror(s, res, "read", error);
+		return TRX_PROTO_ERROR;
+	}
+
+	return (ssize_t)res;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: trx_tls_close                                                    *
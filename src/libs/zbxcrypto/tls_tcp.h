@@ -14,6 +14,10 @@ void	trx_tls_close(trx_socket_t *s);
 
 #if defined(HAVE_OPENSSL)
 void	trx_tls_error_msg(char **error, size_t *error_alloc, size_t *error_offset);
+int	trx_tls_connect_nonblocking(trx_socket_t *s, unsigned int tls_connect, const char *tls_arg1,
+		const char *tls_arg2, int *want, char **error);
+ssize_t	trx_tls_write_nonblocking(trx_socket_t *s, const char *buf, size_t len, int *want, char **error);
+ssize_t	trx_tls_read_nonblocking(trx_socket_t *s, char *buf, size_t len, int *want, char **error);
 #endif
 
 #endif	/* TREEGIX_TLS_TCP_H */
@@ -100,6 +100,7 @@ static ub4	OCI_DBserver_status(void);
 
 #elif defined(HAVE_POSTGRESQL)
 static PGconn			*conn = NULL;
+static PGconn			*async_conn = NULL;	/* connection for asynchronous statement execution */
 static unsigned int		TRX_PG_BYTEAOID = 0;
 static int			TRX_PG_SVERSION = 0;
 char				TRX_PG_ESCAPE_BACKSLASH = 1;
@@ -853,6 +854,144 @@ void	trx_db_close(void)
 #endif
 }
 
+#if defined(HAVE_POSTGRESQL)
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_db_async_close                                               *
+ *                                                                            *
+ * Purpose: close the asynchronous statement execution connection            *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_db_async_close(void)
+{
+	if (NULL != async_conn)
+	{
+		PQfinish(async_conn);
+		async_conn = NULL;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_db_async_connect                                             *
+ *                                                                            *
+ * Purpose: open additional connection to the database for asynchronous       *
+ *          statement execution                                               *
+ *                                                                            *
+ * Return value: TRX_DB_OK - successfully connected                           *
+ *               TRX_DB_DOWN - database is down                               *
+ *               TRX_DB_FAIL - failed to connect                              *
+ *                                                                            *
+ * Comments: The connection is initialized in the same way as the main        *
+ *           connection. The state of main connection transaction is not      *
+ *           affected.                                                        *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_db_async_connect(char *host, char *user, char *password, char *dbname, char *dbschema, char *dbsocket,
+		int port)
+{
+	PGconn	*main_conn = conn;
+	int	ret, last_txn_error = txn_error, last_txn_level = txn_level;
+
+	trx_db_async_close();
+
+	conn = NULL;
+	txn_error = TRX_DB_OK;
+	txn_level = 0;
+
+	ret = trx_db_connect(host, user, password, dbname, dbschema, dbsocket, port);
+
+	async_conn = conn;
+	conn = main_conn;
+	txn_error = last_txn_error;
+	txn_level = last_txn_level;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_db_async_execute                                             *
+ *                                                                            *
+ * Purpose: send SQL statements for execution without waiting for results     *
+ *                                                                            *
+ * Parameters: sql - [IN] the SQL statements to execute                       *
+ *                                                                            *
+ * Return value: TRX_DB_OK - the statements were sent                         *
+ *               TRX_DB_DOWN - database is down                               *
+ *               TRX_DB_FAIL - failed to send statements                      *
+ *                                                                            *
+ * Comments: Multiple statements are executed in a single transaction unless  *
+ *           explicit transaction control statements are included.           *
+ *           Only one request can be executed at a time, the results must be  *
+ *           retrieved with trx_db_async_wait() before sending the next one.  *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_db_async_execute(const char *sql)
+{
+	if (NULL == async_conn)
+	{
+		trx_db_errlog(ERR_Z3003, 0, NULL, NULL);
+		return TRX_DB_DOWN;
+	}
+
+	treegix_log(LOG_LEVEL_DEBUG, "async query [%s]", sql);
+
+	if (0 == PQsendQuery(async_conn, sql))
+	{
+		trx_db_errlog(ERR_Z3005, 0, PQerrorMessage(async_conn), sql);
+		return CONNECTION_OK == PQstatus(async_conn) ? TRX_DB_FAIL : TRX_DB_DOWN;
+	}
+
+	return TRX_DB_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_db_async_wait                                                *
+ *                                                                            *
+ * Purpose: wait for the statements sent by trx_db_async_execute() to finish  *
+ *                                                                            *
+ * Return value: TRX_DB_OK - the statements were executed successfully        *
+ *               TRX_DB_DOWN - database is down or the statements failed with *
+ *                             recoverable error and must be sent again       *
+ *               TRX_DB_FAIL - the statements failed                          *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_db_async_wait(void)
+{
+	PGresult	*result;
+	char		*error = NULL;
+	int		ret = TRX_DB_OK;
+
+	if (NULL == async_conn)
+		return TRX_DB_DOWN;
+
+	while (NULL != (result = PQgetResult(async_conn)))
+	{
+		if (TRX_DB_OK == ret && PGRES_COMMAND_OK != PQresultStatus(result))
+		{
+			trx_postgresql_error(&error, result);
+			trx_db_errlog(ERR_Z3007, 0, error, NULL);
+			trx_free(error);
+
+			ret = (SUCCEED == is_recoverable_postgresql_error(async_conn, result) ? TRX_DB_DOWN : TRX_DB_FAIL);
+		}
+
+		PQclear(result);
+	}
+
+	if (CONNECTION_OK != PQstatus(async_conn))
+		return TRX_DB_DOWN;
+
+	/* failed statement leaves the explicitly started transaction in aborted state */
+	if (PQTRANS_IDLE != PQtransactionStatus(async_conn))
+		PQclear(PQexec(async_conn, "rollback;"));
+
+	return ret;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: trx_db_begin                                                     *
@@ -1310,6 +1449,119 @@ out:
 }
 #endif
 
+#if defined(HAVE_POSTGRESQL)
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_db_copy                                                      *
+ *                                                                            *
+ * Purpose: execute COPY ... FROM STDIN statement                             *
+ *                                                                            *
+ * Parameters: sql      - [IN] the COPY statement                             *
+ *             data     - [IN] the data to copy in the statement format       *
+ *             data_len - [IN] the data length                                *
+ *                                                                            *
+ * Return value: TRX_DB_FAIL (on error) or TRX_DB_DOWN (on recoverable error) *
+ *               or TRX_DB_OK (on success)                                    *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_db_copy(const char *sql, const char *data, size_t data_len)
+{
+	PGresult	*result;
+	char		*error = NULL;
+	int		ret = TRX_DB_OK, rc = 1;
+	size_t		offset, len;
+	double		sec = 0;
+
+	if (0 != CONFIG_LOG_SLOW_QUERIES)
+		sec = trx_time();
+
+	if (0 == txn_level)
+		treegix_log(LOG_LEVEL_DEBUG, "query without transaction detected");
+
+	if (TRX_DB_OK != txn_error)
+	{
+		treegix_log(LOG_LEVEL_DEBUG, "ignoring query [txnlev:%d] [%s] within failed transaction", txn_level, sql);
+		return TRX_DB_FAIL;
+	}
+
+	treegix_log(LOG_LEVEL_DEBUG, "query [txnlev:%d] [%s] data length:" TRX_FS_SIZE_T, txn_level, sql,
+			(trx_fs_size_t)data_len);
+
+	result = PQexec(conn, sql);
+
+	if (NULL == result)
+	{
+		trx_db_errlog(ERR_Z3005, 0, "result is NULL", sql);
+		ret = (CONNECTION_OK == PQstatus(conn) ? TRX_DB_FAIL : TRX_DB_DOWN);
+	}
+	else if (PGRES_COPY_IN != PQresultStatus(result))
+	{
+		trx_postgresql_error(&error, result);
+		trx_db_errlog(ERR_Z3005, 0, error, sql);
+		trx_free(error);
+
+		ret = (SUCCEED == is_recoverable_postgresql_error(conn, result) ? TRX_DB_DOWN : TRX_DB_FAIL);
+	}
+
+	PQclear(result);
+
+	if (TRX_DB_OK != ret)
+		goto out;
+
+	/* send data in chunks to stay within the data length limit of PQputCopyData() */
+	for (offset = 0; offset < data_len && 1 == rc; offset += len)
+	{
+		len = MIN(data_len - offset, TRX_MEBIBYTE);
+		rc = PQputCopyData(conn, data + offset, (int)len);
+	}
+
+	if (1 != rc || 1 != PQputCopyEnd(conn, NULL))
+	{
+		trx_db_errlog(ERR_Z3005, 0, PQerrorMessage(conn), sql);
+		ret = (CONNECTION_OK == PQstatus(conn) ? TRX_DB_FAIL : TRX_DB_DOWN);
+	}
+
+	while (NULL != (result = PQgetResult(conn)))
+	{
+		ExecStatusType	status = PQresultStatus(result);
+
+		if (TRX_DB_OK == ret && PGRES_COMMAND_OK != status)
+		{
+			trx_postgresql_error(&error, result);
+			trx_db_errlog(ERR_Z3005, 0, error, sql);
+			trx_free(error);
+
+			ret = (SUCCEED == is_recoverable_postgresql_error(conn, result) ? TRX_DB_DOWN : TRX_DB_FAIL);
+		}
+
+		PQclear(result);
+
+		/* abort the copy if the data was not sent completely */
+		if (PGRES_COPY_IN == status && 1 != PQputCopyEnd(conn, "cannot send data"))
+		{
+			/* the connection cannot be used anymore */
+			ret = TRX_DB_DOWN;
+			break;
+		}
+	}
+
+	if (0 != CONFIG_LOG_SLOW_QUERIES)
+	{
+		sec = trx_time() - sec;
+		if (sec > (double)CONFIG_LOG_SLOW_QUERIES / 1000.0)
+			treegix_log(LOG_LEVEL_WARNING, "slow query: " TRX_FS_DBL " sec, \"%s\"", sec, sql);
+	}
+out:
+	if (TRX_DB_FAIL == ret && 0 < txn_level)
+	{
+		treegix_log(LOG_LEVEL_DEBUG, "query [%s] failed, setting transaction as failed", sql);
+		txn_error = TRX_DB_FAIL;
+	}
+
+	return ret;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: trx_db_vexecute                                                  *
@@ -20,12 +20,20 @@
 #include "trxjson.h"
 #include "trxhistory.h"
 
-static trx_mem_info_t	*hc_index_mem = NULL;
-static trx_mem_info_t	*hc_mem = NULL;
+/* the maximum number of history cache shards */
+#define TRX_HC_SHARDS_MAX	(TRX_MUTEX_CACHE_SHARD_LAST - TRX_MUTEX_CACHE_SHARD_FIRST + 1)
+
+static trx_mem_info_t	*hc_index_mem[TRX_HC_SHARDS_MAX];
+static trx_mem_info_t	*hc_mem[TRX_HC_SHARDS_MAX];
 static trx_mem_info_t	*trend_mem = NULL;
+#ifdef HAVE_TRX_RINGBUF
+static trx_mem_info_t	*ring_mem = NULL;
+#endif
 
 #define	LOCK_CACHE	trx_mutex_lock(cache_lock)
 #define	UNLOCK_CACHE	trx_mutex_unlock(cache_lock)
+#define	LOCK_SHARD(shard)	trx_mutex_lock(shard_locks[(shard)->index])
+#define	UNLOCK_SHARD(shard)	trx_mutex_unlock(shard_locks[(shard)->index])
 #define	LOCK_TRENDS	trx_mutex_lock(trends_lock)
 #define	UNLOCK_TRENDS	trx_mutex_unlock(trends_lock)
 #define	LOCK_CACHE_IDS		trx_mutex_lock(cache_ids_lock)
@@ -34,11 +42,13 @@ static trx_mem_info_t	*trend_mem = NULL;
 static trx_mutex_t	cache_lock = TRX_MUTEX_NULL;
 static trx_mutex_t	trends_lock = TRX_MUTEX_NULL;
 static trx_mutex_t	cache_ids_lock = TRX_MUTEX_NULL;
+static trx_mutex_t	shard_locks[TRX_HC_SHARDS_MAX];
 
 static char		*sql = NULL;
 static size_t		sql_alloc = 64 * TRX_KIBIBYTE;
 
 extern unsigned char	program_type;
+extern int		process_num;
 
 #define TRX_IDS_SIZE	8
 
@@ -49,9 +59,19 @@ extern unsigned char	program_type;
 /* the maximum time spent synchronizing history */
 #define TRX_HC_SYNC_TIME_MAX	10
 
-/* the maximum number of items in one synchronization batch */
-#define TRX_HC_SYNC_MAX		1000
-#define TRX_HC_TIMER_MAX	(TRX_HC_SYNC_MAX / 2)
+/* the limits of the number of items in one synchronization batch, the actual batch size is */
+/* adjusted by each history syncer depending on the database write time and cache backlog   */
+#define TRX_HC_SYNC_MIN		100
+#define TRX_HC_SYNC_MAX		10000
+#define TRX_HC_SYNC_DEFAULT	1000
+
+/* the target time of writing one synchronization batch when history cache has a backlog */
+#define TRX_HC_SYNC_TARGET_BACKLOG	1.0
+/* the target time of writing one synchronization batch otherwise */
+#define TRX_HC_SYNC_TARGET_IDLE		0.2
+
+/* the maximum number of trends in one database or export batch */
+#define TRX_TRENDS_SYNC_MAX	1000
 
 /* the minimum processed item percentage of item candidates to continue synchronizing */
 #define TRX_HC_SYNC_MIN_PCNT	10
@@ -79,15 +99,51 @@ TRX_DC_IDS;
 
 static TRX_DC_IDS	*ids = NULL;
 
+/* history cache shard, items are assigned to shards by itemid */
 typedef struct
 {
-	trx_hashset_t		trends;
-	TRX_DC_STATS		stats;
-
 	trx_hashset_t		history_items;
 	trx_binary_heap_t	history_queue;
+	TRX_DC_STATS		stats;
 
 	int			history_num;
+	int			index;
+
+	/* history data memory of the shard */
+	trx_mem_malloc_func_t	mem_malloc_func;
+	trx_mem_realloc_func_t	mem_realloc_func;
+	trx_mem_free_func_t	mem_free_func;
+}
+trx_hc_shard_t;
+
+/* history syncer batch statistics */
+typedef struct
+{
+	/* the current synchronization batch size */
+	int	batch;
+	/* the time spent writing the last batch to database */
+	double	latency;
+}
+trx_hc_sync_stats_t;
+
+typedef struct
+{
+	trx_hashset_t		trends;
+
+	trx_hc_shard_t		*shards[TRX_HC_SHARDS_MAX];
+	int			shards_num;
+
+#ifdef HAVE_TRX_RINGBUF
+	/* history ingest rings, one per history syncer */
+	trx_ringbuf_t		**rings;
+	int			*rings_waiting;
+	int			rings_num;
+#endif
+
+	/* batch statistics, one per history syncer */
+	trx_hc_sync_stats_t	*sync_stats;
+	int			sync_stats_num;
+
 	int			trends_num;
 	int			trends_last_cleanup_hour;
 	int			history_num_total;
@@ -97,6 +153,16 @@ TRX_DC_CACHE;
 
 static TRX_DC_CACHE	*cache = NULL;
 
+/* the shard to start looking for history data to synchronize from */
+static int	sync_shard = -1;
+
+/* the history ingest ring drained by this history syncer */
+static int	sync_ring = -1;
+
+/* the synchronization batch size of this history syncer and the smoothed time of writing one value */
+static int	sync_batch = TRX_HC_SYNC_DEFAULT;
+static double	sync_value_time = 0.0;
+
 /* local history cache */
 #define TRX_MAX_VALUES_LOCAL	256
 #define TRX_STRUCT_REALLOC_STEP	8
@@ -140,14 +206,22 @@ static size_t		string_values_alloc = 0, string_values_offset = 0;
 static dc_item_value_t	*item_values = NULL;
 static size_t		item_values_alloc = 0, item_values_num = 0;
 
-static void	hc_add_item_values(dc_item_value_t *values, int values_num);
-static void	hc_pop_items(trx_vector_ptr_t *history_items);
+static void	hc_add_item_values(trx_hc_shard_t *shard, dc_item_value_t *values, const int *indexes,
+		int indexes_num, const char *strings, unsigned char *added);
+static trx_hc_shard_t	*hc_pop_items(trx_vector_ptr_t *history_items);
 static void	hc_get_item_values(TRX_DC_HISTORY *history, trx_vector_ptr_t *history_items);
-static void	hc_push_items(trx_vector_ptr_t *history_items);
+static void	hc_push_items(trx_hc_shard_t *shard, trx_vector_ptr_t *history_items);
 static void	hc_free_item_values(TRX_DC_HISTORY *history, int history_num);
-static void	hc_queue_item(trx_hc_item_t *item);
+static void	hc_queue_item(trx_hc_shard_t *shard, trx_hc_item_t *item);
 static int	hc_queue_elem_compare_func(const void *d1, const void *d2);
 static int	hc_queue_get_size(void);
+static int	hc_get_history_num(void);
+static int	hc_get_shard_index(trx_uint64_t itemid);
+static void	hc_add_values(dc_item_value_t *values, int values_num, const char *strings, unsigned char *added);
+static void	hc_sync_ring(void);
+#ifdef HAVE_TRX_RINGBUF
+static int	hc_ring_drain_all(void);
+#endif
 
 /******************************************************************************
  *                                                                            *
@@ -157,24 +231,66 @@ static int	hc_queue_get_size(void);
  *                                                                            *
  * Parameters: stats - [OUT] write cache metrics                              *
  *                                                                            *
+ * Comments: Shard locks are taken one at a time and never nested with other  *
+ *           cache locks, so no lock ordering is needed. Each lock is held    *
+ *           only while counters of one shard are copied, which keeps the     *
+ *           statistics of the shard consistent without blocking the other    *
+ *           shards.                                                          *
+ *                                                                            *
  ******************************************************************************/
 void	DCget_stats_all(trx_wcache_info_t *wcache_info)
 {
-	LOCK_CACHE;
+	int	i;
+
+	memset(wcache_info, 0, sizeof(trx_wcache_info_t));
+
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		trx_hc_shard_t	*shard = cache->shards[i];
+
+		LOCK_SHARD(shard);
+
+		wcache_info->stats.history_counter += shard->stats.history_counter;
+		wcache_info->stats.history_float_counter += shard->stats.history_float_counter;
+		wcache_info->stats.history_uint_counter += shard->stats.history_uint_counter;
+		wcache_info->stats.history_str_counter += shard->stats.history_str_counter;
+		wcache_info->stats.history_log_counter += shard->stats.history_log_counter;
+		wcache_info->stats.history_text_counter += shard->stats.history_text_counter;
+		wcache_info->stats.notsupported_counter += shard->stats.notsupported_counter;
 
-	wcache_info->stats = cache->stats;
-	wcache_info->history_free = hc_mem->free_size;
-	wcache_info->history_total = hc_mem->total_size;
-	wcache_info->index_free = hc_index_mem->free_size;
-	wcache_info->index_total = hc_index_mem->total_size;
+		wcache_info->history_free += hc_mem[i]->free_size;
+		wcache_info->history_total += hc_mem[i]->total_size;
+		wcache_info->index_free += hc_index_mem[i]->free_size;
+		wcache_info->index_total += hc_index_mem[i]->total_size;
+
+		UNLOCK_SHARD(shard);
+	}
 
 	if (0 != (program_type & TRX_PROGRAM_TYPE_SERVER))
 	{
+		LOCK_TRENDS;
+
 		wcache_info->trend_free = trend_mem->free_size;
 		wcache_info->trend_total = trend_mem->orig_size;
+
+		UNLOCK_TRENDS;
 	}
 
-	UNLOCK_CACHE;
+	if (0 != cache->sync_stats_num)
+	{
+		LOCK_CACHE;
+
+		for (i = 0; i < cache->sync_stats_num; i++)
+		{
+			wcache_info->sync_batch += (trx_uint64_t)cache->sync_stats[i].batch;
+			wcache_info->sync_latency += cache->sync_stats[i].latency;
+		}
+
+		UNLOCK_CACHE;
+
+		wcache_info->sync_batch /= (trx_uint64_t)cache->sync_stats_num;
+		wcache_info->sync_latency /= cache->sync_stats_num;
+	}
 }
 
 /******************************************************************************
@@ -191,107 +307,115 @@ void	*DCget_stats(int request)
 	static trx_uint64_t	value_uint;
 	static double		value_double;
 	void			*ret;
+	trx_wcache_info_t	wcache_info;
 
-	LOCK_CACHE;
+	DCget_stats_all(&wcache_info);
 
 	switch (request)
 	{
 		case TRX_STATS_HISTORY_COUNTER:
-			value_uint = cache->stats.history_counter;
+			value_uint = wcache_info.stats.history_counter;
 			ret = (void *)&value_uint;
 			break;
 		case TRX_STATS_HISTORY_FLOAT_COUNTER:
-			value_uint = cache->stats.history_float_counter;
+			value_uint = wcache_info.stats.history_float_counter;
 			ret = (void *)&value_uint;
 			break;
 		case TRX_STATS_HISTORY_UINT_COUNTER:
-			value_uint = cache->stats.history_uint_counter;
+			value_uint = wcache_info.stats.history_uint_counter;
 			ret = (void *)&value_uint;
 			break;
 		case TRX_STATS_HISTORY_STR_COUNTER:
-			value_uint = cache->stats.history_str_counter;
+			value_uint = wcache_info.stats.history_str_counter;
 			ret = (void *)&value_uint;
 			break;
 		case TRX_STATS_HISTORY_LOG_COUNTER:
-			value_uint = cache->stats.history_log_counter;
+			value_uint = wcache_info.stats.history_log_counter;
 			ret = (void *)&value_uint;
 			break;
 		case TRX_STATS_HISTORY_TEXT_COUNTER:
-			value_uint = cache->stats.history_text_counter;
+			value_uint = wcache_info.stats.history_text_counter;
 			ret = (void *)&value_uint;
 			break;
 		case TRX_STATS_NOTSUPPORTED_COUNTER:
-			value_uint = cache->stats.notsupported_counter;
+			value_uint = wcache_info.stats.notsupported_counter;
 			ret = (void *)&value_uint;
 			break;
 		case TRX_STATS_HISTORY_TOTAL:
-			value_uint = hc_mem->total_size;
+			value_uint = wcache_info.history_total;
 			ret = (void *)&value_uint;
 			break;
 		case TRX_STATS_HISTORY_USED:
-			value_uint = hc_mem->total_size - hc_mem->free_size;
+			value_uint = wcache_info.history_total - wcache_info.history_free;
 			ret = (void *)&value_uint;
 			break;
 		case TRX_STATS_HISTORY_FREE:
-			value_uint = hc_mem->free_size;
+			value_uint = wcache_info.history_free;
 			ret = (void *)&value_uint;
 			break;
 		case TRX_STATS_HISTORY_PUSED:
-			value_double = 100 * (double)(hc_mem->total_size - hc_mem->free_size) / hc_mem->total_size;
+			value_double = 100 * (double)(wcache_info.history_total - wcache_info.history_free) /
+					wcache_info.history_total;
 			ret = (void *)&value_double;
 			break;
 		case TRX_STATS_HISTORY_PFREE:
-			value_double = 100 * (double)hc_mem->free_size / hc_mem->total_size;
+			value_double = 100 * (double)wcache_info.history_free / wcache_info.history_total;
 			ret = (void *)&value_double;
 			break;
 		case TRX_STATS_TREND_TOTAL:
-			value_uint = trend_mem->orig_size;
+			value_uint = wcache_info.trend_total;
 			ret = (void *)&value_uint;
 			break;
 		case TRX_STATS_TREND_USED:
-			value_uint = trend_mem->orig_size - trend_mem->free_size;
+			value_uint = wcache_info.trend_total - wcache_info.trend_free;
 			ret = (void *)&value_uint;
 			break;
 		case TRX_STATS_TREND_FREE:
-			value_uint = trend_mem->free_size;
+			value_uint = wcache_info.trend_free;
 			ret = (void *)&value_uint;
 			break;
 		case TRX_STATS_TREND_PUSED:
-			value_double = 100 * (double)(trend_mem->orig_size - trend_mem->free_size) /
-					trend_mem->orig_size;
+			value_double = 100 * (double)(wcache_info.trend_total - wcache_info.trend_free) /
+					wcache_info.trend_total;
 			ret = (void *)&value_double;
 			break;
 		case TRX_STATS_TREND_PFREE:
-			value_double = 100 * (double)trend_mem->free_size / trend_mem->orig_size;
+			value_double = 100 * (double)wcache_info.trend_free / wcache_info.trend_total;
 			ret = (void *)&value_double;
 			break;
 		case TRX_STATS_HISTORY_INDEX_TOTAL:
-			value_uint = hc_index_mem->total_size;
+			value_uint = wcache_info.index_total;
 			ret = (void *)&value_uint;
 			break;
 		case TRX_STATS_HISTORY_INDEX_USED:
-			value_uint = hc_index_mem->total_size - hc_index_mem->free_size;
+			value_uint = wcache_info.index_total - wcache_info.index_free;
 			ret = (void *)&value_uint;
 			break;
 		case TRX_STATS_HISTORY_INDEX_FREE:
-			value_uint = hc_index_mem->free_size;
+			value_uint = wcache_info.index_free;
 			ret = (void *)&value_uint;
 			break;
 		case TRX_STATS_HISTORY_INDEX_PUSED:
-			value_double = 100 * (double)(hc_index_mem->total_size - hc_index_mem->free_size) /
-					hc_index_mem->total_size;
+			value_double = 100 * (double)(wcache_info.index_total - wcache_info.index_free) /
+					wcache_info.index_total;
 			ret = (void *)&value_double;
 			break;
 		case TRX_STATS_HISTORY_INDEX_PFREE:
-			value_double = 100 * (double)hc_index_mem->free_size / hc_index_mem->total_size;
+			value_double = 100 * (double)wcache_info.index_free / wcache_info.index_total;
+			ret = (void *)&value_double;
+			break;
+		case TRX_STATS_HISTORY_SYNC_BATCH:
+			value_uint = wcache_info.sync_batch;
+			ret = (void *)&value_uint;
+			break;
+		case TRX_STATS_HISTORY_SYNC_LATENCY:
+			value_double = wcache_info.sync_latency;
 			ret = (void *)&value_double;
 			break;
 		default:
 			ret = NULL;
 	}
 
-	UNLOCK_CACHE;
-
 	return ret;
 }
 
@@ -363,6 +487,7 @@ static void	dc_insert_trends_in_db(TRX_DC_TREND *trends, int trends_num, unsigne
 
 	trx_db_insert_prepare(&db_insert, table_name, "itemid", "clock", "num", "value_min", "value_avg",
 			"value_max", NULL);
+	trx_db_insert_use_copy(&db_insert);
 
 	for (i = 0; i < trends_num; i++)
 	{
@@ -639,7 +764,7 @@ static void	DBflush_trends(TRX_DC_TREND *trends, int *trends_num, trx_vector_uin
 			assert(0);
 	}
 
-	itemids_alloc = MIN(TRX_HC_SYNC_MAX, *trends_num);
+	itemids_alloc = MIN(TRX_TRENDS_SYNC_MAX, *trends_num);
 	itemids = (trx_uint64_t *)trx_malloc(itemids, itemids_alloc * sizeof(trx_uint64_t));
 
 	for (i = 0; i < *trends_num; i++)
@@ -656,7 +781,7 @@ static void	DBflush_trends(TRX_DC_TREND *trends, int *trends_num, trx_vector_uin
 
 		uint64_array_add(&itemids, &itemids_alloc, &itemids_num, trend->itemid, 64);
 
-		if (TRX_HC_SYNC_MAX == itemids_num)
+		if (TRX_TRENDS_SYNC_MAX == itemids_num)
 		{
 			trends_to = i + 1;
 			break;
@@ -1405,7 +1530,7 @@ static void	DCexport_all_trends(const TRX_DC_TREND *trends, int trends_num)
 
 	while (0 < trends_num)
 	{
-		num = MIN(TRX_HC_SYNC_MAX, trends_num);
+		num = MIN(TRX_TRENDS_SYNC_MAX, trends_num);
 
 		items = (DC_ITEM *)trx_malloc(NULL, sizeof(DC_ITEM) * (size_t)num);
 		errcodes = (int *)trx_malloc(NULL, sizeof(int) * (size_t)num);
@@ -2657,15 +2782,115 @@ static void	DCmodule_sync_history(int history_float_num, int history_integer_num
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_get_history_buffer                                            *
+ *                                                                            *
+ * Purpose: returns buffer for the history values of synchronization batch    *
+ *                                                                            *
+ * Parameters: history_num - [IN] the number of values in the batch           *
+ *                                                                            *
+ * Return value: The history buffer having space for at least history_num     *
+ *               values.                                                      *
+ *                                                                            *
+ * Comments: The buffer is reused between batches and grows together with     *
+ *           the synchronization batch size.                                  *
+ *                                                                            *
+ ******************************************************************************/
+static TRX_DC_HISTORY	*hc_get_history_buffer(int history_num)
+{
+	static TRX_DC_HISTORY	*history = NULL;
+	static int		history_alloc = 0;
+
+	if (history_alloc < history_num)
+	{
+		history_alloc = history_num;
+		history = (TRX_DC_HISTORY *)trx_realloc(history, sizeof(TRX_DC_HISTORY) * (size_t)history_alloc);
+	}
+
+	return history;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_update_sync_batch                                             *
+ *                                                                            *
+ * Purpose: adjusts the synchronization batch size of history syncer based on *
+ *          the measured database write time                                  *
+ *                                                                            *
+ * Parameters: history_num - [IN] the number of values in the written batch   *
+ *             write_time  - [IN] the time spent writing the batch to         *
+ *                                database (insert and commit), with history  *
+ *                                pipelining - from sending the batch until   *
+ *                                it's written                                *
+ *             queue_size  - [IN] the number of items left in history cache   *
+ *                                                                            *
+ * Comments: The batch size is chosen so that writing one batch takes about   *
+ *           TRX_HC_SYNC_TARGET_BACKLOG seconds when history cache has more   *
+ *           items than fit in a batch and TRX_HC_SYNC_TARGET_IDLE seconds    *
+ *           otherwise. Larger batches amortize the per transaction costs     *
+ *           when catching up, while smaller batches keep the trigger         *
+ *           processing latency low when the load is light.                   *
+ *           The time of writing one value is smoothed over batches and the   *
+ *           batch size can change at most twice per step to avoid            *
+ *           oscillation.                                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_update_sync_batch(int history_num, double write_time, int queue_size)
+{
+	double	target;
+	int	batch;
+
+	if (0 >= history_num)
+		return;
+
+	if (0.0 == sync_value_time)
+		sync_value_time = write_time / history_num;
+	else
+		sync_value_time = sync_value_time * 0.7 + write_time / history_num * 0.3;
+
+	target = (queue_size > sync_batch ? TRX_HC_SYNC_TARGET_BACKLOG : TRX_HC_SYNC_TARGET_IDLE);
+
+	if (0.0 < sync_value_time && TRX_HC_SYNC_MAX > target / sync_value_time)
+		batch = (int)(target / sync_value_time);
+	else
+		batch = TRX_HC_SYNC_MAX;
+
+	batch = MIN(batch, sync_batch * 2);
+	batch = MAX(batch, sync_batch / 2);
+	batch = MIN(batch, TRX_HC_SYNC_MAX);
+	batch = MAX(batch, TRX_HC_SYNC_MIN);
+
+	if (batch != sync_batch)
+	{
+		treegix_log(LOG_LEVEL_DEBUG, "%s() batch:%d write_time:" TRX_FS_DBL " queue:%d new batch:%d",
+				__func__, sync_batch, write_time, queue_size, batch);
+		sync_batch = batch;
+	}
+
+	/* only history syncers have statistics slots, full sync is done by the main process */
+	if (0 < process_num && process_num <= cache->sync_stats_num)
+	{
+		LOCK_CACHE;
+
+		cache->sync_stats[process_num - 1].batch = sync_batch;
+		cache->sync_stats[process_num - 1].latency = write_time;
+
+		UNLOCK_CACHE;
+	}
+}
+
 static void	sync_proxy_history(int *total_num, int *more)
 {
-	int			history_num;
+	int			history_num, queue_size;
 	time_t			sync_start;
+	double			write_start;
 	trx_vector_ptr_t	history_items;
-	TRX_DC_HISTORY		history[TRX_HC_SYNC_MAX];
+	trx_hc_shard_t		*shard;
+	TRX_DC_HISTORY		*history;
 
 	trx_vector_ptr_create(&history_items);
-	trx_vector_ptr_reserve(&history_items, TRX_HC_SYNC_MAX);
+	trx_vector_ptr_reserve(&history_items, TRX_HC_SYNC_DEFAULT);
 
 	sync_start = time(NULL);
 
@@ -2673,18 +2898,19 @@ static void	sync_proxy_history(int *total_num, int *more)
 	{
 		*more = TRX_SYNC_DONE;
 
-		LOCK_CACHE;
+		hc_sync_ring();
 
-		hc_pop_items(&history_items);		/* select and take items out of history cache */
+		shard = hc_pop_items(&history_items);	/* select and take items out of history cache */
 		history_num = history_items.values_num;
 
-		UNLOCK_CACHE;
-
 		if (0 == history_num)
 			break;
 
+		history = hc_get_history_buffer(history_num);
 		hc_get_item_values(history, &history_items);	/* copy item data from history cache */
 
+		write_start = trx_time();
+
 		do
 		{
 			DBbegin();
@@ -2694,15 +2920,17 @@ static void	sync_proxy_history(int *total_num, int *more)
 		}
 		while (TRX_DB_DOWN == DBcommit());
 
-		LOCK_CACHE;
+		LOCK_SHARD(shard);
 
-		hc_push_items(&history_items);	/* return items to history cache */
-		cache->history_num -= history_num;
+		hc_push_items(shard, &history_items);	/* return items to history cache */
+		shard->history_num -= history_num;
 
-		if (0 != hc_queue_get_size())
+		UNLOCK_SHARD(shard);
+
+		if (0 != (queue_size = hc_queue_get_size()))
 			*more = TRX_SYNC_MORE;
 
-		UNLOCK_CACHE;
+		hc_update_sync_batch(history_num, trx_time() - write_start, queue_size);
 
 		*total_num += history_num;
 
@@ -2718,6 +2946,96 @@ static void	sync_proxy_history(int *total_num, int *more)
 	trx_vector_ptr_destroy(&history_items);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_defer_item_changes                                            *
+ *                                                                            *
+ * Purpose: swaps item changes of the current batch with the pending item     *
+ *          changes of the previous batch                                     *
+ *                                                                            *
+ * Parameters: item_diff                - [IN/OUT] the item changes           *
+ *             inventory_values         - [IN/OUT] the inventory values       *
+ *             item_diff_pending        - [IN/OUT] the pending item changes   *
+ *             inventory_values_pending - [IN/OUT] the pending inventory      *
+ *                                                   values                   *
+ *                                                                            *
+ * Comments: With history pipelining item changes must be written only after  *
+ *           the history of their batch is stored, which happens when the     *
+ *           next batch is being processed. Item errors reference history     *
+ *           values of the current batch, so they are copied.                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_defer_item_changes(trx_vector_ptr_t *item_diff, trx_vector_ptr_t *inventory_values,
+		trx_vector_ptr_t *item_diff_pending, trx_vector_ptr_t *inventory_values_pending)
+{
+	int			i;
+	trx_vector_ptr_t	tmp;
+
+	for (i = 0; i < item_diff->values_num; i++)
+	{
+		trx_item_diff_t	*diff = (trx_item_diff_t *)item_diff->values[i];
+		size_t		len;
+
+		if (0 == (TRX_FLAGS_ITEM_DIFF_UPDATE_ERROR & diff->flags))
+			continue;
+
+		/* store error after the structure, so it's freed together with item diff */
+		len = strlen(diff->error) + 1;
+		diff = (trx_item_diff_t *)trx_realloc(diff, sizeof(trx_item_diff_t) + len);
+		memcpy(diff + 1, diff->error, len);
+		diff->error = (const char *)(diff + 1);
+
+		item_diff->values[i] = diff;
+	}
+
+	tmp = *item_diff;
+	*item_diff = *item_diff_pending;
+	*item_diff_pending = tmp;
+
+	tmp = *inventory_values;
+	*inventory_values = *inventory_values_pending;
+	*inventory_values_pending = tmp;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_sync_pending_history                                          *
+ *                                                                            *
+ * Purpose: waits until history of the previous batch is written when history *
+ *          pipelining is enabled                                             *
+ *                                                                            *
+ * Parameters: item_diff_pending        - [IN/OUT] the pending item changes   *
+ *             inventory_values_pending - [IN/OUT] the pending inventory      *
+ *                                                   values                   *
+ *             pending_num              - [IN] the number of values in the    *
+ *                                             previous batch                 *
+ *             pending_start            - [IN] the time the previous batch    *
+ *                                             was sent to database           *
+ *                                                                            *
+ * Comments: The batch write time is measured from sending the batch until    *
+ *           it's reported written and used to adjust the sync batch size.    *
+ *           If the batch failed to be written its item changes are           *
+ *           discarded, as it's done when writing history synchronously.      *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_sync_pending_history(trx_vector_ptr_t *item_diff_pending, trx_vector_ptr_t *inventory_values_pending,
+		int pending_num, double pending_start)
+{
+	if (SUCCEED != trx_history_sync())
+	{
+		treegix_log(LOG_LEVEL_WARNING, "cannot write history of the previous batch, discarding changes of"
+				" %d items", item_diff_pending->values_num);
+
+		trx_vector_ptr_clear_ext(inventory_values_pending, (trx_clean_func_t)DCinventory_value_free);
+		trx_vector_ptr_clear_ext(item_diff_pending, (trx_clean_func_t)trx_ptr_free);
+
+		return;
+	}
+
+	if (0 != pending_num)
+		hc_update_sync_batch(pending_num, trx_time() - pending_start, hc_queue_get_size());
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: sync_server_history                                              *
@@ -2732,14 +3050,15 @@ static void	sync_proxy_history(int *total_num, int *more)
  *                               TRX_SYNC_DONE - nothing to sync, go idle     *
  *                               TRX_SYNC_MORE - more data to sync            *
  *                                                                            *
- * Comments: This function loops syncing history values by 1k batches and     *
- *           processing timer triggers by batches of 500 triggers.            *
+ * Comments: This function loops syncing history values by batches of         *
+ *           adaptive size (see hc_update_sync_batch()) and processing timer  *
+ *           triggers by batches of half that size.                           *
  *           Unless full sync is being done the loop is aborted if either     *
  *           timeout has passed or there are no more data to process.         *
  *           The last is assumed when the following is true:                  *
  *            a) history cache is empty or less than 10% of batch values were *
  *               processed (the other items were locked by triggers)          *
- *            b) less than 500 (full batch) timer triggers were processed     *
+ *            b) less than full batch of timer triggers were processed        *
  *                                                                            *
  ******************************************************************************/
 static void	sync_server_history(int *values_num, int *triggers_num, int *more)
@@ -2750,12 +3069,15 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 	static TRX_HISTORY_TEXT		*history_text;
 	static TRX_HISTORY_LOG		*history_log;
 	int				i, history_num, history_float_num, history_integer_num, history_string_num,
-					history_text_num, history_log_num, txn_error;
+					history_text_num, history_log_num, txn_error, queue_size, pending_num = 0;
 	time_t				sync_start;
+	double				write_time, pending_start = 0.0;
 	trx_vector_uint64_t		triggerids, timer_triggerids;
-	trx_vector_ptr_t		history_items, trigger_diff, item_diff, inventory_values;
+	trx_vector_ptr_t		history_items, trigger_diff, item_diff, inventory_values,
+					item_diff_pending, inventory_values_pending;
 	trx_vector_uint64_pair_t	trends_diff;
-	TRX_DC_HISTORY			history[TRX_HC_SYNC_MAX];
+	trx_hc_shard_t			*shard;
+	TRX_DC_HISTORY			*history;
 
 	if (NULL == history_float && NULL != history_float_cbs)
 	{
@@ -2789,40 +3111,44 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 
 	trx_vector_ptr_create(&inventory_values);
 	trx_vector_ptr_create(&item_diff);
+	trx_vector_ptr_create(&inventory_values_pending);
+	trx_vector_ptr_create(&item_diff_pending);
 	trx_vector_ptr_create(&trigger_diff);
 	trx_vector_uint64_pair_create(&trends_diff);
 
 	trx_vector_uint64_create(&triggerids);
-	trx_vector_uint64_reserve(&triggerids, TRX_HC_SYNC_MAX);
+	trx_vector_uint64_reserve(&triggerids, TRX_HC_SYNC_DEFAULT);
 
 	trx_vector_uint64_create(&timer_triggerids);
-	trx_vector_uint64_reserve(&timer_triggerids, TRX_HC_TIMER_MAX);
+	trx_vector_uint64_reserve(&timer_triggerids, TRX_HC_SYNC_DEFAULT / 2);
 
 	trx_vector_ptr_create(&history_items);
-	trx_vector_ptr_reserve(&history_items, TRX_HC_SYNC_MAX);
+	trx_vector_ptr_reserve(&history_items, TRX_HC_SYNC_DEFAULT);
 
 	sync_start = time(NULL);
 
 	do
 	{
 		DC_ITEM			*items;
-		int			*errcodes, trends_num = 0, timers_num = 0, ret = SUCCEED;
+		int			*errcodes, trends_num = 0, timers_num = 0, timers_max, ret = SUCCEED;
 		trx_vector_uint64_t	itemids;
 		TRX_DC_TREND		*trends = NULL;
 
 		*more = TRX_SYNC_DONE;
+		history = NULL;
+		write_time = 0.0;
 
-		LOCK_CACHE;
-		hc_pop_items(&history_items);		/* select and take items out of history cache */
-		UNLOCK_CACHE;
+		hc_sync_ring();
+
+		shard = hc_pop_items(&history_items);	/* select and take items out of history cache */
 
 		if (0 != history_items.values_num)
 		{
 			if (0 == (history_num = DCconfig_lock_triggers_by_history_items(&history_items, &triggerids)))
 			{
-				LOCK_CACHE;
-				hc_push_items(&history_items);
-				UNLOCK_CACHE;
+				LOCK_SHARD(shard);
+				hc_push_items(shard, &history_items);
+				UNLOCK_SHARD(shard);
 				trx_vector_ptr_clear(&history_items);
 			}
 		}
@@ -2831,6 +3157,7 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 
 		if (0 != history_num)
 		{
+			history = hc_get_history_buffer(history_num);
 			hc_get_item_values(history, &history_items);	/* copy item data from history cache */
 
 			items = (DC_ITEM *)trx_malloc(NULL, sizeof(DC_ITEM) * (size_t)history_num);
@@ -2849,11 +3176,33 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 			DCmass_prepare_history(history, &itemids, items, errcodes, history_num, &item_diff,
 					&inventory_values);
 
+			/* the previous batch history failing to be written is handled like synchronous write */
+			/* failure - its item changes are not stored                                          */
+			if (0 != CONFIG_HISTORY_PIPELINING)
+			{
+				dc_sync_pending_history(&item_diff_pending, &inventory_values_pending, pending_num,
+						pending_start);
+				pending_num = 0;
+			}
+
+			write_time = trx_time();
+
 			if (FAIL != (ret = DBmass_add_history(history, history_num)))
 			{
 				DCconfig_items_apply_changes(&item_diff);
 				DCmass_update_trends(history, history_num, &trends, &trends_num);
 
+				/* the current batch history is being written asynchronously, */
+				/* store item changes of the previous batch instead           */
+				if (0 != CONFIG_HISTORY_PIPELINING)
+				{
+					pending_num = history_num;
+					pending_start = write_time;
+
+					dc_defer_item_changes(&item_diff, &inventory_values, &item_diff_pending,
+							&inventory_values_pending);
+				}
+
 				do
 				{
 					DBbegin();
@@ -2874,6 +3223,8 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 				while (TRX_DB_DOWN == txn_error);
 			}
 
+			write_time = trx_time() - write_time;
+
 			trx_clean_events();
 
 			trx_vector_ptr_clear_ext(&inventory_values, (trx_clean_func_t)DCinventory_value_free);
@@ -2882,10 +3233,11 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 
 		if (FAIL != ret)
 		{
-			trx_dc_get_timer_triggerids(&timer_triggerids, time(NULL), TRX_HC_TIMER_MAX);
+			timers_max = sync_batch / 2;
+			trx_dc_get_timer_triggerids(&timer_triggerids, time(NULL), timers_max);
 			timers_num = timer_triggerids.values_num;
 
-			if (TRX_HC_TIMER_MAX == timers_num)
+			if (timers_max == timers_num)
 				*more = TRX_SYNC_MORE;
 
 			if (0 != history_num || 0 != timers_num)
@@ -2929,11 +3281,12 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 
 		if (0 != history_num)
 		{
-			LOCK_CACHE;
-			hc_push_items(&history_items);	/* return items to history cache */
-			cache->history_num -= history_num;
+			LOCK_SHARD(shard);
+			hc_push_items(shard, &history_items);	/* return items to history cache */
+			shard->history_num -= history_num;
+			UNLOCK_SHARD(shard);
 
-			if (0 != hc_queue_get_size())
+			if (0 != (queue_size = hc_queue_get_size()))
 			{
 				/* Continue sync if enough of sync candidates were processed       */
 				/* (meaning most of sync candidates are not locked by triggers).   */
@@ -2944,7 +3297,9 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 					*more = TRX_SYNC_MORE;
 			}
 
-			UNLOCK_CACHE;
+			/* pipelined batch write time is known only when the next batch is written */
+			if (FAIL != ret && 0 == CONFIG_HISTORY_PIPELINING)
+				hc_update_sync_batch(history_num, write_time, queue_size);
 
 			*values_num += history_num;
 		}
@@ -2995,9 +3350,30 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 	}
 	while (TRX_SYNC_MORE == *more && TRX_HC_SYNC_TIME_MAX >= time(NULL) - sync_start);
 
+	if (0 != CONFIG_HISTORY_PIPELINING)
+	{
+		/* finish writing the last batch history and store its item changes */
+		dc_sync_pending_history(&item_diff_pending, &inventory_values_pending, pending_num, pending_start);
+
+		if (0 != item_diff_pending.values_num || 0 != inventory_values_pending.values_num)
+		{
+			do
+			{
+				DBbegin();
+				DBmass_update_items(&item_diff_pending, &inventory_values_pending);
+			}
+			while (TRX_DB_DOWN == DBcommit());
+
+			trx_vector_ptr_clear_ext(&inventory_values_pending, (trx_clean_func_t)DCinventory_value_free);
+			trx_vector_ptr_clear_ext(&item_diff_pending, (trx_clean_func_t)trx_ptr_free);
+		}
+	}
+
 	trx_vector_ptr_destroy(&history_items);
 	trx_vector_ptr_destroy(&inventory_values);
 	trx_vector_ptr_destroy(&item_diff);
+	trx_vector_ptr_destroy(&inventory_values_pending);
+	trx_vector_ptr_destroy(&item_diff_pending);
 	trx_vector_ptr_destroy(&trigger_diff);
 	trx_vector_uint64_pair_destroy(&trends_diff);
 
@@ -3019,12 +3395,15 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
  ******************************************************************************/
 static void	sync_history_cache_full(void)
 {
-	int			values_num = 0, triggers_num = 0, more;
+	int			values_num = 0, triggers_num = 0, more, i;
 	trx_hashset_iter_t	iter;
 	trx_hc_item_t		*item;
-	trx_binary_heap_t	tmp_history_queue;
+	trx_binary_heap_t	tmp_history_queue[TRX_HC_SHARDS_MAX];
+#ifdef HAVE_TRX_RINGBUF
+	int			rings_drained;
+#endif
 
-	treegix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, cache->history_num);
+	treegix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, hc_get_history_num());
 
 	/* History index cache might be full without any space left for queueing items from history index to  */
 	/* history queue. The solution: replace the shared-memory history queue with heap-allocated one. Add  */
@@ -3046,18 +3425,28 @@ static void	sync_history_cache_full(void)
 		trx_dc_clear_timer_queue();
 	}
 
-	tmp_history_queue = cache->history_queue;
+#ifdef HAVE_TRX_RINGBUF
+	/* move values left in history ingest rings to history cache */
+	rings_drained = hc_ring_drain_all();
+#endif
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		trx_hc_shard_t	*shard = cache->shards[i];
 
-	trx_binary_heap_create(&cache->history_queue, hc_queue_elem_compare_func, TRX_BINARY_HEAP_OPTION_EMPTY);
-	trx_hashset_iter_reset(&cache->history_items, &iter);
+		tmp_history_queue[i] = shard->history_queue;
 
-	/* add all items from history index to the new history queue */
-	while (NULL != (item = (trx_hc_item_t *)trx_hashset_iter_next(&iter)))
-	{
-		if (NULL != item->tail)
+		trx_binary_heap_create(&shard->history_queue, hc_queue_elem_compare_func,
+				TRX_BINARY_HEAP_OPTION_EMPTY);
+		trx_hashset_iter_reset(&shard->history_items, &iter);
+
+		/* add all items from history index to the new history queue */
+		while (NULL != (item = (trx_hc_item_t *)trx_hashset_iter_next(&iter)))
 		{
-			item->status = TRX_HC_ITEM_STATUS_NORMAL;
-			hc_queue_item(item);
+			if (NULL != item->tail)
+			{
+				item->status = TRX_HC_ITEM_STATUS_NORMAL;
+				hc_queue_item(shard, item);
+			}
 		}
 	}
 
@@ -3071,17 +3460,24 @@ static void	sync_history_cache_full(void)
 				sync_server_history(&values_num, &triggers_num, &more);
 			else
 				sync_proxy_history(&values_num, &more);
-
+#ifdef HAVE_TRX_RINGBUF
+			/* move the values that did not fit into full history cache when space is freed */
+			if (SUCCEED != rings_drained)
+				rings_drained = hc_ring_drain_all();
+#endif
 			treegix_log(LOG_LEVEL_WARNING, "syncing history data... " TRX_FS_DBL "%%",
-					(double)values_num / (cache->history_num + values_num) * 100);
+					(double)values_num / (hc_get_history_num() + values_num) * 100);
 		}
 		while (0 != hc_queue_get_size());
 
 		treegix_log(LOG_LEVEL_WARNING, "syncing history data done");
 	}
 
-	trx_binary_heap_destroy(&cache->history_queue);
-	cache->history_queue = tmp_history_queue;
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		trx_binary_heap_destroy(&cache->shards[i]->history_queue);
+		cache->shards[i]->history_queue = tmp_history_queue[i];
+	}
 
 	treegix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -3096,7 +3492,9 @@ static void	sync_history_cache_full(void)
 void	trx_log_sync_history_cache_progress(void)
 {
 	double		pcnt = -1.0;
-	int		ts_last, ts_next, sec;
+	int		ts_last, ts_next, sec, history_num;
+
+	history_num = hc_get_history_num();
 
 	LOCK_CACHE;
 
@@ -3111,16 +3509,16 @@ void	trx_log_sync_history_cache_progress(void)
 
 	if (0 == cache->history_progress_ts)
 	{
-		cache->history_num_total = cache->history_num;
+		cache->history_num_total = history_num;
 		cache->history_progress_ts = sec;
 	}
 
-	if (TRX_HC_SYNC_TIME_MAX <= sec - cache->history_progress_ts || 0 == cache->history_num)
+	if (TRX_HC_SYNC_TIME_MAX <= sec - cache->history_progress_ts || 0 == history_num)
 	{
 		if (0 != cache->history_num_total)
-			pcnt = 100 * (double)(cache->history_num_total - cache->history_num) / cache->history_num_total;
+			pcnt = 100 * (double)(cache->history_num_total - history_num) / cache->history_num_total;
 
-		cache->history_progress_ts = (0 == cache->history_num ? INT_MAX : sec);
+		cache->history_progress_ts = (0 == history_num ? INT_MAX : sec);
 	}
 
 	ts_next = cache->history_progress_ts;
@@ -3151,15 +3549,28 @@ void	trx_log_sync_history_cache_progress(void)
  ******************************************************************************/
 void	trx_sync_history_cache(int *values_num, int *triggers_num, int *more)
 {
-	treegix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, cache->history_num);
+	treegix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, hc_get_history_num());
 
 	*values_num = 0;
 	*triggers_num = 0;
 
+#ifdef HAVE_TRX_RINGBUF
+	if (-1 == sync_ring && 0 != cache->rings_num)
+		sync_ring = (process_num - 1) % cache->rings_num;
+#endif
 	if (0 != (program_type & TRX_PROGRAM_TYPE_SERVER))
 		sync_server_history(values_num, triggers_num, more);
 	else
 		sync_proxy_history(values_num, more);
+
+#ifdef HAVE_TRX_RINGBUF
+	/* data gathering processes are waiting for free space in the ring, do not go idle */
+	if (-1 != sync_ring && 0 != cache->rings_waiting[sync_ring])
+	{
+		cache->rings_waiting[sync_ring] = 0;
+		*more = TRX_SYNC_MORE;
+	}
+#endif
 }
 
 /******************************************************************************
@@ -3509,121 +3920,543 @@ void	dc_add_history(trx_uint64_t itemid, unsigned char item_value_type, unsigned
 	}
 }
 
-void	dc_flush_history(void)
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_add_values                                                    *
+ *                                                                            *
+ * Purpose: adds item values to history cache shards                          *
+ *                                                                            *
+ * Parameters: values     - [IN] the item values to add                       *
+ *             values_num - [IN] the number of item values to add             *
+ *             strings    - [IN] the buffer containing string values         *
+ *             added      - [OUT] optional, the flags of added values; if set *
+ *                                the values that do not fit into full shard  *
+ *                                are left instead of waiting for free space  *
+ *                                                                            *
+ * Comments: Each shard is locked only while its own values are added, so     *
+ *           processes adding values of items belonging to different shards   *
+ *           do not block each other.                                         *
+ *           The values are partitioned by shards once before locking,        *
+ *           keeping the order of values within each shard.                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_add_values(dc_item_value_t *values, int values_num, const char *strings, unsigned char *added)
 {
-	if (0 == item_values_num)
-		return;
+	static int	*indexes = NULL, indexes_alloc = 0;
+	int		i, offsets[TRX_HC_SHARDS_MAX + 1];
 
-	LOCK_CACHE;
+	if (indexes_alloc < values_num * 2)
+	{
+		indexes_alloc = values_num * 2;
+		indexes = (int *)trx_realloc(indexes, sizeof(int) * (size_t)indexes_alloc);
+	}
+
+	/* count values per shard, the second half of indexes keeps shard index of each value */
+	memset(offsets, 0, sizeof(int) * (size_t)(cache->shards_num + 1));
+
+	for (i = 0; i < values_num; i++)
+	{
+		indexes[values_num + i] = hc_get_shard_index(values[i].itemid);
+		offsets[indexes[values_num + i] + 1]++;
+	}
 
-	hc_add_item_values(item_values, item_values_num);
+	for (i = 0; i < cache->shards_num; i++)
+		offsets[i + 1] += offsets[i];
 
-	cache->history_num += item_values_num;
+	/* place value indexes grouped by shards, offsets are moved to the end of shard groups */
+	for (i = 0; i < values_num; i++)
+		indexes[offsets[indexes[values_num + i]]++] = i;
 
-	UNLOCK_CACHE;
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		int	start = (0 == i ? 0 : offsets[i - 1]);
 
-	item_values_num = 0;
-	string_values_offset = 0;
+		if (start != offsets[i])
+		{
+			hc_add_item_values(cache->shards[i], values, indexes + start, offsets[i] - start, strings,
+					added);
+		}
+	}
 }
 
+#ifdef HAVE_TRX_RINGBUF
 /******************************************************************************
  *                                                                            *
- * history cache storage                                                      *
+ * history ingest rings                                                       *
+ *                                                                            *
+ * When enabled each history syncer has a lock-free ring in shared memory.    *
+ * Data gathering processes publish values into the ring of the history       *
+ * syncer owning the item (by itemid) without taking any locks and the        *
+ * history syncer moves them into history cache before synchronizing.        *
  *                                                                            *
  ******************************************************************************/
-TRX_MEM_FUNC_IMPL(__hc_index, hc_index_mem)
-TRX_MEM_FUNC_IMPL(__hc, hc_mem)
+
+/* the maximum number of values moved from ring to history cache at once */
+#define TRX_HC_RING_DRAIN_MAX	1000
+
+/* the time limits to wait for history syncer to drain the ring, in nanoseconds */
+#define TRX_HC_RING_WAIT_MIN_NS	1000000
+#define TRX_HC_RING_WAIT_MAX_NS	64000000
 
 /******************************************************************************
  *                                                                            *
- * Function: hc_queue_elem_compare_func                                       *
+ * Function: hc_ring_wait                                                     *
  *                                                                            *
- * Purpose: compares history queue elements                                   *
+ * Purpose: waits for history syncer to drain history ingest ring             *
+ *                                                                            *
+ * Parameters: index   - [IN] the ring index                                  *
+ *             wait_ns - [IN/OUT] the time to wait, doubled after each wait   *
+ *                       up to TRX_HC_RING_WAIT_MAX_NS                        *
+ *                                                                            *
+ * Comments: The waiting flag keeps the owning history syncer draining the    *
+ *           ring instead of going idle until the producer is released.       *
  *                                                                            *
  ******************************************************************************/
-static int	hc_queue_elem_compare_func(const void *d1, const void *d2)
+static void	hc_ring_wait(int index, long *wait_ns)
 {
-	const trx_binary_heap_elem_t	*e1 = (const trx_binary_heap_elem_t *)d1;
-	const trx_binary_heap_elem_t	*e2 = (const trx_binary_heap_elem_t *)d2;
+	struct timespec	ts = {0, *wait_ns};
 
-	const trx_hc_item_t	*item1 = (const trx_hc_item_t *)e1->data;
-	const trx_hc_item_t	*item2 = (const trx_hc_item_t *)e2->data;
+	cache->rings_waiting[index] = 1;
+	nanosleep(&ts, NULL);
 
-	/* compare by timestamp of the oldest value */
-	return trx_timespec_compare(&item1->tail->ts, &item2->tail->ts);
+	if (TRX_HC_RING_WAIT_MAX_NS < (*wait_ns *= 2))
+		*wait_ns = TRX_HC_RING_WAIT_MAX_NS;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: hc_free_data                                                     *
+ * Function: dc_item_value_get_strings                                        *
  *                                                                            *
- * Purpose: free history item data allocated in history cache                 *
+ * Purpose: gets the string values used by item value                         *
  *                                                                            *
- * Parameters: data - [IN] history item data                                  *
+ * Parameters: item_value - [IN] the item value                               *
+ *             value_str  - [OUT] the string value or NULL                    *
+ *             source     - [OUT] the log source or NULL                      *
  *                                                                            *
  ******************************************************************************/
-static void	hc_free_data(trx_hc_data_t *data)
+static void	dc_item_value_get_strings(dc_item_value_t *item_value, dc_value_str_t **value_str,
+		dc_value_str_t **source)
 {
-	if (ITEM_STATE_NOTSUPPORTED == data->state)
+	*value_str = NULL;
+	*source = NULL;
+
+	if (ITEM_STATE_NOTSUPPORTED == item_value->state || 0 != (TRX_DC_FLAG_LLD & item_value->flags))
 	{
-		__hc_mem_free_func(data->value.str);
+		*value_str = &item_value->value.value_str;
+		return;
 	}
-	else
-	{
-		if (0 == (data->flags & TRX_DC_FLAG_NOVALUE))
-		{
-			switch (data->value_type)
-			{
-				case ITEM_VALUE_TYPE_STR:
-				case ITEM_VALUE_TYPE_TEXT:
-					__hc_mem_free_func(data->value.str);
-					break;
-				case ITEM_VALUE_TYPE_LOG:
-					__hc_mem_free_func(data->value.log->value);
 
-					if (NULL != data->value.log->source)
-						__hc_mem_free_func(data->value.log->source);
+	if (0 != (TRX_DC_FLAG_NOVALUE & item_value->flags))
+		return;
 
-					__hc_mem_free_func(data->value.log);
-					break;
-			}
-		}
+	switch (item_value->value_type)
+	{
+		case ITEM_VALUE_TYPE_LOG:
+			*source = &item_value->source;
+			TRX_FALLTHROUGH;
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			*value_str = &item_value->value.value_str;
+			break;
 	}
-
-	__hc_mem_free_func(data);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: hc_queue_item                                                    *
+ * Function: hc_ring_add_item_value                                           *
  *                                                                            *
- * Purpose: put back item into history queue                                  *
+ * Purpose: publishes item value into history ingest ring                     *
  *                                                                            *
- * Parameters: data - [IN] history item data                                  *
+ * Parameters: item_value - [IN] the item value from local history cache      *
+ *                                                                            *
+ * Comments: The value is stored as a single record - item value structure    *
+ *           followed by its strings with offsets relative to the strings     *
+ *           start.                                                           *
+ *           Values too large for the ring (large low-level discovery data)   *
+ *           are added directly to history cache after the values published   *
+ *           earlier into the ring are moved to history cache.                *
  *                                                                            *
  ******************************************************************************/
-static void	hc_queue_item(trx_hc_item_t *item)
+static void	hc_ring_add_item_value(dc_item_value_t *item_value)
 {
-	trx_binary_heap_elem_t	elem = {item->itemid, (const void *)item};
+	int		index = (int)(item_value->itemid % (trx_uint64_t)cache->rings_num);
+	trx_ringbuf_t	*ring = cache->rings[index];
+	dc_item_value_t	*value;
+	dc_value_str_t	*value_str, *source;
+	size_t		size = sizeof(dc_item_value_t), offset = 0;
+	char		*strings;
+	long		wait_ns = TRX_HC_RING_WAIT_MIN_NS;
 
-	trx_binary_heap_insert(&cache->history_queue, &elem);
-}
+	dc_item_value_get_strings(item_value, &value_str, &source);
 
-/******************************************************************************
- *                                                                            *
- * Function: hc_get_item                                                      *
- *                                                                            *
- * Purpose: returns history item by itemid                                    *
- *                                                                            *
- * Parameters: itemid - [IN] the item id                                      *
+	if (NULL != value_str)
+		size += value_str->len;
+
+	if (NULL != source)
+		size += source->len;
+
+	if (size > ring->size / 4)
+	{
+		trx_uint64_t	pos;
+
+		pos = trx_ringbuf_get_reserved(ring);
+
+		while (SUCCEED != trx_ringbuf_is_released(ring, pos))
+			hc_ring_wait(index, &wait_ns);
+
+		hc_add_values(item_value, 1, string_values, NULL);
+		return;
+	}
+
+	while (NULL == (value = (dc_item_value_t *)trx_ringbuf_reserve(ring, size)))
+	{
+		treegix_log(LOG_LEVEL_DEBUG, "History ring is full. Waiting for history syncer.");
+		hc_ring_wait(index, &wait_ns);
+	}
+
+	memcpy(value, item_value, sizeof(dc_item_value_t));
+	strings = (char *)(value + 1);
+
+	dc_item_value_get_strings(value, &value_str, &source);
+
+	if (NULL != value_str)
+	{
+		memcpy(strings + offset, &string_values[value_str->pvalue], value_str->len);
+		value_str->pvalue = offset;
+		offset += value_str->len;
+	}
+
+	if (NULL != source)
+	{
+		memcpy(strings + offset, &string_values[source->pvalue], source->len);
+		source->pvalue = offset;
+	}
+
+	trx_ringbuf_commit(value);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_ring_drain                                                    *
+ *                                                                            *
+ * Purpose: moves values from history ingest ring into history cache          *
+ *                                                                            *
+ * Parameters: ring - [IN] the history ingest ring                            *
+ *                                                                            *
+ * Return value: SUCCEED - all values were moved                              *
+ *               FAIL    - history cache is full, the values left in the ring *
+ *                         must be moved after history is synced              *
+ *                                                                            *
+ * Comments: Only the owning history syncer (or main process during full      *
+ *           synchronization) may drain the ring.                             *
+ *           The function does not wait for free space in history cache       *
+ *           because it's called by the history syncer that frees it. The     *
+ *           records are released only when all their values are moved,       *
+ *           moved values of the records left in the ring are marked with     *
+ *           zero itemid and skipped by the next drain.                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_ring_drain(trx_ringbuf_t *ring)
+{
+	static dc_item_value_t	values[TRX_HC_RING_DRAIN_MAX], *records[TRX_HC_RING_DRAIN_MAX];
+	static unsigned char	added[TRX_HC_RING_DRAIN_MAX];
+	int			records_num, values_num, i, ret = SUCCEED;
+	size_t			size, offset;
+	char			*data;
+	dc_value_str_t		*value_str, *source;
+
+	/* read again the records left by the previous drain */
+	trx_ringbuf_rewind(ring);
+
+	do
+	{
+		for (records_num = 0, values_num = 0; TRX_HC_RING_DRAIN_MAX > records_num &&
+				NULL != (data = (char *)trx_ringbuf_read(ring, &size)); records_num++)
+		{
+			records[values_num] = (dc_item_value_t *)data;
+
+			if (0 == records[values_num]->itemid)
+				continue;
+
+			memcpy(&values[values_num], data, sizeof(dc_item_value_t));
+
+			/* rebase string offsets to be relative to the ring start */
+			offset = (size_t)(data + sizeof(dc_item_value_t) - (char *)ring);
+			dc_item_value_get_strings(&values[values_num], &value_str, &source);
+
+			if (NULL != value_str)
+				value_str->pvalue += offset;
+
+			if (NULL != source)
+				source->pvalue += offset;
+
+			values_num++;
+		}
+
+		if (0 != values_num)
+		{
+			memset(added, 0, (size_t)values_num);
+			hc_add_values(values, values_num, (const char *)ring, added);
+
+			for (i = 0; i < values_num; i++)
+			{
+				if (0 != added[i])
+					records[i]->itemid = 0;
+				else
+					ret = FAIL;
+			}
+
+			if (SUCCEED != ret)
+			{
+				treegix_log(LOG_LEVEL_DEBUG, "History cache is full, leaving values in history ring.");
+				break;
+			}
+		}
+
+		if (0 != records_num)
+			trx_ringbuf_release(ring);
+	}
+	while (TRX_HC_RING_DRAIN_MAX == records_num);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_ring_drain_all                                                *
+ *                                                                            *
+ * Purpose: moves values from all history ingest rings into history cache     *
+ *                                                                            *
+ * Return value: SUCCEED - all values were moved                              *
+ *               FAIL    - history cache is full, some values are left in     *
+ *                         the rings                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_ring_drain_all(void)
+{
+	int	i, ret = SUCCEED;
+
+	for (i = 0; i < cache->rings_num; i++)
+	{
+		if (SUCCEED != hc_ring_drain(cache->rings[i]))
+			ret = FAIL;
+	}
+
+	return ret;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_sync_ring                                                     *
+ *                                                                            *
+ * Purpose: moves values from the history ingest ring of current history      *
+ *          syncer into history cache                                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_sync_ring(void)
+{
+#ifdef HAVE_TRX_RINGBUF
+	if (-1 != sync_ring)
+		hc_ring_drain(cache->rings[sync_ring]);
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_flush_history                                                 *
+ *                                                                            *
+ * Purpose: moves values from local history cache into history ingest rings   *
+ *          if enabled or directly into history cache shards                  *
+ *                                                                            *
+ ******************************************************************************/
+void	dc_flush_history(void)
+{
+	if (0 == item_values_num)
+		return;
+
+#ifdef HAVE_TRX_RINGBUF
+	if (0 != cache->rings_num)
+	{
+		size_t	i;
+
+		for (i = 0; i < item_values_num; i++)
+			hc_ring_add_item_value(&item_values[i]);
+	}
+	else
+		hc_add_values(item_values, (int)item_values_num, string_values, NULL);
+#else
+	hc_add_values(item_values, (int)item_values_num, string_values, NULL);
+#endif
+	item_values_num = 0;
+	string_values_offset = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * history cache storage                                                      *
+ *                                                                            *
+ ******************************************************************************/
+
+/* Shared memory allocator functions can't have context, so each shard has */
+/* its own set of functions bound to its history and index memory.          */
+#define TRX_HC_SHARD_MEM_FUNC_IMPL(__index)					\
+										\
+TRX_MEM_FUNC_IMPL(__hc_index ## __index, hc_index_mem[__index])			\
+TRX_MEM_FUNC_IMPL(__hc ## __index, hc_mem[__index])
+
+#define TRX_HC_SHARD_MEM_FUNCS(__index)						\
+										\
+	{__hc_index ## __index ## _mem_malloc_func, __hc_index ## __index ## _mem_realloc_func,	\
+	__hc_index ## __index ## _mem_free_func, __hc ## __index ## _mem_malloc_func,		\
+	__hc ## __index ## _mem_realloc_func, __hc ## __index ## _mem_free_func}
+
+typedef struct
+{
+	trx_mem_malloc_func_t	index_malloc_func;
+	trx_mem_realloc_func_t	index_realloc_func;
+	trx_mem_free_func_t	index_free_func;
+	trx_mem_malloc_func_t	malloc_func;
+	trx_mem_realloc_func_t	realloc_func;
+	trx_mem_free_func_t	free_func;
+}
+trx_hc_mem_funcs_t;
+
+TRX_HC_SHARD_MEM_FUNC_IMPL(0)
+TRX_HC_SHARD_MEM_FUNC_IMPL(1)
+TRX_HC_SHARD_MEM_FUNC_IMPL(2)
+TRX_HC_SHARD_MEM_FUNC_IMPL(3)
+TRX_HC_SHARD_MEM_FUNC_IMPL(4)
+TRX_HC_SHARD_MEM_FUNC_IMPL(5)
+TRX_HC_SHARD_MEM_FUNC_IMPL(6)
+TRX_HC_SHARD_MEM_FUNC_IMPL(7)
+TRX_HC_SHARD_MEM_FUNC_IMPL(8)
+TRX_HC_SHARD_MEM_FUNC_IMPL(9)
+TRX_HC_SHARD_MEM_FUNC_IMPL(10)
+TRX_HC_SHARD_MEM_FUNC_IMPL(11)
+TRX_HC_SHARD_MEM_FUNC_IMPL(12)
+TRX_HC_SHARD_MEM_FUNC_IMPL(13)
+TRX_HC_SHARD_MEM_FUNC_IMPL(14)
+TRX_HC_SHARD_MEM_FUNC_IMPL(15)
+
+/* must have TRX_HC_SHARDS_MAX elements */
+static const trx_hc_mem_funcs_t	hc_mem_funcs[] =
+{
+	TRX_HC_SHARD_MEM_FUNCS(0), TRX_HC_SHARD_MEM_FUNCS(1), TRX_HC_SHARD_MEM_FUNCS(2),
+	TRX_HC_SHARD_MEM_FUNCS(3), TRX_HC_SHARD_MEM_FUNCS(4), TRX_HC_SHARD_MEM_FUNCS(5),
+	TRX_HC_SHARD_MEM_FUNCS(6), TRX_HC_SHARD_MEM_FUNCS(7), TRX_HC_SHARD_MEM_FUNCS(8),
+	TRX_HC_SHARD_MEM_FUNCS(9), TRX_HC_SHARD_MEM_FUNCS(10), TRX_HC_SHARD_MEM_FUNCS(11),
+	TRX_HC_SHARD_MEM_FUNCS(12), TRX_HC_SHARD_MEM_FUNCS(13), TRX_HC_SHARD_MEM_FUNCS(14),
+	TRX_HC_SHARD_MEM_FUNCS(15)
+};
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_get_shard_index                                               *
+ *                                                                            *
+ * Purpose: returns index of the history cache shard the item belongs to      *
+ *                                                                            *
+ * Parameters: itemid - [IN] the item id                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_get_shard_index(trx_uint64_t itemid)
+{
+	return (int)(itemid % (trx_uint64_t)cache->shards_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_queue_elem_compare_func                                       *
+ *                                                                            *
+ * Purpose: compares history queue elements                                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_queue_elem_compare_func(const void *d1, const void *d2)
+{
+	const trx_binary_heap_elem_t	*e1 = (const trx_binary_heap_elem_t *)d1;
+	const trx_binary_heap_elem_t	*e2 = (const trx_binary_heap_elem_t *)d2;
+
+	const trx_hc_item_t	*item1 = (const trx_hc_item_t *)e1->data;
+	const trx_hc_item_t	*item2 = (const trx_hc_item_t *)e2->data;
+
+	/* compare by timestamp of the oldest value */
+	return trx_timespec_compare(&item1->tail->ts, &item2->tail->ts);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_free_data                                                     *
+ *                                                                            *
+ * Purpose: free history item data allocated in history cache                 *
+ *                                                                            *
+ * Parameters: shard - [IN] the history cache shard                           *
+ *             data  - [IN] history item data                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_free_data(trx_hc_shard_t *shard, trx_hc_data_t *data)
+{
+	if (ITEM_STATE_NOTSUPPORTED == data->state)
+	{
+		shard->mem_free_func(data->value.str);
+	}
+	else
+	{
+		if (0 == (data->flags & TRX_DC_FLAG_NOVALUE))
+		{
+			switch (data->value_type)
+			{
+				case ITEM_VALUE_TYPE_STR:
+				case ITEM_VALUE_TYPE_TEXT:
+					shard->mem_free_func(data->value.str);
+					break;
+				case ITEM_VALUE_TYPE_LOG:
+					shard->mem_free_func(data->value.log->value);
+
+					if (NULL != data->value.log->source)
+						shard->mem_free_func(data->value.log->source);
+
+					shard->mem_free_func(data->value.log);
+					break;
+			}
+		}
+	}
+
+	shard->mem_free_func(data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_queue_item                                                    *
+ *                                                                            *
+ * Purpose: put back item into history queue                                  *
+ *                                                                            *
+ * Parameters: shard - [IN] the history cache shard                           *
+ *             item  - [IN] history item                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_queue_item(trx_hc_shard_t *shard, trx_hc_item_t *item)
+{
+	trx_binary_heap_elem_t	elem = {item->itemid, (const void *)item};
+
+	trx_binary_heap_insert(&shard->history_queue, &elem);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_get_item                                                      *
+ *                                                                            *
+ * Purpose: returns history item by itemid                                    *
+ *                                                                            *
+ * Parameters: shard  - [IN] the history cache shard                          *
+ *             itemid - [IN] the item id                                      *
  *                                                                            *
  * Return value: the history item or NULL if the requested item is not in     *
  *               history cache                                                *
  *                                                                            *
  ******************************************************************************/
-static trx_hc_item_t	*hc_get_item(trx_uint64_t itemid)
+static trx_hc_item_t	*hc_get_item(trx_hc_shard_t *shard, trx_uint64_t itemid)
 {
-	return (trx_hc_item_t *)trx_hashset_search(&cache->history_items, &itemid);
+	return (trx_hc_item_t *)trx_hashset_search(&shard->history_items, &itemid);
 }
 
 /******************************************************************************
@@ -3632,17 +4465,18 @@ static trx_hc_item_t	*hc_get_item(trx_uint64_t itemid)
  *                                                                            *
  * Purpose: adds a new item to history cache                                  *
  *                                                                            *
- * Parameters: itemid - [IN] the item id                                      *
- *                      [IN] the item data                                    *
+ * Parameters: shard  - [IN] the history cache shard                          *
+ *             itemid - [IN] the item id                                      *
+ *             data   - [IN] the item data                                    *
  *                                                                            *
  * Return value: the added history item                                       *
  *                                                                            *
  ******************************************************************************/
-static trx_hc_item_t	*hc_add_item(trx_uint64_t itemid, trx_hc_data_t *data)
+static trx_hc_item_t	*hc_add_item(trx_hc_shard_t *shard, trx_uint64_t itemid, trx_hc_data_t *data)
 {
 	trx_hc_item_t	item_local = {itemid, TRX_HC_ITEM_STATUS_NORMAL, data, data};
 
-	return (trx_hc_item_t *)trx_hashset_insert(&cache->history_items, &item_local, sizeof(item_local));
+	return (trx_hc_item_t *)trx_hashset_insert(&shard->history_items, &item_local, sizeof(item_local));
 }
 
 /******************************************************************************
@@ -3651,19 +4485,21 @@ static trx_hc_item_t	*hc_add_item(trx_uint64_t itemid, trx_hc_data_t *data)
  *                                                                            *
  * Purpose: copies string value to history cache                              *
  *                                                                            *
- * Parameters: str - [IN] the string value                                    *
+ * Parameters: shard   - [IN] the history cache shard                         *
+ *             str     - [IN] the string value                                *
+ *             strings - [IN] the buffer containing string values            *
  *                                                                            *
  * Return value: the copied string or NULL if there was not enough memory     *
  *                                                                            *
  ******************************************************************************/
-static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
+static char	*hc_mem_value_str_dup(trx_hc_shard_t *shard, const dc_value_str_t *str, const char *strings)
 {
 	char	*ptr;
 
-	if (NULL == (ptr = (char *)__hc_mem_malloc_func(NULL, str->len)))
+	if (NULL == (ptr = (char *)shard->mem_malloc_func(NULL, str->len)))
 		return NULL;
 
-	memcpy(ptr, &string_values[str->pvalue], str->len - 1);
+	memcpy(ptr, &strings[str->pvalue], str->len - 1);
 	ptr[str->len - 1] = '\0';
 
 	return ptr;
@@ -3675,8 +4511,10 @@ static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
  *                                                                            *
  * Purpose: clones string value into history data memory                      *
  *                                                                            *
- * Parameters: dst - [IN/OUT] a reference to the cloned value                 *
- *             str - [IN] the string value to clone                           *
+ * Parameters: shard   - [IN] the history cache shard                         *
+ *             dst     - [IN/OUT] a reference to the cloned value             *
+ *             str     - [IN] the string value to clone                       *
+ *             strings - [IN] the buffer containing string values            *
  *                                                                            *
  * Return value: SUCCESS - either there was no need to clone the string       *
  *                         (it was empty or already cloned) or the string was *
@@ -3687,7 +4525,8 @@ static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
  *           until it finishes cloning string value.                          *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
+static int	hc_clone_history_str_data(trx_hc_shard_t *shard, char **dst, const dc_value_str_t *str,
+		const char *strings)
 {
 	if (0 == str->len)
 		return SUCCEED;
@@ -3695,7 +4534,7 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
 	if (NULL != *dst)
 		return SUCCEED;
 
-	if (NULL != (*dst = hc_mem_value_str_dup(str)))
+	if (NULL != (*dst = hc_mem_value_str_dup(shard, str, strings)))
 		return SUCCEED;
 
 	return FAIL;
@@ -3707,8 +4546,10 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
  *                                                                            *
  * Purpose: clones log value into history data memory                         *
  *                                                                            *
- * Parameters: dst        - [IN/OUT] a reference to the cloned value          *
+ * Parameters: shard      - [IN] the history cache shard                      *
+ *             dst        - [IN/OUT] a reference to the cloned value          *
  *             item_value - [IN] the log value to clone                       *
+ *             strings    - [IN] the buffer containing string values         *
  *                                                                            *
  * Return value: SUCCESS - the log value was cloned successfully              *
  *               FAIL    - not enough memory                                  *
@@ -3717,21 +4558,21 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
  *           until it finishes cloning log value.                             *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_log_data(trx_log_value_t **dst, const dc_item_value_t *item_value)
+static int	hc_clone_history_log_data(trx_hc_shard_t *shard, trx_log_value_t **dst,
+		const dc_item_value_t *item_value, const char *strings)
 {
 	if (NULL == *dst)
 	{
-		/* using realloc instead of malloc just to suppress 'not used' warning for realloc */
-		if (NULL == (*dst = (trx_log_value_t *)__hc_mem_realloc_func(NULL, sizeof(trx_log_value_t))))
+		if (NULL == (*dst = (trx_log_value_t *)shard->mem_malloc_func(NULL, sizeof(trx_log_value_t))))
 			return FAIL;
 
 		memset(*dst, 0, sizeof(trx_log_value_t));
 	}
 
-	if (SUCCEED != hc_clone_history_str_data(&(*dst)->value, &item_value->value.value_str))
+	if (SUCCEED != hc_clone_history_str_data(shard, &(*dst)->value, &item_value->value.value_str, strings))
 		return FAIL;
 
-	if (SUCCEED != hc_clone_history_str_data(&(*dst)->source, &item_value->source))
+	if (SUCCEED != hc_clone_history_str_data(shard, &(*dst)->source, &item_value->source, strings))
 		return FAIL;
 
 	(*dst)->logeventid = item_value->logeventid;
@@ -3747,8 +4588,10 @@ static int	hc_clone_history_log_data(trx_log_value_t **dst, const dc_item_value_
  *                                                                            *
  * Purpose: clones item value from local cache into history cache             *
  *                                                                            *
- * Parameters: data       - [IN/OUT] a reference to the cloned value          *
+ * Parameters: shard      - [IN] the history cache shard                      *
+ *             data       - [IN/OUT] a reference to the cloned value          *
  *             item_value - [IN] the item value                               *
+ *             strings    - [IN] the buffer containing string values         *
  *                                                                            *
  * Return value: SUCCESS - the item value was cloned successfully             *
  *               FAIL    - not enough memory                                  *
@@ -3757,11 +4600,12 @@ static int	hc_clone_history_log_data(trx_log_value_t **dst, const dc_item_value_
  *           until it finishes cloning item value.                            *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_data(trx_hc_data_t **data, const dc_item_value_t *item_value)
+static int	hc_clone_history_data(trx_hc_shard_t *shard, trx_hc_data_t **data, const dc_item_value_t *item_value,
+		const char *strings)
 {
 	if (NULL == *data)
 	{
-		if (NULL == (*data = (trx_hc_data_t *)__hc_mem_malloc_func(NULL, sizeof(trx_hc_data_t))))
+		if (NULL == (*data = (trx_hc_data_t *)shard->mem_malloc_func(NULL, sizeof(trx_hc_data_t))))
 			return FAIL;
 
 		memset(*data, 0, sizeof(trx_hc_data_t));
@@ -3779,24 +4623,24 @@ static int	hc_clone_history_data(trx_hc_data_t **data, const dc_item_value_t *it
 
 	if (ITEM_STATE_NOTSUPPORTED == item_value->state)
 	{
-		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(&item_value->value.value_str)))
+		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(shard, &item_value->value.value_str, strings)))
 			return FAIL;
 
 		(*data)->value_type = item_value->value_type;
-		cache->stats.notsupported_counter++;
+		shard->stats.notsupported_counter++;
 
 		return SUCCEED;
 	}
 
 	if (0 != (TRX_DC_FLAG_LLD & item_value->flags))
 	{
-		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(&item_value->value.value_str)))
+		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(shard, &item_value->value.value_str, strings)))
 			return FAIL;
 
 		(*data)->value_type = ITEM_VALUE_TYPE_TEXT;
 
-		cache->stats.history_text_counter++;
-		cache->stats.history_counter++;
+		shard->stats.history_text_counter++;
+		shard->stats.history_counter++;
 
 		return SUCCEED;
 	}
@@ -3812,21 +4656,21 @@ static int	hc_clone_history_data(trx_hc_data_t **data, const dc_item_value_t *it
 				(*data)->value.ui64 = item_value->value.value_uint;
 				break;
 			case ITEM_VALUE_TYPE_STR:
-				if (SUCCEED != hc_clone_history_str_data(&(*data)->value.str,
-						&item_value->value.value_str))
+				if (SUCCEED != hc_clone_history_str_data(shard, &(*data)->value.str,
+						&item_value->value.value_str, strings))
 				{
 					return FAIL;
 				}
 				break;
 			case ITEM_VALUE_TYPE_TEXT:
-				if (SUCCEED != hc_clone_history_str_data(&(*data)->value.str,
-						&item_value->value.value_str))
+				if (SUCCEED != hc_clone_history_str_data(shard, &(*data)->value.str,
+						&item_value->value.value_str, strings))
 				{
 					return FAIL;
 				}
 				break;
 			case ITEM_VALUE_TYPE_LOG:
-				if (SUCCEED != hc_clone_history_log_data(&(*data)->value.log, item_value))
+				if (SUCCEED != hc_clone_history_log_data(shard, &(*data)->value.log, item_value, strings))
 					return FAIL;
 				break;
 		}
@@ -3834,23 +4678,23 @@ static int	hc_clone_history_data(trx_hc_data_t **data, const dc_item_value_t *it
 		switch (item_value->item_value_type)
 		{
 			case ITEM_VALUE_TYPE_FLOAT:
-				cache->stats.history_float_counter++;
+				shard->stats.history_float_counter++;
 				break;
 			case ITEM_VALUE_TYPE_UINT64:
-				cache->stats.history_uint_counter++;
+				shard->stats.history_uint_counter++;
 				break;
 			case ITEM_VALUE_TYPE_STR:
-				cache->stats.history_str_counter++;
+				shard->stats.history_str_counter++;
 				break;
 			case ITEM_VALUE_TYPE_TEXT:
-				cache->stats.history_text_counter++;
+				shard->stats.history_text_counter++;
 				break;
 			case ITEM_VALUE_TYPE_LOG:
-				cache->stats.history_log_counter++;
+				shard->stats.history_log_counter++;
 				break;
 		}
 
-		cache->stats.history_counter++;
+		shard->stats.history_counter++;
 	}
 
 	(*data)->value_type = item_value->value_type;
@@ -3858,53 +4702,170 @@ static int	hc_clone_history_data(trx_hc_data_t **data, const dc_item_value_t *it
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_free_partial_data                                             *
+ *                                                                            *
+ * Purpose: frees item value partially cloned into history cache              *
+ *                                                                            *
+ * Parameters: shard      - [IN] the history cache shard                      *
+ *             data       - [IN] the partially cloned value                   *
+ *             item_value - [IN] the item value being cloned                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_free_partial_data(trx_hc_shard_t *shard, trx_hc_data_t *data, const dc_item_value_t *item_value)
+{
+	if (ITEM_STATE_NOTSUPPORTED == item_value->state || 0 != (TRX_DC_FLAG_LLD & item_value->flags) ||
+			(0 == (TRX_DC_FLAG_NOVALUE & item_value->flags) &&
+			(ITEM_VALUE_TYPE_STR == item_value->value_type ||
+			ITEM_VALUE_TYPE_TEXT == item_value->value_type)))
+	{
+		if (NULL != data->value.str)
+			shard->mem_free_func(data->value.str);
+	}
+	else if (0 == (TRX_DC_FLAG_NOVALUE & item_value->flags) && ITEM_VALUE_TYPE_LOG == item_value->value_type &&
+			NULL != data->value.log)
+	{
+		if (NULL != data->value.log->value)
+			shard->mem_free_func(data->value.log->value);
+
+		if (NULL != data->value.log->source)
+			shard->mem_free_func(data->value.log->source);
+
+		shard->mem_free_func(data->value.log);
+	}
+
+	shard->mem_free_func(data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_value_size                                                    *
+ *                                                                            *
+ * Purpose: calculates the history data memory needed to store item value     *
+ *                                                                            *
+ * Parameters: item_value - [IN] the item value                               *
+ *                                                                            *
+ * Return value: the size of value data without memory allocator overhead     *
+ *                                                                            *
+ ******************************************************************************/
+static trx_uint64_t	hc_value_size(const dc_item_value_t *item_value)
+{
+	trx_uint64_t	size = sizeof(trx_hc_data_t);
+
+	if (ITEM_STATE_NOTSUPPORTED == item_value->state || 0 != (TRX_DC_FLAG_LLD & item_value->flags))
+		return size + item_value->value.value_str.len;
+
+	if (0 != (TRX_DC_FLAG_NOVALUE & item_value->flags))
+		return size;
+
+	switch (item_value->value_type)
+	{
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			size += item_value->value.value_str.len;
+			break;
+		case ITEM_VALUE_TYPE_LOG:
+			size += sizeof(trx_log_value_t) + item_value->value.value_str.len + item_value->source.len;
+			break;
+	}
+
+	return size;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: hc_add_item_values                                               *
  *                                                                            *
- * Purpose: adds item values to the history cache                             *
+ * Purpose: adds item values belonging to the specified shard to the history *
+ *          cache                                                             *
  *                                                                            *
- * Parameters: values     - [IN] the item values to add                       *
- *             values_num - [IN] the number of item values to add             *
+ * Parameters: shard       - [IN] the history cache shard                     *
+ *             values      - [IN] the item values                             *
+ *             indexes     - [IN] the indexes of values to add, all values    *
+ *                                must belong to the shard                    *
+ *             indexes_num - [IN] the number of values to add                 *
+ *             strings     - [IN] the buffer containing string values         *
+ *             added       - [OUT] optional, the flags of added values        *
  *                                                                            *
- * Comments: If the history cache is full this function will wait until       *
+ * Comments: If the history cache shard is full this function will wait until *
  *           history syncers processes values freeing enough space to store   *
  *           the new value.                                                   *
+ *           If added flags are requested the function does not wait and      *
+ *           stops at the first value not fitting into the shard, so values   *
+ *           of an item are always added in order.                            *
+ *           Values that cannot fit even into empty shard are dropped with a  *
+ *           warning, waiting for them would never end.                       *
  *                                                                            *
  ******************************************************************************/
-static void	hc_add_item_values(dc_item_value_t *values, int values_num)
+static void	hc_add_item_values(trx_hc_shard_t *shard, dc_item_value_t *values, const int *indexes,
+		int indexes_num, const char *strings, unsigned char *added)
 {
 	dc_item_value_t	*item_value;
 	int		i;
 	trx_hc_item_t	*item;
 
-	for (i = 0; i < values_num; i++)
+	LOCK_SHARD(shard);
+
+	for (i = 0; i < indexes_num; i++)
 	{
 		trx_hc_data_t	*data = NULL;
 
-		item_value = &values[i];
+		item_value = &values[indexes[i]];
 
-		while (SUCCEED != hc_clone_history_data(&data, item_value))
+		if (hc_mem[shard->index]->total_size < hc_value_size(item_value))
+			goto skip;
+
+		while (SUCCEED != hc_clone_history_data(shard, &data, item_value, strings))
 		{
-			UNLOCK_CACHE;
+			if (NULL != data)
+			{
+				hc_free_partial_data(shard, data, item_value);
+				data = NULL;
+			}
+
+			/* with no values in the shard there is nothing history syncers could free */
+			if (0 == shard->history_num)
+				goto skip;
+
+			if (NULL != added)
+				goto out;
+
+			UNLOCK_SHARD(shard);
 
 			treegix_log(LOG_LEVEL_DEBUG, "History cache is full. Sleeping for 1 second.");
 			sleep(1);
 
-			LOCK_CACHE;
+			LOCK_SHARD(shard);
 		}
 
-		if (NULL == (item = hc_get_item(item_value->itemid)))
+		if (NULL == (item = hc_get_item(shard, item_value->itemid)))
 		{
-			item = hc_add_item(item_value->itemid, data);
-			hc_queue_item(item);
+			item = hc_add_item(shard, item_value->itemid, data);
+			hc_queue_item(shard, item);
 		}
 		else
 		{
 			item->head->next = data;
 			item->head = data;
 		}
+
+		shard->history_num++;
+
+		if (NULL != added)
+			added[indexes[i]] = 1;
+
+		continue;
+skip:
+		treegix_log(LOG_LEVEL_WARNING, "cannot add value of item [" TRX_FS_UI64 "] to history cache:"
+				" value size exceeds history cache shard size, increase HistoryCacheSize",
+				item_value->itemid);
+
+		if (NULL != added)
+			added[indexes[i]] = 1;
 	}
+out:
+	UNLOCK_SHARD(shard);
 }
 
 /******************************************************************************
@@ -3979,23 +4940,52 @@ static void	hc_copy_history_data(TRX_DC_HISTORY *history, trx_uint64_t itemid, t
  *                                                                            *
  * Parameters: history_items - [OUT] the locked history items                 *
  *                                                                            *
- * Comments: The history_items must be returned back to history cache with    *
- *           hc_push_items() function after they have been processed.         *
+ * Return value: the history cache shard the items were taken from            *
+ *                                                                            *
+ * Comments: The history_items must be returned back to the same history      *
+ *           cache shard with hc_push_items() function after they have been   *
+ *           processed.                                                       *
+ *           Shards are checked in round robin order starting with the next   *
+ *           shard after the last synced one, so the batch is taken from the  *
+ *           first shard having data.                                         *
  *                                                                            *
  ******************************************************************************/
-static void	hc_pop_items(trx_vector_ptr_t *history_items)
+static trx_hc_shard_t	*hc_pop_items(trx_vector_ptr_t *history_items)
 {
 	trx_binary_heap_elem_t	*elem;
 	trx_hc_item_t		*item;
+	trx_hc_shard_t		*shard = NULL;
+	int			i;
 
-	while (TRX_HC_SYNC_MAX > history_items->values_num && FAIL == trx_binary_heap_empty(&cache->history_queue))
+	/* spread history syncers across shards */
+	if (-1 == sync_shard)
+		sync_shard = process_num % cache->shards_num;
+
+	for (i = 0; i < cache->shards_num; i++)
 	{
-		elem = trx_binary_heap_find_min(&cache->history_queue);
-		item = (trx_hc_item_t *)elem->data;
-		trx_vector_ptr_append(history_items, item);
+		shard = cache->shards[(sync_shard + i) % cache->shards_num];
+
+		LOCK_SHARD(shard);
+
+		while (sync_batch > history_items->values_num &&
+				FAIL == trx_binary_heap_empty(&shard->history_queue))
+		{
+			elem = trx_binary_heap_find_min(&shard->history_queue);
+			item = (trx_hc_item_t *)elem->data;
+			trx_vector_ptr_append(history_items, item);
+
+			trx_binary_heap_remove_min(&shard->history_queue);
+		}
+
+		UNLOCK_SHARD(shard);
 
-		trx_binary_heap_remove_min(&cache->history_queue);
+		if (0 != history_items->values_num)
+			break;
 	}
+
+	sync_shard = (shard->index + 1) % cache->shards_num;
+
+	return shard;
 }
 
 /******************************************************************************
@@ -4032,7 +5022,9 @@ static void	hc_get_item_values(TRX_DC_HISTORY *history, trx_vector_ptr_t *histor
  *                                                                            *
  * Purpose: push back the processed history items into history cache          *
  *                                                                            *
- * Parameters: history_items - [IN] the history items containing processed    *
+ * Parameters: shard         - [IN] the history cache shard the items were    *
+ *                                  taken from                                *
+ *             history_items - [IN] the history items containing processed    *
  *                                  (available) and busy items                *
  *                                                                            *
  * Comments: This function removes processed value from history cache.        *
@@ -4040,7 +5032,7 @@ static void	hc_get_item_values(TRX_DC_HISTORY *history, trx_vector_ptr_t *histor
  *           removed from history index.                                      *
  *                                                                            *
  ******************************************************************************/
-void	hc_push_items(trx_vector_ptr_t *history_items)
+void	hc_push_items(trx_hc_shard_t *shard, trx_vector_ptr_t *history_items)
 {
 	int		i;
 	trx_hc_item_t	*item;
@@ -4055,16 +5047,16 @@ void	hc_push_items(trx_vector_ptr_t *history_items)
 			case TRX_HC_ITEM_STATUS_BUSY:
 				/* reset item status before returning it to queue */
 				item->status = TRX_HC_ITEM_STATUS_NORMAL;
-				hc_queue_item(item);
+				hc_queue_item(shard, item);
 				break;
 			case TRX_HC_ITEM_STATUS_NORMAL:
 				data_free = item->tail;
 				item->tail = item->tail->next;
-				hc_free_data(data_free);
+				hc_free_data(shard, data_free);
 				if (NULL == item->tail)
-					trx_hashset_remove(&cache->history_items, item);
+					trx_hashset_remove(&shard->history_items, item);
 				else
-					hc_queue_item(item);
+					hc_queue_item(shard, item);
 				break;
 		}
 	}
@@ -4076,10 +5068,43 @@ void	hc_push_items(trx_vector_ptr_t *history_items)
  *                                                                            *
  * Purpose: retrieve the size of history queue                                *
  *                                                                            *
+ * Return value: the total number of queued items in all history cache shards *
+ *                                                                            *
  ******************************************************************************/
 int	hc_queue_get_size(void)
 {
-	return cache->history_queue.elems_num;
+	int	i, size = 0;
+
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		trx_hc_shard_t	*shard = cache->shards[i];
+
+		LOCK_SHARD(shard);
+		size += shard->history_queue.elems_num;
+		UNLOCK_SHARD(shard);
+	}
+
+	return size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_get_history_num                                               *
+ *                                                                            *
+ * Purpose: retrieve the number of values in history cache                    *
+ *                                                                            *
+ * Comments: Shards are not locked as the result is used only for logging     *
+ *           and progress reporting.                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_get_history_num(void)
+{
+	int	i, history_num = 0;
+
+	for (i = 0; i < cache->shards_num; i++)
+		history_num += cache->shards[i]->history_num;
+
+	return history_num;
 }
 
 /******************************************************************************
@@ -4133,6 +5158,110 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: init_history_cache_shard                                         *
+ *                                                                            *
+ * Purpose: allocate shared memory and create lock for history cache shard    *
+ *                                                                            *
+ * Parameters: index      - [IN] the shard index                              *
+ *             shards_num - [IN] the number of shards                         *
+ *             shard      - [OUT] the initialized shard                       *
+ *             error      - [OUT] the error message                           *
+ *                                                                            *
+ * Return value: SUCCEED - the shard was initialized successfully             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: History cache and history index cache sizes are split evenly     *
+ *           between shards.                                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	init_history_cache_shard(int index, int shards_num, trx_hc_shard_t **shard, char **error)
+{
+	const trx_hc_mem_funcs_t	*mem_funcs = &hc_mem_funcs[index];
+	int				ret;
+
+	if (SUCCEED != (ret = trx_mutex_create(&shard_locks[index], TRX_MUTEX_CACHE_SHARD_FIRST + index, error)))
+		return ret;
+
+	if (SUCCEED != (ret = trx_mem_create(&hc_mem[index], CONFIG_HISTORY_CACHE_SIZE / shards_num,
+			"history cache", "HistoryCacheSize", 1, error)))
+	{
+		return ret;
+	}
+
+	if (SUCCEED != (ret = trx_mem_create(&hc_index_mem[index], CONFIG_HISTORY_INDEX_CACHE_SIZE / shards_num,
+			"history index cache", "HistoryIndexCacheSize", 0, error)))
+	{
+		return ret;
+	}
+
+	*shard = (trx_hc_shard_t *)mem_funcs->index_malloc_func(NULL, sizeof(trx_hc_shard_t));
+	memset(*shard, 0, sizeof(trx_hc_shard_t));
+
+	(*shard)->index = index;
+	(*shard)->mem_malloc_func = mem_funcs->malloc_func;
+	(*shard)->mem_realloc_func = mem_funcs->realloc_func;
+	(*shard)->mem_free_func = mem_funcs->free_func;
+
+	trx_hashset_create_ext(&(*shard)->history_items, TRX_HC_ITEMS_INIT_SIZE / shards_num,
+			TRX_DEFAULT_UINT64_HASH_FUNC, TRX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+			mem_funcs->index_malloc_func, mem_funcs->index_realloc_func, mem_funcs->index_free_func);
+
+	trx_binary_heap_create_ext(&(*shard)->history_queue, hc_queue_elem_compare_func,
+			TRX_BINARY_HEAP_OPTION_EMPTY, mem_funcs->index_malloc_func, mem_funcs->index_realloc_func,
+			mem_funcs->index_free_func);
+
+	return SUCCEED;
+}
+
+#ifdef HAVE_TRX_RINGBUF
+/******************************************************************************
+ *                                                                            *
+ * Function: init_history_rings                                               *
+ *                                                                            *
+ * Purpose: allocates history ingest rings for history syncers                *
+ *                                                                            *
+ * Parameters: error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the rings were allocated successfully              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	init_history_rings(char **error)
+{
+	size_t	ring_size, mem_size;
+	int	i, ret;
+
+	/* ring size must be power of 2 */
+	for (ring_size = TRX_MEBIBYTE; ring_size * 2 <= CONFIG_HISTORY_RING_SIZE; ring_size *= 2)
+		;
+
+	mem_size = trx_mem_required_size(CONFIG_HISTSYNCER_FORKS + 2, "history ring", "HistoryRingSize") +
+			TRX_SIZE_T_ALIGN8(sizeof(trx_ringbuf_t *) * CONFIG_HISTSYNCER_FORKS) +
+			TRX_SIZE_T_ALIGN8(sizeof(int) * CONFIG_HISTSYNCER_FORKS) +
+			trx_ringbuf_required_size(ring_size) * CONFIG_HISTSYNCER_FORKS;
+
+	if (SUCCEED != (ret = trx_mem_create(&ring_mem, mem_size, "history ring", "HistoryRingSize", 0, error)))
+		return ret;
+
+	cache->rings = (trx_ringbuf_t **)trx_mem_malloc(ring_mem, NULL,
+			sizeof(trx_ringbuf_t *) * CONFIG_HISTSYNCER_FORKS);
+	cache->rings_waiting = (int *)trx_mem_malloc(ring_mem, NULL, sizeof(int) * CONFIG_HISTSYNCER_FORKS);
+	memset(cache->rings_waiting, 0, sizeof(int) * CONFIG_HISTSYNCER_FORKS);
+
+	for (i = 0; i < CONFIG_HISTSYNCER_FORKS; i++)
+	{
+		cache->rings[i] = trx_ringbuf_init(trx_mem_malloc(ring_mem, NULL, trx_ringbuf_required_size(ring_size)),
+				ring_size);
+	}
+
+	cache->rings_num = CONFIG_HISTSYNCER_FORKS;
+
+	return SUCCEED;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: init_database_cache                                              *
@@ -4144,7 +5273,8 @@ out:
  ******************************************************************************/
 int	init_database_cache(char **error)
 {
-	int	ret;
+	int		ret, i;
+	trx_hc_shard_t	*shards[TRX_HC_SHARDS_MAX];
 
 	treegix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -4154,30 +5284,21 @@ int	init_database_cache(char **error)
 	if (SUCCEED != (ret = trx_mutex_create(&cache_ids_lock, TRX_MUTEX_CACHE_IDS, error)))
 		goto out;
 
-	if (SUCCEED != (ret = trx_mem_create(&hc_mem, CONFIG_HISTORY_CACHE_SIZE, "history cache",
-			"HistoryCacheSize", 1, error)))
+	for (i = 0; i < CONFIG_HISTORY_CACHE_SHARDS; i++)
 	{
-		goto out;
-	}
-
-	if (SUCCEED != (ret = trx_mem_create(&hc_index_mem, CONFIG_HISTORY_INDEX_CACHE_SIZE, "history index cache",
-			"HistoryIndexCacheSize", 0, error)))
-	{
-		goto out;
+		if (SUCCEED != (ret = init_history_cache_shard(i, CONFIG_HISTORY_CACHE_SHARDS, &shards[i], error)))
+			goto out;
 	}
 
-	cache = (TRX_DC_CACHE *)__hc_index_mem_malloc_func(NULL, sizeof(TRX_DC_CACHE));
+	/* database cache header and ids are stored in the index memory of the first shard */
+	cache = (TRX_DC_CACHE *)hc_mem_funcs[0].index_malloc_func(NULL, sizeof(TRX_DC_CACHE));
 	memset(cache, 0, sizeof(TRX_DC_CACHE));
 
-	ids = (TRX_DC_IDS *)__hc_index_mem_malloc_func(NULL, sizeof(TRX_DC_IDS));
-	memset(ids, 0, sizeof(TRX_DC_IDS));
+	memcpy(cache->shards, shards, sizeof(trx_hc_shard_t *) * CONFIG_HISTORY_CACHE_SHARDS);
+	cache->shards_num = CONFIG_HISTORY_CACHE_SHARDS;
 
-	trx_hashset_create_ext(&cache->history_items, TRX_HC_ITEMS_INIT_SIZE,
-			TRX_DEFAULT_UINT64_HASH_FUNC, TRX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
-			__hc_index_mem_malloc_func, __hc_index_mem_realloc_func, __hc_index_mem_free_func);
-
-	trx_binary_heap_create_ext(&cache->history_queue, hc_queue_elem_compare_func, TRX_BINARY_HEAP_OPTION_EMPTY,
-			__hc_index_mem_malloc_func, __hc_index_mem_realloc_func, __hc_index_mem_free_func);
+	ids = (TRX_DC_IDS *)hc_mem_funcs[0].index_malloc_func(NULL, sizeof(TRX_DC_IDS));
+	memset(ids, 0, sizeof(TRX_DC_IDS));
 
 	if (0 != (program_type & TRX_PROGRAM_TYPE_SERVER))
 	{
@@ -4185,6 +5306,31 @@ int	init_database_cache(char **error)
 			goto out;
 	}
 
+	if (0 != CONFIG_HISTORY_RING_SIZE)
+	{
+#ifdef HAVE_TRX_RINGBUF
+		if (SUCCEED != (ret = init_history_rings(error)))
+			goto out;
+#else
+		*error = trx_strdup(*error, "history ingest rings are not supported on this platform,"
+				" set \"HistoryRingSize\" configuration parameter to 0");
+		ret = FAIL;
+		goto out;
+#endif
+	}
+
+	/* history syncer batch statistics are stored in the index memory of the first shard */
+	cache->sync_stats = (trx_hc_sync_stats_t *)hc_mem_funcs[0].index_malloc_func(NULL,
+			sizeof(trx_hc_sync_stats_t) * CONFIG_HISTSYNCER_FORKS);
+
+	for (i = 0; i < CONFIG_HISTSYNCER_FORKS; i++)
+	{
+		cache->sync_stats[i].batch = TRX_HC_SYNC_DEFAULT;
+		cache->sync_stats[i].latency = 0.0;
+	}
+
+	cache->sync_stats_num = CONFIG_HISTSYNCER_FORKS;
+
 	cache->history_num_total = 0;
 	cache->history_progress_ts = 0;
 
@@ -4227,10 +5373,15 @@ static void	DCsync_all(void)
  ******************************************************************************/
 void	free_database_cache(void)
 {
+	int	i;
+
 	treegix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	DCsync_all();
 
+	for (i = 0; i < cache->shards_num; i++)
+		trx_mutex_destroy(&shard_locks[i]);
+
 	cache = NULL;
 
 	trx_mutex_destroy(&cache_lock);
@@ -22,8 +22,11 @@
 
 int	sync_in_progress = 0;
 
-#define START_SYNC	WRLOCK_CACHE; sync_in_progress = 1
-#define FINISH_SYNC	sync_in_progress = 0; UNLOCK_CACHE
+/* configuration cache write lock timestamp and the longest lock hold time during the current synchronization */
+static double	sync_lock_ts, sync_lock_max;
+
+#define START_SYNC	WRLOCK_CACHE; sync_in_progress = 1; sync_lock_ts = trx_time()
+#define FINISH_SYNC	dc_sync_lock_update(); sync_in_progress = 0; UNLOCK_CACHE
 
 #define TRX_LOC_NOWHERE	0
 #define TRX_LOC_QUEUE	1
@@ -174,6 +177,11 @@ static unsigned char	poller_by_item(unsigned char type, const char *key)
 {
 	switch (type)
 	{
+		case ITEM_TYPE_TREEGIX:
+			if (0 == CONFIG_POLLER_FORKS)
+				break;
+
+			return TRX_POLLER_TYPE_NORMAL;
 		case ITEM_TYPE_SIMPLE:
 			if (SUCCEED == cmp_key_id(key, SERVER_ICMPPING_KEY) ||
 					SUCCEED == cmp_key_id(key, SERVER_ICMPPINGSEC_KEY) ||
@@ -185,7 +193,6 @@ static unsigned char	poller_by_item(unsigned char type, const char *key)
 				return TRX_POLLER_TYPE_PINGER;
 			}
 			TRX_FALLTHROUGH;
-		case ITEM_TYPE_TREEGIX:
 		case ITEM_TYPE_SNMPv1:
 		case ITEM_TYPE_SNMPv2c:
 		case ITEM_TYPE_SNMPv3:
@@ -196,7 +203,14 @@ static unsigned char	poller_by_item(unsigned char type, const char *key)
 		case ITEM_TYPE_SSH:
 		case ITEM_TYPE_TELNET:
 		case ITEM_TYPE_CALCULATED:
+			if (0 == CONFIG_POLLER_FORKS)
+				break;
+
+			return TRX_POLLER_TYPE_NORMAL;
 		case ITEM_TYPE_HTTPAGENT:
+			if (0 != CONFIG_HTTPAGENT_POLLER_FORKS)
+				return TRX_POLLER_TYPE_HTTPAGENT;
+
 			if (0 == CONFIG_POLLER_FORKS)
 				break;
 
@@ -216,6 +230,34 @@ static unsigned char	poller_by_item(unsigned char type, const char *key)
 	return TRX_NO_POLLER;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: poller_by_agent_item                                             *
+ *                                                                            *
+ * Purpose: get poller type of passive agent item that can be checked         *
+ *          asynchronously                                                    *
+ *                                                                            *
+ * Return value: TRX_POLLER_TYPE_AGENT for passive agent items if agent       *
+ *               pollers are started, TRX_NO_POLLER otherwise                 *
+ *                                                                            *
+ * Comments: TLS connections are established without blocking only with       *
+ *           OpenSSL, with other TLS libraries the items of hosts with        *
+ *           encrypted connections are checked by regular pollers.            *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned char	poller_by_agent_item(const TRX_DC_ITEM *dc_item, const TRX_DC_HOST *dc_host)
+{
+	if (0 == CONFIG_AGENTPOLLER_FORKS || ITEM_TYPE_TREEGIX != dc_item->type)
+		return TRX_NO_POLLER;
+#if !defined(HAVE_OPENSSL)
+	if (TRX_TCP_SEC_UNENCRYPTED != dc_host->tls_connect)
+		return TRX_NO_POLLER;
+#else
+	TRX_UNUSED(dc_host);
+#endif
+	return TRX_POLLER_TYPE_AGENT;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: trx_is_counted_in_item_queue                                     *
@@ -386,12 +428,16 @@ static void	DCitem_poller_type_update(TRX_DC_ITEM *dc_item, const TRX_DC_HOST *d
 		return;
 	}
 
-	poller_type = poller_by_item(dc_item->type, dc_item->key);
+	if (TRX_NO_POLLER == (poller_type = poller_by_agent_item(dc_item, dc_host)))
+		poller_type = poller_by_item(dc_item->type, dc_item->key);
 
 	if (0 != (flags & TRX_HOST_UNREACHABLE))
 	{
-		if (TRX_POLLER_TYPE_NORMAL == poller_type || TRX_POLLER_TYPE_JAVA == poller_type)
+		if (TRX_POLLER_TYPE_NORMAL == poller_type || TRX_POLLER_TYPE_JAVA == poller_type ||
+				TRX_POLLER_TYPE_AGENT == poller_type)
+		{
 			poller_type = TRX_POLLER_TYPE_UNREACHABLE;
+		}
 
 		dc_item->poller_type = poller_type;
 		return;
@@ -404,7 +450,8 @@ static void	DCitem_poller_type_update(TRX_DC_ITEM *dc_item, const TRX_DC_HOST *d
 	}
 
 	if (TRX_POLLER_TYPE_UNREACHABLE != dc_item->poller_type ||
-			(TRX_POLLER_TYPE_NORMAL != poller_type && TRX_POLLER_TYPE_JAVA != poller_type))
+			(TRX_POLLER_TYPE_NORMAL != poller_type && TRX_POLLER_TYPE_JAVA != poller_type &&
+			TRX_POLLER_TYPE_AGENT != poller_type))
 	{
 		dc_item->poller_type = poller_type;
 	}
@@ -4869,6 +4916,27 @@ static void	dc_hostgroups_update_cache(void)
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_sync_lock_update                                              *
+ *                                                                            *
+ * Purpose: updates configuration cache write lock hold time statistics of    *
+ *          the current synchronization                                       *
+ *                                                                            *
+ * Comments: Must be called before releasing the write lock acquired by       *
+ *           START_SYNC.                                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_sync_lock_update(void)
+{
+	double	sec;
+
+	sec = trx_time() - sync_lock_ts;
+
+	if (sync_lock_max < sec)
+		sync_lock_max = sec;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: DCsync_configuration                                             *
@@ -4902,7 +4970,10 @@ void	DCsync_configuration(unsigned char mode)
 
 	treegix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	sync_lock_max = 0.0;
+
 	trx_dbsync_init_env(config);
+	trx_dbsync_env_read_changelog(mode);
 
 	/* global configuration must be synchronized directly with database */
 	trx_dbsync_init(&config_sync, TRX_DBSYNC_INIT);
@@ -5004,6 +5075,14 @@ void	DCsync_configuration(unsigned char mode)
 	host_tag_sec2 = trx_time() - sec;
 	FINISH_SYNC;
 
+	/* macro changes are not recorded in changelog but can change items and triggers */
+	if (0 != htmpl_sync.add_num + htmpl_sync.update_num + htmpl_sync.remove_num ||
+			0 != gmacro_sync.add_num + gmacro_sync.update_num + gmacro_sync.remove_num ||
+			0 != hmacro_sync.add_num + hmacro_sync.update_num + hmacro_sync.remove_num)
+	{
+		trx_dbsync_env_require_full_sync();
+	}
+
 	/* sync host data to support host lookups when resolving macros during configuration sync */
 
 	sec = trx_time();
@@ -5044,7 +5123,11 @@ void	DCsync_configuration(unsigned char mode)
 	sec = trx_time();
 	DCsync_host_inventory(&hi_sync);
 	hisec2 = trx_time() - sec;
+	FINISH_SYNC;
 
+	/* host groups and maintenances reference hosts by identifiers only, so they can be */
+	/* published separately to keep the write lock hold time short                     */
+	START_SYNC;
 	sec = trx_time();
 	DCsync_hostgroups(&hgroups_sync);
 	DCsync_hostgroup_hosts(&hgroup_host_sync);
@@ -5097,6 +5180,7 @@ void	DCsync_configuration(unsigned char mode)
 		goto out;
 	itempp_sec = trx_time() - sec;
 
+	/* interfaces, items and their preprocessing reference each other and must be published together */
 	START_SYNC;
 
 	/* resolves macros for interface_snmpaddrs, must be after DCsync_hmacros() */
@@ -5186,6 +5270,9 @@ void	DCsync_configuration(unsigned char mode)
 		goto out;
 	corr_operation_sec = trx_time() - sec;
 
+	/* Triggers, their dependencies, tags and the trigger links must be published together. */
+	/* Expressions, actions and correlations do not reference cached triggers and are      */
+	/* published in separate critical sections to keep the write lock hold time short.     */
 	START_SYNC;
 
 	sec = trx_time();
@@ -5196,41 +5283,11 @@ void	DCsync_configuration(unsigned char mode)
 	DCsync_trigdeps(&tdep_sync);
 	dsec2 = trx_time() - sec;
 
-	sec = trx_time();
-	DCsync_expressions(&expr_sync);
-	expr_sec2 = trx_time() - sec;
-
-	sec = trx_time();
-	DCsync_actions(&action_sync);
-	action_sec2 = trx_time() - sec;
-
-	sec = trx_time();
-	DCsync_action_ops(&action_op_sync);
-	action_op_sec2 = trx_time() - sec;
-
-	sec = trx_time();
-	DCsync_action_conditions(&action_condition_sync);
-	action_condition_sec2 = trx_time() - sec;
-
 	sec = trx_time();
 	/* relies on triggers, must be after DCsync_triggers() */
 	DCsync_trigger_tags(&trigger_tag_sync);
 	trigger_tag_sec2 = trx_time() - sec;
 
-	sec = trx_time();
-	DCsync_correlations(&correlation_sync);
-	correlation_sec2 = trx_time() - sec;
-
-	sec = trx_time();
-	/* relies on correlation rules, must be after DCsync_correlations() */
-	DCsync_corr_conditions(&corr_condition_sync);
-	corr_condition_sec2 = trx_time() - sec;
-
-	sec = trx_time();
-	/* relies on correlation rules, must be after DCsync_correlations() */
-	DCsync_corr_operations(&corr_operation_sync);
-	corr_operation_sec2 = trx_time() - sec;
-
 	sec = trx_time();
 
 	if (0 != hosts_sync.add_num + hosts_sync.update_num + hosts_sync.remove_num)
@@ -5260,9 +5317,55 @@ void	DCsync_configuration(unsigned char mode)
 	}
 
 	update_sec = trx_time() - sec;
+	FINISH_SYNC;
+
+	START_SYNC;
+	sec = trx_time();
+	DCsync_expressions(&expr_sync);
+	expr_sec2 = trx_time() - sec;
+	FINISH_SYNC;
+
+	START_SYNC;
+	sec = trx_time();
+	DCsync_actions(&action_sync);
+	action_sec2 = trx_time() - sec;
+
+	sec = trx_time();
+	DCsync_action_ops(&action_op_sync);
+	action_op_sec2 = trx_time() - sec;
+
+	sec = trx_time();
+	DCsync_action_conditions(&action_condition_sync);
+	action_condition_sec2 = trx_time() - sec;
+	FINISH_SYNC;
+
+	START_SYNC;
+	sec = trx_time();
+	DCsync_correlations(&correlation_sync);
+	correlation_sec2 = trx_time() - sec;
+
+	sec = trx_time();
+	/* relies on correlation rules, must be after DCsync_correlations() */
+	DCsync_corr_conditions(&corr_condition_sync);
+	corr_condition_sec2 = trx_time() - sec;
+
+	sec = trx_time();
+	/* relies on correlation rules, must be after DCsync_correlations() */
+	DCsync_corr_operations(&corr_operation_sync);
+	corr_operation_sec2 = trx_time() - sec;
+
+	config->status->last_update = 0;
+	config->sync_ts = time(NULL);
+
+	/* publish the longest write lock hold time of this synchronization */
+	dc_sync_lock_update();
+	config->sync_lock_max = sync_lock_max;
+	FINISH_SYNC;
 
 	if (SUCCEED == TRX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
 	{
+		RDLOCK_CACHE;
+
 		total = csec + hsec + hisec + htsec + gmsec + hmsec + ifsec + isec + tsec + dsec + fsec + expr_sec +
 				action_sec + action_op_sec + action_condition_sec + trigger_tag_sec + correlation_sec +
 				corr_condition_sec + corr_operation_sec + hgroups_sec + itempp_sec + maintenance_sec;
@@ -5506,13 +5609,14 @@ void	DCsync_configuration(unsigned char mode)
 		treegix_log(LOG_LEVEL_DEBUG, "%s() strings    : %d (%d slots)", __func__,
 				config->strpool.num_data, config->strpool.num_slots);
 
+		treegix_log(LOG_LEVEL_DEBUG, "%s() lock max   : " TRX_FS_DBL " sec.", __func__, sync_lock_max);
+
 		trx_mem_dump_stats(LOG_LEVEL_DEBUG, config_mem);
-	}
 
-	config->status->last_update = 0;
-	config->sync_ts = time(NULL);
+		UNLOCK_CACHE;
+	}
 
-	FINISH_SYNC;
+	trx_dbsync_env_clear_changelog();
 out:
 	trx_dbsync_clear(&config_sync);
 	trx_dbsync_clear(&autoreg_config_sync);
@@ -5903,7 +6007,13 @@ int	init_configuration_cache(char **error)
 	trx_hashset_create_ext(&hashset, hashset_size, hash_func, compare_func, NULL,				\
 			__config_mem_malloc_func, __config_mem_realloc_func, __config_mem_free_func)
 
-	CREATE_HASHSET(config->items, 100);
+/* the most frequently searched hashsets use open addressing to avoid entry chain traversal */
+#define CREATE_HASHSET_UINT64(hashset, hashset_size)								\
+														\
+	trx_hashset_create_uint64_ext(&hashset, hashset_size, NULL,						\
+			__config_mem_malloc_func, __config_mem_realloc_func, __config_mem_free_func)
+
+	CREATE_HASHSET_UINT64(config->items, 100);
 	CREATE_HASHSET(config->numitems, 0);
 	CREATE_HASHSET(config->snmpitems, 0);
 	CREATE_HASHSET(config->ipmiitems, 0);
@@ -5921,10 +6031,10 @@ int	init_configuration_cache(char **error)
 	CREATE_HASHSET(config->httpitems, 0);
 	CREATE_HASHSET(config->template_items, 0);
 	CREATE_HASHSET(config->prototype_items, 0);
-	CREATE_HASHSET(config->functions, 100);
-	CREATE_HASHSET(config->triggers, 100);
+	CREATE_HASHSET_UINT64(config->functions, 100);
+	CREATE_HASHSET_UINT64(config->triggers, 100);
 	CREATE_HASHSET(config->trigdeps, 0);
-	CREATE_HASHSET(config->hosts, 10);
+	CREATE_HASHSET_UINT64(config->hosts, 10);
 	CREATE_HASHSET(config->proxies, 0);
 	CREATE_HASHSET(config->host_inventories, 0);
 	CREATE_HASHSET(config->host_inventories_auto, 0);
@@ -6023,6 +6133,7 @@ int	init_configuration_cache(char **error)
 	config->availability_diff_ts = 0;
 	config->sync_ts = 0;
 	config->item_sync_ts = 0;
+	config->sync_lock_max = 0.0;
 
 	/* maintenance data are used only when timers are defined (server) */
 	if (0 != CONFIG_TIMER_FORKS)
@@ -6049,6 +6160,7 @@ int	init_configuration_cache(char **error)
 
 #undef CREATE_HASHSET
 #undef CREATE_HASHSET_EXT
+#undef CREATE_HASHSET_UINT64
 out:
 	treegix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 
@@ -7109,6 +7221,62 @@ out:
 	treegix_log(LOG_LEVEL_DEBUG, "End of %s() items:%d", __func__, items->num_data);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: DCconfig_get_preprocessable_itemids                              *
+ *                                                                            *
+ * Purpose: get identifiers of items which values must be passed through      *
+ *          preprocessing manager (see DCconfig_get_preprocessable_items())   *
+ *                                                                            *
+ * Parameters: itemids   - [IN/OUT] hashset with item identifiers             *
+ *             timestamp - [IN/OUT] timestamp of a last update                *
+ *                                                                            *
+ * Comments: The items having preprocessing steps, dependent items or being   *
+ *           internal items are copied under a single configuration cache     *
+ *           lock only when item configuration has changed since the last     *
+ *           update, so data gathering processes can check values of the      *
+ *           whole batch without locking configuration cache.                 *
+ *                                                                            *
+ ******************************************************************************/
+void	DCconfig_get_preprocessable_itemids(trx_hashset_t *itemids, int *timestamp)
+{
+	const TRX_DC_PREPROCITEM	*dc_preprocitem;
+	const TRX_DC_MASTERITEM		*dc_masteritem;
+	const TRX_DC_ITEM		*dc_item;
+	trx_hashset_iter_t		iter;
+
+	treegix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	/* no changes */
+	if (0 != *timestamp && *timestamp == config->item_sync_ts)
+		goto out;
+
+	trx_hashset_clear(itemids);
+
+	RDLOCK_CACHE;
+
+	*timestamp = config->item_sync_ts;
+
+	trx_hashset_iter_reset(&config->preprocitems, &iter);
+	while (NULL != (dc_preprocitem = (const TRX_DC_PREPROCITEM *)trx_hashset_iter_next(&iter)))
+		trx_hashset_insert(itemids, &dc_preprocitem->itemid, sizeof(trx_uint64_t));
+
+	trx_hashset_iter_reset(&config->masteritems, &iter);
+	while (NULL != (dc_masteritem = (const TRX_DC_MASTERITEM *)trx_hashset_iter_next(&iter)))
+		trx_hashset_insert(itemids, &dc_masteritem->itemid, sizeof(trx_uint64_t));
+
+	trx_hashset_iter_reset(&config->items, &iter);
+	while (NULL != (dc_item = (const TRX_DC_ITEM *)trx_hashset_iter_next(&iter)))
+	{
+		if (ITEM_TYPE_INTERNAL == dc_item->type)
+			trx_hashset_insert(itemids, &dc_item->itemid, sizeof(trx_uint64_t));
+	}
+
+	UNLOCK_CACHE;
+out:
+	treegix_log(LOG_LEVEL_DEBUG, "End of %s() items:%d", __func__, itemids->num_data);
+}
+
 void	DCconfig_get_hosts_by_itemids(DC_HOST *hosts, const trx_uint64_t *itemids, int *errcodes, size_t num)
 {
 	size_t			i;
@@ -7897,32 +8065,20 @@ static void	dc_requeue_item_at(TRX_DC_ITEM *dc_item, TRX_DC_HOST *dc_host, int n
 
 /******************************************************************************
  *                                                                            *
- * Function: DCconfig_get_poller_items                                        *
+ * Function: dc_config_get_poller_items                                       *
  *                                                                            *
- * Purpose: Get array of items for selected poller                            *
+ * Purpose: get array of items for selected poller                            *
  *                                                                            *
  * Parameters: poller_type - [IN] poller type (TRX_POLLER_TYPE_...)           *
  *             items       - [OUT] array of items                             *
+ *             max_items   - [IN] the maximum number of items to get          *
  *                                                                            *
  * Return value: number of items in items array                               *
  *                                                                            *
- * Author: Alexander Vladishev, Aleksandrs Saveljevs                          *
- *                                                                            *
- * Comments: Items leave the queue only through this function. Pollers must   *
- *           always return the items they have taken using DCrequeue_items()  *
- *           or DCpoller_requeue_items().                                     *
- *                                                                            *
- *           Currently batch polling is supported only for JMX, SNMP and      *
- *           icmpping* simple checks. In other cases only single item is      *
- *           retrieved.                                                       *
- *                                                                            *
- *           IPMI poller queue are handled by DCconfig_get_ipmi_poller_items()*
- *           function.                                                        *
- *                                                                            *
  ******************************************************************************/
-int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
+static int	dc_config_get_poller_items(unsigned char poller_type, DC_ITEM *items, int max_items)
 {
-	int			now, num = 0, max_items;
+	int			now, num = 0;
 	trx_binary_heap_t	*queue;
 
 	treegix_log(LOG_LEVEL_DEBUG, "In %s() poller_type:%d", __func__, (int)poller_type);
@@ -7931,18 +8087,6 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 
 	queue = &config->queues[poller_type];
 
-	switch (poller_type)
-	{
-		case TRX_POLLER_TYPE_JAVA:
-			max_items = MAX_JAVA_ITEMS;
-			break;
-		case TRX_POLLER_TYPE_PINGER:
-			max_items = MAX_PINGER_ITEMS;
-			break;
-		default:
-			max_items = 1;
-	}
-
 	WRLOCK_CACHE;
 
 	while (num < max_items && FAIL == trx_binary_heap_empty(queue))
@@ -8007,7 +8151,7 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 				/* postpone checks on hosts that have been checked recently and */
 				/* are still unreachable                                        */
 				if (TRX_POLLER_TYPE_NORMAL == poller_type || TRX_POLLER_TYPE_JAVA == poller_type ||
-						disable_until > now)
+						TRX_POLLER_TYPE_AGENT == poller_type || disable_until > now)
 				{
 					dc_requeue_item(dc_item, dc_host, dc_item->state,
 							TRX_ITEM_COLLECTED | TRX_HOST_UNREACHABLE, now);
@@ -8046,6 +8190,72 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 	return num;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: DCconfig_get_poller_items                                        *
+ *                                                                            *
+ * Purpose: Get array of items for selected poller                            *
+ *                                                                            *
+ * Parameters: poller_type - [IN] poller type (TRX_POLLER_TYPE_...)           *
+ *             items       - [OUT] array of items                             *
+ *                                                                            *
+ * Return value: number of items in items array                               *
+ *                                                                            *
+ * Author: Alexander Vladishev, Aleksandrs Saveljevs                          *
+ *                                                                            *
+ * Comments: Items leave the queue only through this function. Pollers must   *
+ *           always return the items they have taken using DCrequeue_items()  *
+ *           or DCpoller_requeue_items().                                     *
+ *                                                                            *
+ *           Currently batch polling is supported only for JMX, SNMP and      *
+ *           icmpping* simple checks. In other cases only single item is      *
+ *           retrieved.                                                       *
+ *                                                                            *
+ *           IPMI poller queue are handled by DCconfig_get_ipmi_poller_items()*
+ *           function.                                                        *
+ *                                                                            *
+ ******************************************************************************/
+int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
+{
+	int	max_items;
+
+	switch (poller_type)
+	{
+		case TRX_POLLER_TYPE_JAVA:
+			max_items = MAX_JAVA_ITEMS;
+			break;
+		case TRX_POLLER_TYPE_PINGER:
+			max_items = MAX_PINGER_ITEMS;
+			break;
+		default:
+			max_items = 1;
+	}
+
+	return dc_config_get_poller_items(poller_type, items, max_items);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DCconfig_get_async_poller_items                                  *
+ *                                                                            *
+ * Purpose: get array of items for asynchronous poller                        *
+ *                                                                            *
+ * Parameters: poller_type - [IN] poller type (TRX_POLLER_TYPE_...)           *
+ *             items       - [OUT] array of items                             *
+ *             items_num   - [IN] the maximum number of items to get          *
+ *                                                                            *
+ * Return value: number of items in items array                               *
+ *                                                                            *
+ * Comments: Unlike DCconfig_get_poller_items() the items are not required to *
+ *           belong to the same host or interface, asynchronous pollers check *
+ *           them concurrently.                                               *
+ *                                                                            *
+ ******************************************************************************/
+int	DCconfig_get_async_poller_items(unsigned char poller_type, DC_ITEM *items, int items_num)
+{
+	return dc_config_get_poller_items(poller_type, items, items_num);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: DCconfig_get_ipmi_poller_items                                   *
@@ -9128,6 +9338,9 @@ void	*DCconfig_get_stats(int request)
 		case TRX_CONFSTATS_BUFFER_PFREE:
 			value_double = 100 * (double)config_mem->free_size / config_mem->orig_size;
 			return &value_double;
+		case TRX_CONFSTATS_SYNC_LOCK_MAX:
+			value_double = config->sync_lock_max;
+			return &value_double;
 		default:
 			return NULL;
 	}
@@ -713,6 +713,8 @@ typedef struct
 	int			proxy_lastaccess_ts;
 	int			sync_ts;
 	int			item_sync_ts;
+	/* the longest configuration cache write lock hold time during the last configuration sync */
+	double			sync_lock_max;
 
 	/* maintenance processing management */
 	unsigned char		maintenance_update;		/* flag to trigger maintenance update by timers  */
@@ -10,10 +10,34 @@
 #include "dbconfig.h"
 #include "dbsync.h"
 
+/* the maximum number of object identifiers used in one changelog based select */
+#define TRX_DBSYNC_BATCH_SIZE	1000
+
+/* the period of full table compare, picks up changes that were not recorded in changelog */
+#define TRX_DBSYNC_FULL_PERIOD	SEC_PER_HOUR
+
+typedef int	(*trx_dbsync_compare_func_t)(const void *object, const DB_ROW dbrow);
+
 typedef struct
 {
-	trx_hashset_t	strpool;
-	TRX_DC_CONFIG	*cache;
+	trx_hashset_t		strpool;
+	TRX_DC_CONFIG		*cache;
+
+	/* the changelog records read during this synchronization */
+	trx_vector_uint64_t	changelogids;
+
+	/* the changed objects (see TRX_DBSYNC_OBJ_* defines) */
+	trx_vector_uint64_t	itemids;
+	trx_vector_uint64_t	triggerids;
+
+	/* the hosts with changed proxy, must have their item preprocessing synchronized */
+	trx_vector_uint64_t	hostids;
+
+	/* 1 - synchronize only objects recorded in changelog, 0 - compare whole tables */
+	unsigned char		changelog_sync;
+
+	/* the last time whole tables were compared */
+	time_t			full_sync_ts;
 }
 trx_dbsync_env_t;
 
@@ -280,6 +304,12 @@ void	trx_dbsync_init_env(TRX_DC_CONFIG *cache)
 {
 	dbsync_env.cache = cache;
 	trx_hashset_create(&dbsync_env.strpool, 100, dbsync_strpool_hash_func, dbsync_strpool_compare_func);
+
+	trx_vector_uint64_create(&dbsync_env.changelogids);
+	trx_vector_uint64_create(&dbsync_env.itemids);
+	trx_vector_uint64_create(&dbsync_env.triggerids);
+	trx_vector_uint64_create(&dbsync_env.hostids);
+	dbsync_env.changelog_sync = 0;
 }
 
 /******************************************************************************
@@ -289,9 +319,238 @@ void	trx_dbsync_init_env(TRX_DC_CONFIG *cache)
  ******************************************************************************/
 void	trx_dbsync_free_env(void)
 {
+	trx_vector_uint64_destroy(&dbsync_env.hostids);
+	trx_vector_uint64_destroy(&dbsync_env.triggerids);
+	trx_vector_uint64_destroy(&dbsync_env.itemids);
+	trx_vector_uint64_destroy(&dbsync_env.changelogids);
+
 	trx_hashset_destroy(&dbsync_env.strpool);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_dbsync_env_read_changelog                                    *
+ *                                                                            *
+ * Purpose: reads configuration changes recorded in changelog table           *
+ *                                                                            *
+ * Parameter: mode - [IN] the synchronization mode (see TRX_DBSYNC_* defines) *
+ *                                                                            *
+ * Comments: Changelog must be read before configuration tables, so that      *
+ *           changes committed during synchronization are not lost.           *
+ *           Items, item preprocessing, functions and triggers are compared   *
+ *           only for the recorded objects, unless whole tables must be       *
+ *           compared - during initial synchronization, once per              *
+ *           TRX_DBSYNC_FULL_PERIOD or if changelog cannot be read.           *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_dbsync_env_read_changelog(unsigned char mode)
+{
+	DB_ROW		row;
+	DB_RESULT	result;
+	trx_uint64_t	changelogid, objectid;
+	time_t		now;
+
+	treegix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (NULL == (result = DBselect("select changelogid,object,objectid from changelog")))
+		goto out;
+
+	while (NULL != (row = DBfetch(result)))
+	{
+		TRX_STR2UINT64(changelogid, row[0]);
+		TRX_STR2UINT64(objectid, row[2]);
+
+		trx_vector_uint64_append(&dbsync_env.changelogids, changelogid);
+
+		switch (atoi(row[1]))
+		{
+			case TRX_DBSYNC_OBJ_ITEM:
+				trx_vector_uint64_append(&dbsync_env.itemids, objectid);
+				break;
+			case TRX_DBSYNC_OBJ_TRIGGER:
+				trx_vector_uint64_append(&dbsync_env.triggerids, objectid);
+				break;
+		}
+	}
+	DBfree_result(result);
+
+	trx_vector_uint64_sort(&dbsync_env.changelogids, TRX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	trx_vector_uint64_sort(&dbsync_env.itemids, TRX_DEFAULT_UINT64_COMPARE_FUNC);
+	trx_vector_uint64_uniq(&dbsync_env.itemids, TRX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	trx_vector_uint64_sort(&dbsync_env.triggerids, TRX_DEFAULT_UINT64_COMPARE_FUNC);
+	trx_vector_uint64_uniq(&dbsync_env.triggerids, TRX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	now = time(NULL);
+
+	if (TRX_DBSYNC_UPDATE == mode && now - dbsync_env.full_sync_ts < TRX_DBSYNC_FULL_PERIOD)
+		dbsync_env.changelog_sync = 1;
+	else
+		dbsync_env.full_sync_ts = now;
+out:
+	treegix_log(LOG_LEVEL_DEBUG, "End of %s() records:%d items:%d triggers:%d changelog sync:%d", __func__,
+			dbsync_env.changelogids.values_num, dbsync_env.itemids.values_num,
+			dbsync_env.triggerids.values_num, (int)dbsync_env.changelog_sync);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_dbsync_env_require_full_sync                                 *
+ *                                                                            *
+ * Purpose: forces whole table compare for objects tracked by changelog       *
+ *                                                                            *
+ * Comments: Used when changes not recorded in changelog (for example user    *
+ *           macros) can affect the tracked objects.                          *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_dbsync_env_require_full_sync(void)
+{
+	if (0 == dbsync_env.changelog_sync)
+		return;
+
+	dbsync_env.changelog_sync = 0;
+	dbsync_env.full_sync_ts = time(NULL);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_dbsync_env_clear_changelog                                   *
+ *                                                                            *
+ * Purpose: removes processed records from changelog table                    *
+ *                                                                            *
+ * Comments: Must be called only after successful synchronization.            *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_dbsync_env_clear_changelog(void)
+{
+	char	*sql = NULL;
+	size_t	sql_alloc = 0, sql_offset;
+	int	i;
+
+	for (i = 0; i < dbsync_env.changelogids.values_num; i += TRX_DBSYNC_BATCH_SIZE)
+	{
+		sql_offset = 0;
+		trx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "delete from changelog where");
+		DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "changelogid", dbsync_env.changelogids.values + i,
+				MIN(TRX_DBSYNC_BATCH_SIZE, dbsync_env.changelogids.values_num - i));
+
+		if (TRX_DB_OK > DBexecute("%s", sql))
+			break;
+	}
+
+	trx_free(sql);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_use_changelog                                             *
+ *                                                                            *
+ * Purpose: checks if objects can be synchronized from changelog              *
+ *                                                                            *
+ * Parameter: ids        - [IN] the changed object identifiers                *
+ *            cached_num - [IN] the number of cached objects                  *
+ *                                                                            *
+ * Return value: SUCCEED - only changed objects must be compared              *
+ *               FAIL    - whole table must be compared                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_use_changelog(const trx_vector_uint64_t *ids, int cached_num)
+{
+	if (0 == dbsync_env.changelog_sync)
+		return FAIL;
+
+	/* selecting large part of table by identifiers is slower than reading whole table */
+	if (TRX_DBSYNC_BATCH_SIZE < ids->values_num && cached_num / 4 < ids->values_num)
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_compare_changed_objects                                   *
+ *                                                                            *
+ * Purpose: compares changed objects with cached configuration data           *
+ *                                                                            *
+ * Parameter: sync         - [OUT] the changeset                              *
+ *            sql          - [IN] the query selecting all objects, the object *
+ *                                identifier must be in the first column      *
+ *            fieldname    - [IN] the object identifier field name            *
+ *            ids          - [IN] the changed object identifiers              *
+ *            objects      - [IN] the cached objects                          *
+ *            compare_func - [IN] the cached object and row compare function  *
+ *                                                                            *
+ * Return value: SUCCEED - the changeset was successfully calculated          *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The changed objects that are not selected anymore are removed.   *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_compare_changed_objects(trx_dbsync_t *sync, const char *sql, const char *fieldname,
+		const trx_vector_uint64_t *ids, trx_hashset_t *objects, trx_dbsync_compare_func_t compare_func)
+{
+	DB_ROW			dbrow;
+	DB_RESULT		result;
+	trx_vector_uint64_t	selected;
+	trx_uint64_t		rowid;
+	void			*object;
+	char			*sql_batch = NULL, **row;
+	size_t			sql_alloc = 0, sql_offset;
+	int			i, ret = SUCCEED;
+
+	trx_vector_uint64_create(&selected);
+
+	for (i = 0; i < ids->values_num; i += TRX_DBSYNC_BATCH_SIZE)
+	{
+		sql_offset = 0;
+		trx_snprintf_alloc(&sql_batch, &sql_alloc, &sql_offset, "%s and", sql);
+		DBadd_condition_alloc(&sql_batch, &sql_alloc, &sql_offset, fieldname, ids->values + i,
+				MIN(TRX_DBSYNC_BATCH_SIZE, ids->values_num - i));
+
+		if (NULL == (result = DBselect("%s", sql_batch)))
+		{
+			ret = FAIL;
+			goto out;
+		}
+
+		while (NULL != (dbrow = DBfetch(result)))
+		{
+			unsigned char	tag = TRX_DBSYNC_ROW_NONE;
+
+			TRX_STR2UINT64(rowid, dbrow[0]);
+			trx_vector_uint64_append(&selected, rowid);
+
+			row = dbsync_preproc_row(sync, dbrow);
+
+			if (NULL == (object = trx_hashset_search(objects, &rowid)))
+				tag = TRX_DBSYNC_ROW_ADD;
+			else if (FAIL == compare_func(object, row))
+				tag = TRX_DBSYNC_ROW_UPDATE;
+
+			if (TRX_DBSYNC_ROW_NONE != tag)
+				dbsync_add_row(sync, rowid, tag, row);
+		}
+		DBfree_result(result);
+	}
+
+	trx_vector_uint64_sort(&selected, TRX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	for (i = 0; i < ids->values_num; i++)
+	{
+		if (FAIL != trx_vector_uint64_bsearch(&selected, ids->values[i], TRX_DEFAULT_UINT64_COMPARE_FUNC))
+			continue;
+
+		if (NULL != trx_hashset_search(objects, &ids->values[i]))
+			dbsync_add_row(sync, ids->values[i], TRX_DBSYNC_ROW_REMOVE, NULL);
+	}
+out:
+	trx_free(sql_batch);
+	trx_vector_uint64_destroy(&selected);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: trx_dbsync_init                                                  *
@@ -742,8 +1001,14 @@ int	trx_dbsync_compare_hosts(trx_dbsync_t *sync)
 		if (NULL == (host = (TRX_DC_HOST *)trx_hashset_search(&dbsync_env.cache->hosts, &rowid)))
 			tag = TRX_DBSYNC_ROW_ADD;
 		else if (FAIL == dbsync_compare_host(host, dbrow))
+		{
 			tag = TRX_DBSYNC_ROW_UPDATE;
 
+			/* item preprocessing depends on whether the host is monitored by proxy */
+			if (FAIL == dbsync_compare_uint64(dbrow[1], host->proxy_hostid))
+				trx_vector_uint64_append(&dbsync_env.hostids, rowid);
+		}
+
 		if (TRX_DBSYNC_ROW_NONE != tag)
 			dbsync_add_row(sync, rowid, tag, dbrow);
 	}
@@ -1752,6 +2017,11 @@ static char	**dbsync_item_preproc_row(char **row)
 #undef TRX_DBSYNC_ITEM_COLUMN_TRENDS
 }
 
+static int	dbsync_compare_item_row(const void *object, const DB_ROW dbrow)
+{
+	return dbsync_compare_item((const TRX_DC_ITEM *)object, dbrow);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: trx_dbsync_compare_items                                         *
@@ -1770,9 +2040,11 @@ int	trx_dbsync_compare_items(trx_dbsync_t *sync)
 	trx_hashset_iter_t	iter;
 	trx_uint64_t		rowid;
 	TRX_DC_ITEM		*item;
-	char			**row;
+	char			**row, *sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	int			ret;
 
-	if (NULL == (result = DBselect(
+	trx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select i.itemid,i.hostid,i.status,i.type,i.value_type,i.key_,"
 				"i.snmp_community,i.snmp_oid,i.port,i.snmpv3_securityname,i.snmpv3_securitylevel,"
 				"i.snmpv3_authpassphrase,i.snmpv3_privpassphrase,i.ipmi_sensor,i.delay,"
@@ -1789,13 +2061,25 @@ int	trx_dbsync_compare_items(trx_dbsync_t *sync)
 			" left join item_discovery id on i.itemid=id.itemid"
 			" join item_rtdata ir on i.itemid=ir.itemid"
 			" where h.status in (%d,%d) and i.flags<>%d",
-			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED, TRX_FLAG_DISCOVERY_PROTOTYPE)))
+			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED, TRX_FLAG_DISCOVERY_PROTOTYPE);
+
+	dbsync_prepare(sync, 59, dbsync_item_preproc_row);
 
+	if (TRX_DBSYNC_UPDATE == sync->mode &&
+			SUCCEED == dbsync_use_changelog(&dbsync_env.itemids, dbsync_env.cache->items.num_data))
 	{
-		return FAIL;
+		ret = dbsync_compare_changed_objects(sync, sql, "i.itemid", &dbsync_env.itemids,
+				&dbsync_env.cache->items, dbsync_compare_item_row);
+		trx_free(sql);
+
+		return ret;
 	}
 
-	dbsync_prepare(sync, 59, dbsync_item_preproc_row);
+	result = DBselect("%s", sql);
+	trx_free(sql);
+
+	if (NULL == result)
+		return FAIL;
 
 	if (TRX_DBSYNC_INIT == sync->mode)
 	{
@@ -2114,6 +2398,11 @@ static char	**dbsync_trigger_preproc_row(char **row)
 	return row;
 }
 
+static int	dbsync_compare_trigger_row(const void *object, const DB_ROW dbrow)
+{
+	return dbsync_compare_trigger((const TRX_DC_TRIGGER *)object, dbrow);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: trx_dbsync_compare_triggers                                      *
@@ -2134,9 +2423,11 @@ int	trx_dbsync_compare_triggers(trx_dbsync_t *sync)
 	trx_hashset_iter_t	iter;
 	trx_uint64_t		rowid;
 	TRX_DC_TRIGGER		*trigger;
-	char			**row;
+	char			**row, *sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	int			ret;
 
-	if (NULL == (result = DBselect(
+	trx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select distinct t.triggerid,t.description,t.expression,t.error,t.priority,t.type,t.value,"
 				"t.state,t.lastchange,t.status,t.recovery_mode,t.recovery_expression,"
 				"t.correlation_mode,t.correlation_tag,opdata"
@@ -2147,12 +2438,25 @@ int	trx_dbsync_compare_triggers(trx_dbsync_t *sync)
 				" and h.status in (%d,%d)"
 				" and t.flags<>%d",
 			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED,
-			TRX_FLAG_DISCOVERY_PROTOTYPE)))
+			TRX_FLAG_DISCOVERY_PROTOTYPE);
+
+	dbsync_prepare(sync, 15, dbsync_trigger_preproc_row);
+
+	if (TRX_DBSYNC_UPDATE == sync->mode &&
+			SUCCEED == dbsync_use_changelog(&dbsync_env.triggerids, dbsync_env.cache->triggers.num_data))
 	{
-		return FAIL;
+		ret = dbsync_compare_changed_objects(sync, sql, "t.triggerid", &dbsync_env.triggerids,
+				&dbsync_env.cache->triggers, dbsync_compare_trigger_row);
+		trx_free(sql);
+
+		return ret;
 	}
 
-	dbsync_prepare(sync, 15, dbsync_trigger_preproc_row);
+	result = DBselect("%s", sql);
+	trx_free(sql);
+
+	if (NULL == result)
+		return FAIL;
 
 	if (TRX_DBSYNC_INIT == sync->mode)
 	{
@@ -2313,6 +2617,94 @@ static int	dbsync_compare_function(const TRX_DC_FUNCTION *function, const DB_ROW
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_compare_changed_functions                                 *
+ *                                                                            *
+ * Purpose: compares functions of changed triggers with cached configuration  *
+ *          data                                                              *
+ *                                                                            *
+ * Parameter: sync - [OUT] the changeset                                      *
+ *            sql  - [IN] the query selecting all functions                   *
+ *                                                                            *
+ * Return value: SUCCEED - the changeset was successfully calculated          *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Function changes are recorded in changelog as changes of their   *
+ *           triggers.                                                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_compare_changed_functions(trx_dbsync_t *sync, const char *sql)
+{
+	DB_ROW			dbrow;
+	DB_RESULT		result;
+	trx_vector_uint64_t	selected;
+	trx_hashset_iter_t	iter;
+	trx_uint64_t		rowid;
+	TRX_DC_FUNCTION		*function;
+	const trx_vector_uint64_t	*triggerids = &dbsync_env.triggerids;
+	char			*sql_batch = NULL;
+	size_t			sql_alloc = 0, sql_offset;
+	int			i, ret = SUCCEED;
+
+	if (0 == triggerids->values_num)
+		return SUCCEED;
+
+	trx_vector_uint64_create(&selected);
+
+	for (i = 0; i < triggerids->values_num; i += TRX_DBSYNC_BATCH_SIZE)
+	{
+		sql_offset = 0;
+		trx_snprintf_alloc(&sql_batch, &sql_alloc, &sql_offset, "%s and", sql);
+		DBadd_condition_alloc(&sql_batch, &sql_alloc, &sql_offset, "f.triggerid", triggerids->values + i,
+				MIN(TRX_DBSYNC_BATCH_SIZE, triggerids->values_num - i));
+
+		if (NULL == (result = DBselect("%s", sql_batch)))
+		{
+			ret = FAIL;
+			goto out;
+		}
+
+		while (NULL != (dbrow = DBfetch(result)))
+		{
+			unsigned char	tag = TRX_DBSYNC_ROW_NONE;
+
+			TRX_STR2UINT64(rowid, dbrow[1]);
+			trx_vector_uint64_append(&selected, rowid);
+
+			if (NULL == (function = (TRX_DC_FUNCTION *)trx_hashset_search(&dbsync_env.cache->functions,
+					&rowid)))
+			{
+				tag = TRX_DBSYNC_ROW_ADD;
+			}
+			else if (FAIL == dbsync_compare_function(function, dbrow))
+				tag = TRX_DBSYNC_ROW_UPDATE;
+
+			if (TRX_DBSYNC_ROW_NONE != tag)
+				dbsync_add_row(sync, rowid, tag, dbrow);
+		}
+		DBfree_result(result);
+	}
+
+	trx_vector_uint64_sort(&selected, TRX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	/* functions are not indexed by triggers, so all cached functions must be checked */
+	trx_hashset_iter_reset(&dbsync_env.cache->functions, &iter);
+	while (NULL != (function = (TRX_DC_FUNCTION *)trx_hashset_iter_next(&iter)))
+	{
+		if (FAIL == trx_vector_uint64_bsearch(triggerids, function->triggerid, TRX_DEFAULT_UINT64_COMPARE_FUNC))
+			continue;
+
+		if (FAIL == trx_vector_uint64_bsearch(&selected, function->functionid, TRX_DEFAULT_UINT64_COMPARE_FUNC))
+			dbsync_add_row(sync, function->functionid, TRX_DBSYNC_ROW_REMOVE, NULL);
+	}
+out:
+	trx_free(sql_batch);
+	trx_vector_uint64_destroy(&selected);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: trx_dbsync_compare_functions                                     *
@@ -2333,8 +2725,11 @@ int	trx_dbsync_compare_functions(trx_dbsync_t *sync)
 	trx_hashset_iter_t	iter;
 	trx_uint64_t		rowid;
 	TRX_DC_FUNCTION		*function;
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	int			ret;
 
-	if (NULL == (result = DBselect(
+	trx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select i.itemid,f.functionid,f.name,f.parameter,t.triggerid"
 			" from hosts h,items i,functions f,triggers t"
 			" where h.hostid=i.hostid"
@@ -2343,12 +2738,24 @@ int	trx_dbsync_compare_functions(trx_dbsync_t *sync)
 				" and h.status in (%d,%d)"
 				" and t.flags<>%d",
 			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED,
-			TRX_FLAG_DISCOVERY_PROTOTYPE)))
+			TRX_FLAG_DISCOVERY_PROTOTYPE);
+
+	dbsync_prepare(sync, 5, NULL);
+
+	if (TRX_DBSYNC_UPDATE == sync->mode &&
+			SUCCEED == dbsync_use_changelog(&dbsync_env.triggerids, dbsync_env.cache->triggers.num_data))
 	{
-		return FAIL;
+		ret = dbsync_compare_changed_functions(sync, sql);
+		trx_free(sql);
+
+		return ret;
 	}
 
-	dbsync_prepare(sync, 5, NULL);
+	result = DBselect("%s", sql);
+	trx_free(sql);
+
+	if (NULL == result)
+		return FAIL;
 
 	if (TRX_DBSYNC_INIT == sync->mode)
 	{
@@ -3508,6 +3915,124 @@ static int	dbsync_compare_item_preproc(const trx_dc_preproc_op_t *preproc, const
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_compare_changed_item_preprocs                             *
+ *                                                                            *
+ * Purpose: compares preprocessing of changed items with cached configuration *
+ *          data                                                              *
+ *                                                                            *
+ * Parameter: sync - [OUT] the changeset                                      *
+ *            sql  - [IN] the query selecting all item preprocessing steps    *
+ *                                                                            *
+ * Return value: SUCCEED - the changeset was successfully calculated          *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Preprocessing changes are recorded in changelog as changes of    *
+ *           their items. Preprocessing of all items on hosts with changed    *
+ *           proxy is compared too.                                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_compare_changed_item_preprocs(trx_dbsync_t *sync, const char *sql)
+{
+	DB_ROW			dbrow;
+	DB_RESULT		result;
+	trx_vector_uint64_t	itemids, selected;
+	trx_hashset_iter_t	iter;
+	trx_uint64_t		rowid;
+	trx_dc_preproc_op_t	*preproc;
+	TRX_DC_ITEM		*item;
+	char			*sql_batch = NULL, **row;
+	size_t			sql_alloc = 0, sql_offset;
+	int			i, ret = SUCCEED;
+
+	trx_vector_uint64_create(&itemids);
+	trx_vector_uint64_create(&selected);
+
+	trx_vector_uint64_append_array(&itemids, dbsync_env.itemids.values, dbsync_env.itemids.values_num);
+
+	if (0 != dbsync_env.hostids.values_num)
+	{
+		trx_vector_uint64_sort(&dbsync_env.hostids, TRX_DEFAULT_UINT64_COMPARE_FUNC);
+
+		trx_hashset_iter_reset(&dbsync_env.cache->items, &iter);
+		while (NULL != (item = (TRX_DC_ITEM *)trx_hashset_iter_next(&iter)))
+		{
+			if (FAIL != trx_vector_uint64_bsearch(&dbsync_env.hostids, item->hostid,
+					TRX_DEFAULT_UINT64_COMPARE_FUNC))
+			{
+				trx_vector_uint64_append(&itemids, item->itemid);
+			}
+		}
+
+		trx_vector_uint64_sort(&itemids, TRX_DEFAULT_UINT64_COMPARE_FUNC);
+		trx_vector_uint64_uniq(&itemids, TRX_DEFAULT_UINT64_COMPARE_FUNC);
+	}
+
+	for (i = 0; i < itemids.values_num; i += TRX_DBSYNC_BATCH_SIZE)
+	{
+		sql_offset = 0;
+		trx_snprintf_alloc(&sql_batch, &sql_alloc, &sql_offset, "%s and", sql);
+		DBadd_condition_alloc(&sql_batch, &sql_alloc, &sql_offset, "pp.itemid", itemids.values + i,
+				MIN(TRX_DBSYNC_BATCH_SIZE, itemids.values_num - i));
+		trx_strcpy_alloc(&sql_batch, &sql_alloc, &sql_offset, " order by pp.itemid");
+
+		if (NULL == (result = DBselect("%s", sql_batch)))
+		{
+			ret = FAIL;
+			goto out;
+		}
+
+		while (NULL != (dbrow = DBfetch(result)))
+		{
+			unsigned char	tag = TRX_DBSYNC_ROW_NONE;
+			unsigned char	type;
+
+			TRX_STR2UCHAR(type, dbrow[8]);
+			if (SUCCEED != DBis_null(dbrow[10]) && SUCCEED != is_item_processed_by_server(type, dbrow[9]))
+				continue;
+
+			TRX_STR2UINT64(rowid, dbrow[0]);
+			trx_vector_uint64_append(&selected, rowid);
+
+			row = dbsync_preproc_row(sync, dbrow);
+
+			if (NULL == (preproc = (trx_dc_preproc_op_t *)trx_hashset_search(
+					&dbsync_env.cache->preprocops, &rowid)))
+			{
+				tag = TRX_DBSYNC_ROW_ADD;
+			}
+			else if (FAIL == dbsync_compare_item_preproc(preproc, row))
+				tag = TRX_DBSYNC_ROW_UPDATE;
+
+			if (TRX_DBSYNC_ROW_NONE != tag)
+				dbsync_add_row(sync, rowid, tag, row);
+		}
+		DBfree_result(result);
+	}
+
+	trx_vector_uint64_sort(&selected, TRX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	trx_hashset_iter_reset(&dbsync_env.cache->preprocops, &iter);
+	while (NULL != (preproc = (trx_dc_preproc_op_t *)trx_hashset_iter_next(&iter)))
+	{
+		if (FAIL == trx_vector_uint64_bsearch(&itemids, preproc->itemid, TRX_DEFAULT_UINT64_COMPARE_FUNC))
+			continue;
+
+		if (FAIL == trx_vector_uint64_bsearch(&selected, preproc->item_preprocid,
+				TRX_DEFAULT_UINT64_COMPARE_FUNC))
+		{
+			dbsync_add_row(sync, preproc->item_preprocid, TRX_DBSYNC_ROW_REMOVE, NULL);
+		}
+	}
+out:
+	trx_free(sql_batch);
+	trx_vector_uint64_destroy(&selected);
+	trx_vector_uint64_destroy(&itemids);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: trx_dbsync_compare_item_preprocessing                            *
@@ -3528,9 +4053,11 @@ int	trx_dbsync_compare_item_preprocs(trx_dbsync_t *sync)
 	trx_hashset_iter_t	iter;
 	trx_uint64_t		rowid;
 	trx_dc_preproc_op_t	*preproc;
-	char			**row;
+	char			**row, *sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	int			ret;
 
-	if (NULL == (result = DBselect(
+	trx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select pp.item_preprocid,pp.itemid,pp.type,pp.params,pp.step,i.hostid,pp.error_handler,"
 				"pp.error_handler_params,i.type,i.key_,h.proxy_hostid"
 			" from item_preproc pp,items i,hosts h"
@@ -3539,16 +4066,27 @@ int	trx_dbsync_compare_item_preprocs(trx_dbsync_t *sync)
 				" and (h.proxy_hostid is null"
 					" or i.type in (%d,%d,%d))"
 				" and h.status in (%d,%d)"
-				" and i.flags<>%d"
-			" order by pp.itemid",
+				" and i.flags<>%d",
 			ITEM_TYPE_INTERNAL, ITEM_TYPE_AGGREGATE, ITEM_TYPE_CALCULATED,
 			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED,
-			TRX_FLAG_DISCOVERY_PROTOTYPE)))
+			TRX_FLAG_DISCOVERY_PROTOTYPE);
+
+	dbsync_prepare(sync, 8, dbsync_item_pp_preproc_row);
+
+	if (TRX_DBSYNC_UPDATE == sync->mode &&
+			SUCCEED == dbsync_use_changelog(&dbsync_env.itemids, dbsync_env.cache->items.num_data))
 	{
-		return FAIL;
+		ret = dbsync_compare_changed_item_preprocs(sync, sql);
+		trx_free(sql);
+
+		return ret;
 	}
 
-	dbsync_prepare(sync, 8, dbsync_item_pp_preproc_row);
+	result = DBselect("%s order by pp.itemid", sql);
+	trx_free(sql);
+
+	if (NULL == result)
+		return FAIL;
 
 	if (TRX_DBSYNC_INIT == sync->mode)
 	{
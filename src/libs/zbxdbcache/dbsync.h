@@ -22,6 +22,10 @@
 #define TRX_DBSYNC_UPDATE_HOST_GROUPS		__UINT64_C(0x0020)
 #define TRX_DBSYNC_UPDATE_MAINTENANCE_GROUPS	__UINT64_C(0x0040)
 
+/* changelog object types, recorded by database triggers */
+#define TRX_DBSYNC_OBJ_ITEM	1
+#define TRX_DBSYNC_OBJ_TRIGGER	2
+
 
 #if defined(HAVE_POLARSSL) || defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
 #	define TRX_HOST_TLS_OFFSET	4
@@ -93,6 +97,9 @@ struct trx_dbsync
 
 void	trx_dbsync_init_env(TRX_DC_CONFIG *cache);
 void	trx_dbsync_free_env(void);
+void	trx_dbsync_env_read_changelog(unsigned char mode);
+void	trx_dbsync_env_require_full_sync(void);
+void	trx_dbsync_env_clear_changelog(void);
 
 void	trx_dbsync_init(trx_dbsync_t *sync, unsigned char mode);
 void	trx_dbsync_clear(trx_dbsync_t *sync);
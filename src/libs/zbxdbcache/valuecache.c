@@ -1,5 +1,7 @@
 
 
+#include <sys/mman.h>
+
 #include "common.h"
 #include "log.h"
 #include "memalloc.h"
@@ -74,6 +76,32 @@ TRX_MEM_FUNC_IMPL(__vc, vc_mem)
 
 #define TRX_VC_ITEM_EXPIRE_PERIOD	SEC_PER_DAY
 
+/* the maximum number of items read from database with a single query by trx_vc_get_values_multi() */
+#define TRX_VC_MULTI_BATCH_SIZE		1000
+
+/* the maximum difference of request start times to read the items with a single query */
+#define TRX_VC_MULTI_RANGE_SLACK	SEC_PER_MIN
+
+/* the period read from database for count based requests by trx_vc_get_values_multi() */
+#define TRX_VC_MULTI_COUNT_PERIOD	(15 * SEC_PER_MIN)
+
+/* the value cache snapshot file format identifier */
+#define TRX_VC_SNAPSHOT_MAGIC		"TRXVCS01"
+
+/* the number of items written to snapshot during a single value cache lock */
+#define TRX_VC_SNAPSHOT_BATCH_SIZE	1000
+
+/* The period before snapshot creation that is read again from database when loading     */
+/* snapshot. It covers values with older timestamps written to history after the snapshot */
+/* was created (for example delayed proxy data).                                          */
+#define TRX_VC_SNAPSHOT_RESYNC_PERIOD	(10 * SEC_PER_MIN)
+
+/* the free value cache space percentage at which snapshot loading is stopped */
+#define TRX_VC_SNAPSHOT_MIN_FREE	10
+
+/* the string length marking NULL string in snapshot */
+#define TRX_VC_SNAPSHOT_NULL_STRING	0xffffffff
+
 /* the data chunk used to store data fragment */
 typedef struct trx_vc_chunk
 {
@@ -213,6 +241,54 @@ trx_vc_item_weight_t;
 TRX_VECTOR_DECL(vc_itemweight, trx_vc_item_weight_t)
 TRX_VECTOR_IMPL(vc_itemweight, trx_vc_item_weight_t)
 
+/* the item history range to be read from database by trx_vc_get_values_multi() */
+typedef struct
+{
+	/* a pointer to the value cache item */
+	trx_vc_item_t	*item;
+
+	/* the range to read - [range_start, range_end] */
+	int		range_start;
+	int		range_end;
+}
+trx_vc_fetch_t;
+
+TRX_VECTOR_DECL(vc_fetch, trx_vc_fetch_t)
+TRX_VECTOR_IMPL(vc_fetch, trx_vc_fetch_t)
+
+/* the value cache snapshot file header */
+typedef struct
+{
+	char		magic[8];
+
+	/* the snapshot creation time */
+	int		created;
+
+	/* the number of items in snapshot */
+	trx_uint32_t	items_num;
+}
+trx_vc_snapshot_header_t;
+
+/* The value cache snapshot item header, followed by values_num item values in ascending */
+/* order. Each value is stored as timestamp seconds and nanoseconds followed by the value  */
+/* data - 8 bytes for numeric values, string length and null terminated string for text   */
+/* values, log timestamp, event id, severity, source and value strings for log values.    */
+typedef struct
+{
+	trx_uint64_t	itemid;
+	trx_uint64_t	hits;
+	int		active_range;
+	int		daily_range;
+	int		db_cached_from;
+	int		last_accessed;
+	trx_uint32_t	values_num;
+	unsigned char	value_type;
+	unsigned char	status;
+	unsigned char	range_sync_hour;
+	unsigned char	padding;
+}
+trx_vc_snapshot_item_t;
+
 /* the value cache */
 static trx_vc_cache_t	*vc_cache = NULL;
 
@@ -1923,6 +1999,36 @@ static int	vch_item_cache_values_by_time(trx_vc_item_t *item, int range_start)
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_count_cached_values                                     *
+ *                                                                            *
+ * Purpose: counts the cached item values up to the specified timestamp       *
+ *                                                                            *
+ * Parameters: item  - [IN] the item                                          *
+ *             count - [IN] the number of values after which counting stops   *
+ *             ts    - [IN] the target timestamp                              *
+ *                                                                            *
+ * Return value: The number of cached values with timestamps less or equal to *
+ *               the target timestamp (might exceed count by chunk size).     *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_count_cached_values(const trx_vc_item_t *item, int count, const trx_timespec_t *ts)
+{
+	trx_vc_chunk_t	*chunk;
+	int		index, cached_records = 0;
+
+	if (SUCCEED == vch_item_get_last_value(item, ts, &chunk, &index))
+	{
+		cached_records = index - chunk->first_value + 1;
+
+		while (NULL != (chunk = chunk->prev) && cached_records < count)
+			cached_records += chunk->last_value - chunk->first_value + 1;
+	}
+
+	return cached_records;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: vch_item_cache_values_by_time_and_count                          *
@@ -1955,19 +2061,7 @@ static int	vch_item_cache_values_by_time_and_count(trx_vc_item_t *item, int rang
 		return SUCCEED;
 
 	/* find if the cache should be updated to cover the required count */
-	if (NULL != item->head)
-	{
-		trx_vc_chunk_t	*chunk;
-		int		index;
-
-		if (SUCCEED == vch_item_get_last_value(item, ts, &chunk, &index))
-		{
-			cached_records = index - chunk->first_value + 1;
-
-			while (NULL != (chunk = chunk->prev) && cached_records < count)
-				cached_records += chunk->last_value - chunk->first_value + 1;
-		}
-	}
+	cached_records = vch_item_count_cached_values(item, count, ts);
 
 	/* update cache if necessary */
 	if (cached_records < count)
@@ -2235,6 +2329,219 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_get_fetch_range                                         *
+ *                                                                            *
+ * Purpose: gets the item history range that must be read from database to    *
+ *          serve the specified request from cache                            *
+ *                                                                            *
+ * Parameters: item    - [IN] the item                                        *
+ *             request - [IN] the value request                               *
+ *             fetch   - [OUT] the range to read                              *
+ *                                                                            *
+ * Return value: SUCCEED - the range must be read from database               *
+ *               FAIL    - the requested values are already cached            *
+ *                                                                            *
+ * Comments: Count based requests are served by reading the last              *
+ *           TRX_VC_MULTI_COUNT_PERIOD seconds. If it does not contain enough *
+ *           values, the missing values are read by the request itself.       *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_get_fetch_range(trx_vc_item_t *item, const trx_vc_request_t *request, trx_vc_fetch_t *fetch)
+{
+	int	period;
+
+	if (TRX_ITEM_STATUS_CACHED_ALL == item->status)
+		return FAIL;
+
+	if (0 == request->count)
+	{
+		if (0 >= request->seconds)
+			return FAIL;
+
+		period = request->seconds;
+	}
+	else
+	{
+		if (vch_item_count_cached_values(item, request->count, &request->ts) >= request->count)
+			return FAIL;
+
+		period = (0 == request->seconds ? TRX_VC_MULTI_COUNT_PERIOD :
+				MIN(request->seconds, TRX_VC_MULTI_COUNT_PERIOD));
+	}
+
+	if (0 > (fetch->range_start = request->ts.sec - period))
+		fetch->range_start = 0;
+
+	/* check if the requested period is in the cached range */
+	if (0 != item->db_cached_from && fetch->range_start >= item->db_cached_from)
+		return FAIL;
+
+	if (NULL != item->tail)
+		fetch->range_end = item->tail->slots[item->tail->first_value].timestamp.sec - 1;
+	else
+		fetch->range_end = TRX_JAN_2038;
+
+	if (fetch->range_start >= fetch->range_end)
+		return FAIL;
+
+	fetch->item = item;
+
+	return SUCCEED;
+}
+
+static int	vc_fetch_compare_by_range(const void *d1, const void *d2)
+{
+	const trx_vc_fetch_t	*f1 = (const trx_vc_fetch_t *)d1;
+	const trx_vc_fetch_t	*f2 = (const trx_vc_fetch_t *)d2;
+
+	TRX_RETURN_IF_NOT_EQUAL(f1->item->value_type, f2->item->value_type);
+	TRX_RETURN_IF_NOT_EQUAL(f1->range_start, f2->range_start);
+
+	return 0;
+}
+
+static int	vc_fetch_compare_by_itemid(const void *d1, const void *d2)
+{
+	const trx_vc_fetch_t	*f1 = (const trx_vc_fetch_t *)d1;
+	const trx_vc_fetch_t	*f2 = (const trx_vc_fetch_t *)d2;
+
+	TRX_RETURN_IF_NOT_EQUAL(f1->item->itemid, f2->item->itemid);
+	TRX_RETURN_IF_NOT_EQUAL(f1->range_start, f2->range_start);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_cache_fetch_batch                                            *
+ *                                                                            *
+ * Purpose: reads history of multiple items of the same value type from       *
+ *          database with a single request and adds it to cache               *
+ *                                                                            *
+ * Parameters: fetches     - [IN] the item ranges to read, sorted by itemid   *
+ *             fetches_num - [IN] the number of items                         *
+ *                                                                            *
+ * Comments: The items must be referenced by the caller, this function        *
+ *           releases them.                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_cache_fetch_batch(trx_vc_fetch_t *fetches, int fetches_num)
+{
+	trx_uint64_t			*itemids;
+	trx_vector_history_record_t	*records;
+	int				i, j, k, ret, range_start, range_end = 0, value_type, misses = 0;
+
+	value_type = fetches[0].item->value_type;
+	range_start = fetches[0].range_start;
+
+	itemids = (trx_uint64_t *)trx_malloc(NULL, sizeof(trx_uint64_t) * (size_t)fetches_num);
+	records = (trx_vector_history_record_t *)trx_malloc(NULL,
+			sizeof(trx_vector_history_record_t) * (size_t)fetches_num);
+
+	for (i = 0; i < fetches_num; i++)
+	{
+		itemids[i] = fetches[i].item->itemid;
+		trx_vector_history_record_create(&records[i]);
+
+		range_start = MIN(range_start, fetches[i].range_start);
+		range_end = MAX(range_end, fetches[i].range_end);
+	}
+
+	vc_try_unlock();
+
+	/* decrement interval start point because interval starting point is excluded by history backend */
+	ret = trx_history_get_values_multi(itemids, fetches_num, value_type, 0 != range_start ? range_start - 1 : 0,
+			range_end, records);
+
+	vc_try_lock();
+
+	for (i = 0; i < fetches_num; i++)
+	{
+		trx_vc_item_t			*item = fetches[i].item;
+		trx_vector_history_record_t	*values = &records[i];
+
+		if (SUCCEED == ret && 0 == (item->state & TRX_ITEM_STATE_REMOVE_PENDING))
+		{
+			/* drop values outside the item range, the batch range covers ranges of all items */
+			for (j = 0, k = 0; j < values->values_num; j++)
+			{
+				if (values->values[j].timestamp.sec < fetches[i].range_start ||
+						values->values[j].timestamp.sec > fetches[i].range_end)
+				{
+					trx_history_record_clear(&values->values[j], value_type);
+					continue;
+				}
+
+				values->values[k++] = values->values[j];
+			}
+
+			values->values_num = k;
+
+			trx_vector_history_record_sort(values, (trx_compare_func_t)trx_history_record_compare_asc_func);
+
+			if (0 < values->values_num && FAIL == vch_item_add_values_at_tail(item, values->values,
+					values->values_num))
+			{
+				item->state |= TRX_ITEM_STATE_REMOVE_PENDING;
+			}
+			else
+			{
+				/* the whole range is read, so status flags can be reset as for time based requests */
+				item->status = 0;
+				vc_item_update_db_cached_from(item, fetches[i].range_start);
+				misses += values->values_num;
+			}
+		}
+
+		vc_item_release(item);
+		trx_history_record_vector_destroy(values, value_type);
+	}
+
+	vc_update_statistics(NULL, 0, misses);
+
+	trx_free(records);
+	trx_free(itemids);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_cache_fetch                                                  *
+ *                                                                            *
+ * Purpose: reads history of multiple items from database and adds it to      *
+ *          cache                                                             *
+ *                                                                            *
+ * Parameters: fetches - [IN] the item ranges to read                         *
+ *                                                                            *
+ * Comments: Items are grouped by value type and range start time, each group *
+ *           is read with a single database request.                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_cache_fetch(trx_vector_vc_fetch_t *fetches)
+{
+	int	i, j;
+
+	trx_vector_vc_fetch_sort(fetches, vc_fetch_compare_by_range);
+
+	for (i = 0; i < fetches->values_num; i = j)
+	{
+		trx_vc_fetch_t	*first = &fetches->values[i];
+
+		for (j = i + 1; j < fetches->values_num && TRX_VC_MULTI_BATCH_SIZE > j - i; j++)
+		{
+			if (fetches->values[j].item->value_type != first->item->value_type ||
+					fetches->values[j].range_start - first->range_start > TRX_VC_MULTI_RANGE_SLACK)
+			{
+				break;
+			}
+		}
+
+		qsort(first, (size_t)(j - i), sizeof(trx_vc_fetch_t), vc_fetch_compare_by_itemid);
+		vch_cache_fetch_batch(first, j - i);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: vch_item_free_cache                                              *
@@ -2604,6 +2911,837 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_vc_get_values_multi                                          *
+ *                                                                            *
+ * Purpose: get history data of multiple items                                *
+ *                                                                            *
+ * Parameters: requests     - [IN/OUT] the value requests                     *
+ *             requests_num - [IN] the number of requests                     *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was retrieved successfully  *
+ *                FAIL    - the history data of some items was not retrieved  *
+ *                                                                            *
+ * Comments: The history missing in cache is read from database with a single *
+ *           query per batch of items with the same value type and similar    *
+ *           request ranges instead of a query per item. Afterwards the       *
+ *           values of requests having output vector set are retrieved with   *
+ *           trx_vc_get_values(). Requests without output vector are only     *
+ *           loaded into cache, so the following trx_vc_get_values() calls    *
+ *           are served from cache.                                           *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_vc_get_values_multi(trx_vc_request_t *requests, int requests_num)
+{
+	trx_vector_vc_fetch_t	fetches;
+	trx_vc_fetch_t		fetch;
+	trx_vc_item_t		*item;
+	int			i, j, ret = SUCCEED, fetches_num = 0;
+
+	treegix_log(LOG_LEVEL_DEBUG, "In %s() requests:%d", __func__, requests_num);
+
+	trx_vector_vc_fetch_create(&fetches);
+
+	vc_try_lock();
+
+	if (TRX_VC_DISABLED == vc_state)
+		goto out;
+
+	if (TRX_VC_MODE_LOWMEM == vc_cache->mode)
+		vc_warn_low_memory();
+
+	for (i = 0; i < requests_num; i++)
+	{
+		trx_vc_request_t	*request = &requests[i];
+
+		if (NULL == (item = (trx_vc_item_t *)trx_hashset_search(&vc_cache->items, &request->itemid)))
+		{
+			trx_vc_item_t	new_item = {.itemid = request->itemid, .value_type = request->value_type};
+
+			/* new items are not added to cache in low memory mode */
+			if (TRX_VC_MODE_NORMAL != vc_cache->mode || NULL == (item = (trx_vc_item_t *)trx_hashset_insert(
+					&vc_cache->items, &new_item, sizeof(trx_vc_item_t))))
+			{
+				continue;
+			}
+		}
+
+		if (0 != (item->state & TRX_ITEM_STATE_REMOVE_PENDING) || item->value_type != request->value_type)
+			continue;
+
+		if (SUCCEED == vch_item_get_fetch_range(item, request, &fetch))
+			trx_vector_vc_fetch_append(&fetches, fetch);
+	}
+
+	/* merge multiple requests of the same item */
+	trx_vector_vc_fetch_sort(&fetches, vc_fetch_compare_by_itemid);
+
+	for (i = 0, j = 0; i < fetches.values_num; i++)
+	{
+		if (0 != j && fetches.values[j - 1].item == fetches.values[i].item)
+			continue;
+
+		fetches.values[j++] = fetches.values[i];
+		vc_item_addref(fetches.values[i].item);
+	}
+
+	fetches_num = fetches.values_num = j;
+
+	if (0 != fetches.values_num)
+		vch_cache_fetch(&fetches);
+out:
+	vc_try_unlock();
+
+	trx_vector_vc_fetch_destroy(&fetches);
+
+	for (i = 0; i < requests_num; i++)
+	{
+		trx_vc_request_t	*request = &requests[i];
+
+		if (NULL == request->values)
+			continue;
+
+		if (SUCCEED != trx_vc_get_values(request->itemid, request->value_type, request->values,
+				request->seconds, request->count, &request->ts))
+		{
+			ret = FAIL;
+		}
+	}
+
+	treegix_log(LOG_LEVEL_DEBUG, "End of %s():%s fetched items:%d", __func__, trx_result_string(ret),
+			fetches_num);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_snapshot_write_str                                            *
+ *                                                                            *
+ * Purpose: serializes string into snapshot buffer                            *
+ *                                                                            *
+ * Parameters: data        - [IN/OUT] the snapshot buffer                     *
+ *             data_alloc  - [IN/OUT] the snapshot buffer size                *
+ *             data_offset - [IN/OUT] the snapshot buffer offset              *
+ *             str         - [IN] the string to write, can be NULL            *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_snapshot_write_str(char **data, size_t *data_alloc, size_t *data_offset, const char *str)
+{
+	trx_uint32_t	len;
+
+	if (NULL == str)
+	{
+		len = TRX_VC_SNAPSHOT_NULL_STRING;
+		trx_str_memcpy_alloc(data, data_alloc, data_offset, (const char *)&len, sizeof(len));
+		return;
+	}
+
+	len = (trx_uint32_t)strlen(str);
+	trx_str_memcpy_alloc(data, data_alloc, data_offset, (const char *)&len, sizeof(len));
+	trx_str_memcpy_alloc(data, data_alloc, data_offset, str, len + 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_snapshot_write_item                                           *
+ *                                                                            *
+ * Purpose: serializes value cache item with its history data into snapshot   *
+ *          buffer                                                            *
+ *                                                                            *
+ * Parameters: data        - [IN/OUT] the snapshot buffer                     *
+ *             data_alloc  - [IN/OUT] the snapshot buffer size                *
+ *             data_offset - [IN/OUT] the snapshot buffer offset              *
+ *             item        - [IN] the item to write                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_snapshot_write_item(char **data, size_t *data_alloc, size_t *data_offset,
+		const trx_vc_item_t *item)
+{
+	trx_vc_snapshot_item_t	snapshot_item;
+	const trx_vc_chunk_t	*chunk;
+	int			i;
+
+	memset(&snapshot_item, 0, sizeof(snapshot_item));
+	snapshot_item.itemid = item->itemid;
+	snapshot_item.hits = item->hits;
+	snapshot_item.active_range = item->active_range;
+	snapshot_item.daily_range = item->daily_range;
+	snapshot_item.db_cached_from = item->db_cached_from;
+	snapshot_item.last_accessed = item->last_accessed;
+	snapshot_item.value_type = item->value_type;
+	snapshot_item.status = item->status;
+	snapshot_item.range_sync_hour = item->range_sync_hour;
+
+	for (chunk = item->tail; NULL != chunk; chunk = chunk->next)
+		snapshot_item.values_num += chunk->last_value - chunk->first_value + 1;
+
+	trx_str_memcpy_alloc(data, data_alloc, data_offset, (const char *)&snapshot_item, sizeof(snapshot_item));
+
+	for (chunk = item->tail; NULL != chunk; chunk = chunk->next)
+	{
+		for (i = chunk->first_value; i <= chunk->last_value; i++)
+		{
+			const trx_history_record_t	*record = &chunk->slots[i];
+			const trx_log_value_t		*log;
+
+			trx_str_memcpy_alloc(data, data_alloc, data_offset, (const char *)&record->timestamp.sec,
+					sizeof(int));
+			trx_str_memcpy_alloc(data, data_alloc, data_offset, (const char *)&record->timestamp.ns,
+					sizeof(int));
+
+			switch (item->value_type)
+			{
+				case ITEM_VALUE_TYPE_FLOAT:
+					trx_str_memcpy_alloc(data, data_alloc, data_offset,
+							(const char *)&record->value.dbl, sizeof(double));
+					break;
+				case ITEM_VALUE_TYPE_UINT64:
+					trx_str_memcpy_alloc(data, data_alloc, data_offset,
+							(const char *)&record->value.ui64, sizeof(trx_uint64_t));
+					break;
+				case ITEM_VALUE_TYPE_STR:
+				case ITEM_VALUE_TYPE_TEXT:
+					vc_snapshot_write_str(data, data_alloc, data_offset, record->value.str);
+					break;
+				case ITEM_VALUE_TYPE_LOG:
+					log = record->value.log;
+					trx_str_memcpy_alloc(data, data_alloc, data_offset,
+							(const char *)&log->timestamp, sizeof(int));
+					trx_str_memcpy_alloc(data, data_alloc, data_offset,
+							(const char *)&log->logeventid, sizeof(int));
+					trx_str_memcpy_alloc(data, data_alloc, data_offset,
+							(const char *)&log->severity, sizeof(int));
+					vc_snapshot_write_str(data, data_alloc, data_offset, log->source);
+					vc_snapshot_write_str(data, data_alloc, data_offset, log->value);
+					break;
+			}
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_snapshot_read                                                 *
+ *                                                                            *
+ * Purpose: reads fixed size data from snapshot                               *
+ *                                                                            *
+ * Parameters: ptr  - [IN/OUT] the current position in snapshot               *
+ *             end  - [IN] the end of snapshot                                *
+ *             dst  - [OUT] the output buffer                                 *
+ *             size - [IN] the number of bytes to read                        *
+ *                                                                            *
+ * Return value: SUCCEED - the data was read successfully                     *
+ *               FAIL    - unexpected end of snapshot                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_snapshot_read(const char **ptr, const char *end, void *dst, size_t size)
+{
+	if ((size_t)(end - *ptr) < size)
+		return FAIL;
+
+	memcpy(dst, *ptr, size);
+	*ptr += size;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_snapshot_read_str                                             *
+ *                                                                            *
+ * Purpose: reads string from snapshot                                        *
+ *                                                                            *
+ * Parameters: ptr - [IN/OUT] the current position in snapshot                *
+ *             end - [IN] the end of snapshot                                 *
+ *             str - [OUT] the string, pointing into snapshot data or NULL    *
+ *                                                                            *
+ * Return value: SUCCEED - the string was read successfully                   *
+ *               FAIL    - the snapshot data is corrupted                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_snapshot_read_str(const char **ptr, const char *end, char **str)
+{
+	trx_uint32_t	len;
+
+	if (SUCCEED != vc_snapshot_read(ptr, end, &len, sizeof(len)))
+		return FAIL;
+
+	if (TRX_VC_SNAPSHOT_NULL_STRING == len)
+	{
+		*str = NULL;
+		return SUCCEED;
+	}
+
+	if ((size_t)(end - *ptr) <= len || '\0' != (*ptr)[len])
+		return FAIL;
+
+	*str = (char *)*ptr;
+	*ptr += len + 1;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_snapshot_read_values                                          *
+ *                                                                            *
+ * Purpose: reads item history values from snapshot                           *
+ *                                                                            *
+ * Parameters: ptr        - [IN/OUT] the current position in snapshot         *
+ *             end        - [IN] the end of snapshot                          *
+ *             value_type - [IN] the item value type                          *
+ *             values_num - [IN] the number of values to read                 *
+ *             range_end  - [IN] the values with timestamp seconds greater or *
+ *                               equal to range end are skipped               *
+ *             values     - [OUT] the history values in ascending order       *
+ *                                                                            *
+ * Return value: SUCCEED - the values were read successfully                  *
+ *               FAIL    - the snapshot data is corrupted                     *
+ *                                                                            *
+ * Comments: The string values are not copied, they are pointing into         *
+ *           snapshot data. The log value structures are allocated and must   *
+ *           be freed with vc_snapshot_clear_values() function.               *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_snapshot_read_values(const char **ptr, const char *end, int value_type, trx_uint32_t values_num,
+		int range_end, trx_vector_history_record_t *values)
+{
+	trx_history_record_t	record;
+	trx_log_value_t		log;
+	trx_uint32_t		i;
+
+	for (i = 0; i < values_num; i++)
+	{
+		if (SUCCEED != vc_snapshot_read(ptr, end, &record.timestamp.sec, sizeof(int)) ||
+				SUCCEED != vc_snapshot_read(ptr, end, &record.timestamp.ns, sizeof(int)))
+		{
+			return FAIL;
+		}
+
+		switch (value_type)
+		{
+			case ITEM_VALUE_TYPE_FLOAT:
+				if (SUCCEED != vc_snapshot_read(ptr, end, &record.value.dbl, sizeof(double)))
+					return FAIL;
+				break;
+			case ITEM_VALUE_TYPE_UINT64:
+				if (SUCCEED != vc_snapshot_read(ptr, end, &record.value.ui64, sizeof(trx_uint64_t)))
+					return FAIL;
+				break;
+			case ITEM_VALUE_TYPE_STR:
+			case ITEM_VALUE_TYPE_TEXT:
+				if (SUCCEED != vc_snapshot_read_str(ptr, end, &record.value.str) || NULL == record.value.str)
+					return FAIL;
+				break;
+			case ITEM_VALUE_TYPE_LOG:
+				if (SUCCEED != vc_snapshot_read(ptr, end, &log.timestamp, sizeof(int)) ||
+						SUCCEED != vc_snapshot_read(ptr, end, &log.logeventid, sizeof(int)) ||
+						SUCCEED != vc_snapshot_read(ptr, end, &log.severity, sizeof(int)) ||
+						SUCCEED != vc_snapshot_read_str(ptr, end, &log.source) ||
+						SUCCEED != vc_snapshot_read_str(ptr, end, &log.value) || NULL == log.value)
+				{
+					return FAIL;
+				}
+				break;
+			default:
+				return FAIL;
+		}
+
+		if (0 > record.timestamp.ns || VC_MAX_NANOSECONDS < record.timestamp.ns)
+			return FAIL;
+
+		if (0 != values->values_num && 0 < trx_timespec_compare(&values->values[values->values_num - 1].timestamp,
+				&record.timestamp))
+		{
+			return FAIL;
+		}
+
+		if (record.timestamp.sec >= range_end)
+			continue;
+
+		if (ITEM_VALUE_TYPE_LOG == value_type)
+		{
+			record.value.log = (trx_log_value_t *)trx_malloc(NULL, sizeof(trx_log_value_t));
+			*record.value.log = log;
+		}
+
+		trx_vector_history_record_append_ptr(values, &record);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_snapshot_clear_values                                         *
+ *                                                                            *
+ * Purpose: frees history values read from snapshot                           *
+ *                                                                            *
+ * Parameters: values     - [IN/OUT] the history values                       *
+ *             value_type - [IN] the item value type                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_snapshot_clear_values(trx_vector_history_record_t *values, int value_type)
+{
+	int	i;
+
+	if (ITEM_VALUE_TYPE_LOG == value_type)
+	{
+		for (i = 0; i < values->values_num; i++)
+			trx_free(values->values[i].value.log);
+	}
+
+	values->values_num = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_snapshot_resync_batch                                         *
+ *                                                                            *
+ * Purpose: adds history values written after snapshot creation to the items  *
+ *          loaded from snapshot                                              *
+ *                                                                            *
+ * Parameters: itemids     - [IN] the item identifiers, sorted                *
+ *             itemids_num - [IN] the number of items                         *
+ *             value_type  - [IN] the items value type                        *
+ *             range_start - [IN] the timestamp from which the values must be *
+ *                                read from database                          *
+ *                                                                            *
+ * Comments: Items that cannot be synchronized are removed from cache.        *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_snapshot_resync_batch(const trx_uint64_t *itemids, int itemids_num, int value_type,
+		int range_start)
+{
+	trx_vector_history_record_t	*records;
+	trx_vc_item_t			*item;
+	int				i, j, ret;
+
+	records = (trx_vector_history_record_t *)trx_malloc(NULL,
+			sizeof(trx_vector_history_record_t) * (size_t)itemids_num);
+
+	for (i = 0; i < itemids_num; i++)
+		trx_vector_history_record_create(&records[i]);
+
+	/* decrement interval start point because interval starting point is excluded by history backend */
+	ret = trx_history_get_values_multi(itemids, itemids_num, value_type, range_start - 1, TRX_JAN_2038, records);
+
+	vc_try_lock();
+
+	for (i = 0; i < itemids_num; i++)
+	{
+		trx_vector_history_record_t	*values = &records[i];
+
+		if (NULL == (item = (trx_vc_item_t *)trx_hashset_search(&vc_cache->items, &itemids[i])))
+			goto next;
+
+		vc_item_addref(item);
+
+		if (SUCCEED != ret || item->value_type != value_type)
+		{
+			item->state |= TRX_ITEM_STATE_REMOVE_PENDING;
+		}
+		else
+		{
+			trx_vector_history_record_sort(values, (trx_compare_func_t)trx_history_record_compare_asc_func);
+
+			for (j = 0; j < values->values_num; j++)
+			{
+				if (SUCCEED != vch_item_add_value_at_head(item, &values->values[j]))
+				{
+					item->state |= TRX_ITEM_STATE_REMOVE_PENDING;
+					break;
+				}
+			}
+
+			/* all values since the range start are cached now */
+			if (j == values->values_num)
+				vc_item_update_db_cached_from(item, range_start);
+		}
+
+		vc_item_release(item);
+next:
+		trx_history_record_vector_destroy(values, value_type);
+	}
+
+	vc_try_unlock();
+
+	trx_free(records);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_snapshot_item_compare_by_access                               *
+ *                                                                            *
+ * Purpose: sorts items by last access time in descending order               *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_snapshot_item_compare_by_access(const void *d1, const void *d2)
+{
+	const trx_uint64_pair_t	*p1 = (const trx_uint64_pair_t *)d1;
+	const trx_uint64_pair_t	*p2 = (const trx_uint64_pair_t *)d2;
+
+	TRX_RETURN_IF_NOT_EQUAL(p2->second, p1->second);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_vc_save_snapshot                                             *
+ *                                                                            *
+ * Purpose: writes value cache contents into snapshot file                    *
+ *                                                                            *
+ * Parameters: path  - [IN] the snapshot file path                            *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot was written successfully              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The items are written in batches, locking value cache for each   *
+ *           batch, so other processes are not blocked during the whole       *
+ *           snapshot writing. The most recently accessed items are written   *
+ *           first, so they are loaded first if the value cache size was      *
+ *           reduced. The snapshot is written into temporary file which is    *
+ *           synced to disk and then replaces the old snapshot file.          *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_vc_save_snapshot(const char *path, char **error)
+{
+	trx_vector_uint64_pair_t	items;
+	trx_uint64_pair_t		pair;
+	trx_vc_snapshot_header_t	header;
+	trx_vc_item_t			*item;
+	trx_hashset_iter_t		iter;
+	FILE				*fp = NULL;
+	char				*path_tmp = NULL, *data = NULL;
+	size_t				data_alloc = 0, data_offset = 0;
+	int				i, j, ret = FAIL, expire_timestamp;
+	double				sec;
+
+	/* value cache is enabled only after it is loaded, so the snapshot is not overwritten with */
+	/* empty cache if server fails during startup                                              */
+	if (TRX_VC_DISABLED == vc_state)
+		return SUCCEED;
+
+	treegix_log(LOG_LEVEL_DEBUG, "In %s() path:'%s'", __func__, path);
+
+	sec = trx_time();
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, TRX_VC_SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.created = (int)time(NULL);
+	expire_timestamp = header.created - TRX_VC_ITEM_EXPIRE_PERIOD;
+
+	trx_vector_uint64_pair_create(&items);
+
+	vc_try_lock();
+
+	trx_vector_uint64_pair_reserve(&items, (size_t)vc_cache->items.num_data);
+
+	trx_hashset_iter_reset(&vc_cache->items, &iter);
+	while (NULL != (item = (trx_vc_item_t *)trx_hashset_iter_next(&iter)))
+	{
+		if (0 != (item->state & TRX_ITEM_STATE_REMOVE_PENDING) || item->last_accessed < expire_timestamp)
+			continue;
+
+		pair.first = item->itemid;
+		pair.second = (trx_uint64_t)item->last_accessed;
+		trx_vector_uint64_pair_append(&items, pair);
+	}
+
+	vc_try_unlock();
+
+	trx_vector_uint64_pair_sort(&items, vc_snapshot_item_compare_by_access);
+
+	path_tmp = trx_dsprintf(NULL, "%s.tmp", path);
+
+	if (NULL == (fp = fopen(path_tmp, "w")))
+	{
+		*error = trx_dsprintf(*error, "cannot create file \"%s\": %s", path_tmp, trx_strerror(errno));
+		goto out;
+	}
+
+	if (1 != fwrite(&header, sizeof(header), 1, fp))
+		goto write_error;
+
+	for (i = 0; i < items.values_num; i += TRX_VC_SNAPSHOT_BATCH_SIZE)
+	{
+		data_offset = 0;
+
+		vc_try_lock();
+
+		for (j = i; j < items.values_num && j < i + TRX_VC_SNAPSHOT_BATCH_SIZE; j++)
+		{
+			if (NULL == (item = (trx_vc_item_t *)trx_hashset_search(&vc_cache->items, &items.values[j].first)))
+				continue;
+
+			if (0 != (item->state & TRX_ITEM_STATE_REMOVE_PENDING))
+				continue;
+
+			vc_snapshot_write_item(&data, &data_alloc, &data_offset, item);
+			header.items_num++;
+		}
+
+		vc_try_unlock();
+
+		if (0 != data_offset && 1 != fwrite(data, data_offset, 1, fp))
+			goto write_error;
+	}
+
+	if (0 != fseek(fp, 0, SEEK_SET) || 1 != fwrite(&header, sizeof(header), 1, fp))
+		goto write_error;
+
+	/* make sure the data reaches disk before the old snapshot is replaced */
+	if (0 != fflush(fp) || 0 != fsync(fileno(fp)))
+		goto write_error;
+
+	if (0 != fclose(fp))
+	{
+		fp = NULL;
+		goto write_error;
+	}
+
+	fp = NULL;
+
+	if (0 != rename(path_tmp, path))
+	{
+		*error = trx_dsprintf(*error, "cannot rename file \"%s\" to \"%s\": %s", path_tmp, path,
+				trx_strerror(errno));
+		goto out;
+	}
+
+	treegix_log(LOG_LEVEL_DEBUG, "value cache snapshot of %u items written in " TRX_FS_DBL " sec",
+			header.items_num, trx_time() - sec);
+
+	ret = SUCCEED;
+	goto out;
+write_error:
+	*error = trx_dsprintf(*error, "cannot write file \"%s\": %s", path_tmp, trx_strerror(errno));
+out:
+	if (NULL != fp)
+		fclose(fp);
+
+	if (SUCCEED != ret)
+		unlink(path_tmp);
+
+	trx_free(data);
+	trx_free(path_tmp);
+	trx_vector_uint64_pair_destroy(&items);
+
+	treegix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, trx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_vc_load_snapshot                                             *
+ *                                                                            *
+ * Purpose: loads value cache contents from snapshot file                     *
+ *                                                                            *
+ * Parameters: path  - [IN] the snapshot file path                            *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot was loaded or there was no snapshot   *
+ *                         to load                                            *
+ *               FAIL    - the snapshot could not be loaded                   *
+ *                                                                            *
+ * Comments: This function must be called before forking processes, with      *
+ *           database connection opened.                                      *
+ *           Snapshots older than item expiration period are ignored. Item    *
+ *           values newer than the snapshot creation time minus resync period *
+ *           are dropped and read again from history storage, so the loaded   *
+ *           cache contains all values written during server downtime and     *
+ *           the cached ranges (db_cached_from) stay valid.                   *
+ *           Loading stops when value cache free space drops below 10%.       *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_vc_load_snapshot(const char *path, char **error)
+{
+	trx_vc_snapshot_header_t	header;
+	trx_vc_snapshot_item_t		snapshot_item;
+	trx_vector_history_record_t	values;
+	trx_vector_uint64_t		itemids[ITEM_VALUE_TYPE_MAX];
+	trx_vc_item_t			*item, new_item;
+	struct stat			st;
+	const char			*data = MAP_FAILED, *ptr, *end;
+	int				fd, i, ret = FAIL, now, range_end, items_num = 0, values_num = 0, corrupted = 0;
+	trx_uint32_t			n;
+	double				sec;
+
+	if (NULL == vc_cache)
+		return SUCCEED;
+
+	treegix_log(LOG_LEVEL_DEBUG, "In %s() path:'%s'", __func__, path);
+
+	sec = trx_time();
+
+	for (i = 0; i < ITEM_VALUE_TYPE_MAX; i++)
+		trx_vector_uint64_create(&itemids[i]);
+
+	trx_vector_history_record_create(&values);
+
+	if (-1 == (fd = open(path, O_RDONLY)))
+	{
+		if (ENOENT == errno)
+		{
+			ret = SUCCEED;
+			goto out;
+		}
+
+		*error = trx_dsprintf(*error, "cannot open file \"%s\": %s", path, trx_strerror(errno));
+		goto out;
+	}
+
+	if (0 != fstat(fd, &st))
+	{
+		*error = trx_dsprintf(*error, "cannot stat file \"%s\": %s", path, trx_strerror(errno));
+		close(fd);
+		goto out;
+	}
+
+	if ((size_t)st.st_size < sizeof(header))
+	{
+		*error = trx_dsprintf(*error, "file \"%s\" is not a value cache snapshot", path);
+		close(fd);
+		goto out;
+	}
+
+	data = (const char *)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (MAP_FAILED == data)
+	{
+		*error = trx_dsprintf(*error, "cannot map file \"%s\": %s", path, trx_strerror(errno));
+		goto out;
+	}
+
+	ptr = data;
+	end = data + st.st_size;
+	vc_snapshot_read(&ptr, end, &header, sizeof(header));
+
+	if (0 != memcmp(header.magic, TRX_VC_SNAPSHOT_MAGIC, sizeof(header.magic)))
+	{
+		*error = trx_dsprintf(*error, "file \"%s\" is not a value cache snapshot", path);
+		goto out;
+	}
+
+	now = (int)time(NULL);
+
+	if (header.created > now || header.created < now - TRX_VC_ITEM_EXPIRE_PERIOD)
+	{
+		treegix_log(LOG_LEVEL_WARNING, "value cache snapshot \"%s\" is outdated, ignoring it", path);
+		ret = SUCCEED;
+		goto out;
+	}
+
+	range_end = header.created - TRX_VC_SNAPSHOT_RESYNC_PERIOD;
+
+	vc_try_lock();
+
+	for (n = 0; n < header.items_num; n++)
+	{
+		if (SUCCEED != vc_snapshot_read(&ptr, end, &snapshot_item, sizeof(snapshot_item)) ||
+				ITEM_VALUE_TYPE_MAX <= snapshot_item.value_type ||
+				SUCCEED != vc_snapshot_read_values(&ptr, end, snapshot_item.value_type,
+				snapshot_item.values_num, range_end, &values))
+		{
+			vc_snapshot_clear_values(&values, snapshot_item.value_type);
+			corrupted = 1;
+			break;
+		}
+
+		/* stop loading when cache is getting full, so there is space left for new items */
+		if (TRX_VC_MODE_NORMAL != vc_cache->mode ||
+				vc_mem->free_size < vc_mem->total_size / 100 * TRX_VC_SNAPSHOT_MIN_FREE)
+		{
+			vc_snapshot_clear_values(&values, snapshot_item.value_type);
+			break;
+		}
+
+		if (snapshot_item.last_accessed < now - TRX_VC_ITEM_EXPIRE_PERIOD ||
+				NULL != trx_hashset_search(&vc_cache->items, &snapshot_item.itemid))
+		{
+			vc_snapshot_clear_values(&values, snapshot_item.value_type);
+			continue;
+		}
+
+		memset(&new_item, 0, sizeof(new_item));
+		new_item.itemid = snapshot_item.itemid;
+		new_item.value_type = snapshot_item.value_type;
+
+		if (NULL == (item = (trx_vc_item_t *)trx_hashset_insert(&vc_cache->items, &new_item,
+				sizeof(trx_vc_item_t))))
+		{
+			vc_snapshot_clear_values(&values, snapshot_item.value_type);
+			break;
+		}
+
+		item->status = snapshot_item.status;
+		item->range_sync_hour = snapshot_item.range_sync_hour;
+		item->last_accessed = snapshot_item.last_accessed;
+		item->active_range = snapshot_item.active_range;
+		item->daily_range = snapshot_item.daily_range;
+		item->db_cached_from = snapshot_item.db_cached_from;
+		item->hits = snapshot_item.hits;
+
+		vc_item_addref(item);
+
+		if (0 != values.values_num && SUCCEED != vch_item_add_values_at_tail(item, values.values,
+				values.values_num))
+		{
+			item->state |= TRX_ITEM_STATE_REMOVE_PENDING;
+		}
+		else
+		{
+			trx_vector_uint64_append(&itemids[item->value_type], item->itemid);
+			values_num += values.values_num;
+			items_num++;
+		}
+
+		vc_item_release(item);
+		vc_snapshot_clear_values(&values, snapshot_item.value_type);
+	}
+
+	vc_try_unlock();
+
+	for (i = 0; i < ITEM_VALUE_TYPE_MAX; i++)
+	{
+		int	j;
+
+		trx_vector_uint64_sort(&itemids[i], TRX_DEFAULT_UINT64_COMPARE_FUNC);
+
+		for (j = 0; j < itemids[i].values_num; j += TRX_VC_MULTI_BATCH_SIZE)
+		{
+			vc_snapshot_resync_batch(itemids[i].values + j, MIN(TRX_VC_MULTI_BATCH_SIZE,
+					itemids[i].values_num - j), i, range_end);
+		}
+	}
+
+	treegix_log(LOG_LEVEL_INFORMATION, "loaded %d items with %d values from value cache snapshot in "
+			TRX_FS_DBL " sec", items_num, values_num, trx_time() - sec);
+
+	if (0 != corrupted)
+		*error = trx_dsprintf(*error, "file \"%s\" is corrupted", path);
+	else
+		ret = SUCCEED;
+out:
+	if (MAP_FAILED != data)
+		munmap((void *)data, (size_t)st.st_size);
+
+	trx_vector_history_record_destroy(&values);
+
+	for (i = 0; i < ITEM_VALUE_TYPE_MAX; i++)
+		trx_vector_uint64_destroy(&itemids[i]);
+
+	treegix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, trx_result_string(ret));
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: trx_vc_get_statistics                                            *
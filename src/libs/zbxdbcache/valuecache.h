@@ -65,6 +65,20 @@ typedef struct
 }
 trx_vc_stats_t;
 
+/* the value request of trx_vc_get_values_multi() function */
+typedef struct
+{
+	trx_uint64_t			itemid;
+	int				value_type;
+	int				seconds;
+	int				count;
+	trx_timespec_t			ts;
+
+	/* the item history data, optional - if not set the values are only loaded into cache */
+	trx_vector_history_record_t	*values;
+}
+trx_vc_request_t;
+
 int	trx_vc_init(char **error);
 
 void	trx_vc_destroy(void);
@@ -84,8 +98,14 @@ int	trx_vc_get_values(trx_uint64_t itemid, int value_type, trx_vector_history_re
 
 int	trx_vc_get_value(trx_uint64_t itemid, int value_type, const trx_timespec_t *ts, trx_history_record_t *value);
 
+int	trx_vc_get_values_multi(trx_vc_request_t *requests, int requests_num);
+
 int	trx_vc_add_values(trx_vector_ptr_t *history);
 
 int	trx_vc_get_statistics(trx_vc_stats_t *stats);
 
+int	trx_vc_save_snapshot(const char *path, char **error);
+
+int	trx_vc_load_snapshot(const char *path, char **error);
+
 #endif	/* TREEGIX_VALUECACHE_H */
@@ -82,6 +82,63 @@ int	DBconnect(int flag)
 	return err;
 }
 
+#ifdef HAVE_POSTGRESQL
+/******************************************************************************
+ *                                                                            *
+ * Function: DBasync_connect                                                  *
+ *                                                                            *
+ * Purpose: open connection for asynchronous statement execution              *
+ *                                                                            *
+ * Parameters: flag - TRX_DB_CONNECT_ONCE (try once and return the result),   *
+ *                    TRX_DB_CONNECT_EXIT (exit on failure) or                *
+ *                    TRX_DB_CONNECT_NORMAL (retry until connected)           *
+ *                                                                            *
+ * Return value: same as trx_db_async_connect()                               *
+ *                                                                            *
+ ******************************************************************************/
+int	DBasync_connect(int flag)
+{
+	int	err;
+
+	treegix_log(LOG_LEVEL_DEBUG, "In %s() flag:%d", __func__, flag);
+
+	while (TRX_DB_OK != (err = trx_db_async_connect(CONFIG_DBHOST, CONFIG_DBUSER, CONFIG_DBPASSWORD,
+			CONFIG_DBNAME, CONFIG_DBSCHEMA, CONFIG_DBSOCKET, CONFIG_DBPORT)))
+	{
+		if (TRX_DB_CONNECT_ONCE == flag)
+			break;
+
+		if (TRX_DB_FAIL == err || TRX_DB_CONNECT_EXIT == flag)
+		{
+			treegix_log(LOG_LEVEL_CRIT, "Cannot connect to the database. Exiting...");
+			exit(EXIT_FAILURE);
+		}
+
+		treegix_log(LOG_LEVEL_ERR, "database is down: reconnecting in %d seconds", TRX_DB_WAIT_DOWN);
+		trx_sleep(TRX_DB_WAIT_DOWN);
+	}
+
+	treegix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, err);
+
+	return err;
+}
+
+void	DBasync_close(void)
+{
+	trx_db_async_close();
+}
+
+int	DBasync_execute(const char *sql)
+{
+	return trx_db_async_execute(sql);
+}
+
+int	DBasync_wait(void)
+{
+	return trx_db_async_wait();
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: DBinit                                                           *
@@ -2254,6 +2311,7 @@ void	trx_db_insert_prepare_dyn(trx_db_insert_t *self, const TRX_TABLE *table, co
 	}
 
 	self->autoincrement = -1;
+	self->copy = 0;
 
 	trx_vector_ptr_create(&self->fields);
 	trx_vector_ptr_create(&self->rows);
@@ -2358,7 +2416,9 @@ void	trx_db_insert_add_values_dyn(trx_db_insert_t *self, const trx_db_value_t **
 #ifdef HAVE_ORACLE
 				row[i].str = DBdyn_escape_field_len(field, value->str, ESCAPE_SEQUENCE_OFF);
 #else
-				row[i].str = DBdyn_escape_field_len(field, value->str, ESCAPE_SEQUENCE_ON);
+				/* strings are escaped when formatting insert statement if COPY is not possible */
+				row[i].str = DBdyn_escape_field_len(field, value->str,
+						0 == self->copy ? ESCAPE_SEQUENCE_ON : ESCAPE_SEQUENCE_OFF);
 #endif
 				break;
 			default:
@@ -2437,6 +2497,259 @@ void	trx_db_insert_add_values(trx_db_insert_t *self, ...)
 	trx_vector_ptr_destroy(&values);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_db_insert_use_copy                                           *
+ *                                                                            *
+ * Purpose: requests the bulk insert operation to be executed with COPY       *
+ *          command if the database supports it                               *
+ *                                                                            *
+ * Parameters: self - [IN] the bulk insert data                               *
+ *                                                                            *
+ * Comments: Must be called before adding values.                             *
+ *           On PostgreSQL the rows are sent with COPY ... FROM STDIN in text *
+ *           format, saving the server from parsing large multi-row insert    *
+ *           statements and the string values from SQL escaping. Insert       *
+ *           statements are still used for other databases and for inserts   *
+ *           with auto increment field.                                       *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_db_insert_use_copy(trx_db_insert_t *self)
+{
+#ifdef HAVE_POSTGRESQL
+	if (0 == self->rows.values_num)
+		self->copy = 1;
+#else
+	TRX_UNUSED(self);
+#endif
+}
+
+#ifdef HAVE_POSTGRESQL
+/******************************************************************************
+ *                                                                            *
+ * Function: db_copy_escape_string                                            *
+ *                                                                            *
+ * Purpose: escapes string value for COPY text format                         *
+ *                                                                            *
+ * Parameters: src         - [IN] the string to escape                        *
+ *             data        - [IN/OUT] the COPY data buffer                    *
+ *             data_alloc  - [IN/OUT] the COPY data buffer size               *
+ *             data_offset - [IN/OUT] the COPY data buffer offset             *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_copy_escape_string(const char *src, char **data, size_t *data_alloc, size_t *data_offset)
+{
+	const char	*ptr;
+
+	for (ptr = src; '\0' != *ptr; ptr++)
+	{
+		const char	*esc;
+
+		switch (*ptr)
+		{
+			case '\\':
+				esc = "\\\\";
+				break;
+			case '\t':
+				esc = "\\t";
+				break;
+			case '\n':
+				esc = "\\n";
+				break;
+			case '\r':
+				esc = "\\r";
+				break;
+			default:
+				continue;
+		}
+
+		trx_strncpy_alloc(data, data_alloc, data_offset, src, (size_t)(ptr - src));
+		trx_strcpy_alloc(data, data_alloc, data_offset, esc);
+		src = ptr + 1;
+	}
+
+	trx_strncpy_alloc(data, data_alloc, data_offset, src, (size_t)(ptr - src));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: db_insert_copy                                                   *
+ *                                                                            *
+ * Purpose: executes the prepared database bulk insert operation with COPY    *
+ *          command                                                           *
+ *                                                                            *
+ * Parameters: self - [IN] the bulk insert data                               *
+ *                                                                            *
+ * Return value: Returns SUCCEED if the operation completed successfully or   *
+ *               FAIL otherwise.                                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	db_insert_copy(const trx_db_insert_t *self)
+{
+	int		i, j, rc;
+	const TRX_FIELD	*field;
+	char		*sql = NULL, *data;
+	size_t		sql_alloc = 0, sql_offset = 0, data_alloc = 16 * TRX_KIBIBYTE, data_offset = 0;
+	const char	delim[2] = {'\t', '\n'};
+
+	trx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "copy %s (", self->table->table);
+
+	for (i = 0; i < self->fields.values_num; i++)
+	{
+		field = (const TRX_FIELD *)self->fields.values[i];
+
+		if (0 != i)
+			trx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+
+		trx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, field->name);
+	}
+
+	trx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ") from stdin");
+
+	data = (char *)trx_malloc(NULL, data_alloc);
+
+	for (i = 0; i < self->rows.values_num; i++)
+	{
+		const trx_db_value_t	*values = (const trx_db_value_t *)self->rows.values[i];
+
+		for (j = 0; j < self->fields.values_num; j++)
+		{
+			const trx_db_value_t	*value = &values[j];
+
+			field = (const TRX_FIELD *)self->fields.values[j];
+
+			switch (field->type)
+			{
+				case TRX_TYPE_CHAR:
+				case TRX_TYPE_TEXT:
+				case TRX_TYPE_SHORTTEXT:
+				case TRX_TYPE_LONGTEXT:
+					db_copy_escape_string(value->str, &data, &data_alloc, &data_offset);
+					break;
+				case TRX_TYPE_INT:
+					trx_snprintf_alloc(&data, &data_alloc, &data_offset, "%d", value->i32);
+					break;
+				case TRX_TYPE_FLOAT:
+					trx_snprintf_alloc(&data, &data_alloc, &data_offset, TRX_FS_DBL, value->dbl);
+					break;
+				case TRX_TYPE_UINT:
+					trx_snprintf_alloc(&data, &data_alloc, &data_offset, TRX_FS_UI64, value->ui64);
+					break;
+				case TRX_TYPE_ID:
+					if (0 != value->ui64)
+					{
+						trx_snprintf_alloc(&data, &data_alloc, &data_offset, TRX_FS_UI64,
+								value->ui64);
+					}
+					else
+						trx_strcpy_alloc(&data, &data_alloc, &data_offset, "\\N");
+					break;
+				default:
+					THIS_SHOULD_NEVER_HAPPEN;
+					exit(EXIT_FAILURE);
+			}
+
+			trx_chrcpy_alloc(&data, &data_alloc, &data_offset, delim[self->fields.values_num - 1 == j]);
+		}
+	}
+
+	rc = trx_db_copy(sql, data, data_offset);
+
+	while (TRX_DB_DOWN == rc)
+	{
+		DBclose();
+		DBconnect(TRX_DB_CONNECT_NORMAL);
+
+		if (TRX_DB_DOWN == (rc = trx_db_copy(sql, data, data_offset)))
+		{
+			treegix_log(LOG_LEVEL_ERR, "database is down: retrying in %d seconds", TRX_DB_WAIT_DOWN);
+			connection_failure = 1;
+			sleep(TRX_DB_WAIT_DOWN);
+		}
+	}
+
+	trx_free(data);
+	trx_free(sql);
+
+	return TRX_DB_OK == rc ? SUCCEED : FAIL;
+}
+#endif
+
+#ifndef HAVE_ORACLE
+/******************************************************************************
+ *                                                                            *
+ * Function: db_insert_format_values                                          *
+ *                                                                            *
+ * Purpose: formats the row values of bulk insert operation                   *
+ *                                                                            *
+ * Parameters: self       - [IN] the bulk insert data                         *
+ *             values     - [IN] the row values                               *
+ *             sql        - [IN/OUT] the SQL buffer                           *
+ *             sql_alloc  - [IN/OUT] the SQL buffer size                      *
+ *             sql_offset - [IN/OUT] the SQL buffer offset                    *
+ *                                                                            *
+ * Comments: The values are written as "(value1,value2,..." without the       *
+ *           closing bracket.                                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_insert_format_values(const trx_db_insert_t *self, const trx_db_value_t *values, char **sql,
+		size_t *sql_alloc, size_t *sql_offset)
+{
+	int		j;
+	const TRX_FIELD	*field;
+	const char	delim[2] = {',', '('};
+
+	for (j = 0; j < self->fields.values_num; j++)
+	{
+		const trx_db_value_t	*value = &values[j];
+
+		field = (const TRX_FIELD *)self->fields.values[j];
+
+		trx_chrcpy_alloc(sql, sql_alloc, sql_offset, delim[0 == j]);
+
+		switch (field->type)
+		{
+			case TRX_TYPE_CHAR:
+			case TRX_TYPE_TEXT:
+			case TRX_TYPE_SHORTTEXT:
+			case TRX_TYPE_LONGTEXT:
+				trx_chrcpy_alloc(sql, sql_alloc, sql_offset, '\'');
+
+				if (0 == self->copy)
+				{
+					trx_strcpy_alloc(sql, sql_alloc, sql_offset, value->str);
+				}
+				else
+				{
+					char	*str_esc;
+
+					str_esc = DBdyn_escape_string(value->str);
+					trx_strcpy_alloc(sql, sql_alloc, sql_offset, str_esc);
+					trx_free(str_esc);
+				}
+
+				trx_chrcpy_alloc(sql, sql_alloc, sql_offset, '\'');
+				break;
+			case TRX_TYPE_INT:
+				trx_snprintf_alloc(sql, sql_alloc, sql_offset, "%d", value->i32);
+				break;
+			case TRX_TYPE_FLOAT:
+				trx_snprintf_alloc(sql, sql_alloc, sql_offset, TRX_FS_DBL, value->dbl);
+				break;
+			case TRX_TYPE_UINT:
+				trx_snprintf_alloc(sql, sql_alloc, sql_offset, TRX_FS_UI64, value->ui64);
+				break;
+			case TRX_TYPE_ID:
+				trx_strcpy_alloc(sql, sql_alloc, sql_offset, DBsql_id_ins(value->ui64));
+				break;
+			default:
+				THIS_SHOULD_NEVER_HAPPEN;
+				exit(EXIT_FAILURE);
+		}
+	}
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: trx_db_insert_execute                                            *
@@ -2451,7 +2764,7 @@ void	trx_db_insert_add_values(trx_db_insert_t *self, ...)
  ******************************************************************************/
 int	trx_db_insert_execute(trx_db_insert_t *self)
 {
-	int		ret = FAIL, i, j;
+	int		ret = FAIL, i;
 	const TRX_FIELD	*field;
 	char		*sql_command, delim[2] = {',', '('};
 	size_t		sql_command_alloc = 512, sql_command_offset = 0;
@@ -2466,12 +2779,16 @@ int	trx_db_insert_execute(trx_db_insert_t *self)
 #	endif
 #else
 	trx_db_bind_context_t	*contexts;
-	int			rc, tries = 0;
+	int			rc, tries = 0, j;
 #endif
 
 	if (0 == self->rows.values_num)
 		return SUCCEED;
 
+#ifdef HAVE_POSTGRESQL
+	if (0 != self->copy && -1 == self->autoincrement)
+		return db_insert_copy(self);
+#endif
 	/* process the auto increment field */
 	if (-1 != self->autoincrement)
 	{
@@ -2607,44 +2924,7 @@ retry_oracle:
 #	else
 		trx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, sql_command);
 #	endif
-		for (j = 0; j < self->fields.values_num; j++)
-		{
-			const trx_db_value_t	*value = &values[j];
-
-			field = (const TRX_FIELD *)self->fields.values[j];
-
-			trx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, delim[0 == j]);
-
-			switch (field->type)
-			{
-				case TRX_TYPE_CHAR:
-				case TRX_TYPE_TEXT:
-				case TRX_TYPE_SHORTTEXT:
-				case TRX_TYPE_LONGTEXT:
-					trx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, '\'');
-					trx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, value->str);
-					trx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, '\'');
-					break;
-				case TRX_TYPE_INT:
-					trx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "%d", value->i32);
-					break;
-				case TRX_TYPE_FLOAT:
-					trx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, TRX_FS_DBL,
-							value->dbl);
-					break;
-				case TRX_TYPE_UINT:
-					trx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, TRX_FS_UI64,
-							value->ui64);
-					break;
-				case TRX_TYPE_ID:
-					trx_strcpy_alloc(&sql, &sql_alloc, &sql_offset,
-							DBsql_id_ins(value->ui64));
-					break;
-				default:
-					THIS_SHOULD_NEVER_HAPPEN;
-					exit(EXIT_FAILURE);
-			}
-		}
+		db_insert_format_values(self, values, &sql, &sql_alloc, &sql_offset);
 #	ifdef HAVE_MYSQL
 		if (NULL != sql_values)
 			trx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, sql_values);
@@ -2687,6 +2967,57 @@ out:
 	return ret;
 }
 
+#ifdef HAVE_POSTGRESQL
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_db_insert_format                                             *
+ *                                                                            *
+ * Purpose: formats the prepared bulk insert operation as SQL statement       *
+ *          without executing it                                              *
+ *                                                                            *
+ * Parameters: self       - [IN] the bulk insert data                         *
+ *             sql        - [IN/OUT] the SQL buffer                           *
+ *             sql_alloc  - [IN/OUT] the SQL buffer size                      *
+ *             sql_offset - [IN/OUT] the SQL buffer offset                    *
+ *                                                                            *
+ * Comments: All rows are inserted with a single multi-row insert statement.  *
+ *           Auto increment fields are not supported.                         *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_db_insert_format(const trx_db_insert_t *self, char **sql, size_t *sql_alloc, size_t *sql_offset)
+{
+	int		i;
+	const TRX_FIELD	*field;
+	const char	delim[2] = {',', '('};
+
+	if (0 == self->rows.values_num)
+		return;
+
+	trx_snprintf_alloc(sql, sql_alloc, sql_offset, "insert into %s ", self->table->table);
+
+	for (i = 0; i < self->fields.values_num; i++)
+	{
+		field = (const TRX_FIELD *)self->fields.values[i];
+
+		trx_chrcpy_alloc(sql, sql_alloc, sql_offset, delim[0 == i]);
+		trx_strcpy_alloc(sql, sql_alloc, sql_offset, field->name);
+	}
+
+	trx_strcpy_alloc(sql, sql_alloc, sql_offset, ") values ");
+
+	for (i = 0; i < self->rows.values_num; i++)
+	{
+		if (0 != i)
+			trx_chrcpy_alloc(sql, sql_alloc, sql_offset, ',');
+
+		db_insert_format_values(self, (const trx_db_value_t *)self->rows.values[i], sql, sql_alloc, sql_offset);
+		trx_chrcpy_alloc(sql, sql_alloc, sql_offset, ')');
+	}
+
+	trx_strcpy_alloc(sql, sql_alloc, sql_offset, ";\n");
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: trx_db_insert_autoincrement                                      *
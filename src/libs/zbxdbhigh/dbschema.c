@@ -2071,6 +2071,16 @@ const TRX_TABLE	tables[] = {
 		},
 		"tls_psk_identity"
 	},
+	{"changelog",	"changelogid",	0,
+		{
+		{"changelogid",	NULL,	NULL,	NULL,	0,	TRX_TYPE_UINT,	TRX_NOTNULL,	0},
+		{"object",	"0",	NULL,	NULL,	0,	TRX_TYPE_INT,	TRX_NOTNULL,	0},
+		{"objectid",	NULL,	NULL,	NULL,	0,	TRX_TYPE_UINT,	TRX_NOTNULL,	0},
+		{"clock",	"0",	NULL,	NULL,	0,	TRX_TYPE_INT,	TRX_NOTNULL,	0},
+		{0}
+		},
+		NULL
+	},
 	{"dbversion",	"",	0,
 		{
 		{"mandatory",	"0",	NULL,	NULL,	0,	TRX_TYPE_INT,	TRX_NOTNULL,	0},
@@ -3903,11 +3913,29 @@ tls_psk varchar(512) DEFAULT '' NOT NULL,\n\
 PRIMARY KEY (autoreg_tlsid)\n\
 );\n\
 CREATE UNIQUE INDEX config_autoreg_tls_1 ON config_autoreg_tls (tls_psk_identity);\n\
+CREATE TABLE changelog (\n\
+changelogid integer  NOT NULL PRIMARY KEY AUTOINCREMENT,\n\
+object integer DEFAULT '0' NOT NULL,\n\
+objectid bigint  NOT NULL,\n\
+clock integer DEFAULT '0' NOT NULL\n\
+);\n\
 CREATE TABLE dbversion (\n\
 mandatory integer DEFAULT '0' NOT NULL,\n\
 optional integer DEFAULT '0' NOT NULL\n\
 );\n\
-INSERT INTO dbversion VALUES ('4040000','4040000');\n\
+INSERT INTO dbversion VALUES ('4040002','4040002');\n\
+CREATE TRIGGER items_insert AFTER INSERT ON items FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (1,new.itemid,cast(strftime('%s','now') as integer)); END;\n\
+CREATE TRIGGER items_update AFTER UPDATE ON items FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (1,new.itemid,cast(strftime('%s','now') as integer)); END;\n\
+CREATE TRIGGER items_delete AFTER DELETE ON items FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (1,old.itemid,cast(strftime('%s','now') as integer)); END;\n\
+CREATE TRIGGER item_preproc_insert AFTER INSERT ON item_preproc FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (1,new.itemid,cast(strftime('%s','now') as integer)); END;\n\
+CREATE TRIGGER item_preproc_update AFTER UPDATE ON item_preproc FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (1,new.itemid,cast(strftime('%s','now') as integer)); END;\n\
+CREATE TRIGGER item_preproc_delete AFTER DELETE ON item_preproc FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (1,old.itemid,cast(strftime('%s','now') as integer)); END;\n\
+CREATE TRIGGER triggers_insert AFTER INSERT ON triggers FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (2,new.triggerid,cast(strftime('%s','now') as integer)); END;\n\
+CREATE TRIGGER triggers_update AFTER UPDATE OF description,expression,priority,type,status,recovery_mode,recovery_expression,correlation_mode,correlation_tag,opdata,flags ON triggers FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (2,new.triggerid,cast(strftime('%s','now') as integer)); END;\n\
+CREATE TRIGGER triggers_delete AFTER DELETE ON triggers FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (2,old.triggerid,cast(strftime('%s','now') as integer)); END;\n\
+CREATE TRIGGER functions_insert AFTER INSERT ON functions FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (2,new.triggerid,cast(strftime('%s','now') as integer)); END;\n\
+CREATE TRIGGER functions_update AFTER UPDATE ON functions FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (2,new.triggerid,cast(strftime('%s','now') as integer)); END;\n\
+CREATE TRIGGER functions_delete AFTER DELETE ON functions FOR EACH ROW BEGIN INSERT INTO changelog (object,objectid,clock) VALUES (2,old.triggerid,cast(strftime('%s','now') as integer)); END;\n\
 ";
 const char	*const db_schema_fkeys[] = {
 	NULL
@@ -3,6 +3,7 @@
 #include "common.h"
 #include "db.h"
 #include "dbupgrade.h"
+#include "log.h"
 
 extern unsigned char	program_type;
 
@@ -17,6 +18,350 @@ static int	DBpatch_4040000(void)
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: DBpatch_execute_statements                                       *
+ *                                                                            *
+ * Purpose: executes NULL terminated list of SQL statements                   *
+ *                                                                            *
+ * Comments: Auto increment columns and database triggers are database        *
+ *           specific and cannot be created with DBcreate_table().            *
+ *                                                                            *
+ ******************************************************************************/
+static int	DBpatch_execute_statements(const char *const *sql)
+{
+	for (; NULL != *sql; sql++)
+	{
+		if (TRX_DB_OK > DBexecute("%s", *sql))
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+static int	DBpatch_4040001(void)
+{
+#if defined(HAVE_MYSQL)
+	const char	*const sql[] = {
+		"CREATE TABLE `changelog` (`changelogid` bigint unsigned NOT NULL auto_increment,"
+			"`object` integer DEFAULT '0' NOT NULL,`objectid` bigint unsigned NOT NULL,"
+			"`clock` integer DEFAULT '0' NOT NULL,PRIMARY KEY (changelogid)) ENGINE=InnoDB",
+		NULL
+	};
+#elif defined(HAVE_POSTGRESQL)
+	const char	*const sql[] = {
+		"CREATE TABLE changelog (changelogid bigserial NOT NULL,object integer DEFAULT '0' NOT NULL,"
+			"objectid bigint NOT NULL,clock integer DEFAULT '0' NOT NULL,PRIMARY KEY (changelogid))",
+		NULL
+	};
+#elif defined(HAVE_ORACLE)
+	const char	*const sql[] = {
+		"CREATE TABLE changelog (changelogid number(20) NOT NULL,object number(10) DEFAULT '0' NOT NULL,"
+			"objectid number(20) NOT NULL,clock number(10) DEFAULT '0' NOT NULL,PRIMARY KEY (changelogid))",
+		"CREATE SEQUENCE changelog_seq START WITH 1 INCREMENT BY 1 NOMAXVALUE",
+		"CREATE TRIGGER changelog_tr BEFORE INSERT ON changelog FOR EACH ROW\n"
+		"BEGIN\n"
+		"SELECT changelog_seq.nextval INTO :new.changelogid FROM dual;\n"
+		"END;",
+		NULL
+	};
+#elif defined(HAVE_IBM_DB2)
+	const char	*const sql[] = {
+		"CREATE TABLE changelog (changelogid bigint NOT NULL GENERATED ALWAYS AS IDENTITY (START WITH 1"
+			" INCREMENT BY 1),object integer WITH DEFAULT '0' NOT NULL,objectid bigint NOT NULL,"
+			"clock integer WITH DEFAULT '0' NOT NULL,PRIMARY KEY (changelogid))",
+		NULL
+	};
+#endif
+
+	return DBpatch_execute_statements(sql);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DBpatch_4040002                                                  *
+ *                                                                            *
+ * Purpose: creates triggers recording item and trigger configuration changes *
+ *          into changelog table                                              *
+ *                                                                            *
+ * Comments: When binary logging is enabled MySQL allows creating triggers    *
+ *           only for users with SUPER privilege or if the server is started  *
+ *           with log_bin_trust_function_creators=1. The database user also   *
+ *           needs TRIGGER privilege on the database.                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	DBpatch_4040002(void)
+{
+#if defined(HAVE_MYSQL)
+	const char	*const sql[] = {
+		"CREATE TRIGGER items_insert AFTER INSERT ON items FOR EACH ROW INSERT INTO changelog (object,"
+			"objectid,clock) VALUES (1,new.itemid,unix_timestamp())",
+		"CREATE TRIGGER items_update AFTER UPDATE ON items FOR EACH ROW INSERT INTO changelog (object,"
+			"objectid,clock) VALUES (1,new.itemid,unix_timestamp())",
+		"CREATE TRIGGER items_delete AFTER DELETE ON items FOR EACH ROW INSERT INTO changelog (object,"
+			"objectid,clock) VALUES (1,old.itemid,unix_timestamp())",
+		"CREATE TRIGGER item_preproc_insert AFTER INSERT ON item_preproc FOR EACH ROW INSERT INTO"
+			" changelog (object,objectid,clock) VALUES (1,new.itemid,unix_timestamp())",
+		"CREATE TRIGGER item_preproc_update AFTER UPDATE ON item_preproc FOR EACH ROW INSERT INTO"
+			" changelog (object,objectid,clock) VALUES (1,new.itemid,unix_timestamp())",
+		"CREATE TRIGGER item_preproc_delete AFTER DELETE ON item_preproc FOR EACH ROW INSERT INTO"
+			" changelog (object,objectid,clock) VALUES (1,old.itemid,unix_timestamp())",
+		"CREATE TRIGGER triggers_insert AFTER INSERT ON triggers FOR EACH ROW INSERT INTO changelog"
+			" (object,objectid,clock) VALUES (2,new.triggerid,unix_timestamp())",
+		"CREATE TRIGGER triggers_update AFTER UPDATE ON triggers FOR EACH ROW INSERT INTO changelog"
+			" (object,objectid,clock) SELECT 2,new.triggerid,"
+			"unix_timestamp() FROM dual WHERE old.description<>new.description OR"
+			" old.expression<>new.expression OR old.priority<>new.priority OR old.type<>new.type OR"
+			" old.status<>new.status OR old.recovery_mode<>new.recovery_mode OR"
+			" old.recovery_expression<>new.recovery_expression OR old.correlation_mode<>new.correlation_mode"
+			" OR old.correlation_tag<>new.correlation_tag OR old.opdata<>new.opdata OR old.flags<>new.flags",
+		"CREATE TRIGGER triggers_delete AFTER DELETE ON triggers FOR EACH ROW INSERT INTO changelog"
+			" (object,objectid,clock) VALUES (2,old.triggerid,unix_timestamp())",
+		"CREATE TRIGGER functions_insert AFTER INSERT ON functions FOR EACH ROW INSERT INTO changelog"
+			" (object,objectid,clock) VALUES (2,new.triggerid,unix_timestamp())",
+		"CREATE TRIGGER functions_update AFTER UPDATE ON functions FOR EACH ROW INSERT INTO changelog"
+			" (object,objectid,clock) VALUES (2,new.triggerid,unix_timestamp())",
+		"CREATE TRIGGER functions_delete AFTER DELETE ON functions FOR EACH ROW INSERT INTO changelog"
+			" (object,objectid,clock) VALUES (2,old.triggerid,unix_timestamp())",
+		NULL
+	};
+#elif defined(HAVE_POSTGRESQL)
+	const char	*const sql[] = {
+		"CREATE FUNCTION changelog_items() RETURNS trigger LANGUAGE plpgsql AS $$\n"
+		"BEGIN\n"
+		"IF TG_OP = 'DELETE' THEN\n"
+		"INSERT INTO changelog (object,objectid,clock) VALUES (1,old.itemid,"
+			"cast(extract(epoch from now()) as integer));\n"
+		"RETURN old;\n"
+		"END IF;\n"
+		"INSERT INTO changelog (object,objectid,clock) VALUES (1,new.itemid,"
+			"cast(extract(epoch from now()) as integer));\n"
+		"RETURN new;\n"
+		"END;\n"
+		"$$",
+		"CREATE TRIGGER items_insert AFTER INSERT ON items FOR EACH ROW EXECUTE PROCEDURE"
+			" changelog_items()",
+		"CREATE TRIGGER items_update AFTER UPDATE ON items FOR EACH ROW EXECUTE PROCEDURE"
+			" changelog_items()",
+		"CREATE TRIGGER items_delete AFTER DELETE ON items FOR EACH ROW EXECUTE PROCEDURE"
+			" changelog_items()",
+		"CREATE FUNCTION changelog_item_preproc() RETURNS trigger LANGUAGE plpgsql AS $$\n"
+		"BEGIN\n"
+		"IF TG_OP = 'DELETE' THEN\n"
+		"INSERT INTO changelog (object,objectid,clock) VALUES (1,old.itemid,"
+			"cast(extract(epoch from now()) as integer));\n"
+		"RETURN old;\n"
+		"END IF;\n"
+		"INSERT INTO changelog (object,objectid,clock) VALUES (1,new.itemid,"
+			"cast(extract(epoch from now()) as integer));\n"
+		"RETURN new;\n"
+		"END;\n"
+		"$$",
+		"CREATE TRIGGER item_preproc_insert AFTER INSERT ON item_preproc FOR EACH ROW EXECUTE PROCEDURE"
+			" changelog_item_preproc()",
+		"CREATE TRIGGER item_preproc_update AFTER UPDATE ON item_preproc FOR EACH ROW EXECUTE PROCEDURE"
+			" changelog_item_preproc()",
+		"CREATE TRIGGER item_preproc_delete AFTER DELETE ON item_preproc FOR EACH ROW EXECUTE PROCEDURE"
+			" changelog_item_preproc()",
+		"CREATE FUNCTION changelog_triggers() RETURNS trigger LANGUAGE plpgsql AS $$\n"
+		"BEGIN\n"
+		"IF TG_OP = 'DELETE' THEN\n"
+		"INSERT INTO changelog (object,objectid,clock) VALUES (2,old.triggerid,"
+			"cast(extract(epoch from now()) as integer));\n"
+		"RETURN old;\n"
+		"END IF;\n"
+		"INSERT INTO changelog (object,objectid,clock) VALUES (2,new.triggerid,"
+			"cast(extract(epoch from now()) as integer));\n"
+		"RETURN new;\n"
+		"END;\n"
+		"$$",
+		"CREATE TRIGGER triggers_insert AFTER INSERT ON triggers FOR EACH ROW EXECUTE PROCEDURE"
+			" changelog_triggers()",
+		"CREATE TRIGGER triggers_update AFTER UPDATE OF description,expression,priority,type,status,"
+			"recovery_mode,recovery_expression,correlation_mode,correlation_tag,opdata,"
+			"flags ON triggers FOR EACH ROW EXECUTE PROCEDURE changelog_triggers()",
+		"CREATE TRIGGER triggers_delete AFTER DELETE ON triggers FOR EACH ROW EXECUTE PROCEDURE"
+			" changelog_triggers()",
+		"CREATE FUNCTION changelog_functions() RETURNS trigger LANGUAGE plpgsql AS $$\n"
+		"BEGIN\n"
+		"IF TG_OP = 'DELETE' THEN\n"
+		"INSERT INTO changelog (object,objectid,clock) VALUES (2,old.triggerid,"
+			"cast(extract(epoch from now()) as integer));\n"
+		"RETURN old;\n"
+		"END IF;\n"
+		"INSERT INTO changelog (object,objectid,clock) VALUES (2,new.triggerid,"
+			"cast(extract(epoch from now()) as integer));\n"
+		"RETURN new;\n"
+		"END;\n"
+		"$$",
+		"CREATE TRIGGER functions_insert AFTER INSERT ON functions FOR EACH ROW EXECUTE PROCEDURE"
+			" changelog_functions()",
+		"CREATE TRIGGER functions_update AFTER UPDATE ON functions FOR EACH ROW EXECUTE PROCEDURE"
+			" changelog_functions()",
+		"CREATE TRIGGER functions_delete AFTER DELETE ON functions FOR EACH ROW EXECUTE PROCEDURE"
+			" changelog_functions()",
+		NULL
+	};
+#elif defined(HAVE_ORACLE)
+	const char	*const sql[] = {
+		"CREATE TRIGGER items_insert\n"
+		"AFTER INSERT ON items\n"
+		"FOR EACH ROW\n"
+		"BEGIN\n"
+		"INSERT INTO changelog (object,objectid,clock) VALUES (1,:new.itemid,"
+			"(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);\n"
+		"END;",
+		"CREATE TRIGGER items_update\n"
+		"AFTER UPDATE ON items\n"
+		"FOR EACH ROW\n"
+		"BEGIN\n"
+		"INSERT INTO changelog (object,objectid,clock) VALUES (1,:new.itemid,"
+			"(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);\n"
+		"END;",
+		"CREATE TRIGGER items_delete\n"
+		"AFTER DELETE ON items\n"
+		"FOR EACH ROW\n"
+		"BEGIN\n"
+		"INSERT INTO changelog (object,objectid,clock) VALUES (1,:old.itemid,"
+			"(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);\n"
+		"END;",
+		"CREATE TRIGGER item_preproc_insert\n"
+		"AFTER INSERT ON item_preproc\n"
+		"FOR EACH ROW\n"
+		"BEGIN\n"
+		"INSERT INTO changelog (object,objectid,clock) VALUES (1,:new.itemid,"
+			"(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);\n"
+		"END;",
+		"CREATE TRIGGER item_preproc_update\n"
+		"AFTER UPDATE ON item_preproc\n"
+		"FOR EACH ROW\n"
+		"BEGIN\n"
+		"INSERT INTO changelog (object,objectid,clock) VALUES (1,:new.itemid,"
+			"(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);\n"
+		"END;",
+		"CREATE TRIGGER item_preproc_delete\n"
+		"AFTER DELETE ON item_preproc\n"
+		"FOR EACH ROW\n"
+		"BEGIN\n"
+		"INSERT INTO changelog (object,objectid,clock) VALUES (1,:old.itemid,"
+			"(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);\n"
+		"END;",
+		"CREATE TRIGGER triggers_insert\n"
+		"AFTER INSERT ON triggers\n"
+		"FOR EACH ROW\n"
+		"BEGIN\n"
+		"INSERT INTO changelog (object,objectid,clock) VALUES (2,:new.triggerid,"
+			"(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);\n"
+		"END;",
+		"CREATE TRIGGER triggers_update\n"
+		"AFTER UPDATE OF description,expression,priority,type,status,recovery_mode,recovery_expression,"
+			"correlation_mode,correlation_tag,opdata,flags ON triggers\n"
+		"FOR EACH ROW\n"
+		"BEGIN\n"
+		"INSERT INTO changelog (object,objectid,clock) VALUES (2,:new.triggerid,"
+			"(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);\n"
+		"END;",
+		"CREATE TRIGGER triggers_delete\n"
+		"AFTER DELETE ON triggers\n"
+		"FOR EACH ROW\n"
+		"BEGIN\n"
+		"INSERT INTO changelog (object,objectid,clock) VALUES (2,:old.triggerid,"
+			"(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);\n"
+		"END;",
+		"CREATE TRIGGER functions_insert\n"
+		"AFTER INSERT ON functions\n"
+		"FOR EACH ROW\n"
+		"BEGIN\n"
+		"INSERT INTO changelog (object,objectid,clock) VALUES (2,:new.triggerid,"
+			"(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);\n"
+		"END;",
+		"CREATE TRIGGER functions_update\n"
+		"AFTER UPDATE ON functions\n"
+		"FOR EACH ROW\n"
+		"BEGIN\n"
+		"INSERT INTO changelog (object,objectid,clock) VALUES (2,:new.triggerid,"
+			"(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);\n"
+		"END;",
+		"CREATE TRIGGER functions_delete\n"
+		"AFTER DELETE ON functions\n"
+		"FOR EACH ROW\n"
+		"BEGIN\n"
+		"INSERT INTO changelog (object,objectid,clock) VALUES (2,:old.triggerid,"
+			"(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);\n"
+		"END;",
+		NULL
+	};
+#elif defined(HAVE_IBM_DB2)
+	const char	*const sql[] = {
+		"CREATE TRIGGER items_insert AFTER INSERT ON items REFERENCING NEW AS n FOR EACH ROW INSERT INTO"
+			" changelog (object,objectid,clock) VALUES (1,n.itemid,"
+			"(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT"
+			" TIMESTAMP - CURRENT TIMEZONE))",
+		"CREATE TRIGGER items_update AFTER UPDATE ON items REFERENCING NEW AS n FOR EACH ROW INSERT INTO"
+			" changelog (object,objectid,clock) VALUES (1,n.itemid,"
+			"(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT"
+			" TIMESTAMP - CURRENT TIMEZONE))",
+		"CREATE TRIGGER items_delete AFTER DELETE ON items REFERENCING OLD AS o FOR EACH ROW INSERT INTO"
+			" changelog (object,objectid,clock) VALUES (1,o.itemid,"
+			"(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT"
+			" TIMESTAMP - CURRENT TIMEZONE))",
+		"CREATE TRIGGER item_preproc_insert AFTER INSERT ON item_preproc REFERENCING NEW AS n FOR EACH"
+			" ROW INSERT INTO changelog (object,objectid,clock) VALUES (1,n.itemid,"
+			"(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT"
+			" TIMESTAMP - CURRENT TIMEZONE))",
+		"CREATE TRIGGER item_preproc_update AFTER UPDATE ON item_preproc REFERENCING NEW AS n FOR EACH"
+			" ROW INSERT INTO changelog (object,objectid,clock) VALUES (1,n.itemid,"
+			"(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT"
+			" TIMESTAMP - CURRENT TIMEZONE))",
+		"CREATE TRIGGER item_preproc_delete AFTER DELETE ON item_preproc REFERENCING OLD AS o FOR EACH"
+			" ROW INSERT INTO changelog (object,objectid,clock) VALUES (1,o.itemid,"
+			"(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT"
+			" TIMESTAMP - CURRENT TIMEZONE))",
+		"CREATE TRIGGER triggers_insert AFTER INSERT ON triggers REFERENCING NEW AS n FOR EACH ROW"
+			" INSERT INTO changelog (object,objectid,clock) VALUES (2,n.triggerid,"
+			"(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT"
+			" TIMESTAMP - CURRENT TIMEZONE))",
+		"CREATE TRIGGER triggers_update AFTER UPDATE OF description,expression,priority,type,status,"
+			"recovery_mode,recovery_expression,correlation_mode,correlation_tag,opdata,"
+			"flags ON triggers REFERENCING NEW AS n FOR EACH ROW INSERT INTO changelog (object,objectid,"
+			"clock) VALUES (2,n.triggerid,(DAYS(CURRENT TIMESTAMP - CURRENT"
+			" TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT TIMESTAMP - CURRENT TIMEZONE))",
+		"CREATE TRIGGER triggers_delete AFTER DELETE ON triggers REFERENCING OLD AS o FOR EACH ROW"
+			" INSERT INTO changelog (object,objectid,clock) VALUES (2,o.triggerid,"
+			"(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT"
+			" TIMESTAMP - CURRENT TIMEZONE))",
+		"CREATE TRIGGER functions_insert AFTER INSERT ON functions REFERENCING NEW AS n FOR EACH ROW"
+			" INSERT INTO changelog (object,objectid,clock) VALUES (2,n.triggerid,"
+			"(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT"
+			" TIMESTAMP - CURRENT TIMEZONE))",
+		"CREATE TRIGGER functions_update AFTER UPDATE ON functions REFERENCING NEW AS n FOR EACH ROW"
+			" INSERT INTO changelog (object,objectid,clock) VALUES (2,n.triggerid,"
+			"(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT"
+			" TIMESTAMP - CURRENT TIMEZONE))",
+		"CREATE TRIGGER functions_delete AFTER DELETE ON functions REFERENCING OLD AS o FOR EACH ROW"
+			" INSERT INTO changelog (object,objectid,clock) VALUES (2,o.triggerid,"
+			"(DAYS(CURRENT TIMESTAMP - CURRENT TIMEZONE)-DAYS('1970-01-01'))*86400+MIDNIGHT_SECONDS(CURRENT"
+			" TIMESTAMP - CURRENT TIMEZONE))",
+		NULL
+	};
+#endif
+
+	if (SUCCEED != DBpatch_execute_statements(sql))
+	{
+#if defined(HAVE_MYSQL)
+		treegix_log(LOG_LEVEL_CRIT, "cannot create changelog triggers: the database user must have TRIGGER"
+				" privilege and, if binary logging is enabled, either SUPER privilege or"
+				" log_bin_trust_function_creators=1 must be set in MySQL server configuration");
+#else
+		treegix_log(LOG_LEVEL_CRIT, "cannot create changelog triggers: the database user must have"
+				" privileges to create triggers");
+#endif
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
 #endif
 
 DBPATCH_START(4040)
@@ -24,5 +369,7 @@ DBPATCH_START(4040)
 /* version, duplicates flag, mandatory flag */
 
 DBPATCH_ADD(4040000, 0, 1)
+DBPATCH_ADD(4040001, 0, 1)
+DBPATCH_ADD(4040002, 0, 1)
 
 DBPATCH_END()
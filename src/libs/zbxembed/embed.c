@@ -17,6 +17,11 @@
 /* maximum number of consequent runtime errors after which it's treated as fatal error */
 #define TRX_ES_MAX_CONSEQUENT_RT_ERROR	3
 
+/* maximum number of loaded script functions kept in the scripting engine heap */
+#define TRX_ES_FUNCTION_CACHE_MAX	100
+
+#define TRX_ES_FUNCTION_STASH	"\xff""\xff""trx_func"
+
 #define TRX_ES_SCRIPT_HEADER	"function(value){"
 #define TRX_ES_SCRIPT_FOOTER	"\n}"
 
@@ -120,6 +125,157 @@ int	trx_es_check_timeout(void *udata)
 	return 0;
 }
 
+static trx_hash_t	es_func_hash(const void *data)
+{
+	const trx_es_func_t	*func = (const trx_es_func_t *)data;
+
+	return TRX_DEFAULT_STRING_HASH_FUNC(func->script);
+}
+
+static int	es_func_compare(const void *d1, const void *d2)
+{
+	const trx_es_func_t	*f1 = (const trx_es_func_t *)d1;
+	const trx_es_func_t	*f2 = (const trx_es_func_t *)d2;
+
+	return strcmp(f1->script, f2->script);
+}
+
+static void	es_func_clear(trx_es_func_t *func)
+{
+	trx_free(func->script);
+}
+
+static void	es_func_unlink(trx_es_env_t *env, trx_es_func_t *func)
+{
+	if (NULL != func->prev)
+		func->prev->next = func->next;
+	else
+		env->func_head = func->next;
+
+	if (NULL != func->next)
+		func->next->prev = func->prev;
+	else
+		env->func_tail = func->prev;
+}
+
+static void	es_func_link_head(trx_es_env_t *env, trx_es_func_t *func)
+{
+	func->prev = NULL;
+
+	if (NULL != (func->next = env->func_head))
+		env->func_head->prev = func;
+	else
+		env->func_tail = func;
+
+	env->func_head = func;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: es_func_push                                                     *
+ *                                                                            *
+ * Purpose: pushes cached script function on the scripting engine stack       *
+ *                                                                            *
+ * Parameters: env    - [IN] the scripting engine environment                 *
+ *             script - [IN] the script                                       *
+ *                                                                            *
+ * Return value: SUCCEED - the function was pushed on stack                   *
+ *               FAIL - the script function is not cached                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	es_func_push(trx_es_env_t *env, const char *script)
+{
+	trx_es_func_t	func_local, *func;
+
+	func_local.script = (char *)script;
+
+	if (NULL == (func = (trx_es_func_t *)trx_hashset_search(&env->functions, &func_local)))
+		return FAIL;
+
+	if (env->func_head != func)
+	{
+		es_func_unlink(env, func);
+		es_func_link_head(env, func);
+	}
+
+	duk_push_global_stash(env->ctx);
+	duk_get_prop_string(env->ctx, -1, TRX_ES_FUNCTION_STASH);
+	duk_get_prop_index(env->ctx, -1, (duk_uarridx_t)func->index);
+	duk_remove(env->ctx, -2);
+	duk_remove(env->ctx, -2);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: es_func_add                                                      *
+ *                                                                            *
+ * Purpose: caches script function from the top of scripting engine stack     *
+ *                                                                            *
+ * Parameters: env    - [IN] the scripting engine environment                 *
+ *             script - [IN] the script                                       *
+ *                                                                            *
+ * Comments: The least recently used function is replaced when the cache is   *
+ *           full. The function is left on the stack.                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	es_func_add(trx_es_env_t *env, const char *script)
+{
+	trx_es_func_t	func_local, *func;
+
+	if (TRX_ES_FUNCTION_CACHE_MAX <= env->functions.num_data)
+	{
+		func = env->func_tail;
+		func_local.index = func->index;
+		es_func_unlink(env, func);
+		trx_hashset_remove_direct(&env->functions, func);
+	}
+	else
+		func_local.index = env->functions.num_data;
+
+	func_local.script = trx_strdup(NULL, script);
+	func = (trx_es_func_t *)trx_hashset_insert(&env->functions, &func_local, sizeof(func_local));
+	es_func_link_head(env, func);
+
+	duk_push_global_stash(env->ctx);
+	duk_get_prop_string(env->ctx, -1, TRX_ES_FUNCTION_STASH);
+	duk_dup(env->ctx, -3);
+	duk_put_prop_index(env->ctx, -2, (duk_uarridx_t)func->index);
+	duk_pop_2(env->ctx);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: es_func_trim                                                     *
+ *                                                                            *
+ * Purpose: drops cached script functions if the scripting engine heap is     *
+ *          running low on memory                                             *
+ *                                                                            *
+ * Parameters: env - [IN] the scripting engine environment                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	es_func_trim(trx_es_env_t *env)
+{
+	if (0 == env->functions.num_data || env->total_alloc < TRX_ES_MEMORY_LIMIT / 2)
+		return;
+
+	treegix_log(LOG_LEVEL_DEBUG, "dropping %d cached javascript functions, heap size " TRX_FS_SIZE_T,
+			env->functions.num_data, (trx_fs_size_t)env->total_alloc);
+
+	trx_hashset_clear(&env->functions);
+	env->func_head = NULL;
+	env->func_tail = NULL;
+
+	duk_push_global_stash(env->ctx);
+	duk_push_object(env->ctx);
+	duk_put_prop_string(env->ctx, -2, TRX_ES_FUNCTION_STASH);
+	duk_pop(env->ctx);
+
+	/* functions have reference loops with their prototypes, full garbage collection is required to free them */
+	duk_gc(env->ctx, 0);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: trx_es_init                                                      *
@@ -171,6 +327,10 @@ int	trx_es_init_env(trx_es_t *es, char **error)
 	es->env = trx_malloc(NULL, sizeof(trx_es_env_t));
 	memset(es->env, 0, sizeof(trx_es_env_t));
 
+	trx_hashset_create_ext(&es->env->functions, TRX_ES_FUNCTION_CACHE_MAX, es_func_hash, es_func_compare,
+			(trx_clean_func_t)es_func_clear, TRX_DEFAULT_MEM_MALLOC_FUNC, TRX_DEFAULT_MEM_REALLOC_FUNC,
+			TRX_DEFAULT_MEM_FREE_FUNC);
+
 	if (0 != setjmp(es->env->loc))
 	{
 		*error = trx_strdup(*error, es->env->error);
@@ -201,6 +361,11 @@ int	trx_es_init_env(trx_es_t *es, char **error)
 		return FAIL;
 	}
 
+	/* create object for cached script functions */
+	duk_push_object(es->env->ctx);
+	duk_put_prop_string(es->env->ctx, -2, TRX_ES_FUNCTION_STASH);
+	duk_pop(es->env->ctx);
+
 	/* initialize CurlHttpRequest prototype */
 	if (FAIL == trx_es_init_httprequest(es, error))
 		goto out;
@@ -210,6 +375,7 @@ int	trx_es_init_env(trx_es_t *es, char **error)
 out:
 	if (SUCCEED != ret)
 	{
+		trx_hashset_destroy(&es->env->functions);
 		trx_free(es->env->error);
 		trx_free(es->env);
 	}
@@ -246,6 +412,7 @@ int	trx_es_destroy_env(trx_es_t *es, char **error)
 		goto out;
 	}
 
+	trx_hashset_destroy(&es->env->functions);
 	duk_destroy_heap(es->env->ctx);
 	trx_free(es->env->error);
 	trx_free(es->env);
@@ -405,12 +572,16 @@ out:
  *           cache some compilation data that can be reused for the next      *
  *           compilation. Because of that execute function accepts script and *
  *           bytecode parameters.                                             *
+ *           If script is not NULL the loaded function is cached in the       *
+ *           scripting engine heap and the bytecode is loaded only when the   *
+ *           script is not found in cache.                                    *
  *                                                                            *
  ******************************************************************************/
 int	trx_es_execute(trx_es_t *es, const char *script, const char *code, int size, const char *param, char **output,
 	char **error)
 {
 	void		*buffer;
+	duk_int_t	rc;
 	volatile int	ret = FAIL;
 
 	treegix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
@@ -421,31 +592,38 @@ int	trx_es_execute(trx_es_t *es, const char *script, const char *code, int size,
 		goto out;
 	}
 
-	TRX_UNUSED(script);
-
 	if (0 != setjmp(es->env->loc))
 	{
 		*error = trx_strdup(*error, es->env->error);
 		goto out;
 	}
 
-	buffer = duk_push_fixed_buffer(es->env->ctx, size);
-	memcpy(buffer, code, size);
-	duk_load_function(es->env->ctx);
+	if (NULL == script || SUCCEED != es_func_push(es->env, script))
+	{
+		buffer = duk_push_fixed_buffer(es->env->ctx, size);
+		memcpy(buffer, code, size);
+		duk_load_function(es->env->ctx);
+
+		if (NULL != script)
+			es_func_add(es->env, script);
+	}
+
 	duk_push_string(es->env->ctx, param);
 
 	es->env->start_time = time(NULL);
+	rc = duk_pcall(es->env->ctx, 1);
+	es_func_trim(es->env);
 
-	if (DUK_EXEC_SUCCESS != duk_pcall(es->env->ctx, 1))
+	if (DUK_EXEC_SUCCESS != rc)
 	{
-		duk_small_int_t	rc = 0;
+		duk_small_int_t	found = 0;
 
 		es->env->rt_error_num++;
 
 		if (0 != duk_is_object(es->env->ctx, -1))
 		{
 			/* try to get 'stack' property of the object on stack, assuming it's an Error object */
-			if (0 != (rc = duk_get_prop_string(es->env->ctx, -1, "stack")))
+			if (0 != (found = duk_get_prop_string(es->env->ctx, -1, "stack")))
 				*error = trx_strdup(*error, duk_get_string(es->env->ctx, -1));
 
 			duk_pop(es->env->ctx);
@@ -453,7 +631,7 @@ int	trx_es_execute(trx_es_t *es, const char *script, const char *code, int size,
 
 		/* If the object does not have stack property, return the object itself as error. */
 		/* This allows to simply throw "error message" from scripts                       */
-		if (0 == rc)
+		if (0 == found)
 			*error = trx_strdup(*error, duk_safe_to_string(es->env->ctx, -1));
 
 		duk_pop(es->env->ctx);
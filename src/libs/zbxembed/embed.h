@@ -4,8 +4,21 @@
 #define TREEGIX_EMBED_H
 
 #include "common.h"
+#include "trxalgo.h"
 #include "duktape.h"
 
+/* loaded script function cache entry */
+typedef struct trx_es_func
+{
+	char			*script;
+	int			index;		/* function index in the stash function object */
+
+	/* least recently used list, the head is the most recently used entry */
+	struct trx_es_func	*prev;
+	struct trx_es_func	*next;
+}
+trx_es_func_t;
+
 struct trx_es_env
 {
 	duk_context	*ctx;
@@ -17,6 +30,10 @@ struct trx_es_env
 	int		fatal_error;
 	int		timeout;
 
+	trx_hashset_t	functions;
+	trx_es_func_t	*func_head;
+	trx_es_func_t	*func_tail;
+
 	jmp_buf		loc;
 };
 
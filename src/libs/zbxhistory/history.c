@@ -12,6 +12,7 @@ TRX_VECTOR_IMPL(history_record, trx_history_record_t)
 
 extern char	*CONFIG_HISTORY_STORAGE_URL;
 extern char	*CONFIG_HISTORY_STORAGE_OPTS;
+extern char	*CONFIG_HISTORY_STORAGE_PATH;
 
 trx_history_iface_t	history_ifaces[ITEM_VALUE_TYPE_MAX];
 
@@ -36,10 +37,12 @@ int	trx_history_init(char **error)
 
 	for (i = 0; i < ITEM_VALUE_TYPE_MAX; i++)
 	{
-		if (NULL == CONFIG_HISTORY_STORAGE_URL || NULL == strstr(CONFIG_HISTORY_STORAGE_OPTS, opts[i]))
-			ret = trx_history_sql_init(&history_ifaces[i], i, error);
-		else
+		if (NULL != CONFIG_HISTORY_STORAGE_PATH && NULL != strstr(CONFIG_HISTORY_STORAGE_OPTS, opts[i]))
+			ret = trx_history_columnar_init(&history_ifaces[i], i, error);
+		else if (NULL != CONFIG_HISTORY_STORAGE_URL && NULL != strstr(CONFIG_HISTORY_STORAGE_OPTS, opts[i]))
 			ret = trx_history_elastic_init(&history_ifaces[i], i, error);
+		else
+			ret = trx_history_sql_init(&history_ifaces[i], i, error);
 
 		if (FAIL == ret)
 			return FAIL;
@@ -78,7 +81,14 @@ void	trx_history_destroy(void)
  *                                                                                  *
  * Parameters: history - [IN] the values to store                                   *
  *                                                                                  *
- * Comments: add history values to the configured storage backends                  *
+ * Return value: SUCCEED - the values were stored successfully                      *
+ *               FAIL    - otherwise                                                *
+ *                                                                                  *
+ * Comments: add history values to the configured storage backends.                 *
+ *           With history pipelining enabled SQL backend values are written         *
+ *           asynchronously and the previous batch write is finished here, so after *
+ *           this function returns all values except the current batch are stored.  *
+ *           Failure to store the previous batch is reported as failure too.        *
  *                                                                                  *
  ************************************************************************************/
 int	trx_history_add_values(const trx_vector_ptr_t *history)
@@ -87,6 +97,10 @@ int	trx_history_add_values(const trx_vector_ptr_t *history)
 
 	treegix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	/* the previous batch must be written before the next one is accepted */
+	if (SUCCEED != trx_history_sql_sync())
+		ret = FAIL;
+
 	for (i = 0; i < ITEM_VALUE_TYPE_MAX; i++)
 	{
 		trx_history_iface_t	*writer = &history_ifaces[i];
@@ -99,8 +113,8 @@ int	trx_history_add_values(const trx_vector_ptr_t *history)
 	{
 		trx_history_iface_t	*writer = &history_ifaces[i];
 
-		if (0 != (flags & (1 << i)))
-			ret = writer->flush(writer);
+		if (0 != (flags & (1 << i)) && SUCCEED != writer->flush(writer))
+			ret = FAIL;
 	}
 
 	treegix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -108,6 +122,21 @@ int	trx_history_add_values(const trx_vector_ptr_t *history)
 	return ret;
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Function: trx_history_sync                                                       *
+ *                                                                                  *
+ * Purpose: waits until all history values are written to the history storage      *
+ *                                                                                  *
+ * Return value: SUCCEED - the values were written successfully                     *
+ *               FAIL    - otherwise                                                *
+ *                                                                                  *
+ ************************************************************************************/
+int	trx_history_sync(void)
+{
+	return trx_history_sql_sync();
+}
+
 /************************************************************************************
  *                                                                                  *
  * Function: trx_history_get_values                                                 *
@@ -138,6 +167,7 @@ int	trx_history_get_values(trx_uint64_t itemid, int value_type, int start, int c
 			__func__, itemid, value_type, start, count, end);
 
 	pos = values->values_num;
+
 	ret = writer->get_values(writer, itemid, start, count, end, values);
 
 	if (SUCCEED == ret && SUCCEED == TRX_CHECK_LOG_LEVEL(LOG_LEVEL_TRACE))
@@ -160,6 +190,52 @@ int	trx_history_get_values(trx_uint64_t itemid, int value_type, int start, int c
 	return ret;
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Function: trx_history_get_values_multi                                           *
+ *                                                                                  *
+ * Purpose: gets history data of multiple items from history storage                *
+ *                                                                                  *
+ * Parameters:  itemids     - [IN] the item identifiers, sorted in ascending order  *
+ *              itemids_num - [IN] the number of items                              *
+ *              value_type  - [IN] the items value type                             *
+ *              start       - [IN] the period start timestamp                       *
+ *              end         - [IN] the period end timestamp                         *
+ *              values      - [OUT] the item history data values, an array of       *
+ *                                  itemids_num vectors matching itemids            *
+ *                                                                                  *
+ * Return value: SUCCEED - the history data were read successfully                  *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ * Comments: This function reads all values from ]<start>,<end>] interval. Storage  *
+ *           backends able to read multiple items at once do it with a single       *
+ *           request, otherwise the items are read one by one.                      *
+ *                                                                                  *
+ ************************************************************************************/
+int	trx_history_get_values_multi(const trx_uint64_t *itemids, int itemids_num, int value_type, int start, int end,
+		trx_vector_history_record_t *values)
+{
+	int			ret = SUCCEED, i;
+	trx_history_iface_t	*writer = &history_ifaces[value_type];
+
+	treegix_log(LOG_LEVEL_DEBUG, "In %s() items:%d value_type:%d start:%d end:%d", __func__, itemids_num,
+			value_type, start, end);
+
+	if (NULL != writer->get_values_multi)
+	{
+		ret = writer->get_values_multi(writer, itemids, itemids_num, start, end, values);
+	}
+	else
+	{
+		for (i = 0; i < itemids_num && SUCCEED == ret; i++)
+			ret = writer->get_values(writer, itemids[i], start, 0, end, &values[i]);
+	}
+
+	treegix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, trx_result_string(ret));
+
+	return ret;
+}
+
 /************************************************************************************
  *                                                                                  *
  * Function: trx_history_requires_trends                                            *
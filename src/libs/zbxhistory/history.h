@@ -5,6 +5,7 @@
 
 #define TRX_HISTORY_IFACE_SQL		0
 #define TRX_HISTORY_IFACE_ELASTIC	1
+#define TRX_HISTORY_IFACE_COLUMNAR	2
 
 typedef struct trx_history_iface trx_history_iface_t;
 
@@ -12,6 +13,8 @@ typedef void (*trx_history_destroy_func_t)(struct trx_history_iface *hist);
 typedef int (*trx_history_add_values_func_t)(struct trx_history_iface *hist, const trx_vector_ptr_t *history);
 typedef int (*trx_history_get_values_func_t)(struct trx_history_iface *hist, trx_uint64_t itemid, int start,
 		int count, int end, trx_vector_history_record_t *values);
+typedef int (*trx_history_get_values_multi_func_t)(struct trx_history_iface *hist, const trx_uint64_t *itemids,
+		int itemids_num, int start, int end, trx_vector_history_record_t *values);
 typedef int (*trx_history_flush_func_t)(struct trx_history_iface *hist);
 
 struct trx_history_iface
@@ -23,13 +26,19 @@ struct trx_history_iface
 	trx_history_destroy_func_t	destroy;
 	trx_history_add_values_func_t	add_values;
 	trx_history_get_values_func_t	get_values;
+	/* optional, values of multiple items are read with get_values if not set */
+	trx_history_get_values_multi_func_t	get_values_multi;
 	trx_history_flush_func_t	flush;
 };
 
 /* SQL hist */
 int	trx_history_sql_init(trx_history_iface_t *hist, unsigned char value_type, char **error);
+int	trx_history_sql_sync(void);
 
 /* elastic hist */
 int	trx_history_elastic_init(trx_history_iface_t *hist, unsigned char value_type, char **error);
 
+/* columnar hist */
+int	trx_history_columnar_init(trx_history_iface_t *hist, unsigned char value_type, char **error);
+
 #endif
@@ -0,0 +1,1479 @@
+#include "common.h"
+#include "log.h"
+#include <sys/mman.h>
+#include "trxalgo.h"
+#include "dbcache.h"
+#include "trxhistory.h"
+#include "history.h"
+
+/******************************************************************************
+ *                                                                            *
+ * Embedded columnar history storage                                          *
+ *                                                                            *
+ * History values of each value type are stored in                            *
+ * <HistoryStoragePath>/<type> directory as append-only segment files, each   *
+ * written by a single history syncer process and memory mapped by the        *
+ * readers. A segment consists of header, item index (open addressing hash    *
+ * table of itemid -> the last block offset) and data area of item value      *
+ * blocks. The blocks of an item are chained from the newest to the oldest    *
+ * one.                                                                       *
+ *                                                                            *
+ * Values in a block are encoded as bit stream - timestamps and unsigned      *
+ * integers with delta-of-delta encoding, floating point values with XOR      *
+ * encoding (as described in Facebook Gorilla paper) and strings as raw       *
+ * bytes.                                                                     *
+ * Values are appended to the block bit stream in place and published by      *
+ * incrementing the block value counter, so readers can decode blocks while   *
+ * they are being written without any locking.                                *
+ *                                                                            *
+ * The segment files use native byte order and are not portable between       *
+ * architectures.                                                             *
+ *                                                                            *
+ * The storage is read only by Treegix server (value cache, trigger and       *
+ * calculated item functions). Frontend and API read history from the         *
+ * database, so they do not show history of the value types stored here.      *
+ *                                                                            *
+ ******************************************************************************/
+
+extern char	*CONFIG_HISTORY_STORAGE_PATH;
+extern int	CONFIG_HISTORY_STORAGE_RETENTION;
+
+#define TRX_COL_MAGIC		"TRXCOL01"
+#define TRX_COL_SUFFIX		".seg"
+
+/* the maximum segment file size */
+#define TRX_COL_SEGMENT_SIZE	(256 * TRX_MEBIBYTE)
+/* the period after which history syncer starts writing a new segment */
+#define TRX_COL_SEGMENT_PERIOD	SEC_PER_DAY
+/* the number of item index slots in segment, must be power of 2 */
+#define TRX_COL_SLOTS_NUM	(256 * 1024)
+/* the maximum number of items in segment to keep the index sparse enough */
+#define TRX_COL_ITEMS_MAX	(TRX_COL_SLOTS_NUM / 4 * 3)
+/* the default value block payload size */
+#define TRX_COL_BLOCK_SIZE	1024
+/* the segment file is allocated by the specified number of bytes */
+#define TRX_COL_ALLOC_STEP	(4 * TRX_MEBIBYTE)
+
+#define TRX_COL_ALIGN(size)	(((size) + 7) & ~(trx_uint64_t)7)
+
+/* segment header */
+typedef struct
+{
+	char		magic[8];
+	trx_uint32_t	value_type;
+	trx_uint32_t	slots_num;
+	/* the start of data area */
+	trx_uint64_t	data_start;
+	/* the end of allocated data, all blocks are located before it */
+	trx_uint64_t	data_end;
+	/* the segment creation time */
+	int		created;
+	/* the range of value timestamps (seconds) stored in segment */
+	int		min_sec;
+	int		max_sec;
+}
+trx_col_header_t;
+
+#define TRX_COL_HEADER_SIZE	TRX_COL_ALIGN(sizeof(trx_col_header_t))
+
+/* item index slot, empty slots have zero itemid */
+typedef struct
+{
+	trx_uint64_t	itemid;
+	/* the offset of the last item block */
+	trx_uint64_t	head;
+}
+trx_col_slot_t;
+
+/* value block header, followed by the payload */
+typedef struct
+{
+	trx_uint64_t	itemid;
+	/* the offset of the previous item block, 0 if this is the first block */
+	trx_uint64_t	prev;
+	/* the payload size */
+	trx_uint32_t	capacity;
+	/* the number of values in block, updated by writer after the value is encoded */
+	trx_uint32_t	count;
+	/* the range of value timestamps (seconds) in block */
+	int		min_sec;
+	int		max_sec;
+}
+trx_col_block_t;
+
+/* bit stream encoder/decoder state of item block */
+typedef struct
+{
+	trx_uint64_t	pos;		/* the bit position in payload */
+	trx_uint64_t	value;		/* the last value - float bits or unsigned integer */
+	trx_uint64_t	delta;		/* the last unsigned integer delta */
+	int		sec;		/* the last timestamp */
+	int		sec_delta;	/* the last timestamp delta */
+	int		leading;	/* the leading zero bits of the last XOR window, -1 - no window */
+	int		trailing;	/* the trailing zero bits of the last XOR window */
+}
+trx_col_state_t;
+
+/* writer item data */
+typedef struct
+{
+	trx_uint64_t	itemid;
+	/* the offset of the block being written */
+	trx_uint64_t	block;
+	trx_col_state_t	state;
+}
+trx_col_item_t;
+
+/* memory mapped segment file */
+typedef struct
+{
+	char		*path;
+	int		fd;
+	unsigned char	*mem;
+	size_t		mem_size;
+	/* the allocated file size (writer only) */
+	size_t		file_size;
+	int		created;
+	int		items_num;
+	/* the segment was found during the last directory scan */
+	unsigned char	found;
+}
+trx_col_segment_t;
+
+typedef struct
+{
+	/* the segment directory of the value type */
+	char			*dir;
+
+	/* the segment being written by the current process and its items */
+	trx_col_segment_t	*writer;
+	trx_hashset_t		items;
+
+	/* the segments mapped for reading, sorted by creation time in descending order */
+	trx_vector_ptr_t	segments;
+	time_t			dir_mtime;
+	time_t			dir_scan;
+}
+trx_col_data_t;
+
+static const char	*value_type_dir[] = {"dbl", "str", "log", "uint", "text"};
+
+/******************************************************************************
+ *                                                                            *
+ * bit stream support                                                         *
+ *                                                                            *
+ ******************************************************************************/
+
+static void	col_write_bits(unsigned char *data, trx_uint64_t *pos, trx_uint64_t value, int bits)
+{
+	while (0 < bits)
+	{
+		int	free_bits = 8 - (int)(*pos & 7), num = MIN(bits, free_bits);
+
+		data[*pos >> 3] |= (unsigned char)(((value >> (bits - num)) & ((1u << num) - 1)) << (free_bits - num));
+		*pos += (trx_uint64_t)num;
+		bits -= num;
+	}
+}
+
+static trx_uint64_t	col_read_bits(const unsigned char *data, trx_uint64_t *pos, int bits)
+{
+	trx_uint64_t	value = 0;
+
+	while (0 < bits)
+	{
+		int	free_bits = 8 - (int)(*pos & 7), num = MIN(bits, free_bits);
+
+		value = (value << num) | ((data[*pos >> 3] >> (free_bits - num)) & ((1u << num) - 1));
+		*pos += (trx_uint64_t)num;
+		bits -= num;
+	}
+
+	return value;
+}
+
+static trx_uint64_t	col_zigzag(trx_int64_t value)
+{
+	return ((trx_uint64_t)value << 1) ^ (trx_uint64_t)(value >> 63);
+}
+
+static trx_int64_t	col_unzigzag(trx_uint64_t value)
+{
+	return (trx_int64_t)((value >> 1) ^ (~(value & 1) + 1));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: col_write_dod                                                    *
+ *                                                                            *
+ * Purpose: writes delta-of-delta value with variable length prefix code:     *
+ *          '0' - zero, '10' - 7 bits, '110' - 16 bits, '1110' - 32 bits,     *
+ *          '1111' - 64 bits                                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	col_write_dod(unsigned char *data, trx_uint64_t *pos, trx_int64_t dod)
+{
+	trx_uint64_t	value = col_zigzag(dod);
+
+	if (0 == value)
+	{
+		col_write_bits(data, pos, 0, 1);
+	}
+	else if (value < (1 << 7))
+	{
+		col_write_bits(data, pos, 2, 2);
+		col_write_bits(data, pos, value, 7);
+	}
+	else if (value < (1 << 16))
+	{
+		col_write_bits(data, pos, 6, 3);
+		col_write_bits(data, pos, value, 16);
+	}
+	else if (value < __UINT64_C(0x100000000))
+	{
+		col_write_bits(data, pos, 14, 4);
+		col_write_bits(data, pos, value, 32);
+	}
+	else
+	{
+		col_write_bits(data, pos, 15, 4);
+		col_write_bits(data, pos, value, 64);
+	}
+}
+
+static trx_int64_t	col_read_dod(const unsigned char *data, trx_uint64_t *pos)
+{
+	static const int	widths[] = {7, 16, 32, 64};
+	int			i;
+
+	if (0 == col_read_bits(data, pos, 1))
+		return 0;
+
+	for (i = 0; i < 3 && 0 != col_read_bits(data, pos, 1); i++)
+		;
+
+	return col_unzigzag(col_read_bits(data, pos, widths[i]));
+}
+
+static void	col_write_str(unsigned char *data, trx_uint64_t *pos, const char *str)
+{
+	size_t	len = (NULL == str ? 0 : strlen(str));
+
+	col_write_bits(data, pos, len, 32);
+	*pos = (*pos + 7) & ~(trx_uint64_t)7;
+	memcpy(data + (*pos >> 3), str, len);
+	*pos += len << 3;
+}
+
+static char	*col_read_str(const unsigned char *data, trx_uint64_t *pos, int skip)
+{
+	size_t	len;
+	char	*str = NULL;
+
+	len = (size_t)col_read_bits(data, pos, 32);
+	*pos = (*pos + 7) & ~(trx_uint64_t)7;
+
+	if (0 == skip)
+	{
+		str = (char *)trx_malloc(NULL, len + 1);
+		memcpy(str, data + (*pos >> 3), len);
+		str[len] = '\0';
+	}
+
+	*pos += len << 3;
+
+	return str;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: col_write_timestamp                                              *
+ *                                                                            *
+ * Purpose: encodes value timestamp                                           *
+ *                                                                            *
+ * Comments: The first timestamp in block is stored as is, the following -    *
+ *           as delta-of-delta of seconds. Nanoseconds are stored as '0' if   *
+ *           zero or '1' followed by 30 bits otherwise.                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	col_write_timestamp(unsigned char *data, trx_col_state_t *state, int count, const trx_timespec_t *ts)
+{
+	if (0 == count)
+	{
+		col_write_bits(data, &state->pos, (trx_uint32_t)ts->sec, 32);
+		state->sec_delta = 0;
+	}
+	else
+	{
+		int	delta = ts->sec - state->sec;
+
+		col_write_dod(data, &state->pos, (trx_int64_t)delta - state->sec_delta);
+		state->sec_delta = delta;
+	}
+
+	state->sec = ts->sec;
+
+	if (0 == ts->ns)
+	{
+		col_write_bits(data, &state->pos, 0, 1);
+	}
+	else
+	{
+		col_write_bits(data, &state->pos, 1, 1);
+		col_write_bits(data, &state->pos, (trx_uint64_t)ts->ns, 30);
+	}
+}
+
+static void	col_read_timestamp(const unsigned char *data, trx_col_state_t *state, int index, trx_timespec_t *ts)
+{
+	if (0 == index)
+	{
+		state->sec = (int)col_read_bits(data, &state->pos, 32);
+		state->sec_delta = 0;
+	}
+	else
+	{
+		state->sec_delta += (int)col_read_dod(data, &state->pos);
+		state->sec += state->sec_delta;
+	}
+
+	ts->sec = state->sec;
+	ts->ns = (0 == col_read_bits(data, &state->pos, 1) ? 0 : (int)col_read_bits(data, &state->pos, 30));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: col_write_dbl                                                    *
+ *                                                                            *
+ * Purpose: encodes floating point value as XOR with the previous value       *
+ *                                                                            *
+ * Comments: The XOR result is stored as '0' if zero, '10' followed by the    *
+ *           meaningful bits if they fit in the previous window or '11'       *
+ *           followed by 5 bits of leading zero count, 6 bits of meaningful   *
+ *           bit count minus one and the meaningful bits otherwise.           *
+ *                                                                            *
+ ******************************************************************************/
+static void	col_write_dbl(unsigned char *data, trx_col_state_t *state, int count, double value)
+{
+	trx_uint64_t	bits, xor;
+	int		leading, trailing;
+
+	memcpy(&bits, &value, sizeof(bits));
+
+	if (0 == count)
+	{
+		col_write_bits(data, &state->pos, bits, 64);
+		state->leading = -1;
+		state->value = bits;
+		return;
+	}
+
+	if (0 == (xor = bits ^ state->value))
+	{
+		col_write_bits(data, &state->pos, 0, 1);
+		return;
+	}
+
+	col_write_bits(data, &state->pos, 1, 1);
+
+	leading = MIN(__builtin_clzll(xor), 31);
+	trailing = __builtin_ctzll(xor);
+
+	if (-1 != state->leading && leading >= state->leading && trailing >= state->trailing)
+	{
+		col_write_bits(data, &state->pos, 0, 1);
+		col_write_bits(data, &state->pos, xor >> state->trailing, 64 - state->leading - state->trailing);
+	}
+	else
+	{
+		col_write_bits(data, &state->pos, 1, 1);
+		col_write_bits(data, &state->pos, (trx_uint64_t)leading, 5);
+		col_write_bits(data, &state->pos, (trx_uint64_t)(64 - leading - trailing - 1), 6);
+		col_write_bits(data, &state->pos, xor >> trailing, 64 - leading - trailing);
+
+		state->leading = leading;
+		state->trailing = trailing;
+	}
+
+	state->value = bits;
+}
+
+static double	col_read_dbl(const unsigned char *data, trx_col_state_t *state, int index)
+{
+	double	value;
+
+	if (0 == index)
+	{
+		state->value = col_read_bits(data, &state->pos, 64);
+	}
+	else if (0 != col_read_bits(data, &state->pos, 1))
+	{
+		if (0 != col_read_bits(data, &state->pos, 1))
+		{
+			state->leading = (int)col_read_bits(data, &state->pos, 5);
+			state->trailing = 64 - state->leading - (int)col_read_bits(data, &state->pos, 6) - 1;
+		}
+
+		state->value ^= col_read_bits(data, &state->pos, 64 - state->leading - state->trailing) <<
+				state->trailing;
+	}
+
+	memcpy(&value, &state->value, sizeof(value));
+
+	return value;
+}
+
+static void	col_write_ui64(unsigned char *data, trx_col_state_t *state, int count, trx_uint64_t value)
+{
+	if (0 == count)
+	{
+		col_write_bits(data, &state->pos, value, 64);
+		state->delta = 0;
+	}
+	else
+	{
+		trx_uint64_t	delta = value - state->value;
+
+		col_write_dod(data, &state->pos, (trx_int64_t)(delta - state->delta));
+		state->delta = delta;
+	}
+
+	state->value = value;
+}
+
+static trx_uint64_t	col_read_ui64(const unsigned char *data, trx_col_state_t *state, int index)
+{
+	if (0 == index)
+	{
+		state->value = col_read_bits(data, &state->pos, 64);
+		state->delta = 0;
+	}
+	else
+	{
+		state->delta += (trx_uint64_t)col_read_dod(data, &state->pos);
+		state->value += state->delta;
+	}
+
+	return state->value;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: col_value_max_size                                               *
+ *                                                                            *
+ * Purpose: calculates the maximum encoded value size in bytes                *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	col_value_max_size(const TRX_DC_HISTORY *h)
+{
+	/* timestamp: 4 + 64 bits of seconds, 1 + 30 bits of nanoseconds */
+	size_t	size = 13;
+
+	switch (h->value_type)
+	{
+		case ITEM_VALUE_TYPE_FLOAT:
+		case ITEM_VALUE_TYPE_UINT64:
+			return size + 10;
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			return size + 5 + strlen(h->value.str);
+		case ITEM_VALUE_TYPE_LOG:
+			return size + 12 + 10 + strlen(h->value.log->value) +
+					(NULL == h->value.log->source ? 0 : strlen(h->value.log->source));
+	}
+
+	return size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * segment file support                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+static trx_col_header_t	*col_header(const trx_col_segment_t *segment)
+{
+	return (trx_col_header_t *)segment->mem;
+}
+
+static trx_col_slot_t	*col_slots(const trx_col_segment_t *segment)
+{
+	return (trx_col_slot_t *)(segment->mem + TRX_COL_HEADER_SIZE);
+}
+
+static trx_uint32_t	col_slot_index(trx_uint64_t itemid, trx_uint32_t slots_num)
+{
+	/* the hash function is part of the file format and must not be changed */
+	return (trx_uint32_t)((itemid * __UINT64_C(0x9e3779b97f4a7c15)) >> 32) & (slots_num - 1);
+}
+
+static void	col_segment_free(trx_col_segment_t *segment)
+{
+	if (NULL != segment->mem)
+		munmap(segment->mem, segment->mem_size);
+
+	if (-1 != segment->fd)
+		close(segment->fd);
+
+	trx_free(segment->path);
+	trx_free(segment);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: col_segment_map                                                  *
+ *                                                                            *
+ * Purpose: maps segment file for reading                                     *
+ *                                                                            *
+ * Parameters: segment - [IN] the segment                                     *
+ *                                                                            *
+ * Return value: SUCCEED - the segment was mapped                             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Segment files grow while being written, so readers map the       *
+ *           current file size and map again when accessing data beyond it.   *
+ *                                                                            *
+ ******************************************************************************/
+static int	col_segment_map(trx_col_segment_t *segment)
+{
+	struct stat	st;
+
+	if (0 != fstat(segment->fd, &st))
+	{
+		treegix_log(LOG_LEVEL_WARNING, "cannot obtain history segment \"%s\" information: %s",
+				segment->path, trx_strerror(errno));
+		return FAIL;
+	}
+
+	if ((size_t)st.st_size == segment->mem_size)
+		return SUCCEED;
+
+	if (NULL != segment->mem)
+	{
+		munmap(segment->mem, segment->mem_size);
+		segment->mem = NULL;
+		segment->mem_size = 0;
+	}
+
+	if (TRX_COL_HEADER_SIZE + sizeof(trx_col_slot_t) * TRX_COL_SLOTS_NUM > (size_t)st.st_size)
+		return FAIL;
+
+	if (MAP_FAILED == (segment->mem = (unsigned char *)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED,
+			segment->fd, 0)))
+	{
+		treegix_log(LOG_LEVEL_WARNING, "cannot map history segment \"%s\": %s", segment->path,
+				trx_strerror(errno));
+		segment->mem = NULL;
+		return FAIL;
+	}
+
+	segment->mem_size = (size_t)st.st_size;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: col_segment_open                                                 *
+ *                                                                            *
+ * Purpose: opens segment file for reading                                    *
+ *                                                                            *
+ ******************************************************************************/
+static trx_col_segment_t	*col_segment_open(const char *path, unsigned char value_type)
+{
+	trx_col_segment_t	*segment;
+	const trx_col_header_t	*header;
+
+	segment = (trx_col_segment_t *)trx_malloc(NULL, sizeof(trx_col_segment_t));
+	memset(segment, 0, sizeof(trx_col_segment_t));
+	segment->path = trx_strdup(NULL, path);
+
+	if (-1 == (segment->fd = open(path, O_RDONLY)))
+	{
+		treegix_log(LOG_LEVEL_WARNING, "cannot open history segment \"%s\": %s", path, trx_strerror(errno));
+		goto fail;
+	}
+
+	if (SUCCEED != col_segment_map(segment))
+		goto fail;
+
+	header = col_header(segment);
+
+	/* the segment is being created */
+	if ('\0' == header->magic[0])
+		goto fail;
+
+	if (0 != memcmp(header->magic, TRX_COL_MAGIC, sizeof(header->magic)) || value_type != header->value_type ||
+			TRX_COL_SLOTS_NUM != header->slots_num)
+	{
+		treegix_log(LOG_LEVEL_WARNING, "invalid history segment \"%s\"", path);
+		goto fail;
+	}
+
+	segment->created = header->created;
+
+	return segment;
+fail:
+	col_segment_free(segment);
+
+	return NULL;
+}
+
+static int	col_segment_compare_desc(const void *d1, const void *d2)
+{
+	const trx_col_segment_t	*s1 = *(const trx_col_segment_t * const *)d1;
+	const trx_col_segment_t	*s2 = *(const trx_col_segment_t * const *)d2;
+
+	TRX_RETURN_IF_NOT_EQUAL(s2->created, s1->created);
+
+	return strcmp(s2->path, s1->path);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: col_scan_segments                                                *
+ *                                                                            *
+ * Purpose: updates the list of segments mapped for reading                   *
+ *                                                                            *
+ * Comments: The directory is scanned only when it has been modified, as new  *
+ *           segments are created rarely.                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	col_scan_segments(trx_col_data_t *data, unsigned char value_type)
+{
+	DIR			*dir;
+	struct dirent		*entry;
+	struct stat		st;
+	trx_col_segment_t	*segment;
+	char			*path = NULL;
+	size_t			path_alloc = 0, path_offset;
+	time_t			now;
+	int			i;
+
+	if (0 != stat(data->dir, &st))
+	{
+		treegix_log(LOG_LEVEL_WARNING, "cannot obtain history directory \"%s\" information: %s", data->dir,
+				trx_strerror(errno));
+		return;
+	}
+
+	now = time(NULL);
+
+	/* rescan the directory modified within the same second as the last scan in case of missed changes */
+	if (st.st_mtime == data->dir_mtime && st.st_mtime < data->dir_scan)
+		return;
+
+	if (NULL == (dir = opendir(data->dir)))
+	{
+		treegix_log(LOG_LEVEL_WARNING, "cannot open history directory \"%s\": %s", data->dir,
+				trx_strerror(errno));
+		return;
+	}
+
+	data->dir_mtime = st.st_mtime;
+	data->dir_scan = now;
+
+	for (i = 0; i < data->segments.values_num; i++)
+		((trx_col_segment_t *)data->segments.values[i])->found = 0;
+
+	while (NULL != (entry = readdir(dir)))
+	{
+		size_t	len = strlen(entry->d_name);
+
+		if (len <= TRX_CONST_STRLEN(TRX_COL_SUFFIX) ||
+				0 != strcmp(entry->d_name + len - TRX_CONST_STRLEN(TRX_COL_SUFFIX), TRX_COL_SUFFIX))
+		{
+			continue;
+		}
+
+		path_offset = 0;
+		trx_snprintf_alloc(&path, &path_alloc, &path_offset, "%s/%s", data->dir, entry->d_name);
+
+		for (i = 0; i < data->segments.values_num; i++)
+		{
+			segment = (trx_col_segment_t *)data->segments.values[i];
+
+			if (0 == strcmp(segment->path, path))
+			{
+				segment->found = 1;
+				break;
+			}
+		}
+
+		if (i != data->segments.values_num)
+			continue;
+
+		if (NULL != (segment = col_segment_open(path, value_type)))
+		{
+			segment->found = 1;
+			trx_vector_ptr_append(&data->segments, segment);
+		}
+	}
+
+	closedir(dir);
+	trx_free(path);
+
+	for (i = 0; i < data->segments.values_num; i++)
+	{
+		segment = (trx_col_segment_t *)data->segments.values[i];
+
+		if (0 == segment->found)
+		{
+			col_segment_free(segment);
+			trx_vector_ptr_remove(&data->segments, i--);
+		}
+	}
+
+	trx_vector_ptr_sort(&data->segments, col_segment_compare_desc);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: col_remove_segments                                              *
+ *                                                                            *
+ * Purpose: removes segments older than HistoryStorageRetention days          *
+ *                                                                            *
+ * Comments: Segments are removed only after their writing period has ended,  *
+ *           readers keep removed segments mapped until the next directory    *
+ *           scan.                                                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	col_remove_segments(trx_col_data_t *data, unsigned char value_type, int now)
+{
+	int			i, cutoff;
+	trx_col_segment_t	*segment;
+
+	if (0 == CONFIG_HISTORY_STORAGE_RETENTION)
+		return;
+
+	cutoff = now - CONFIG_HISTORY_STORAGE_RETENTION * SEC_PER_DAY;
+
+	col_scan_segments(data, value_type);
+
+	for (i = 0; i < data->segments.values_num; i++)
+	{
+		segment = (trx_col_segment_t *)data->segments.values[i];
+
+		if (segment->created + TRX_COL_SEGMENT_PERIOD >= cutoff ||
+				__atomic_load_n(&col_header(segment)->max_sec, __ATOMIC_RELAXED) >= cutoff)
+		{
+			continue;
+		}
+
+		treegix_log(LOG_LEVEL_DEBUG, "removing history segment \"%s\"", segment->path);
+
+		if (0 != unlink(segment->path) && ENOENT != errno)
+		{
+			treegix_log(LOG_LEVEL_WARNING, "cannot remove history segment \"%s\": %s", segment->path,
+					trx_strerror(errno));
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: col_writer_sync                                                  *
+ *                                                                            *
+ * Purpose: writes the modified pages of the segment being written to disk    *
+ *                                                                            *
+ * Return value: SUCCEED - the segment was written to disk                    *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	col_writer_sync(trx_col_segment_t *segment)
+{
+	if (0 != msync(segment->mem, segment->file_size, MS_SYNC))
+	{
+		treegix_log(LOG_LEVEL_ERR, "cannot write history segment \"%s\" to disk: %s", segment->path,
+				trx_strerror(errno));
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: col_writer_close                                                 *
+ *                                                                            *
+ * Purpose: closes the segment being written by the current process           *
+ *                                                                            *
+ ******************************************************************************/
+static void	col_writer_close(trx_col_data_t *data)
+{
+	if (NULL == data->writer)
+		return;
+
+	col_writer_sync(data->writer);
+	col_segment_free(data->writer);
+	data->writer = NULL;
+
+	trx_hashset_clear(&data->items);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: col_writer_open                                                  *
+ *                                                                            *
+ * Purpose: creates a new segment for writing by the current process          *
+ *                                                                            *
+ * Return value: SUCCEED - the segment was created                            *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	col_writer_open(trx_col_data_t *data, unsigned char value_type, int now)
+{
+	trx_col_segment_t	*segment;
+	trx_col_header_t	*header;
+	int			seq, ret;
+
+	col_remove_segments(data, value_type, now);
+
+	segment = (trx_col_segment_t *)trx_malloc(NULL, sizeof(trx_col_segment_t));
+	memset(segment, 0, sizeof(trx_col_segment_t));
+	segment->fd = -1;
+
+	for (seq = 0; -1 == segment->fd; seq++)
+	{
+		segment->path = trx_dsprintf(segment->path, "%s/%d-%d-%d" TRX_COL_SUFFIX, data->dir, now,
+				(int)getpid(), seq);
+
+		if (-1 == (segment->fd = open(segment->path, O_RDWR | O_CREAT | O_EXCL, 0640)) && EEXIST != errno)
+		{
+			treegix_log(LOG_LEVEL_ERR, "cannot create history segment \"%s\": %s", segment->path,
+					trx_strerror(errno));
+			goto fail;
+		}
+	}
+
+	segment->file_size = TRX_COL_HEADER_SIZE + sizeof(trx_col_slot_t) * TRX_COL_SLOTS_NUM;
+
+	if (0 != (ret = posix_fallocate(segment->fd, 0, (off_t)segment->file_size)))
+	{
+		treegix_log(LOG_LEVEL_ERR, "cannot allocate history segment \"%s\": %s", segment->path,
+				trx_strerror(ret));
+		goto fail;
+	}
+
+	/* the writer maps the maximum segment size at once so the mapping never moves */
+	if (MAP_FAILED == (segment->mem = (unsigned char *)mmap(NULL, TRX_COL_SEGMENT_SIZE, PROT_READ | PROT_WRITE,
+			MAP_SHARED, segment->fd, 0)))
+	{
+		treegix_log(LOG_LEVEL_ERR, "cannot map history segment \"%s\": %s", segment->path,
+				trx_strerror(errno));
+		segment->mem = NULL;
+		goto fail;
+	}
+
+	segment->mem_size = TRX_COL_SEGMENT_SIZE;
+	segment->created = now;
+
+	header = col_header(segment);
+	header->value_type = value_type;
+	header->slots_num = TRX_COL_SLOTS_NUM;
+	header->data_start = segment->file_size;
+	header->data_end = segment->file_size;
+	header->created = now;
+	header->min_sec = INT_MAX;
+	header->max_sec = INT_MIN;
+
+	/* the magic is written last to mark header as initialized */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy(header->magic, TRX_COL_MAGIC, sizeof(header->magic));
+
+	data->writer = segment;
+
+	treegix_log(LOG_LEVEL_DEBUG, "created history segment \"%s\"", segment->path);
+
+	return SUCCEED;
+fail:
+	if (-1 != segment->fd)
+		unlink(segment->path);
+
+	col_segment_free(segment);
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: col_writer_alloc                                                 *
+ *                                                                            *
+ * Purpose: allocates space in the data area of the segment being written     *
+ *                                                                            *
+ * Return value: The allocated space offset or 0 if the segment is full or    *
+ *               file cannot be extended.                                     *
+ *                                                                            *
+ ******************************************************************************/
+static trx_uint64_t	col_writer_alloc(trx_col_segment_t *segment, size_t size)
+{
+	trx_col_header_t	*header = col_header(segment);
+	trx_uint64_t		offset = header->data_end;
+	int			ret;
+
+	size = TRX_COL_ALIGN(size);
+
+	if (offset + size > TRX_COL_SEGMENT_SIZE)
+		return 0;
+
+	if (offset + size > segment->file_size)
+	{
+		size_t	file_size = MIN(TRX_COL_SEGMENT_SIZE, TRX_COL_ALIGN(offset + size) + TRX_COL_ALLOC_STEP);
+
+		/* allocate disk space so running out of it fails here rather than with SIGBUS on mapped write */
+		if (0 != (ret = posix_fallocate(segment->fd, (off_t)segment->file_size,
+				(off_t)(file_size - segment->file_size))))
+		{
+			treegix_log(LOG_LEVEL_ERR, "cannot extend history segment \"%s\": %s", segment->path,
+					trx_strerror(ret));
+			return 0;
+		}
+
+		segment->file_size = file_size;
+	}
+
+	__atomic_store_n(&header->data_end, offset + size, __ATOMIC_RELEASE);
+
+	return offset;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: col_writer_new_block                                             *
+ *                                                                            *
+ * Purpose: starts a new value block of the item                              *
+ *                                                                            *
+ * Return value: SUCCEED - the block was allocated                            *
+ *               FAIL    - the segment is full                                *
+ *                                                                            *
+ ******************************************************************************/
+static int	col_writer_new_block(trx_col_segment_t *segment, trx_col_item_t *item, size_t size)
+{
+	trx_col_slot_t	*slots = col_slots(segment), *slot;
+	trx_col_block_t	*block;
+	trx_uint32_t	index, capacity;
+	trx_uint64_t	offset;
+
+	capacity = (trx_uint32_t)TRX_COL_ALIGN(MAX(TRX_COL_BLOCK_SIZE, size));
+
+	if (0 == (offset = col_writer_alloc(segment, sizeof(trx_col_block_t) + capacity)))
+		return FAIL;
+
+	block = (trx_col_block_t *)(segment->mem + offset);
+	block->itemid = item->itemid;
+	block->prev = item->block;
+	block->capacity = capacity;
+	block->count = 0;
+	block->min_sec = INT_MAX;
+	block->max_sec = INT_MIN;
+
+	for (index = col_slot_index(item->itemid, TRX_COL_SLOTS_NUM);; index = (index + 1) & (TRX_COL_SLOTS_NUM - 1))
+	{
+		slot = &slots[index];
+
+		if (item->itemid == slot->itemid)
+		{
+			__atomic_store_n(&slot->head, offset, __ATOMIC_RELEASE);
+			break;
+		}
+
+		if (0 == slot->itemid)
+		{
+			slot->head = offset;
+			__atomic_store_n(&slot->itemid, item->itemid, __ATOMIC_RELEASE);
+			break;
+		}
+	}
+
+	item->block = offset;
+	memset(&item->state, 0, sizeof(item->state));
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: col_writer_append                                                *
+ *                                                                            *
+ * Purpose: appends value to the item block                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the value was appended                             *
+ *               FAIL    - the segment is full                                *
+ *                                                                            *
+ ******************************************************************************/
+static int	col_writer_append(trx_col_segment_t *segment, trx_col_item_t *item, const TRX_DC_HISTORY *h)
+{
+	trx_col_block_t		*block;
+	trx_col_header_t	*header = col_header(segment);
+	unsigned char		*payload;
+	size_t			size;
+	int			count;
+
+	size = col_value_max_size(h);
+
+	if (0 == item->block || ((trx_col_block_t *)(segment->mem + item->block))->capacity <
+			(item->state.pos >> 3) + 1 + size)
+	{
+		if (SUCCEED != col_writer_new_block(segment, item, size))
+			return FAIL;
+	}
+
+	block = (trx_col_block_t *)(segment->mem + item->block);
+	payload = (unsigned char *)(block + 1);
+	count = (int)block->count;
+
+	col_write_timestamp(payload, &item->state, count, &h->ts);
+
+	switch (h->value_type)
+	{
+		case ITEM_VALUE_TYPE_FLOAT:
+			col_write_dbl(payload, &item->state, count, h->value.dbl);
+			break;
+		case ITEM_VALUE_TYPE_UINT64:
+			col_write_ui64(payload, &item->state, count, h->value.ui64);
+			break;
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			col_write_str(payload, &item->state.pos, h->value.str);
+			break;
+		case ITEM_VALUE_TYPE_LOG:
+			col_write_bits(payload, &item->state.pos, (trx_uint32_t)h->value.log->timestamp, 32);
+			col_write_bits(payload, &item->state.pos, (trx_uint32_t)h->value.log->logeventid, 32);
+			col_write_bits(payload, &item->state.pos, (trx_uint32_t)h->value.log->severity, 32);
+			col_write_str(payload, &item->state.pos, h->value.log->source);
+			col_write_str(payload, &item->state.pos, h->value.log->value);
+			break;
+	}
+
+	/* the timestamp ranges may be updated before the value is published, readers use them only for filtering */
+	if (h->ts.sec < block->min_sec)
+		__atomic_store_n(&block->min_sec, h->ts.sec, __ATOMIC_RELAXED);
+	if (h->ts.sec > block->max_sec)
+		__atomic_store_n(&block->max_sec, h->ts.sec, __ATOMIC_RELAXED);
+	if (h->ts.sec < header->min_sec)
+		__atomic_store_n(&header->min_sec, h->ts.sec, __ATOMIC_RELAXED);
+	if (h->ts.sec > header->max_sec)
+		__atomic_store_n(&header->max_sec, h->ts.sec, __ATOMIC_RELAXED);
+
+	__atomic_store_n(&block->count, count + 1, __ATOMIC_RELEASE);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: col_read_block                                                   *
+ *                                                                            *
+ * Purpose: decodes block values from the specified time period               *
+ *                                                                            *
+ * Parameters: block      - [IN] the value block                              *
+ *             count      - [IN] the number of published values in block      *
+ *             value_type - [IN] the value type                               *
+ *             start      - [IN] the period start timestamp (exclusive)       *
+ *             end        - [IN] the period end timestamp (inclusive)         *
+ *             values     - [OUT] the decoded values                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	col_read_block(const trx_col_block_t *block, int count, unsigned char value_type, int start, int end,
+		trx_vector_history_record_t *values)
+{
+	const unsigned char	*payload = (const unsigned char *)(block + 1);
+	trx_col_state_t		state;
+	trx_history_record_t	record;
+	int			i, skip;
+
+	memset(&state, 0, sizeof(state));
+
+	for (i = 0; i < count; i++)
+	{
+		col_read_timestamp(payload, &state, i, &record.timestamp);
+		skip = (record.timestamp.sec <= start || record.timestamp.sec > end);
+
+		switch (value_type)
+		{
+			case ITEM_VALUE_TYPE_FLOAT:
+				record.value.dbl = col_read_dbl(payload, &state, i);
+				break;
+			case ITEM_VALUE_TYPE_UINT64:
+				record.value.ui64 = col_read_ui64(payload, &state, i);
+				break;
+			case ITEM_VALUE_TYPE_STR:
+			case ITEM_VALUE_TYPE_TEXT:
+				record.value.str = col_read_str(payload, &state.pos, skip);
+				break;
+			case ITEM_VALUE_TYPE_LOG:
+				if (0 == skip)
+				{
+					record.value.log = (trx_log_value_t *)trx_malloc(NULL, sizeof(trx_log_value_t));
+					record.value.log->timestamp = (int)col_read_bits(payload, &state.pos, 32);
+					record.value.log->logeventid = (int)col_read_bits(payload, &state.pos, 32);
+					record.value.log->severity = (int)col_read_bits(payload, &state.pos, 32);
+					record.value.log->source = col_read_str(payload, &state.pos, 0);
+					record.value.log->value = col_read_str(payload, &state.pos, 0);
+
+					if ('\0' == *record.value.log->source)
+						trx_free(record.value.log->source);
+				}
+				else
+				{
+					state.pos += 96;
+					col_read_str(payload, &state.pos, 1);
+					col_read_str(payload, &state.pos, 1);
+				}
+				break;
+		}
+
+		if (0 == skip)
+			trx_vector_history_record_append_ptr(values, &record);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: col_block_mapped                                                 *
+ *                                                                            *
+ * Purpose: checks if the block at the specified offset is mapped             *
+ *                                                                            *
+ ******************************************************************************/
+static int	col_block_mapped(const trx_col_segment_t *segment, trx_uint64_t offset)
+{
+	if (offset + sizeof(trx_col_block_t) > segment->mem_size)
+		return FAIL;
+
+	if (offset + sizeof(trx_col_block_t) + ((const trx_col_block_t *)(segment->mem + offset))->capacity >
+			segment->mem_size)
+	{
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: col_read_segment                                                 *
+ *                                                                            *
+ * Purpose: reads item values from the specified time period of segment       *
+ *                                                                            *
+ * Parameters: segment    - [IN] the segment                                  *
+ *             itemid     - [IN] the itemid                                   *
+ *             value_type - [IN] the value type                               *
+ *             start      - [IN] the period start timestamp (exclusive)       *
+ *             end        - [IN] the period end timestamp (inclusive)         *
+ *             values     - [OUT] the values                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	col_read_segment(trx_col_segment_t *segment, trx_uint64_t itemid, unsigned char value_type, int start,
+		int end, trx_vector_history_record_t *values)
+{
+	const trx_col_header_t	*header = col_header(segment);
+	const trx_col_slot_t	*slots = col_slots(segment), *slot;
+	const trx_col_block_t	*block;
+	trx_uint64_t		offset = 0, slot_itemid;
+	trx_uint32_t		index;
+	int			count;
+
+	if (__atomic_load_n(&header->max_sec, __ATOMIC_RELAXED) <= start ||
+			__atomic_load_n(&header->min_sec, __ATOMIC_RELAXED) > end)
+	{
+		return;
+	}
+
+	for (index = col_slot_index(itemid, TRX_COL_SLOTS_NUM);; index = (index + 1) & (TRX_COL_SLOTS_NUM - 1))
+	{
+		slot = &slots[index];
+
+		if (0 == (slot_itemid = __atomic_load_n(&slot->itemid, __ATOMIC_ACQUIRE)))
+			return;
+
+		if (slot_itemid == itemid)
+		{
+			offset = __atomic_load_n(&slot->head, __ATOMIC_ACQUIRE);
+			break;
+		}
+	}
+
+	while (0 != offset)
+	{
+		/* the block might be written after the segment was mapped */
+		if (SUCCEED != col_block_mapped(segment, offset) &&
+				(SUCCEED != col_segment_map(segment) || SUCCEED != col_block_mapped(segment, offset)))
+		{
+			return;
+		}
+
+		block = (const trx_col_block_t *)(segment->mem + offset);
+		count = (int)__atomic_load_n(&block->count, __ATOMIC_ACQUIRE);
+
+		if (0 != count && block->max_sec > start && block->min_sec <= end)
+			col_read_block(block, count, value_type, start, end, values);
+
+		offset = block->prev;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: col_limit_values                                                 *
+ *                                                                            *
+ * Purpose: keeps the specified number of the newest values                   *
+ *                                                                            *
+ * Comments: Values from the same second as the oldest kept value are kept    *
+ *           as well, so the data is always cached by whole seconds.          *
+ *                                                                            *
+ ******************************************************************************/
+static void	col_limit_values(trx_vector_history_record_t *values, int count, unsigned char value_type)
+{
+	int	sec;
+
+	trx_vector_history_record_sort(values, (trx_compare_func_t)trx_history_record_compare_desc_func);
+
+	if (values->values_num <= count)
+		return;
+
+	sec = values->values[count - 1].timestamp.sec;
+
+	while (count < values->values_num && values->values[count].timestamp.sec == sec)
+		count++;
+
+	while (values->values_num > count)
+		trx_history_record_clear(&values->values[--values->values_num], value_type);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * history interface support                                                  *
+ *                                                                            *
+ ******************************************************************************/
+
+/******************************************************************************
+ *                                                                            *
+ * Function: columnar_destroy                                                 *
+ *                                                                            *
+ * Purpose: destroys history storage interface                                *
+ *                                                                            *
+ * Parameters:  hist - [IN] the history storage interface                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	columnar_destroy(trx_history_iface_t *hist)
+{
+	trx_col_data_t	*data = (trx_col_data_t *)hist->data;
+
+	col_writer_close(data);
+	trx_hashset_destroy(&data->items);
+
+	trx_vector_ptr_clear_ext(&data->segments, (trx_clean_func_t)col_segment_free);
+	trx_vector_ptr_destroy(&data->segments);
+
+	trx_free(data->dir);
+	trx_free(data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: columnar_get_values                                              *
+ *                                                                            *
+ * Purpose: gets item history data from history storage                       *
+ *                                                                            *
+ * Parameters:  hist    - [IN] the history storage interface                  *
+ *              itemid  - [IN] the itemid                                     *
+ *              start   - [IN] the period start timestamp                     *
+ *              count   - [IN] the number of values to read                   *
+ *              end     - [IN] the period end timestamp                       *
+ *              values  - [OUT] the item history data values                  *
+ *                                                                            *
+ * Return value: SUCCEED - the history data were read successfully            *
+ *               FAIL - otherwise                                             *
+ *                                                                            *
+ * Comments: This function reads <count> values from ]<start>,<end>] interval *
+ *           or all values from the specified interval if count is zero.      *
+ *           Segments are read from the newest to the oldest one and when     *
+ *           enough values are found the older segments are read only if they *
+ *           have values newer than the oldest found value.                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	columnar_get_values(trx_history_iface_t *hist, trx_uint64_t itemid, int start, int count, int end,
+		trx_vector_history_record_t *values)
+{
+	trx_col_data_t			*data = (trx_col_data_t *)hist->data;
+	trx_vector_history_record_t	found;
+	int				i;
+
+	treegix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	col_scan_segments(data, hist->value_type);
+
+	trx_history_record_vector_create(&found);
+
+	for (i = 0; i < data->segments.values_num; i++)
+	{
+		trx_col_segment_t	*segment = (trx_col_segment_t *)data->segments.values[i];
+
+		col_read_segment(segment, itemid, hist->value_type, start, end, &found);
+
+		if (0 < count && count <= found.values_num)
+		{
+			col_limit_values(&found, count, hist->value_type);
+
+			/* older values than the already found ones are not needed */
+			start = MAX(start, found.values[found.values_num - 1].timestamp.sec - 1);
+		}
+	}
+
+	if (0 < count)
+		col_limit_values(&found, count, hist->value_type);
+
+	trx_vector_history_record_append_array(values, found.values, found.values_num);
+	trx_vector_history_record_destroy(&found);
+
+	treegix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: columnar_add_values                                              *
+ *                                                                            *
+ * Purpose: writes history data to the storage                                *
+ *                                                                            *
+ * Parameters:  hist    - [IN] the history storage interface                  *
+ *              history - [IN] the history data vector (may have mixed value  *
+ *                             types)                                         *
+ *                                                                            *
+ * Return value: The number of values written.                                *
+ *                                                                            *
+ * Comments: The values are visible to readers as soon as they are written,   *
+ *           flushing writes them to disk.                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	columnar_add_values(trx_history_iface_t *hist, const trx_vector_ptr_t *history)
+{
+	trx_col_data_t	*data = (trx_col_data_t *)hist->data;
+	int		i, num = 0, now;
+	trx_col_item_t	*item, item_local;
+
+	treegix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	now = (int)time(NULL);
+
+	if (NULL != data->writer && data->writer->created + TRX_COL_SEGMENT_PERIOD <= now)
+		col_writer_close(data);
+
+	for (i = 0; i < history->values_num; i++)
+	{
+		const TRX_DC_HISTORY	*h = (const TRX_DC_HISTORY *)history->values[i];
+
+		if (hist->value_type != h->value_type)
+			continue;
+
+		if (NULL == data->writer && SUCCEED != col_writer_open(data, hist->value_type, now))
+			break;
+
+		if (NULL == (item = (trx_col_item_t *)trx_hashset_search(&data->items, &h->itemid)))
+		{
+			if (TRX_COL_ITEMS_MAX <= data->items.num_data)
+			{
+				col_writer_close(data);
+				i--;
+				continue;
+			}
+
+			memset(&item_local, 0, sizeof(item_local));
+			item_local.itemid = h->itemid;
+			item = (trx_col_item_t *)trx_hashset_insert(&data->items, &item_local, sizeof(item_local));
+		}
+
+		if (SUCCEED != col_writer_append(data->writer, item, h))
+		{
+			/* the segment is full, continue with a new one */
+			if (0 == item->block || 0 == ((trx_col_block_t *)(data->writer->mem + item->block))->count)
+			{
+				treegix_log(LOG_LEVEL_ERR, "cannot write history value of item " TRX_FS_UI64
+						" to history storage", h->itemid);
+				col_writer_close(data);
+				break;
+			}
+
+			col_writer_close(data);
+			i--;
+			continue;
+		}
+
+		num++;
+	}
+
+	treegix_log(LOG_LEVEL_DEBUG, "End of %s() values:%d", __func__, num);
+
+	return num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: columnar_flush                                                   *
+ *                                                                            *
+ * Purpose: flushes the history data to storage                               *
+ *                                                                            *
+ * Parameters:  hist    - [IN] the history storage interface                  *
+ *                                                                            *
+ * Comments: The values are written directly to the memory mapped segment,    *
+ *           the modified pages are written to disk after each batch so the   *
+ *           values published to readers survive operating system crash.      *
+ *                                                                            *
+ ******************************************************************************/
+static int	columnar_flush(trx_history_iface_t *hist)
+{
+	trx_col_data_t	*data = (trx_col_data_t *)hist->data;
+
+	if (NULL == data->writer)
+		return SUCCEED;
+
+	return col_writer_sync(data->writer);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_history_columnar_init                                        *
+ *                                                                            *
+ * Purpose: initializes history storage interface                             *
+ *                                                                            *
+ * Parameters:  hist       - [IN] the history storage interface               *
+ *              value_type - [IN] the target value type                       *
+ *              error      - [OUT] the error message                          *
+ *                                                                            *
+ * Return value: SUCCEED - the history storage interface was initialized      *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_history_columnar_init(trx_history_iface_t *hist, unsigned char value_type, char **error)
+{
+	trx_col_data_t	*data;
+	char		*dir;
+
+	dir = trx_dsprintf(NULL, "%s/%s", CONFIG_HISTORY_STORAGE_PATH, value_type_dir[value_type]);
+
+	if (0 != mkdir(dir, 0750) && EEXIST != errno)
+	{
+		*error = trx_dsprintf(*error, "cannot create history storage directory \"%s\": %s", dir,
+				trx_strerror(errno));
+		trx_free(dir);
+		return FAIL;
+	}
+
+	data = (trx_col_data_t *)trx_malloc(NULL, sizeof(trx_col_data_t));
+	memset(data, 0, sizeof(trx_col_data_t));
+	data->dir = dir;
+	trx_hashset_create(&data->items, 1000, TRX_DEFAULT_UINT64_HASH_FUNC, TRX_DEFAULT_UINT64_COMPARE_FUNC);
+	trx_vector_ptr_create(&data->segments);
+
+	hist->value_type = value_type;
+	hist->data = data;
+	hist->destroy = columnar_destroy;
+	hist->add_values = columnar_add_values;
+	hist->flush = columnar_flush;
+	hist->get_values = columnar_get_values;
+	hist->get_values_multi = NULL;
+	hist->requires_trends = 1;
+
+	return SUCCEED;
+}
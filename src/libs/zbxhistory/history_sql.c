@@ -4,14 +4,47 @@
 #include "log.h"
 #include "trxalgo.h"
 #include "db.h"
+#include "threads.h"
 #include "dbcache.h"
 #include "trxhistory.h"
 #include "history.h"
 
+extern int	CONFIG_HISTORY_PIPELINING;
+
+#ifdef HAVE_POSTGRESQL
+/* the time limits to wait before writing failed history batch again, in seconds */
+#define TRX_SQL_RETRY_DELAY_MIN	1
+#define TRX_SQL_RETRY_DELAY_MAX	60
+
+/* the maximum number of attempts to write history batch */
+#define TRX_SQL_RETRY_MAX	10
+
+/* history batch written asynchronously, see HistoryPipelining parameter */
+typedef struct
+{
+	char			*sql;
+
+	/* the bulk inserts of the batch, kept to read its values until the batch is written */
+	trx_vector_ptr_t	dbinserts;
+
+	int			attempts;
+	int			delay;
+	time_t			retry_time;
+}
+trx_sql_batch_t;
+#endif
+
 typedef struct
 {
 	unsigned char		initialized;
 	trx_vector_ptr_t	dbinserts;
+#ifdef HAVE_POSTGRESQL
+	/* the history batch being written asynchronously */
+	trx_sql_batch_t		*pending;
+	/* the history batches that failed to be written and are written again later */
+	trx_vector_ptr_t	failed;
+	unsigned char		async_connected;
+#endif
 }
 trx_sql_writer_t;
 
@@ -96,24 +129,38 @@ static void	sql_writer_init(void)
 
 /************************************************************************************
  *                                                                                  *
- * Function: sql_writer_release                                                     *
+ * Function: sql_dbinserts_clear                                                    *
  *                                                                                  *
- * Purpose: releases initialized sql writer by freeing allocated resources and      *
- *          setting its state to uninitialized.                                     *
+ * Purpose: frees bulk insert data                                                  *
+ *                                                                                  *
+ * Parameters: dbinserts - [IN/OUT] the bulk insert data vector                     *
  *                                                                                  *
  ************************************************************************************/
-static void	sql_writer_release(void)
+static void	sql_dbinserts_clear(trx_vector_ptr_t *dbinserts)
 {
 	int	i;
 
-	for (i = 0; i < writer.dbinserts.values_num; i++)
+	for (i = 0; i < dbinserts->values_num; i++)
 	{
-		trx_db_insert_t	*db_insert = (trx_db_insert_t *)writer.dbinserts.values[i];
+		trx_db_insert_t	*db_insert = (trx_db_insert_t *)dbinserts->values[i];
 
 		trx_db_insert_clean(db_insert);
 		trx_free(db_insert);
 	}
-	trx_vector_ptr_clear(&writer.dbinserts);
+	trx_vector_ptr_clear(dbinserts);
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: sql_writer_release                                                     *
+ *                                                                                  *
+ * Purpose: releases initialized sql writer by freeing allocated resources and      *
+ *          setting its state to uninitialized.                                     *
+ *                                                                                  *
+ ************************************************************************************/
+static void	sql_writer_release(void)
+{
+	sql_dbinserts_clear(&writer.dbinserts);
 	trx_vector_ptr_destroy(&writer.dbinserts);
 
 	writer.initialized = 0;
@@ -134,6 +181,370 @@ static void	sql_writer_add_dbinsert(trx_db_insert_t *db_insert)
 	trx_vector_ptr_append(&writer.dbinserts, db_insert);
 }
 
+#ifdef HAVE_POSTGRESQL
+/************************************************************************************
+ *                                                                                  *
+ * Function: sql_batch_free                                                         *
+ *                                                                                  *
+ * Purpose: frees history batch                                                     *
+ *                                                                                  *
+ ************************************************************************************/
+static void	sql_batch_free(trx_sql_batch_t *batch)
+{
+	sql_dbinserts_clear(&batch->dbinserts);
+	trx_vector_ptr_destroy(&batch->dbinserts);
+	trx_free(batch->sql);
+	trx_free(batch);
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: sql_writer_fail                                                        *
+ *                                                                                  *
+ * Purpose: schedules failed history batch to be written again                      *
+ *                                                                                  *
+ * Parameters: batch - [IN] the history batch                                       *
+ *                                                                                  *
+ * Comments: The delay before the next attempt is doubled after each failure. The   *
+ *           batch is discarded after TRX_SQL_RETRY_MAX failed attempts, so batches *
+ *           rejected by database do not accumulate.                                *
+ *                                                                                  *
+ ************************************************************************************/
+static void	sql_writer_fail(trx_sql_batch_t *batch)
+{
+	if (TRX_SQL_RETRY_MAX <= ++batch->attempts)
+	{
+		treegix_log(LOG_LEVEL_ERR, "cannot write history batch to database after %d attempts, discarding it",
+				batch->attempts);
+		sql_batch_free(batch);
+		return;
+	}
+
+	treegix_log(LOG_LEVEL_WARNING, "cannot write history batch to database, retrying in %d seconds",
+			batch->delay);
+
+	batch->retry_time = time(NULL) + batch->delay;
+	batch->delay = MIN(batch->delay * 2, TRX_SQL_RETRY_DELAY_MAX);
+
+	trx_vector_ptr_append(&writer.failed, batch);
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: sql_writer_wait                                                        *
+ *                                                                                  *
+ * Purpose: waits for the asynchronous history batch write to finish                *
+ *                                                                                  *
+ * Return value: SUCCEED - the batch was written or there was no batch pending      *
+ *               FAIL    - the batch write failed                                   *
+ *                                                                                  *
+ * Comments: If the database connection was lost the batch is written again after   *
+ *           reconnecting, with the delay between attempts doubled up to            *
+ *           TRX_DB_WAIT_DOWN seconds. Batches failed for other reasons are kept    *
+ *           and written again later, see sql_writer_fail().                        *
+ *                                                                                  *
+ ************************************************************************************/
+static int	sql_writer_wait(void)
+{
+	trx_sql_batch_t	*batch;
+	int		rc, delay = TRX_SQL_RETRY_DELAY_MIN;
+
+	if (NULL == (batch = writer.pending))
+		return SUCCEED;
+
+	while (TRX_DB_DOWN == (rc = DBasync_wait()))
+	{
+		treegix_log(LOG_LEVEL_WARNING, "history batch was not written to database, retrying in %d seconds",
+				delay);
+		trx_sleep(delay);
+		delay = MIN(delay * 2, TRX_DB_WAIT_DOWN);
+
+		DBasync_connect(TRX_DB_CONNECT_NORMAL);
+		DBasync_execute(batch->sql);
+	}
+
+	writer.pending = NULL;
+
+	if (TRX_DB_OK != rc)
+	{
+		sql_writer_fail(batch);
+		return FAIL;
+	}
+
+	sql_batch_free(batch);
+
+	return SUCCEED;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: sql_writer_send                                                        *
+ *                                                                                  *
+ * Purpose: sends history batch to database without waiting for it to be written    *
+ *                                                                                  *
+ * Parameters: batch - [IN] the history batch                                       *
+ *                                                                                  *
+ * Return value: SUCCEED - the batch was sent                                       *
+ *               FAIL    - the batch was not sent and is scheduled to be written    *
+ *                         again                                                    *
+ *                                                                                  *
+ ************************************************************************************/
+static int	sql_writer_send(trx_sql_batch_t *batch)
+{
+	/* connection errors are handled when waiting for the batch */
+	if (TRX_DB_FAIL == DBasync_execute(batch->sql))
+	{
+		sql_writer_fail(batch);
+		return FAIL;
+	}
+
+	writer.pending = batch;
+
+	return SUCCEED;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: sql_writer_retry                                                       *
+ *                                                                                  *
+ * Purpose: writes again the history batches that failed to be written              *
+ *                                                                                  *
+ * Parameters: now - [IN] the current time, batches with later retry time are       *
+ *                        skipped                                                   *
+ *                                                                                  *
+ * Comments: The batches are written synchronously, as retrying is expected only    *
+ *           after database errors.                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+static void	sql_writer_retry(time_t now)
+{
+	int	i, failed_num = writer.failed.values_num;
+
+	/* the batches failing again are appended to the vector, skip them */
+	for (i = 0; i < failed_num;)
+	{
+		trx_sql_batch_t	*batch = (trx_sql_batch_t *)writer.failed.values[i];
+
+		if (now < batch->retry_time)
+		{
+			i++;
+			continue;
+		}
+
+		trx_vector_ptr_remove(&writer.failed, i);
+		failed_num--;
+
+		if (SUCCEED == sql_writer_send(batch))
+			sql_writer_wait();
+	}
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: sql_writer_flush_async                                                 *
+ *                                                                                  *
+ * Purpose: sends bulk insert data to database without waiting for it to be         *
+ *          written                                                                 *
+ *                                                                                  *
+ * Comments: The data is written by a separate database connection in its own       *
+ *           transaction. Only one batch can be pending - the previous batch is     *
+ *           waited for before sending the next one.                                *
+ *                                                                                  *
+ ************************************************************************************/
+static int	sql_writer_flush_async(void)
+{
+	int		i;
+	size_t		sql_alloc = 0, sql_offset = 0;
+	trx_sql_batch_t	*batch;
+
+	sql_writer_wait();
+
+	if (0 == writer.async_connected)
+	{
+		DBasync_connect(TRX_DB_CONNECT_NORMAL);
+		trx_vector_ptr_create(&writer.failed);
+		writer.async_connected = 1;
+	}
+
+	sql_writer_retry(time(NULL));
+
+	batch = (trx_sql_batch_t *)trx_malloc(NULL, sizeof(trx_sql_batch_t));
+	memset(batch, 0, sizeof(trx_sql_batch_t));
+	batch->delay = TRX_SQL_RETRY_DELAY_MIN;
+
+	trx_strcpy_alloc(&batch->sql, &sql_alloc, &sql_offset, "begin;\n");
+
+	for (i = 0; i < writer.dbinserts.values_num; i++)
+	{
+		trx_db_insert_format((trx_db_insert_t *)writer.dbinserts.values[i], &batch->sql, &sql_alloc,
+				&sql_offset);
+	}
+
+	trx_strcpy_alloc(&batch->sql, &sql_alloc, &sql_offset, "commit;\n");
+
+	/* the bulk inserts are moved to the batch, leaving the writer uninitialized */
+	batch->dbinserts = writer.dbinserts;
+	writer.initialized = 0;
+
+	return sql_writer_send(batch);
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: sql_batch_get_values                                                   *
+ *                                                                                  *
+ * Purpose: gets item values from history batch not yet written to database         *
+ *                                                                                  *
+ * Parameters: batch        - [IN] the history batch                                *
+ *             itemids      - [IN] the item identifiers, sorted in ascending order  *
+ *             itemids_num  - [IN] the number of items                              *
+ *             value_type   - [IN] the value type (see ITEM_VALUE_TYPE_* defs)      *
+ *             start        - [IN] the period start timestamp                       *
+ *             end          - [IN] the period end timestamp                         *
+ *             values       - [OUT] the item history data values, an array of       *
+ *                                  itemids_num vectors matching itemids            *
+ *             values_start - [IN] the number of values in vectors before reading   *
+ *                                 from database                                    *
+ *                                                                                  *
+ * Return value: The number of values added.                                        *
+ *                                                                                  *
+ * Comments: The batch might be already committed while its result is not yet       *
+ *           received, so values already read from database are skipped.            *
+ *                                                                                  *
+ ************************************************************************************/
+static int	sql_batch_get_values(const trx_sql_batch_t *batch, const trx_uint64_t *itemids, int itemids_num,
+		int value_type, int start, int end, trx_vector_history_record_t *values, int values_start)
+{
+	int	i, j, k, index, added = 0;
+
+	for (i = 0; i < batch->dbinserts.values_num; i++)
+	{
+		const trx_db_insert_t	*db_insert = (const trx_db_insert_t *)batch->dbinserts.values[i];
+
+		if (0 != strcmp(db_insert->table->table, vc_history_tables[value_type].name))
+			continue;
+
+		for (j = 0; j < db_insert->rows.values_num; j++)
+		{
+			const trx_db_value_t		*row = (const trx_db_value_t *)db_insert->rows.values[j];
+			const trx_uint64_t		*ptr;
+			trx_vector_history_record_t	*item_values;
+			trx_history_record_t		value;
+
+			if (start >= row[1].i32 || end < row[1].i32)
+				continue;
+
+			if (NULL == (ptr = (const trx_uint64_t *)trx_bsearch(&row[0].ui64, itemids, (size_t)itemids_num,
+					sizeof(trx_uint64_t), TRX_DEFAULT_UINT64_COMPARE_FUNC)))
+			{
+				continue;
+			}
+
+			index = (int)(ptr - itemids);
+			item_values = &values[index];
+
+			value.timestamp.sec = row[1].i32;
+			value.timestamp.ns = row[2].i32;
+
+			for (k = values_start; k < item_values->values_num; k++)
+			{
+				if (0 == trx_timespec_compare(&value.timestamp, &item_values->values[k].timestamp))
+					break;
+			}
+
+			if (k != item_values->values_num)
+				continue;
+
+			switch (value_type)
+			{
+				case ITEM_VALUE_TYPE_FLOAT:
+					value.value.dbl = row[3].dbl;
+					break;
+				case ITEM_VALUE_TYPE_UINT64:
+					value.value.ui64 = row[3].ui64;
+					break;
+				case ITEM_VALUE_TYPE_STR:
+				case ITEM_VALUE_TYPE_TEXT:
+					value.value.str = trx_strdup(NULL, row[3].str);
+					break;
+				case ITEM_VALUE_TYPE_LOG:
+					/* itemid, clock, ns, timestamp, source, severity, value, logeventid */
+					value.value.log = (trx_log_value_t *)trx_malloc(NULL, sizeof(trx_log_value_t));
+					value.value.log->timestamp = row[3].i32;
+					value.value.log->source = '\0' == *row[4].str ? NULL :
+							trx_strdup(NULL, row[4].str);
+					value.value.log->severity = row[5].i32;
+					value.value.log->value = trx_strdup(NULL, row[6].str);
+					value.value.log->logeventid = row[7].i32;
+					break;
+			}
+
+			trx_vector_history_record_append_ptr(item_values, &value);
+			added++;
+		}
+	}
+
+	return added;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: sql_writer_get_values                                                  *
+ *                                                                                  *
+ * Purpose: gets item values from history batches not yet written to database       *
+ *                                                                                  *
+ * Parameters: see sql_batch_get_values()                                           *
+ *                                                                                  *
+ * Return value: The number of values added.                                        *
+ *                                                                                  *
+ * Comments: History reads do not wait for the pending batch to be written, instead *
+ *           the values of pending and failed batches are read from memory.         *
+ *                                                                                  *
+ ************************************************************************************/
+static int	sql_writer_get_values(const trx_uint64_t *itemids, int itemids_num, int value_type, int start,
+		int end, trx_vector_history_record_t *values, int values_start)
+{
+	int	i, added = 0;
+
+	if (0 == writer.async_connected)
+		return 0;
+
+	if (NULL != writer.pending)
+	{
+		added += sql_batch_get_values(writer.pending, itemids, itemids_num, value_type, start, end, values,
+				values_start);
+	}
+
+	for (i = 0; i < writer.failed.values_num; i++)
+	{
+		added += sql_batch_get_values((const trx_sql_batch_t *)writer.failed.values[i], itemids, itemids_num,
+				value_type, start, end, values, values_start);
+	}
+
+	return added;
+}
+#endif
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: trx_history_sql_sync                                                   *
+ *                                                                                  *
+ * Purpose: waits until the history data sent to database asynchronously is         *
+ *          written                                                                 *
+ *                                                                                  *
+ * Return value: SUCCEED - the data was written or there was no data pending        *
+ *               FAIL    - failed to write the data                                 *
+ *                                                                                  *
+ ************************************************************************************/
+int	trx_history_sql_sync(void)
+{
+#ifdef HAVE_POSTGRESQL
+	return sql_writer_wait();
+#else
+	return SUCCEED;
+#endif
+}
+
 /************************************************************************************
  *                                                                                  *
  * Function: sql_writer_flush                                                       *
@@ -150,6 +561,10 @@ static int	sql_writer_flush(void)
 	if (0 == writer.initialized)
 		return SUCCEED;
 
+#ifdef HAVE_POSTGRESQL
+	if (0 != CONFIG_HISTORY_PIPELINING)
+		return sql_writer_flush_async();
+#endif
 	do
 	{
 		DBbegin();
@@ -187,6 +602,7 @@ static void	add_history_dbl(const trx_vector_ptr_t *history)
 
 	db_insert = (trx_db_insert_t *)trx_malloc(NULL, sizeof(trx_db_insert_t));
 	trx_db_insert_prepare(db_insert, "history", "itemid", "clock", "ns", "value", NULL);
+	trx_db_insert_use_copy(db_insert);
 
 	for (i = 0; i < history->values_num; i++)
 	{
@@ -213,6 +629,7 @@ static void	add_history_uint(trx_vector_ptr_t *history)
 
 	db_insert = (trx_db_insert_t *)trx_malloc(NULL, sizeof(trx_db_insert_t));
 	trx_db_insert_prepare(db_insert, "history_uint", "itemid", "clock", "ns", "value", NULL);
+	trx_db_insert_use_copy(db_insert);
 
 	for (i = 0; i < history->values_num; i++)
 	{
@@ -239,6 +656,7 @@ static void	add_history_str(trx_vector_ptr_t *history)
 
 	db_insert = (trx_db_insert_t *)trx_malloc(NULL, sizeof(trx_db_insert_t));
 	trx_db_insert_prepare(db_insert, "history_str", "itemid", "clock", "ns", "value", NULL);
+	trx_db_insert_use_copy(db_insert);
 
 	for (i = 0; i < history->values_num; i++)
 	{
@@ -265,6 +683,7 @@ static void	add_history_text(trx_vector_ptr_t *history)
 
 	db_insert = (trx_db_insert_t *)trx_malloc(NULL, sizeof(trx_db_insert_t));
 	trx_db_insert_prepare(db_insert, "history_text", "itemid", "clock", "ns", "value", NULL);
+	trx_db_insert_use_copy(db_insert);
 
 	for (i = 0; i < history->values_num; i++)
 	{
@@ -292,6 +711,7 @@ static void	add_history_log(trx_vector_ptr_t *history)
 	db_insert = (trx_db_insert_t *)trx_malloc(NULL, sizeof(trx_db_insert_t));
 	trx_db_insert_prepare(db_insert, "history_log", "itemid", "clock", "ns", "timestamp", "source", "severity",
 			"value", "logeventid", NULL);
+	trx_db_insert_use_copy(db_insert);
 
 	for (i = 0; i < history->values_num; i++)
 	{
@@ -585,6 +1005,89 @@ out:
 	return ret;
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Function: db_read_values_multi                                                   *
+ *                                                                                  *
+ * Purpose: reads history data of multiple items from database with single query    *
+ *                                                                                  *
+ * Parameters:  itemids     - [IN] the item identifiers, sorted in ascending order  *
+ *              itemids_num - [IN] the number of items                              *
+ *              value_type  - [IN] the value type (see ITEM_VALUE_TYPE_* defs)      *
+ *              start       - [IN] the period start timestamp                       *
+ *              end         - [IN] the period end timestamp                         *
+ *              values      - [OUT] the item history data values, an array of       *
+ *                                  itemids_num vectors matching itemids            *
+ *                                                                                  *
+ * Return value: SUCCEED - the history data were read successfully                  *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ * Comments: This function reads all values with timestamps in range:               *
+ *             start < <value timestamp> <= end                                     *
+ *                                                                                  *
+ ************************************************************************************/
+static int	db_read_values_multi(const trx_uint64_t *itemids, int itemids_num, int value_type, int start,
+		int end, trx_vector_history_record_t *values)
+{
+	char			*sql = NULL;
+	size_t	 		sql_alloc = 0, sql_offset = 0;
+	DB_RESULT		result;
+	DB_ROW			row;
+	trx_vc_history_table_t	*table = &vc_history_tables[value_type];
+	trx_uint64_t		itemid;
+	int			index = 0;
+
+	trx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+			"select itemid,clock,ns,%s"
+			" from %s"
+			" where",
+			table->fields, table->name);
+
+	DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", itemids, itemids_num);
+
+	if (TRX_JAN_2038 == end)
+		trx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " and clock>%d", start);
+	else
+		trx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " and clock>%d and clock<=%d", start, end);
+
+	result = DBselect("%s", sql);
+
+	trx_free(sql);
+
+	if (NULL == result)
+		return FAIL;
+
+	while (NULL != (row = DBfetch(result)))
+	{
+		trx_history_record_t	value;
+
+		TRX_STR2UINT64(itemid, row[0]);
+
+		/* rows are not ordered, but usually come grouped by item */
+		if (itemids[index] != itemid)
+		{
+			const trx_uint64_t	*ptr;
+
+			if (NULL == (ptr = (const trx_uint64_t *)trx_bsearch(&itemid, itemids, (size_t)itemids_num,
+					sizeof(trx_uint64_t), TRX_DEFAULT_UINT64_COMPARE_FUNC)))
+			{
+				continue;
+			}
+
+			index = (int)(ptr - itemids);
+		}
+
+		value.timestamp.sec = atoi(row[1]);
+		value.timestamp.ns = atoi(row[2]);
+		table->rtov(&value.value, row + 3);
+
+		trx_vector_history_record_append_ptr(&values[index], &value);
+	}
+	DBfree_result(result);
+
+	return SUCCEED;
+}
+
 /******************************************************************************************************************
  *                                                                                                                *
  * history interface support                                                                                      *
@@ -603,6 +1106,22 @@ out:
 static void	sql_destroy(trx_history_iface_t *hist)
 {
 	TRX_UNUSED(hist);
+
+#ifdef HAVE_POSTGRESQL
+	if (0 != writer.async_connected)
+	{
+		sql_writer_wait();
+
+		/* make the last attempt to write the failed batches */
+		sql_writer_retry(TRX_JAN_2038);
+
+		trx_vector_ptr_clear_ext(&writer.failed, (trx_clean_func_t)sql_batch_free);
+		trx_vector_ptr_destroy(&writer.failed);
+
+		DBasync_close();
+		writer.async_connected = 0;
+	}
+#endif
 }
 
 /************************************************************************************
@@ -628,13 +1147,63 @@ static void	sql_destroy(trx_history_iface_t *hist)
 static int	sql_get_values(trx_history_iface_t *hist, trx_uint64_t itemid, int start, int count, int end,
 		trx_vector_history_record_t *values)
 {
+	int	ret;
+#ifdef HAVE_POSTGRESQL
+	int	values_start = values->values_num;
+#endif
 	if (0 == count)
-		return db_read_values_by_time(itemid, hist->value_type, values, end - start, end);
+		ret = db_read_values_by_time(itemid, hist->value_type, values, end - start, end);
+	else if (0 == start)
+		ret = db_read_values_by_count(itemid, hist->value_type, values, count, end);
+	else
+		ret = db_read_values_by_time_and_count(itemid, hist->value_type, values, end - start, count, end);
+
+#ifdef HAVE_POSTGRESQL
+	if (SUCCEED != ret)
+		return ret;
 
-	if (0 == start)
-		return db_read_values_by_count(itemid, hist->value_type, values, count, end);
+	/* all values older than the oldest second read are not needed when the requested count was read */
+	if (0 != count && count <= values->values_num - values_start)
+		start = MAX(start, values->values[values->values_num - 1].timestamp.sec - 1);
 
-	return db_read_values_by_time_and_count(itemid, hist->value_type, values, end - start, count, end);
+	if (0 != sql_writer_get_values(&itemid, 1, hist->value_type, start, end, values, values_start))
+	{
+		/* keep values sorted in descending order by timestamp as read from database */
+		qsort(values->values + values_start, (size_t)(values->values_num - values_start),
+				sizeof(trx_history_record_t), (trx_compare_func_t)trx_history_record_compare_desc_func);
+	}
+#endif
+	return ret;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: sql_get_values_multi                                                   *
+ *                                                                                  *
+ * Purpose: gets history data of multiple items from history storage                *
+ *                                                                                  *
+ * Parameters:  hist        - [IN] the history storage interface                    *
+ *              itemids     - [IN] the item identifiers, sorted in ascending order  *
+ *              itemids_num - [IN] the number of items                              *
+ *              start       - [IN] the period start timestamp                       *
+ *              end         - [IN] the period end timestamp                         *
+ *              values      - [OUT] the item history data values                    *
+ *                                                                                  *
+ * Return value: SUCCEED - the history data were read successfully                  *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ ************************************************************************************/
+static int	sql_get_values_multi(trx_history_iface_t *hist, const trx_uint64_t *itemids, int itemids_num,
+		int start, int end, trx_vector_history_record_t *values)
+{
+	int	ret;
+
+	ret = db_read_values_multi(itemids, itemids_num, hist->value_type, start, end, values);
+#ifdef HAVE_POSTGRESQL
+	if (SUCCEED == ret)
+		sql_writer_get_values(itemids, itemids_num, hist->value_type, start, end, values, 0);
+#endif
+	return ret;
 }
 
 /************************************************************************************
@@ -711,6 +1280,7 @@ int	trx_history_sql_init(trx_history_iface_t *hist, unsigned char value_type, ch
 	hist->add_values = sql_add_values;
 	hist->flush = sql_flush;
 	hist->get_values = sql_get_values;
+	hist->get_values_multi = sql_get_values_multi;
 
 	switch (value_type)
 	{
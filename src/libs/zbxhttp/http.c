@@ -12,6 +12,9 @@ extern char	*CONFIG_SSL_CA_LOCATION;
 extern char	*CONFIG_SSL_CERT_LOCATION;
 extern char	*CONFIG_SSL_KEY_LOCATION;
 
+/* the cURL data shared by easy handles of the process, see trx_http_prepare_share() */
+static CURLSH	*http_share = NULL;
+
 int	trx_http_prepare_ssl(CURL *easyhandle, const char *ssl_cert_file, const char *ssl_key_file,
 		const char *ssl_key_password, unsigned char verify_peer, unsigned char verify_host,
 		char **error)
@@ -164,6 +167,39 @@ int	trx_http_prepare_auth(CURL *easyhandle, unsigned char authtype, const char *
 	return SUCCEED;
 }
 
+int	trx_http_prepare_share(CURL *easyhandle, char **error)
+{
+	CURLcode	err;
+
+	/* the share is used only by the easy handles of the same process, so locking callbacks are not needed */
+	if (NULL == http_share)
+	{
+		if (NULL == (http_share = curl_share_init()))
+		{
+			*error = trx_strdup(*error, "Cannot initialize cURL share");
+			return FAIL;
+		}
+
+		curl_share_setopt(http_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+#if LIBCURL_VERSION_NUM >= 0x071700
+		/* SSL session sharing is supported starting with version 7.23.0 (0x071700) */
+		curl_share_setopt(http_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x073900
+		/* connection cache sharing is supported starting with version 7.57.0 (0x073900) */
+		curl_share_setopt(http_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+	}
+
+	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_SHARE, http_share)))
+	{
+		*error = trx_dsprintf(*error, "Cannot set shared connection data: %s", curl_easy_strerror(err));
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
 char	*trx_http_get_header(char **headers)
 {
 	while ('\0' != **headers)
@@ -512,6 +512,740 @@ static int	process_ping(TRX_FPING_HOST *hosts, int hosts_count, int count, int i
 	return ret;
 }
 
+/* native ICMP pinger, fping is executed only when ICMP sockets cannot be opened */
+
+#define TRX_ICMP_ECHOREPLY		0
+#define TRX_ICMP_ECHO			8
+#define TRX_ICMP6_ECHO			128
+#define TRX_ICMP6_ECHOREPLY		129
+
+#define TRX_ICMP_HEADER_LEN		8
+#define TRX_ICMP_IP_HEADER_MAX		60
+
+/* the fping defaults used when the item key does not specify the parameter */
+#define TRX_ICMP_DEFAULT_SIZE		56
+#define TRX_ICMP_DEFAULT_INTERVAL	1000
+#define TRX_ICMP_DEFAULT_TIMEOUT	500
+
+#define TRX_ICMP_BATCH_SIZE		64	/* packets sent before checking for replies */
+#define TRX_ICMP_WHEEL_SLOTS		1024	/* timer wheel slots, one millisecond each */
+#define TRX_ICMP_SOCKET_BUFFER		(1024 * 1024)
+
+#define TRX_ICMP_PACKET_PENDING		0
+#define TRX_ICMP_PACKET_SENT		1
+#define TRX_ICMP_PACKET_DONE		2	/* replied, timed out or could not be sent */
+
+typedef struct
+{
+	int		family;
+	int		fd;
+	unsigned char	raw;		/* 1 - raw socket, 0 - ICMP datagram socket */
+	unsigned char	checked;	/* 1 - the socket open was attempted */
+}
+trx_icmp_socket_t;
+
+static trx_icmp_socket_t	icmp_socket = {AF_INET, -1, 0, 0};
+#ifdef HAVE_IPV6
+static trx_icmp_socket_t	icmp6_socket = {AF_INET6, -1, 0, 0};
+#endif
+
+/* the data echoed back by hosts to match replies with requests */
+typedef struct
+{
+	trx_uint32_t	cookie;
+	trx_uint32_t	host;
+	trx_uint32_t	index;
+}
+trx_icmp_stamp_t;
+
+typedef struct
+{
+	double		sent;
+	int		next;	/* the next packet in the same timer wheel slot, -1 for the last one */
+	unsigned char	state;
+}
+trx_icmp_packet_t;
+
+typedef struct
+{
+	TRX_SOCKADDR		addr;
+	socklen_t		addr_len;
+	trx_icmp_socket_t	*sock;	/* NULL if the address could not be resolved */
+}
+trx_icmp_target_t;
+
+typedef struct
+{
+	TRX_FPING_HOST		*hosts;
+	trx_icmp_target_t	*targets;
+	int			hosts_count;
+	int			count;
+	double			timeout;
+
+	/* hosts_count * count packets, the packet of host h and ping i has index h * count + i */
+	trx_icmp_packet_t	*packets;
+
+	/* the number of sent packets waiting for reply */
+	int			outstanding;
+
+	/* the packets are linked to the slot of their timeout millisecond */
+	int			wheel[TRX_ICMP_WHEEL_SLOTS];
+	trx_uint64_t		wheel_tick;
+
+	trx_uint32_t		cookie;
+	unsigned short		id;
+}
+trx_icmp_pinger_t;
+
+static int	icmp_resolve(const char *addr, int family, int flags, TRX_SOCKADDR *sa, socklen_t *sa_len)
+{
+#ifdef HAVE_IPV6
+	struct addrinfo	hints, *ai = NULL;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = family;
+	hints.ai_socktype = SOCK_DGRAM;
+	hints.ai_flags = flags;
+
+	if (0 != getaddrinfo(addr, NULL, &hints, &ai))
+		return FAIL;
+
+	if (sizeof(TRX_SOCKADDR) < ai->ai_addrlen || (AF_INET != ai->ai_family && AF_INET6 != ai->ai_family))
+	{
+		freeaddrinfo(ai);
+		return FAIL;
+	}
+
+	memcpy(sa, ai->ai_addr, ai->ai_addrlen);
+	*sa_len = ai->ai_addrlen;
+
+	freeaddrinfo(ai);
+#else
+	struct hostent	*hp;
+
+	TRX_UNUSED(family);
+	TRX_UNUSED(flags);
+
+	if (NULL == (hp = gethostbyname(addr)) || AF_INET != hp->h_addrtype)
+		return FAIL;
+
+	memset(sa, 0, sizeof(TRX_SOCKADDR));
+	sa->sin_family = AF_INET;
+	sa->sin_addr = *((struct in_addr *)hp->h_addr);
+	*sa_len = sizeof(struct sockaddr_in);
+#endif
+	return SUCCEED;
+}
+
+static int	icmp_addr_compare(const TRX_SOCKADDR *sa1, const TRX_SOCKADDR *sa2)
+{
+#ifdef HAVE_IPV6
+	if (sa1->ss_family != sa2->ss_family)
+		return FAIL;
+
+	if (AF_INET6 == sa1->ss_family)
+	{
+		return 0 == memcmp(&((const struct sockaddr_in6 *)sa1)->sin6_addr,
+				&((const struct sockaddr_in6 *)sa2)->sin6_addr, sizeof(struct in6_addr)) ?
+				SUCCEED : FAIL;
+	}
+#endif
+	return ((const struct sockaddr_in *)sa1)->sin_addr.s_addr ==
+			((const struct sockaddr_in *)sa2)->sin_addr.s_addr ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: icmp_socket_open                                                 *
+ *                                                                            *
+ * Purpose: open ICMP socket of the specified address family                  *
+ *                                                                            *
+ * Parameters: sock - [IN/OUT] the socket                                     *
+ *                                                                            *
+ * Return value: SUCCEED - the socket is open                                 *
+ *               FAIL    - the process is not allowed to open ICMP sockets    *
+ *                                                                            *
+ * Comments: The socket is opened once and kept open by the process. ICMP     *
+ *           datagram sockets do not require privileges on systems allowing   *
+ *           them (net.ipv4.ping_group_range on Linux), otherwise raw socket  *
+ *           is opened, which requires superuser or CAP_NET_RAW capability.   *
+ *                                                                            *
+ ******************************************************************************/
+static int	icmp_socket_open(trx_icmp_socket_t *sock)
+{
+	int	protocol, fd, value;
+
+	if (0 != sock->checked)
+		return -1 != sock->fd ? SUCCEED : FAIL;
+
+	sock->checked = 1;
+
+#ifdef HAVE_IPV6
+	protocol = (AF_INET == sock->family ? IPPROTO_ICMP : IPPROTO_ICMPV6);
+#else
+	protocol = IPPROTO_ICMP;
+#endif
+	if (-1 == (fd = socket(sock->family, SOCK_DGRAM, protocol)))
+	{
+		if (-1 == (fd = socket(sock->family, SOCK_RAW, protocol)))
+		{
+			treegix_log(LOG_LEVEL_WARNING, "cannot open ICMP%s socket: %s, ICMP pings will be performed"
+					" by fping", AF_INET == sock->family ? "" : "v6", trx_strerror(errno));
+			return FAIL;
+		}
+
+		sock->raw = 1;
+	}
+
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+	value = TRX_ICMP_SOCKET_BUFFER;
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &value, sizeof(value));
+	setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &value, sizeof(value));
+#ifdef SO_TIMESTAMP
+	value = 1;
+	setsockopt(fd, SOL_SOCKET, SO_TIMESTAMP, &value, sizeof(value));
+#endif
+	if (NULL != CONFIG_SOURCE_IP)
+	{
+		TRX_SOCKADDR	sa;
+		socklen_t	sa_len;
+
+		if (SUCCEED != icmp_resolve(CONFIG_SOURCE_IP, sock->family, AI_NUMERICHOST, &sa, &sa_len))
+		{
+			treegix_log(LOG_LEVEL_WARNING, "invalid source IP address \"%s\", ICMP pings will be performed"
+					" by fping", CONFIG_SOURCE_IP);
+			close(fd);
+			return FAIL;
+		}
+
+		if (0 != bind(fd, (struct sockaddr *)&sa, sa_len))
+		{
+			treegix_log(LOG_LEVEL_WARNING, "cannot bind ICMP socket to \"%s\": %s, ICMP pings will be"
+					" performed by fping", CONFIG_SOURCE_IP, trx_strerror(errno));
+			close(fd);
+			return FAIL;
+		}
+	}
+
+	sock->fd = fd;
+
+	treegix_log(LOG_LEVEL_DEBUG, "opened %s ICMP%s socket", 0 != sock->raw ? "raw" : "datagram",
+			AF_INET == sock->family ? "" : "v6");
+
+	return SUCCEED;
+}
+
+static unsigned short	icmp_checksum(const unsigned char *data, size_t len)
+{
+	trx_uint32_t	sum = 0;
+
+	for (; 1 < len; data += 2, len -= 2)
+		sum += (data[0] << 8) | data[1];
+
+	if (1 == len)
+		sum += data[0] << 8;
+
+	while (0 != (sum >> 16))
+		sum = (sum & 0xffff) + (sum >> 16);
+
+	return (unsigned short)~sum;
+}
+
+static trx_uint64_t	icmp_tick(double time)
+{
+	return (trx_uint64_t)(time * 1000);
+}
+
+static void	icmp_wheel_add(trx_icmp_pinger_t *pinger, int packet)
+{
+	int	slot;
+
+	slot = (int)((icmp_tick(pinger->packets[packet].sent + pinger->timeout) + 1) % TRX_ICMP_WHEEL_SLOTS);
+
+	pinger->packets[packet].next = pinger->wheel[slot];
+	pinger->wheel[slot] = packet;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: icmp_wheel_expire                                                *
+ *                                                                            *
+ * Purpose: mark the packets not replied within timeout as lost               *
+ *                                                                            *
+ * Parameters: pinger - [IN/OUT] the pinger                                   *
+ *             now    - [IN] the current time                                 *
+ *                                                                            *
+ * Comments: The slots of milliseconds passed since the last call are         *
+ *           processed. Packets timing out after the next wheel rotation are  *
+ *           left in the slot, replied packets are removed from it.           *
+ *                                                                            *
+ ******************************************************************************/
+static void	icmp_wheel_expire(trx_icmp_pinger_t *pinger, double now)
+{
+	trx_uint64_t	tick, ticks;
+
+	if (pinger->wheel_tick >= (tick = icmp_tick(now)))
+		return;
+
+	if (TRX_ICMP_WHEEL_SLOTS < (ticks = tick - pinger->wheel_tick))
+		ticks = TRX_ICMP_WHEEL_SLOTS;
+
+	for (tick = pinger->wheel_tick + 1; 0 != ticks; ticks--, tick++)
+	{
+		int	*link = &pinger->wheel[tick % TRX_ICMP_WHEEL_SLOTS];
+
+		while (-1 != *link)
+		{
+			trx_icmp_packet_t	*packet = &pinger->packets[*link];
+
+			if (TRX_ICMP_PACKET_SENT == packet->state)
+			{
+				if (packet->sent + pinger->timeout > now)
+				{
+					link = &packet->next;
+					continue;
+				}
+
+				packet->state = TRX_ICMP_PACKET_DONE;
+				pinger->outstanding--;
+			}
+
+			*link = packet->next;
+		}
+	}
+
+	pinger->wheel_tick = icmp_tick(now);
+}
+
+static double	icmp_wheel_next(const trx_icmp_pinger_t *pinger)
+{
+	trx_uint64_t	tick;
+
+	for (tick = pinger->wheel_tick + 1; tick <= pinger->wheel_tick + TRX_ICMP_WHEEL_SLOTS; tick++)
+	{
+		if (-1 != pinger->wheel[tick % TRX_ICMP_WHEEL_SLOTS])
+			break;
+	}
+
+	return (double)tick / 1000;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: icmp_send                                                        *
+ *                                                                            *
+ * Purpose: send echo request of the specified host and ping index            *
+ *                                                                            *
+ * Parameters: pinger - [IN/OUT] the pinger                                   *
+ *             host   - [IN] the host index                                   *
+ *             index  - [IN] the ping index                                   *
+ *             buf    - [IN] the packet buffer                                *
+ *             len    - [IN] the packet length                                *
+ *                                                                            *
+ * Return value: SUCCEED      - the packet was sent                           *
+ *               FAIL         - the socket send buffer is full, the packet    *
+ *                              must be sent later                            *
+ *               NOTSUPPORTED - the packet cannot be sent                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	icmp_send(trx_icmp_pinger_t *pinger, int host, int index, unsigned char *buf, size_t len)
+{
+	trx_icmp_target_t	*target = &pinger->targets[host];
+	trx_icmp_stamp_t	stamp;
+	int			packet = host * pinger->count + index;
+	unsigned short		checksum;
+
+	buf[0] = (AF_INET == target->sock->family ? TRX_ICMP_ECHO : TRX_ICMP6_ECHO);
+	buf[1] = 0;
+	buf[2] = 0;
+	buf[3] = 0;
+	buf[4] = (unsigned char)(pinger->id >> 8);
+	buf[5] = (unsigned char)pinger->id;
+	buf[6] = (unsigned char)(packet >> 8);
+	buf[7] = (unsigned char)packet;
+
+	stamp.cookie = pinger->cookie;
+	stamp.host = host;
+	stamp.index = index;
+	memcpy(buf + TRX_ICMP_HEADER_LEN, &stamp, sizeof(stamp));
+
+	/* the kernel calculates ICMPv6 checksum over the pseudo header */
+	if (AF_INET == target->sock->family)
+	{
+		checksum = icmp_checksum(buf, len);
+		buf[2] = (unsigned char)(checksum >> 8);
+		buf[3] = (unsigned char)checksum;
+	}
+
+	pinger->packets[packet].sent = trx_time();
+
+	if (-1 == sendto(target->sock->fd, buf, len, 0, (struct sockaddr *)&target->addr, target->addr_len))
+	{
+		if (EAGAIN == errno || EWOULDBLOCK == errno || ENOBUFS == errno || EINTR == errno)
+			return FAIL;
+
+		treegix_log(LOG_LEVEL_DEBUG, "cannot send ICMP echo request to \"%s\": %s", pinger->hosts[host].addr,
+				trx_strerror(errno));
+
+		pinger->packets[packet].state = TRX_ICMP_PACKET_DONE;
+
+		return NOTSUPPORTED;
+	}
+
+	pinger->packets[packet].state = TRX_ICMP_PACKET_SENT;
+	pinger->outstanding++;
+	icmp_wheel_add(pinger, packet);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: icmp_recv                                                        *
+ *                                                                            *
+ * Purpose: read the received echo replies and update host statistics         *
+ *                                                                            *
+ * Parameters: pinger - [IN/OUT] the pinger                                   *
+ *             sock   - [IN] the readable socket                              *
+ *             buf    - [IN] the buffer for received packets                  *
+ *             size   - [IN] the buffer size                                  *
+ *                                                                            *
+ * Comments: Duplicate replies and replies sent from other addresses than the *
+ *           pinged one (for example, to broadcast address) are ignored.      *
+ *           The reply time is taken from the kernel timestamp when it is     *
+ *           available so that it does not depend on the batch being sent.    *
+ *                                                                            *
+ ******************************************************************************/
+static void	icmp_recv(trx_icmp_pinger_t *pinger, const trx_icmp_socket_t *sock, unsigned char *buf, size_t size)
+{
+	TRX_SOCKADDR		from;
+	struct msghdr		msg;
+	struct iovec		iov;
+	union
+	{
+		struct cmsghdr	hdr;
+		char		buf[256];
+	}
+	control;
+	struct cmsghdr		*cmsg;
+	trx_icmp_stamp_t	stamp;
+	trx_icmp_packet_t	*packet;
+	TRX_FPING_HOST		*host;
+	unsigned char		*reply;
+	ssize_t			n;
+	double			received, sec;
+
+	while (1)
+	{
+		iov.iov_base = buf;
+		iov.iov_len = size;
+
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_name = &from;
+		msg.msg_namelen = sizeof(from);
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = &control;
+		msg.msg_controllen = sizeof(control);
+
+		if (-1 == (n = recvmsg(sock->fd, &msg, 0)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			break;
+		}
+
+		received = 0;
+#ifdef SO_TIMESTAMP
+		for (cmsg = CMSG_FIRSTHDR(&msg); NULL != cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+		{
+			if (SOL_SOCKET == cmsg->cmsg_level && SCM_TIMESTAMP == cmsg->cmsg_type)
+			{
+				struct timeval	tv;
+
+				memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+				received = tv.tv_sec + tv.tv_usec / 1e6;
+				break;
+			}
+		}
+#else
+		TRX_UNUSED(cmsg);
+#endif
+		if (0 == received)
+			received = trx_time();
+
+		reply = buf;
+
+		/* raw IPv4 sockets and datagram sockets on some systems receive the IP header */
+		if (AF_INET == sock->family && 0 < n && 0x40 == (reply[0] & 0xf0))
+		{
+			n -= (reply[0] & 0x0f) * 4;
+			reply += (reply[0] & 0x0f) * 4;
+		}
+
+		if ((ssize_t)(TRX_ICMP_HEADER_LEN + sizeof(stamp)) > n)
+			continue;
+
+		if ((AF_INET == sock->family ? TRX_ICMP_ECHOREPLY : TRX_ICMP6_ECHOREPLY) != reply[0])
+			continue;
+
+		/* the kernel sets identifier of datagram socket and delivers it only own replies */
+		if (0 != sock->raw && pinger->id != ((reply[4] << 8) | reply[5]))
+			continue;
+
+		memcpy(&stamp, reply + TRX_ICMP_HEADER_LEN, sizeof(stamp));
+
+		if (pinger->cookie != stamp.cookie || (trx_uint32_t)pinger->hosts_count <= stamp.host ||
+				(trx_uint32_t)pinger->count <= stamp.index)
+		{
+			continue;
+		}
+
+		if (SUCCEED != icmp_addr_compare(&from, &pinger->targets[stamp.host].addr))
+			continue;
+
+		packet = &pinger->packets[stamp.host * pinger->count + stamp.index];
+
+		if (TRX_ICMP_PACKET_SENT != packet->state)
+			continue;
+
+		packet->state = TRX_ICMP_PACKET_DONE;
+		pinger->outstanding--;
+
+		if (0 > (sec = received - packet->sent))
+			sec = 0;
+
+		host = &pinger->hosts[stamp.host];
+
+		if (0 == host->rcv || host->min > sec)
+			host->min = sec;
+		if (0 == host->rcv || host->max < sec)
+			host->max = sec;
+		host->sum += sec;
+		host->rcv++;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: icmp_ping                                                        *
+ *                                                                            *
+ * Purpose: ping hosts without executing fping                                *
+ *                                                                            *
+ * Parameters: hosts         - [IN/OUT] the hosts to ping                     *
+ *             hosts_count   - [IN] the number of hosts                       *
+ *             count         - [IN] the number of pings per host              *
+ *             interval      - [IN] the interval between pings of the same    *
+ *                                  host in milliseconds, 0 - default         *
+ *             size          - [IN] the ICMP data size, 0 - default           *
+ *             timeout       - [IN] the reply timeout in milliseconds,        *
+ *                                  0 - default                               *
+ *             error         - [OUT] the error message                        *
+ *             max_error_len - [IN] the size of error buffer                  *
+ *                                                                            *
+ * Return value: SUCCEED      - the hosts were pinged                         *
+ *               NOTSUPPORTED - the hosts could not be pinged                 *
+ *               FAIL         - ICMP sockets cannot be used, fping must be    *
+ *                              used instead                                  *
+ *                                                                            *
+ * Comments: All hosts share one socket of each address family. The requests  *
+ *           are sent in rounds, one echo request to each host per round and  *
+ *           rounds are started interval apart. Replies are read between      *
+ *           batches of requests and lost packets are found by timer wheel.   *
+ *                                                                            *
+ ******************************************************************************/
+static int	icmp_ping(TRX_FPING_HOST *hosts, int hosts_count, int count, int interval, int size, int timeout,
+		char *error, int max_error_len)
+{
+	static trx_uint32_t	run = 0;
+	trx_icmp_pinger_t	pinger;
+	trx_icmp_socket_t	*blocked = NULL;
+	unsigned char		*buf = NULL, *recv_buf = NULL;
+	size_t			len, recv_size;
+	int			i, family = AF_UNSPEC, host = 0, round = 0, ret = FAIL;
+	double			now, round_start, wait;
+
+	if (0 == size)
+		size = TRX_ICMP_DEFAULT_SIZE;
+
+	if (sizeof(trx_icmp_stamp_t) > (size_t)size)
+		return FAIL;
+
+	if (0 == interval)
+		interval = TRX_ICMP_DEFAULT_INTERVAL;
+
+	if (0 == timeout)
+		timeout = TRX_ICMP_DEFAULT_TIMEOUT;
+
+#ifdef HAVE_IPV6
+	/* as with fping, only hosts of the source address family can be pinged */
+	if (NULL != CONFIG_SOURCE_IP && SUCCEED != get_address_family(CONFIG_SOURCE_IP, &family, error, max_error_len))
+		return NOTSUPPORTED;
+#endif
+	memset(&pinger, 0, sizeof(pinger));
+	pinger.hosts = hosts;
+	pinger.hosts_count = hosts_count;
+	pinger.count = count;
+	pinger.timeout = (double)timeout / 1000;
+	pinger.targets = (trx_icmp_target_t *)trx_malloc(NULL, sizeof(trx_icmp_target_t) * hosts_count);
+
+	for (i = 0; i < hosts_count; i++)
+	{
+		trx_icmp_target_t	*target = &pinger.targets[i];
+
+		target->sock = NULL;
+
+		if (SUCCEED != icmp_resolve(hosts[i].addr, family, 0, &target->addr, &target->addr_len))
+		{
+			treegix_log(LOG_LEVEL_DEBUG, "cannot resolve \"%s\"", hosts[i].addr);
+			continue;
+		}
+#ifdef HAVE_IPV6
+		if (AF_INET6 == target->addr.ss_family)
+			target->sock = &icmp6_socket;
+		else
+#endif
+			target->sock = &icmp_socket;
+
+		if (SUCCEED != icmp_socket_open(target->sock))
+			goto out;
+	}
+
+	pinger.packets = (trx_icmp_packet_t *)trx_malloc(NULL, sizeof(trx_icmp_packet_t) * hosts_count * count);
+	memset(pinger.packets, 0, sizeof(trx_icmp_packet_t) * hosts_count * count);
+	memset(pinger.wheel, -1, sizeof(pinger.wheel));
+
+	pinger.cookie = ((trx_uint32_t)getpid() << 16) ^ ++run;
+	pinger.id = (unsigned short)getpid();
+
+	len = TRX_ICMP_HEADER_LEN + size;
+	buf = (unsigned char *)trx_malloc(NULL, len);
+	memset(buf, 0, len);
+
+	recv_size = TRX_ICMP_IP_HEADER_MAX + len;
+	recv_buf = (unsigned char *)trx_malloc(NULL, recv_size);
+
+	round_start = trx_time();
+	pinger.wheel_tick = icmp_tick(round_start);
+
+	while (round < count || 0 != pinger.outstanding)
+	{
+		fd_set		rfds, wfds;
+		struct timeval	tv;
+		int		sent = 0, max_fd = -1;
+
+		now = trx_time();
+
+		while (round < count && round_start <= now && NULL == blocked && TRX_ICMP_BATCH_SIZE > sent)
+		{
+			if (NULL == pinger.targets[host].sock)
+			{
+				pinger.packets[host * count + round].state = TRX_ICMP_PACKET_DONE;
+			}
+			else
+			{
+				int	rc;
+
+				if (FAIL == (rc = icmp_send(&pinger, host, round, buf, len)))
+				{
+					blocked = pinger.targets[host].sock;
+					break;
+				}
+
+				if (SUCCEED == rc)
+					sent++;
+			}
+
+			if (++host == hosts_count)
+			{
+				host = 0;
+				round++;
+				round_start += (double)interval / 1000;
+			}
+		}
+
+		now = trx_time();
+		icmp_wheel_expire(&pinger, now);
+
+		if (round == count && 0 == pinger.outstanding)
+			break;
+
+		if (round < count && round_start <= now && NULL == blocked)
+		{
+			wait = 0;
+		}
+		else
+		{
+			wait = (0 != pinger.outstanding ? icmp_wheel_next(&pinger) - now : pinger.timeout);
+
+			if (round < count && NULL == blocked && round_start - now < wait)
+				wait = round_start - now;
+
+			if (0 > wait)
+				wait = 0;
+		}
+
+		FD_ZERO(&rfds);
+		FD_ZERO(&wfds);
+
+		if (-1 != icmp_socket.fd)
+		{
+			FD_SET(icmp_socket.fd, &rfds);
+			max_fd = icmp_socket.fd;
+		}
+#ifdef HAVE_IPV6
+		if (-1 != icmp6_socket.fd)
+		{
+			FD_SET(icmp6_socket.fd, &rfds);
+			max_fd = MAX(max_fd, icmp6_socket.fd);
+		}
+#endif
+		if (NULL != blocked)
+			FD_SET(blocked->fd, &wfds);
+
+		tv.tv_sec = (time_t)wait;
+		tv.tv_usec = (suseconds_t)((wait - tv.tv_sec) * 1000000);
+
+		if (-1 == select(max_fd + 1, &rfds, &wfds, NULL, &tv))
+		{
+			if (EINTR == errno)
+				continue;
+
+			trx_snprintf(error, max_error_len, "select() failed: %s", trx_strerror(errno));
+			ret = NOTSUPPORTED;
+			goto out;
+		}
+
+		blocked = NULL;
+
+		if (-1 != icmp_socket.fd && FD_ISSET(icmp_socket.fd, &rfds))
+			icmp_recv(&pinger, &icmp_socket, recv_buf, recv_size);
+#ifdef HAVE_IPV6
+		if (-1 != icmp6_socket.fd && FD_ISSET(icmp6_socket.fd, &rfds))
+			icmp_recv(&pinger, &icmp6_socket, recv_buf, recv_size);
+#endif
+	}
+
+	/* fping reports the ping statistics of all hosts it was able to resolve */
+	for (i = 0; i < hosts_count; i++)
+	{
+		if (NULL != pinger.targets[i].sock)
+			hosts[i].cnt += count;
+	}
+
+	ret = SUCCEED;
+out:
+	trx_free(recv_buf);
+	trx_free(buf);
+	trx_free(pinger.packets);
+	trx_free(pinger.targets);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: do_ping                                                          *
@@ -525,7 +1259,9 @@ static int	process_ping(TRX_FPING_HOST *hosts, int hosts_count, int count, int i
  *                                                                            *
  * Author: Alexei Vladishev                                                   *
  *                                                                            *
- * Comments: use external binary 'fping' to avoid superuser privileges        *
+ * Comments: hosts are pinged over ICMP sockets when the process may open     *
+ *           them, otherwise external binary 'fping' is used to avoid         *
+ *           superuser privileges                                             *
  *                                                                            *
  ******************************************************************************/
 int	do_ping(TRX_FPING_HOST *hosts, int hosts_count, int count, int interval, int size, int timeout, char *error, int max_error_len)
@@ -534,7 +1270,10 @@ int	do_ping(TRX_FPING_HOST *hosts, int hosts_count, int count, int interval, int
 
 	treegix_log(LOG_LEVEL_DEBUG, "In %s() hosts_count:%d", __func__, hosts_count);
 
-	if (NOTSUPPORTED == (res = process_ping(hosts, hosts_count, count, interval, size, timeout, error, max_error_len)))
+	if (FAIL == (res = icmp_ping(hosts, hosts_count, count, interval, size, timeout, error, max_error_len)))
+		res = process_ping(hosts, hosts_count, count, interval, size, timeout, error, max_error_len);
+
+	if (NOTSUPPORTED == res)
 		treegix_log(LOG_LEVEL_ERR, "%s", error);
 
 	treegix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, trx_result_string(res));
@@ -2145,4 +2145,259 @@ out:
 	return ret;
 }
 
+#ifdef HAVE_TRX_RINGBUF
+/*
+ * Shared memory ring transport API
+ */
+
+/* ring message header, the message data follows the header */
+typedef struct
+{
+	trx_uint32_t	code;
+	trx_uint32_t	size;
+}
+trx_ipc_ring_header_t;
+
+#define TRX_IPC_RING_WAIT_NS	1000000
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_ring_wait                                                    *
+ *                                                                            *
+ * Purpose: notifies ring consumer and waits a little for it to read messages *
+ *                                                                            *
+ * Parameters: ring        - [IN] the ring                                    *
+ *             csocket     - [IN] the socket connected to the ring consumer   *
+ *             notify_code - [IN] the notification message code               *
+ *                                                                            *
+ * Return value: SUCCEED - the consumer was notified                          *
+ *               FAIL    - the notification message could not be sent         *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_ring_wait(trx_ipc_ring_t *ring, trx_ipc_socket_t *csocket, trx_uint32_t notify_code)
+{
+	struct timespec	ts = {0, TRX_IPC_RING_WAIT_NS};
+
+	if (SUCCEED != trx_ipc_ring_notify(ring, csocket, notify_code))
+		return FAIL;
+
+	nanosleep(&ts, NULL);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_ipc_ring_required_size                                       *
+ *                                                                            *
+ * Purpose: calculates memory size required to store ring with the specified  *
+ *          data size                                                         *
+ *                                                                            *
+ * Parameters: size - [IN] the ring data size, must be power of 2             *
+ *                                                                            *
+ * Return value: The required memory size                                     *
+ *                                                                            *
+ ******************************************************************************/
+size_t	trx_ipc_ring_required_size(size_t size)
+{
+	return offsetof(trx_ipc_ring_t, ring) + trx_ringbuf_required_size(size);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_ipc_ring_init                                                *
+ *                                                                            *
+ * Purpose: initializes IPC ring in the specified memory                      *
+ *                                                                            *
+ * Parameters: mem  - [IN] the shared memory to store ring, 8 byte aligned    *
+ *             size - [IN] the ring data size, must be power of 2             *
+ *                                                                            *
+ * Return value: The initialized ring                                         *
+ *                                                                            *
+ * Comments: The ring must be created before forking the processes using it.  *
+ *           Messages can be written by any number of processes connected to  *
+ *           the service, but only the service process may read them.         *
+ *                                                                            *
+ ******************************************************************************/
+trx_ipc_ring_t	*trx_ipc_ring_init(void *mem, size_t size)
+{
+	trx_ipc_ring_t	*ring = (trx_ipc_ring_t *)mem;
+
+	ring->notified = 0;
+	trx_ringbuf_init(&ring->ring, size);
+
+	return ring;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_ipc_ring_reserve                                             *
+ *                                                                            *
+ * Purpose: reserves message in IPC ring                                      *
+ *                                                                            *
+ * Parameters: ring        - [IN] the ring                                    *
+ *             csocket     - [IN] the socket connected to the ring consumer   *
+ *             notify_code - [IN] the notification message code               *
+ *             code        - [IN] the message code                            *
+ *             size        - [IN] the message data size                       *
+ *             data        - [OUT] the message data to be written             *
+ *                                                                            *
+ * Return value: SUCCEED - the message was reserved                           *
+ *               FAIL    - the message is too large for the ring or the       *
+ *                         consumer could not be notified                     *
+ *                                                                            *
+ * Comments: If the ring is full the consumer is notified and the function    *
+ *           waits until there is enough free space.                          *
+ *           The message data must be committed with trx_ipc_ring_commit()    *
+ *           after it's written.                                              *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_ipc_ring_reserve(trx_ipc_ring_t *ring, trx_ipc_socket_t *csocket, trx_uint32_t notify_code,
+		trx_uint32_t code, trx_uint32_t size, unsigned char **data)
+{
+	trx_ipc_ring_header_t	*header;
+
+	/* larger messages could be blocked by padding at the end of ring buffer */
+	if (sizeof(trx_ipc_ring_header_t) + size > ring->ring.size / 2)
+		return FAIL;
+
+	while (NULL == (header = (trx_ipc_ring_header_t *)trx_ringbuf_reserve(&ring->ring,
+			sizeof(trx_ipc_ring_header_t) + size)))
+	{
+		if (SUCCEED != ipc_ring_wait(ring, csocket, notify_code))
+			return FAIL;
+	}
+
+	header->code = code;
+	header->size = size;
+	*data = (unsigned char *)(header + 1);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_ipc_ring_commit                                              *
+ *                                                                            *
+ * Purpose: makes reserved message visible to the ring consumer               *
+ *                                                                            *
+ * Parameters: data - [IN] the message data returned by                       *
+ *                         trx_ipc_ring_reserve() function                    *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_ipc_ring_commit(unsigned char *data)
+{
+	trx_ringbuf_commit((trx_ipc_ring_header_t *)data - 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_ipc_ring_notify                                              *
+ *                                                                            *
+ * Purpose: wakes up the ring consumer to read committed messages             *
+ *                                                                            *
+ * Parameters: ring        - [IN] the ring                                    *
+ *             csocket     - [IN] the socket connected to the ring consumer   *
+ *             notify_code - [IN] the notification message code               *
+ *                                                                            *
+ * Return value: SUCCEED - the consumer was notified or has been notified     *
+ *                         by another producer                                *
+ *               FAIL    - the notification message could not be sent         *
+ *                                                                            *
+ * Comments: The notification is an empty message sent through the socket.    *
+ *           It is not sent if the consumer has been already notified and has *
+ *           not started reading messages yet.                                *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_ipc_ring_notify(trx_ipc_ring_t *ring, trx_ipc_socket_t *csocket, trx_uint32_t notify_code)
+{
+	if (0 != __atomic_exchange_n(&ring->notified, 1, __ATOMIC_SEQ_CST))
+		return SUCCEED;
+
+	return trx_ipc_socket_write(csocket, notify_code, NULL, 0);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_ipc_ring_flush                                               *
+ *                                                                            *
+ * Purpose: waits until the ring consumer has read all messages committed     *
+ *          before the call                                                   *
+ *                                                                            *
+ * Parameters: ring        - [IN] the ring                                    *
+ *             csocket     - [IN] the socket connected to the ring consumer   *
+ *             notify_code - [IN] the notification message code               *
+ *                                                                            *
+ * Return value: SUCCEED - the messages were read                             *
+ *               FAIL    - the consumer could not be notified                 *
+ *                                                                            *
+ * Comments: Used to preserve message ordering when a message is sent through *
+ *           the socket after messages written to the ring.                   *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_ipc_ring_flush(trx_ipc_ring_t *ring, trx_ipc_socket_t *csocket, trx_uint32_t notify_code)
+{
+	trx_uint64_t	pos;
+
+	pos = trx_ringbuf_get_reserved(&ring->ring);
+
+	while (SUCCEED != trx_ringbuf_is_released(&ring->ring, pos))
+	{
+		if (SUCCEED != ipc_ring_wait(ring, csocket, notify_code))
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_ipc_ring_read                                                *
+ *                                                                            *
+ * Purpose: reads the next committed message from IPC ring                    *
+ *                                                                            *
+ * Parameters: ring - [IN] the ring                                           *
+ *             code - [OUT] the message code                                  *
+ *             size - [OUT] the message data size                             *
+ *                                                                            *
+ * Return value: The message data or NULL if there are no more committed      *
+ *               messages.                                                    *
+ *                                                                            *
+ * Comments: The message data is located in shared memory and stays valid     *
+ *           until it's released with trx_ipc_ring_release() function.        *
+ *           This function must be called only by the service process.        *
+ *                                                                            *
+ ******************************************************************************/
+unsigned char	*trx_ipc_ring_read(trx_ipc_ring_t *ring, trx_uint32_t *code, trx_uint32_t *size)
+{
+	trx_ipc_ring_header_t	*header;
+	size_t			record_size;
+
+	/* producers must notify consumer about messages committed after this point */
+	__atomic_store_n(&ring->notified, 0, __ATOMIC_SEQ_CST);
+
+	if (NULL == (header = (trx_ipc_ring_header_t *)trx_ringbuf_read(&ring->ring, &record_size)))
+		return NULL;
+
+	*code = header->code;
+	*size = header->size;
+
+	return (unsigned char *)(header + 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_ipc_ring_release                                             *
+ *                                                                            *
+ * Purpose: frees the messages read from IPC ring for reuse by producers      *
+ *                                                                            *
+ * Parameters: ring - [IN] the ring                                           *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_ipc_ring_release(trx_ipc_ring_t *ring)
+{
+	trx_ringbuf_release(&ring->ring);
+}
+#endif
+
 #endif
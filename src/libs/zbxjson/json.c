@@ -6,6 +6,19 @@
 #include "json.h"
 #include "jsonpath.h"
 
+/* Vectorized scanning reads whole aligned blocks, possibly past the string  */
+/* terminator. Aligned blocks never cross page boundary, so it's safe, but   */
+/* address sanitizer would report it - use scalar scanning in such builds.   */
+#if defined(__GNUC__) && !defined(__SANITIZE_ADDRESS__)
+#	if defined(__AVX2__)
+#		include <immintrin.h>
+#		define TRX_JSON_SCAN_AVX2
+#	elif defined(__SSE2__)
+#		include <emmintrin.h>
+#		define TRX_JSON_SCAN_SSE2
+#	endif
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: trx_json_strerror                                                *
@@ -486,6 +499,173 @@ static trx_json_type_t	__trx_json_type(const char *p)
 	return TRX_JSON_TYPE_UNKNOWN;
 }
 
+#if defined(TRX_JSON_SCAN_AVX2)
+
+#define TRX_JSON_SCAN_BLOCK	32
+
+typedef __m256i	trx_json_block_t;
+
+#define json_block_load(p)		_mm256_load_si256((const __m256i *)(p))
+#define json_block_set(c)		_mm256_set1_epi8((char)(c))
+#define json_block_eq(a, b)		_mm256_cmpeq_epi8(a, b)
+#define json_block_or(a, b)		_mm256_or_si256(a, b)
+#define json_block_le(a, b)		_mm256_cmpeq_epi8(_mm256_max_epu8(a, b), b)
+#define json_block_mask(a)		((trx_uint32_t)_mm256_movemask_epi8(a))
+
+#elif defined(TRX_JSON_SCAN_SSE2)
+
+#define TRX_JSON_SCAN_BLOCK	16
+
+typedef __m128i	trx_json_block_t;
+
+#define json_block_load(p)		_mm_load_si128((const __m128i *)(p))
+#define json_block_set(c)		_mm_set1_epi8((char)(c))
+#define json_block_eq(a, b)		_mm_cmpeq_epi8(a, b)
+#define json_block_or(a, b)		_mm_or_si128(a, b)
+#define json_block_le(a, b)		_mm_cmpeq_epi8(_mm_max_epu8(a, b), b)
+#define json_block_mask(a)		((trx_uint32_t)_mm_movemask_epi8(a))
+
+#endif
+
+#if defined(TRX_JSON_SCAN_BLOCK)
+
+/******************************************************************************
+ *                                                                            *
+ * Function: json_block_string_mask                                           *
+ *                                                                            *
+ * Purpose: get mask of string data characters requiring attention - quotes,  *
+ *          backslashes and control characters (including terminating zero)   *
+ *                                                                            *
+ ******************************************************************************/
+static trx_uint32_t	json_block_string_mask(const char *block)
+{
+	trx_json_block_t	data, special;
+
+	data = json_block_load(block);
+
+	special = json_block_or(json_block_eq(data, json_block_set('"')), json_block_eq(data, json_block_set('\\')));
+	special = json_block_or(special, json_block_le(data, json_block_set(0x1f)));
+
+	return json_block_mask(special);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: json_block_structural_mask                                       *
+ *                                                                            *
+ * Purpose: get mask of structural characters outside strings - quotes,       *
+ *          brackets, commas and terminating zero                             *
+ *                                                                            *
+ ******************************************************************************/
+static trx_uint32_t	json_block_structural_mask(const char *block)
+{
+	trx_json_block_t	data, lower, special;
+
+	data = json_block_load(block);
+
+	/* '[' and ']' differ from '{' and '}' only by 0x20 bit */
+	lower = json_block_or(data, json_block_set(0x20));
+
+	special = json_block_or(json_block_eq(lower, json_block_set('{')), json_block_eq(lower, json_block_set('}')));
+	special = json_block_or(special, json_block_eq(data, json_block_set('"')));
+	special = json_block_or(special, json_block_eq(data, json_block_set(',')));
+	special = json_block_or(special, json_block_eq(data, json_block_set('\0')));
+
+	return json_block_mask(special);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: json_scan_blocks                                                 *
+ *                                                                            *
+ * Purpose: find the first character matching block mask function             *
+ *                                                                            *
+ * Comments: The data is read by aligned blocks, starting with the block      *
+ *           containing p. The mask function must match terminating zero, so  *
+ *           blocks after the end of string are never read.                   *
+ *                                                                            *
+ ******************************************************************************/
+static const char	*json_scan_blocks(const char *p, trx_uint32_t (*block_mask)(const char *block))
+{
+	const char	*block;
+	trx_uint32_t	mask;
+
+	block = (const char *)((uintptr_t)p & ~(uintptr_t)(TRX_JSON_SCAN_BLOCK - 1));
+
+	/* ignore characters before p in the first block */
+	mask = block_mask(block) & ((trx_uint32_t)~0 << (p - block));
+
+	while (0 == mask)
+	{
+		block += TRX_JSON_SCAN_BLOCK;
+		mask = block_mask(block);
+	}
+
+	return block + __builtin_ctz(mask);
+}
+
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_json_scan_string                                             *
+ *                                                                            *
+ * Purpose: skip string data characters not requiring special processing      *
+ *                                                                            *
+ * Parameters: p - [IN] pointer inside json string                            *
+ *                                                                            *
+ * Return value: pointer to the first quote, backslash or control character   *
+ *               (including terminating zero) at or after p                   *
+ *                                                                            *
+ ******************************************************************************/
+const char	*trx_json_scan_string(const char *p)
+{
+#if defined(TRX_JSON_SCAN_BLOCK)
+	return json_scan_blocks(p, json_block_string_mask);
+#else
+	while ('"' != *p && '\\' != *p && 0x1f < (unsigned char)*p)
+		p++;
+
+	return p;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_json_scan_structural                                         *
+ *                                                                            *
+ * Purpose: skip json data characters outside strings that do not affect      *
+ *          value boundaries                                                  *
+ *                                                                            *
+ * Parameters: p - [IN] pointer to json data outside strings                  *
+ *                                                                            *
+ * Return value: pointer to the first quote, bracket, comma or terminating    *
+ *               zero at or after p                                           *
+ *                                                                            *
+ ******************************************************************************/
+const char	*trx_json_scan_structural(const char *p)
+{
+#if defined(TRX_JSON_SCAN_BLOCK)
+	return json_scan_blocks(p, json_block_structural_mask);
+#else
+	while (1)
+	{
+		switch (*p)
+		{
+			case '"':
+			case '{':
+			case '}':
+			case '[':
+			case ']':
+			case ',':
+			case '\0':
+				return p;
+		}
+		p++;
+	}
+#endif
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: __trx_json_rbracket                                              *
@@ -513,10 +693,14 @@ static const char	*__trx_json_rbracket(const char *p)
 
 	rbracket = ('{' == lbracket ? '}' : ']');
 
-	while ('\0' != *p)
+	while (1)
 	{
+		p = (0 == state ? trx_json_scan_structural(p) : trx_json_scan_string(p));
+
 		switch (*p)
 		{
+			case '\0':
+				return NULL;
 			case '"':
 				state = (0 == state ? 1 : 0);
 				break;
@@ -542,8 +726,6 @@ static const char	*__trx_json_rbracket(const char *p)
 		}
 		p++;
 	}
-
-	return NULL;
 }
 
 /******************************************************************************
@@ -619,8 +801,11 @@ const char	*trx_json_next(const struct trx_json_parse *jp, const char *p)
 		return p;
 	}
 
-	while (p <= jp->end)
+	while (1)
 	{
+		if (jp->end < (p = (0 == state ? trx_json_scan_structural(p) : trx_json_scan_string(p))))
+			break;
+
 		switch (*p)
 		{
 			case '"':
@@ -4,7 +4,7 @@
 #define TREEGIX_JSON_H
 
 #define SKIP_WHITESPACE(src)	\
-	while ('\0' != *(src) && NULL != strchr(TRX_WHITESPACE, *(src))) (src)++
+	while (' ' == *(src) || '\t' == *(src) || '\r' == *(src) || '\n' == *(src)) (src)++
 
 /* can only be used on non empty string */
 #define SKIP_WHITESPACE_NEXT(src)\
@@ -14,4 +14,7 @@
 void	trx_set_json_strerror(const char *fmt, ...) __trx_attr_format_printf(1, 2);
 int	trx_json_open_path(const struct trx_json_parse *jp, const char *path, struct trx_json_parse *out);
 
+const char	*trx_json_scan_string(const char *p);
+const char	*trx_json_scan_structural(const char *p);
+
 #endif
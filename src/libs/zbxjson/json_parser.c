@@ -62,7 +62,7 @@ static int	json_parse_string(const char *start, char **error)
 	/* skip starting '"' */
 	ptr++;
 
-	while ('"' != *ptr)
+	while ('"' != *(ptr = trx_json_scan_string(ptr)))
 	{
 		/* unexpected end of string data, failing */
 		if ('\0' == *ptr)
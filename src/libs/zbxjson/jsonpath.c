@@ -14,10 +14,32 @@
 TRX_VECTOR_DECL(var, trx_variant_t)
 TRX_VECTOR_IMPL(var, trx_variant_t)
 
-static int	jsonpath_query_object(const struct trx_json_parse *jp_root, const struct trx_json_parse *jp,
-		const trx_jsonpath_t *jsonpath, int path_depth, trx_vector_str_t *objects);
-static int	jsonpath_query_array(const struct trx_json_parse *jp_root, const struct trx_json_parse *jp,
-		const trx_jsonpath_t *jsonpath, int path_depth, trx_vector_str_t *objects);
+/* json document index, allows to find object values by name without scanning the object */
+struct trx_jsonpath_index
+{
+	trx_hashset_t	objects;	/* the indexed objects */
+	trx_hashset_t	pairs;		/* name/value pairs of the indexed objects */
+};
+
+typedef struct
+{
+	const char	*object;	/* the object location in json document */
+	int		unique;		/* SUCCEED - the object member names are unique, FAIL - otherwise */
+}
+trx_jsonpath_index_object_t;
+
+typedef struct
+{
+	const char	*object;
+	char		*name;
+	const char	*value;
+}
+trx_jsonpath_index_pair_t;
+
+static int	jsonpath_query_object(const struct trx_json_parse *jp_root, trx_jsonpath_index_t *doc_index,
+		const struct trx_json_parse *jp, const trx_jsonpath_t *jsonpath, int path_depth, trx_vector_str_t *objects);
+static int	jsonpath_query_array(const struct trx_json_parse *jp_root, trx_jsonpath_index_t *doc_index,
+		const struct trx_json_parse *jp, const trx_jsonpath_t *jsonpath, int path_depth, trx_vector_str_t *objects);
 
 typedef struct
 {
@@ -1257,6 +1279,101 @@ static int	jsonpath_pointer_to_jp(const char *pnext, struct trx_json_parse *jp)
 	}
 }
 
+static trx_hash_t	jsonpath_index_pair_hash(const void *data)
+{
+	const trx_jsonpath_index_pair_t	*pair = (const trx_jsonpath_index_pair_t *)data;
+	trx_hash_t			hash;
+
+	hash = TRX_DEFAULT_PTR_HASH_ALGO(&pair->object, sizeof(pair->object), TRX_DEFAULT_HASH_SEED);
+
+	return TRX_DEFAULT_STRING_HASH_ALGO(pair->name, strlen(pair->name), hash);
+}
+
+static int	jsonpath_index_pair_compare(const void *d1, const void *d2)
+{
+	const trx_jsonpath_index_pair_t	*p1 = (const trx_jsonpath_index_pair_t *)d1;
+	const trx_jsonpath_index_pair_t	*p2 = (const trx_jsonpath_index_pair_t *)d2;
+
+	TRX_RETURN_IF_NOT_EQUAL(p1->object, p2->object);
+
+	return strcmp(p1->name, p2->name);
+}
+
+static void	jsonpath_index_pair_clear(void *data)
+{
+	trx_jsonpath_index_pair_t	*pair = (trx_jsonpath_index_pair_t *)data;
+
+	trx_free(pair->name);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: jsonpath_index_get_value                                         *
+ *                                                                            *
+ * Purpose: find object value by name using the document index                *
+ *                                                                            *
+ * Parameters: doc_index - [IN] the document index                            *
+ *             jp        - [IN] the json object                               *
+ *             name      - [IN] the value name                                *
+ *             value     - [OUT] a pointer to the value in json data or NULL  *
+ *                               if the object has no value with such name    *
+ *                                                                            *
+ * Return value: SUCCEED - the index was used to look up the value            *
+ *               FAIL    - the object has duplicate names and must be scanned *
+ *                                                                            *
+ * Comments: The object is indexed when it's queried for the first time.      *
+ *                                                                            *
+ ******************************************************************************/
+static int	jsonpath_index_get_value(trx_jsonpath_index_t *doc_index, const struct trx_json_parse *jp,
+		const char *name, const char **value)
+{
+	trx_jsonpath_index_object_t	*object, object_local;
+	trx_jsonpath_index_pair_t	*pair, pair_local;
+
+	object_local.object = jp->start;
+
+	if (NULL == (object = (trx_jsonpath_index_object_t *)trx_hashset_search(&doc_index->objects,
+			&object_local)))
+	{
+		const char	*pnext = NULL;
+		char		buffer[MAX_STRING_LEN];
+
+		object_local.unique = SUCCEED;
+		pair_local.object = jp->start;
+
+		while (NULL != (pnext = trx_json_pair_next(jp, pnext, buffer, sizeof(buffer))))
+		{
+			pair_local.name = buffer;
+
+			if (NULL != trx_hashset_search(&doc_index->pairs, &pair_local))
+			{
+				object_local.unique = FAIL;
+				break;
+			}
+
+			pair_local.name = trx_strdup(NULL, buffer);
+			pair_local.value = pnext;
+			trx_hashset_insert(&doc_index->pairs, &pair_local, sizeof(pair_local));
+		}
+
+		object = (trx_jsonpath_index_object_t *)trx_hashset_insert(&doc_index->objects, &object_local,
+				sizeof(object_local));
+	}
+
+	if (SUCCEED != object->unique)
+		return FAIL;
+
+	pair_local.object = jp->start;
+	pair_local.name = (char *)name;
+
+	if (NULL != (pair = (trx_jsonpath_index_pair_t *)trx_hashset_search(&doc_index->pairs, &pair_local)))
+		*value = pair->value;
+	else
+		*value = NULL;
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: jsonpath_query_contents                                          *
@@ -1264,6 +1381,7 @@ static int	jsonpath_pointer_to_jp(const char *pnext, struct trx_json_parse *jp)
  * Purpose: perform the rest of jsonpath query on json data                   *
  *                                                                            *
  * Parameters: jp_root    - [IN] the document root                            *
+ *             doc_index  - [IN] the document index (optional)                *
  *             pnext      - [IN] a pointer to object/array/value in json data *
  *             jsonpath   - [IN] the jsonpath                                 *
  *             path_depth - [IN] the jsonpath segment to match                *
@@ -1274,8 +1392,8 @@ static int	jsonpath_pointer_to_jp(const char *pnext, struct trx_json_parse *jp)
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	jsonpath_query_contents(const struct trx_json_parse *jp_root, const char *pnext,
-		const trx_jsonpath_t *jsonpath, int path_depth, trx_vector_str_t *objects)
+static int	jsonpath_query_contents(const struct trx_json_parse *jp_root, trx_jsonpath_index_t *doc_index,
+		const char *pnext, const trx_jsonpath_t *jsonpath, int path_depth, trx_vector_str_t *objects)
 {
 	struct trx_json_parse	jp_child;
 
@@ -1285,12 +1403,12 @@ static int	jsonpath_query_contents(const struct trx_json_parse *jp_root, const c
 			if (FAIL == trx_json_brackets_open(pnext, &jp_child))
 				return FAIL;
 
-			return jsonpath_query_object(jp_root, &jp_child, jsonpath, path_depth, objects);
+			return jsonpath_query_object(jp_root, doc_index, &jp_child, jsonpath, path_depth, objects);
 		case '[':
 			if (FAIL == trx_json_brackets_open(pnext, &jp_child))
 				return FAIL;
 
-			return jsonpath_query_array(jp_root, &jp_child, jsonpath, path_depth, objects);
+			return jsonpath_query_array(jp_root, doc_index, &jp_child, jsonpath, path_depth, objects);
 	}
 	return SUCCEED;
 }
@@ -1302,6 +1420,7 @@ static int	jsonpath_query_contents(const struct trx_json_parse *jp_root, const c
  * Purpose: query next segment                                                *
  *                                                                            *
  * Parameters: jp_root    - [IN] the document root                            *
+ *             doc_index  - [IN] the document index (optional)                *
  *             pnext      - [IN] a pointer to object/array/value in json data *
  *             jsonpath   - [IN] the jsonpath                                 *
  *             path_depth - [IN] the jsonpath segment to match                *
@@ -1312,8 +1431,8 @@ static int	jsonpath_query_contents(const struct trx_json_parse *jp_root, const c
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	jsonpath_query_next_segment(const struct trx_json_parse *jp_root, const char *pnext,
-		const trx_jsonpath_t *jsonpath, int path_depth, trx_vector_str_t *objects)
+static int	jsonpath_query_next_segment(const struct trx_json_parse *jp_root, trx_jsonpath_index_t *doc_index,
+		const char *pnext, const trx_jsonpath_t *jsonpath, int path_depth, trx_vector_str_t *objects)
 {
 	/* check if jsonpath end has been reached, so we have found matching data */
 	/* (functions are processed afterwards)                                   */
@@ -1325,7 +1444,7 @@ static int	jsonpath_query_next_segment(const struct trx_json_parse *jp_root, con
 	}
 
 	/* continue by matching found data against the rest of jsonpath segments */
-	return jsonpath_query_contents(jp_root, pnext, jsonpath, path_depth, objects);
+	return jsonpath_query_contents(jp_root, doc_index, pnext, jsonpath, path_depth, objects);
 }
 
 /******************************************************************************
@@ -1335,6 +1454,7 @@ static int	jsonpath_query_next_segment(const struct trx_json_parse *jp_root, con
  * Purpose: match object value name against jsonpath segment name list        *
  *                                                                            *
  * Parameters: jp_root    - [IN] the document root                            *
+ *             doc_index  - [IN] the document index (optional)                *
  *             pnext      - [IN] a pointer to object value with the specified *
  *                               name                                         *
  *             jsonpath   - [IN] the jsonpath                                 *
@@ -1347,8 +1467,8 @@ static int	jsonpath_query_next_segment(const struct trx_json_parse *jp_root, con
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	jsonpath_match_name(const struct trx_json_parse *jp_root, const char *pnext,
-		const trx_jsonpath_t *jsonpath, int path_depth, const char *name, trx_vector_str_t *objects)
+static int	jsonpath_match_name(const struct trx_json_parse *jp_root, trx_jsonpath_index_t *doc_index,
+		const char *pnext, const trx_jsonpath_t *jsonpath, int path_depth, const char *name, trx_vector_str_t *objects)
 {
 	trx_jsonpath_segment_t		*segment;
 	trx_jsonpath_list_node_t	*node;
@@ -1363,7 +1483,7 @@ static int	jsonpath_match_name(const struct trx_json_parse *jp_root, const char
 	{
 		if (0 == strcmp(name, node->data))
 		{
-			if (FAIL == jsonpath_query_next_segment(jp_root, pnext, jsonpath, path_depth, objects))
+			if (FAIL == jsonpath_query_next_segment(jp_root, doc_index, pnext, jsonpath, path_depth, objects))
 				return FAIL;
 			break;
 		}
@@ -1612,6 +1732,7 @@ static int	jsonpath_regexp_match(const char *text, const char *pattern, double *
  * Purpose: match json array element/object value against jsonpath expression *
  *                                                                            *
  * Parameters: jp_root    - [IN] the document root                            *
+ *             doc_index  - [IN] the document index (optional)                *
  *             pnext      - [IN] a pointer to array element/object value      *
  *             jsonpath   - [IN] the jsonpath                                 *
  *             path_depth - [IN] the jsonpath segment to match                *
@@ -1622,8 +1743,8 @@ static int	jsonpath_regexp_match(const char *text, const char *pattern, double *
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	jsonpath_match_expression(const struct trx_json_parse *jp_root, const char *pnext,
-		const trx_jsonpath_t *jsonpath, int path_depth, trx_vector_str_t *objects)
+static int	jsonpath_match_expression(const struct trx_json_parse *jp_root, trx_jsonpath_index_t *doc_index,
+		const char *pnext, const trx_jsonpath_t *jsonpath, int path_depth, trx_vector_str_t *objects)
 {
 	struct trx_json_parse	jp;
 	trx_vector_var_t	stack;
@@ -1819,7 +1940,7 @@ static int	jsonpath_match_expression(const struct trx_json_parse *jp_root, const
 
 	jsonpath_variant_to_boolean(&stack.values[0]);
 	if (SUCCEED != trx_double_compare(stack.values[0].data.dbl, 0.0))
-		ret = jsonpath_query_next_segment(jp_root, pnext, jsonpath, path_depth, objects);
+		ret = jsonpath_query_next_segment(jp_root, doc_index, pnext, jsonpath, path_depth, objects);
 out:
 	for (i = 0; i < stack.values_num; i++)
 		trx_variant_clear(&stack.values[i]);
@@ -1835,6 +1956,7 @@ out:
  * Purpose: query object fields for jsonpath segment match                    *
  *                                                                            *
  * Parameters: jp_root    - [IN] the document root                            *
+ *             doc_index  - [IN] the document index (optional)                *
  *             jp         - [IN] the json object to query                     *
  *             jsonpath   - [IN] the jsonpath                                 *
  *             path_depth - [IN] the jsonpath segment to match                *
@@ -1845,8 +1967,8 @@ out:
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	jsonpath_query_object(const struct trx_json_parse *jp_root, const struct trx_json_parse *jp,
-		const trx_jsonpath_t *jsonpath, int path_depth, trx_vector_str_t *objects)
+static int	jsonpath_query_object(const struct trx_json_parse *jp_root, trx_jsonpath_index_t *doc_index,
+		const struct trx_json_parse *jp, const trx_jsonpath_t *jsonpath, int path_depth, trx_vector_str_t *objects)
 {
 	const char		*pnext = NULL;
 	char			name[MAX_STRING_LEN];
@@ -1855,25 +1977,36 @@ static int	jsonpath_query_object(const struct trx_json_parse *jp_root, const str
 
 	segment = &jsonpath->segments[path_depth];
 
+	if (NULL != doc_index && TRX_JSONPATH_SEGMENT_MATCH_LIST == segment->type && 0 == segment->detached &&
+			TRX_JSONPATH_LIST_NAME == segment->data.list.type && NULL != segment->data.list.values &&
+			NULL == segment->data.list.values->next &&
+			SUCCEED == jsonpath_index_get_value(doc_index, jp, segment->data.list.values->data, &pnext))
+	{
+		if (NULL == pnext)
+			return SUCCEED;
+
+		return jsonpath_query_next_segment(jp_root, doc_index, pnext, jsonpath, path_depth, objects);
+	}
+
 	while (NULL != (pnext = trx_json_pair_next(jp, pnext, name, sizeof(name))) && SUCCEED == ret)
 	{
 		switch (segment->type)
 		{
 			case TRX_JSONPATH_SEGMENT_MATCH_ALL:
-				ret = jsonpath_query_next_segment(jp_root, pnext, jsonpath, path_depth, objects);
+				ret = jsonpath_query_next_segment(jp_root, doc_index, pnext, jsonpath, path_depth, objects);
 				break;
 			case TRX_JSONPATH_SEGMENT_MATCH_LIST:
-				ret = jsonpath_match_name(jp_root, pnext, jsonpath, path_depth, name, objects);
+				ret = jsonpath_match_name(jp_root, doc_index, pnext, jsonpath, path_depth, name, objects);
 				break;
 			case TRX_JSONPATH_SEGMENT_MATCH_EXPRESSION:
-				ret = jsonpath_match_expression(jp_root, pnext, jsonpath, path_depth, objects);
+				ret = jsonpath_match_expression(jp_root, doc_index, pnext, jsonpath, path_depth, objects);
 				break;
 			default:
 				break;
 		}
 
 		if (1 == segment->detached)
-			ret = jsonpath_query_contents(jp_root, pnext, jsonpath, path_depth, objects);
+			ret = jsonpath_query_contents(jp_root, doc_index, pnext, jsonpath, path_depth, objects);
 	}
 
 	return ret;
@@ -1886,6 +2019,7 @@ static int	jsonpath_query_object(const struct trx_json_parse *jp_root, const str
  * Purpose: match array element against segment index list                    *
  *                                                                            *
  * Parameters: jp_root      - [IN] the document root                          *
+ *             doc_index    - [IN] the document index (optional)              *
  *             pnext        - [IN] a pointer to an array element              *
  *             jsonpath     - [IN] the jsonpath                               *
  *             path_depth   - [IN] the jsonpath segment to match              *
@@ -1898,8 +2032,9 @@ static int	jsonpath_query_object(const struct trx_json_parse *jp_root, const str
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	jsonpath_match_index(const struct trx_json_parse *jp_root, const char *pnext,
-		const trx_jsonpath_t *jsonpath, int path_depth, int index, int elements_num, trx_vector_str_t *objects)
+static int	jsonpath_match_index(const struct trx_json_parse *jp_root, trx_jsonpath_index_t *doc_index,
+		const char *pnext, const trx_jsonpath_t *jsonpath, int path_depth, int index, int elements_num,
+		trx_vector_str_t *objects)
 {
 	trx_jsonpath_segment_t		*segment;
 	trx_jsonpath_list_node_t	*node;
@@ -1918,7 +2053,7 @@ static int	jsonpath_match_index(const struct trx_json_parse *jp_root, const char
 
 		if ((query_index >= 0 && index == query_index) || index == elements_num + query_index)
 		{
-			if (FAIL == jsonpath_query_next_segment(jp_root, pnext, jsonpath, path_depth, objects))
+			if (FAIL == jsonpath_query_next_segment(jp_root, doc_index, pnext, jsonpath, path_depth, objects))
 				return FAIL;
 			break;
 		}
@@ -1934,6 +2069,7 @@ static int	jsonpath_match_index(const struct trx_json_parse *jp_root, const char
  * Purpose: match array element against segment index range                   *
  *                                                                            *
  * Parameters: jp_root      - [IN] the document root                          *
+ *             doc_index    - [IN] the document index (optional)              *
  *             pnext        - [IN] a pointer to an array element              *
  *             jsonpath     - [IN] the jsonpath                               *
  *             path_depth   - [IN] the jsonpath segment to match              *
@@ -1946,8 +2082,9 @@ static int	jsonpath_match_index(const struct trx_json_parse *jp_root, const char
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	jsonpath_match_range(const struct trx_json_parse *jp_root, const char *pnext,
-		const trx_jsonpath_t *jsonpath, int path_depth, int index, int elements_num, trx_vector_str_t *objects)
+static int	jsonpath_match_range(const struct trx_json_parse *jp_root, trx_jsonpath_index_t *doc_index,
+		const char *pnext, const trx_jsonpath_t *jsonpath, int path_depth, int index, int elements_num,
+		trx_vector_str_t *objects)
 {
 	int			start_index, end_index;
 	trx_jsonpath_segment_t	*segment;
@@ -1964,7 +2101,7 @@ static int	jsonpath_match_range(const struct trx_json_parse *jp_root, const char
 
 	if (start_index <= index && end_index > index)
 	{
-		if (FAIL == jsonpath_query_next_segment(jp_root, pnext, jsonpath, path_depth, objects))
+		if (FAIL == jsonpath_query_next_segment(jp_root, doc_index, pnext, jsonpath, path_depth, objects))
 			return FAIL;
 	}
 
@@ -1978,6 +2115,7 @@ static int	jsonpath_match_range(const struct trx_json_parse *jp_root, const char
  * Purpose: query array elements for jsonpath segment match                   *
  *                                                                            *
  * Parameters: jp_root    - [IN] the document root                            *
+ *             doc_index  - [IN] the document index (optional)                *
  *             jp         - [IN] the json array to query                      *
  *             jsonpath   - [IN] the jsonpath                                 *
  *             path_depth - [IN] the jsonpath segment to match                *
@@ -1988,8 +2126,8 @@ static int	jsonpath_match_range(const struct trx_json_parse *jp_root, const char
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	jsonpath_query_array(const struct trx_json_parse *jp_root, const struct trx_json_parse *jp,
-		const trx_jsonpath_t *jsonpath, int path_depth, trx_vector_str_t *objects)
+static int	jsonpath_query_array(const struct trx_json_parse *jp_root, trx_jsonpath_index_t *doc_index,
+		const struct trx_json_parse *jp, const trx_jsonpath_t *jsonpath, int path_depth, trx_vector_str_t *objects)
 {
 	const char		*pnext = NULL;
 	int			index = 0, elements_num = 0, ret = SUCCEED;
@@ -2005,25 +2143,25 @@ static int	jsonpath_query_array(const struct trx_json_parse *jp_root, const stru
 		switch (segment->type)
 		{
 			case TRX_JSONPATH_SEGMENT_MATCH_ALL:
-				ret = jsonpath_query_next_segment(jp_root, pnext, jsonpath, path_depth, objects);
+				ret = jsonpath_query_next_segment(jp_root, doc_index, pnext, jsonpath, path_depth, objects);
 				break;
 			case TRX_JSONPATH_SEGMENT_MATCH_LIST:
-				ret = jsonpath_match_index(jp_root, pnext, jsonpath, path_depth, index,
+				ret = jsonpath_match_index(jp_root, doc_index, pnext, jsonpath, path_depth, index,
 						elements_num, objects);
 				break;
 			case TRX_JSONPATH_SEGMENT_MATCH_RANGE:
-				ret = jsonpath_match_range(jp_root, pnext, jsonpath, path_depth, index,
+				ret = jsonpath_match_range(jp_root, doc_index, pnext, jsonpath, path_depth, index,
 						elements_num, objects);
 				break;
 			case TRX_JSONPATH_SEGMENT_MATCH_EXPRESSION:
-				ret = jsonpath_match_expression(jp_root, pnext, jsonpath, path_depth, objects);
+				ret = jsonpath_match_expression(jp_root, doc_index, pnext, jsonpath, path_depth, objects);
 				break;
 			default:
 				break;
 		}
 
 		if (1 == segment->detached)
-			ret = jsonpath_query_contents(jp_root, pnext, jsonpath, path_depth, objects);
+			ret = jsonpath_query_contents(jp_root, doc_index, pnext, jsonpath, path_depth, objects);
 
 		index++;
 	}
@@ -2447,48 +2585,117 @@ int	trx_jsonpath_compile(const char *path, trx_jsonpath_t *jsonpath)
 
 /******************************************************************************
  *                                                                            *
- * Function: trx_jsonpath_query                                               *
+ * Function: trx_jsonpath_index_create                                        *
  *                                                                            *
- * Purpose: perform jsonpath query on the specified json data                 *
+ * Purpose: create json document index                                        *
  *                                                                            *
- * Parameters: jp     - [IN] the json data                                    *
- *             path   - [IN] the jsonpath                                     *
- *             output - [OUT] the output value                                *
+ * Return value: the created index                                            *
+ *                                                                            *
+ * Comments: The index is filled during queries and is bound to the json      *
+ *           document buffer - it must be used only for queries on the same   *
+ *           document and freed before the document is freed or changed.      *
+ *                                                                            *
+ ******************************************************************************/
+trx_jsonpath_index_t	*trx_jsonpath_index_create(void)
+{
+	trx_jsonpath_index_t	*doc_index;
+
+	doc_index = (trx_jsonpath_index_t *)trx_malloc(NULL, sizeof(trx_jsonpath_index_t));
+
+	trx_hashset_create(&doc_index->objects, 0, TRX_DEFAULT_PTR_HASH_FUNC, TRX_DEFAULT_PTR_COMPARE_FUNC);
+	trx_hashset_create_ext(&doc_index->pairs, 0, jsonpath_index_pair_hash, jsonpath_index_pair_compare,
+			jsonpath_index_pair_clear, TRX_DEFAULT_MEM_MALLOC_FUNC, TRX_DEFAULT_MEM_REALLOC_FUNC,
+			TRX_DEFAULT_MEM_FREE_FUNC);
+
+	return doc_index;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_jsonpath_index_free                                          *
+ *                                                                            *
+ * Purpose: free json document index                                          *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_jsonpath_index_free(trx_jsonpath_index_t *doc_index)
+{
+	trx_hashset_destroy(&doc_index->pairs);
+	trx_hashset_destroy(&doc_index->objects);
+	trx_free(doc_index);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_jsonpath_query_compiled                                      *
+ *                                                                            *
+ * Purpose: perform compiled jsonpath query on the specified json data        *
+ *                                                                            *
+ * Parameters: jp        - [IN] the json data                                 *
+ *             jsonpath  - [IN] the compiled jsonpath                         *
+ *             doc_index - [IN] the json data index (optional)                *
+ *             output    - [OUT] the output value                             *
  *                                                                            *
  * Return value: SUCCEED - the query was performed successfully (empty result *
  *                         being counted as successful query)                 *
  *               FAIL    - otherwise                                          *
  *                                                                            *
+ * Comments: The index speeds up multiple queries of the same json data.      *
+ *                                                                            *
  ******************************************************************************/
-int	trx_jsonpath_query(const struct trx_json_parse *jp, const char *path, char **output)
+int	trx_jsonpath_query_compiled(const struct trx_json_parse *jp, trx_jsonpath_t *jsonpath,
+		trx_jsonpath_index_t *doc_index, char **output)
 {
-	trx_jsonpath_t		jsonpath;
 	int			path_depth = 0, ret = SUCCEED;
 	trx_vector_str_t	objects;
 
-	if (FAIL == trx_jsonpath_compile(path, &jsonpath))
-		return FAIL;
-
 	trx_vector_str_create(&objects);
 
 	if ('{' == *jp->start)
-		ret = jsonpath_query_object(jp, jp, &jsonpath, path_depth, &objects);
+		ret = jsonpath_query_object(jp, doc_index, jp, jsonpath, path_depth, &objects);
 	else if ('[' == *jp->start)
-		ret = jsonpath_query_array(jp, jp, &jsonpath, path_depth, &objects);
+		ret = jsonpath_query_array(jp, doc_index, jp, jsonpath, path_depth, &objects);
 
 	if (SUCCEED == ret)
 	{
-		path_depth = jsonpath.segments_num;
-		while (0 < path_depth && TRX_JSONPATH_SEGMENT_FUNCTION == jsonpath.segments[path_depth - 1].type)
+		path_depth = jsonpath->segments_num;
+		while (0 < path_depth && TRX_JSONPATH_SEGMENT_FUNCTION == jsonpath->segments[path_depth - 1].type)
 			path_depth--;
 
-		if (path_depth < jsonpath.segments_num)
-			ret = jsonpath_apply_functions(jp, &objects, &jsonpath, path_depth, output);
+		if (path_depth < jsonpath->segments_num)
+			ret = jsonpath_apply_functions(jp, &objects, jsonpath, path_depth, output);
 		else
-			ret = jsonpath_format_query_result(&objects, &jsonpath, output);
+			ret = jsonpath_format_query_result(&objects, jsonpath, output);
 	}
 
 	trx_vector_str_destroy(&objects);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_jsonpath_query                                               *
+ *                                                                            *
+ * Purpose: perform jsonpath query on the specified json data                 *
+ *                                                                            *
+ * Parameters: jp     - [IN] the json data                                    *
+ *             path   - [IN] the jsonpath                                     *
+ *             output - [OUT] the output value                                *
+ *                                                                            *
+ * Return value: SUCCEED - the query was performed successfully (empty result *
+ *                         being counted as successful query)                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_jsonpath_query(const struct trx_json_parse *jp, const char *path, char **output)
+{
+	trx_jsonpath_t	jsonpath;
+	int		ret;
+
+	if (FAIL == trx_jsonpath_compile(path, &jsonpath))
+		return FAIL;
+
+	ret = trx_jsonpath_query_compiled(jp, &jsonpath, NULL, output);
 	trx_jsonpath_clear(&jsonpath);
 
 	return ret;
@@ -75,6 +75,8 @@ extern int	CONFIG_UNREACHABLE_POLLER_FORKS;
 extern int	CONFIG_IPMIPOLLER_FORKS;
 extern int	CONFIG_PINGER_FORKS;
 extern int	CONFIG_JAVAPOLLER_FORKS;
+extern int	CONFIG_AGENTPOLLER_FORKS;
+extern int	CONFIG_HTTPAGENT_POLLER_FORKS;
 extern int	CONFIG_HTTPPOLLER_FORKS;
 extern int	CONFIG_TRAPPER_FORKS;
 extern int	CONFIG_SNMPTRAPPER_FORKS;
@@ -184,6 +186,10 @@ int	get_process_type_forks(unsigned char proc_type)
 			return CONFIG_LLDWORKER_FORKS;
 		case TRX_PROCESS_TYPE_ALERTSYNCER:
 			return CONFIG_ALERTDB_FORKS;
+		case TRX_PROCESS_TYPE_AGENTPOLLER:
+			return CONFIG_AGENTPOLLER_FORKS;
+		case TRX_PROCESS_TYPE_HTTPAGENT_POLLER:
+			return CONFIG_HTTPAGENT_POLLER_FORKS;
 	}
 
 	THIS_SHOULD_NEVER_HAPPEN;
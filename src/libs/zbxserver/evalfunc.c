@@ -2599,6 +2599,121 @@ out:
 	return ret;
 }
 
+/* the history range of a function evaluation */
+typedef struct
+{
+	const char	*name;
+	/* the number of parameter defining evaluation period (sec or #num), 0 if the period is fixed */
+	int		period_param;
+	/* the number of time shift parameter, 0 if time shift is not supported */
+	int		shift_param;
+	/* the number of values used if the period parameter is not set or is not #num */
+	int		count;
+}
+trx_function_history_t;
+
+static const trx_function_history_t	function_history[] = {
+	{"last",	1,	2,	1},
+	{"prev",	0,	0,	2},
+	{"min",		1,	2,	0},
+	{"max",		1,	2,	0},
+	{"avg",		1,	2,	0},
+	{"sum",		1,	2,	0},
+	{"percentile",	1,	2,	0},
+	{"count",	1,	4,	0},
+	{"delta",	1,	2,	0},
+	{"forecast",	1,	2,	0},
+	{"timeleft",	1,	2,	0},
+	{"abschange",	0,	0,	2},
+	{"change",	0,	0,	2},
+	{"diff",	0,	0,	2},
+	{"fuzzytime",	0,	0,	1},
+	{"logeventid",	0,	0,	1},
+	{"logseverity",	0,	0,	1},
+	{"logsource",	0,	0,	1},
+	{NULL}
+};
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_function_history_range                                       *
+ *                                                                            *
+ * Purpose: gets the item history range a function will request from value    *
+ *          cache when evaluated                                              *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             function  - [IN] the function name                             *
+ *             parameter - [IN] the function parameters                       *
+ *             ts        - [IN] the evaluation timestamp                      *
+ *             seconds   - [OUT] the requested period                         *
+ *             count     - [OUT] the requested number of values               *
+ *             ts_end    - [OUT] the requested period end timestamp           *
+ *                                                                            *
+ * Return value: SUCCEED - the function reads item history                    *
+ *               FAIL    - the function does not read item history or its     *
+ *                         parameters are invalid                             *
+ *                                                                            *
+ * Comments: The range is used to load history of many items into value       *
+ *           cache at once before evaluating functions one by one, so the     *
+ *           parameters are not fully validated here.                         *
+ *                                                                            *
+ ******************************************************************************/
+int	get_function_history_range(const DC_ITEM *item, const char *function, const char *parameter,
+		const trx_timespec_t *ts, int *seconds, int *count, trx_timespec_t *ts_end)
+{
+	const trx_function_history_t	*fh;
+	int				arg1 = 0, time_shift = 0;
+	trx_value_type_t		arg1_type = TRX_VALUE_SECONDS, time_shift_type = TRX_VALUE_SECONDS;
+
+	for (fh = function_history; NULL != fh->name; fh++)
+	{
+		if (0 == strcmp(fh->name, function))
+			break;
+	}
+
+	if (NULL == fh->name)
+		return FAIL;
+
+	*seconds = 0;
+	*count = fh->count;
+	*ts_end = *ts;
+
+	if (0 != fh->period_param)
+	{
+		if (SUCCEED != get_function_parameter_int(item->host.hostid, parameter, fh->period_param,
+				TRX_PARAM_OPTIONAL, &arg1, &arg1_type))
+		{
+			return FAIL;
+		}
+
+		if (TRX_VALUE_NVALUES == arg1_type)
+		{
+			*count = arg1;
+		}
+		else if (0 == fh->count)
+		{
+			if (0 >= arg1)
+				return FAIL;
+
+			*seconds = arg1;
+		}
+	}
+
+	if (0 != fh->shift_param && fh->shift_param <= num_param(parameter))
+	{
+		if (SUCCEED != get_function_parameter_int(item->host.hostid, parameter, fh->shift_param,
+				TRX_PARAM_OPTIONAL, &time_shift, &time_shift_type) ||
+				TRX_VALUE_SECONDS != time_shift_type || 0 > time_shift)
+		{
+			return FAIL;
+		}
+
+		ts_end->sec -= time_shift;
+	}
+
+	return 0 != *seconds || 0 != *count ? SUCCEED : FAIL;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: evaluate_function                                                *
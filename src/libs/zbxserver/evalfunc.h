@@ -6,5 +6,7 @@
 int	evaluate_macro_function(char **result, const char *host, const char *key, const char *function,
 		const char *parameter);
 int	evaluatable_for_notsupported(const char *fn);
+int	get_function_history_range(const DC_ITEM *item, const char *function, const char *parameter,
+		const trx_timespec_t *ts, int *seconds, int *count, trx_timespec_t *ts_end);
 
 #endif
@@ -4875,6 +4875,64 @@ static void	trx_populate_function_items(const trx_vector_uint64_t *functionids,
 	treegix_log(LOG_LEVEL_DEBUG, "End of %s() ifuncs_num:%d", __func__, ifuncs->num_data);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_cache_item_functions_history                                 *
+ *                                                                            *
+ * Purpose: loads history required to evaluate functions into value cache     *
+ *                                                                            *
+ * Parameters: funcs    - [IN] the functions to evaluate                      *
+ *             itemids  - [IN] the function item identifiers, sorted          *
+ *             items    - [IN] the function items                             *
+ *             errcodes - [IN] the item retrieval error codes                 *
+ *                                                                            *
+ * Comments: History missing in value cache is read with a query per batch of *
+ *           items rather than a query per function, which matters when       *
+ *           triggers of many items are evaluated with cold value cache.      *
+ *                                                                            *
+ ******************************************************************************/
+static void	trx_cache_item_functions_history(trx_hashset_t *funcs, const trx_vector_uint64_t *itemids,
+		const DC_ITEM *items, const int *errcodes)
+{
+	trx_vc_request_t	*requests;
+	int			i, requests_num = 0;
+	trx_func_t		*func;
+	trx_hashset_iter_t	iter;
+
+	requests = (trx_vc_request_t *)trx_malloc(NULL, sizeof(trx_vc_request_t) * (size_t)funcs->num_data);
+
+	trx_hashset_iter_reset(funcs, &iter);
+	while (NULL != (func = (trx_func_t *)trx_hashset_iter_next(&iter)))
+	{
+		trx_vc_request_t	*request = &requests[requests_num];
+
+		i = trx_vector_uint64_bsearch(itemids, func->itemid, TRX_DEFAULT_UINT64_COMPARE_FUNC);
+
+		if (SUCCEED != errcodes[i] || ITEM_STATUS_ACTIVE != items[i].status ||
+				HOST_STATUS_MONITORED != items[i].host.status ||
+				ITEM_STATE_NOTSUPPORTED == items[i].state)
+		{
+			continue;
+		}
+
+		if (SUCCEED != get_function_history_range(&items[i], func->function, func->parameter,
+				&func->timespec, &request->seconds, &request->count, &request->ts))
+		{
+			continue;
+		}
+
+		request->itemid = items[i].itemid;
+		request->value_type = items[i].value_type;
+		request->values = NULL;
+		requests_num++;
+	}
+
+	if (1 < requests_num)
+		trx_vc_get_values_multi(requests, requests_num);
+
+	trx_free(requests);
+}
+
 static void	trx_evaluate_item_functions(trx_hashset_t *funcs, trx_vector_ptr_t *unknown_msgs)
 {
 	DC_ITEM			*items = NULL;
@@ -4902,6 +4960,8 @@ static void	trx_evaluate_item_functions(trx_hashset_t *funcs, trx_vector_ptr_t *
 
 	DCconfig_get_items_by_itemids(items, itemids.values, errcodes, itemids.values_num);
 
+	trx_cache_item_functions_history(funcs, &itemids, items, errcodes);
+
 	trx_hashset_iter_reset(funcs, &iter);
 	while (NULL != (func = (trx_func_t *)trx_hashset_iter_next(&iter)))
 	{
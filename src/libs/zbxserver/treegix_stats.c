@@ -61,6 +61,7 @@ void	trx_get_treegix_stats(struct trx_json *json)
 	trx_json_addfloat(json, "pfree", *(double *)DCconfig_get_stats(TRX_CONFSTATS_BUFFER_PFREE));
 	trx_json_adduint64(json, "used", *(trx_uint64_t *)DCconfig_get_stats(TRX_CONFSTATS_BUFFER_USED));
 	trx_json_addfloat(json, "pused", *(double *)DCconfig_get_stats(TRX_CONFSTATS_BUFFER_PUSED));
+	trx_json_addfloat(json, "lock_max", *(double *)DCconfig_get_stats(TRX_CONFSTATS_SYNC_LOCK_MAX));
 	trx_json_close(json);
 
 	/* treegix[wcache,<cache>,<mode>] */
@@ -95,6 +96,11 @@ void	trx_get_treegix_stats(struct trx_json *json)
 			wcache_info.index_total);
 	trx_json_close(json);
 
+	trx_json_addobject(json, "sync");
+	trx_json_adduint64(json, "batch", wcache_info.sync_batch);
+	trx_json_addfloat(json, "latency", wcache_info.sync_latency);
+	trx_json_close(json);
+
 	if (0 != (program_type & TRX_PROGRAM_TYPE_SERVER))
 	{
 		trx_json_addobject(json, "trend");
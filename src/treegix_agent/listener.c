@@ -9,6 +9,7 @@
 #include "stats.h"
 #include "sysinfo.h"
 #include "log.h"
+#include "trxjson.h"
 
 extern unsigned char			program_type;
 extern TRX_THREAD_LOCAL unsigned char	process_type;
@@ -23,61 +24,243 @@ extern TRX_THREAD_LOCAL int		server_num, process_num;
 #include "../libs/trxcrypto/tls.h"
 #include "../libs/trxcrypto/tls_tcp_active.h"
 
-static void	process_listener(trx_socket_t *s)
+/* the maximum time connection kept open by server waits for the next batch of passive checks, seconds */
+#define TRX_PASSIVE_CHECKS_IDLE_TIMEOUT	3
+
+/******************************************************************************
+ *                                                                            *
+ * Function: process_passive_check                                            *
+ *                                                                            *
+ * Purpose: process single key request and send back its value                *
+ *                                                                            *
+ * Parameters: s   - [IN] the connection to server                            *
+ *             key - [IN] the requested item key                              *
+ *                                                                            *
+ * Return value: SUCCEED - the value was sent or there is nothing to send     *
+ *               FAIL    - the value could not be sent                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	process_passive_check(trx_socket_t *s, const char *key)
 {
 	AGENT_RESULT	result;
 	char		**value = NULL;
-	int		ret;
+	int		ret = SUCCEED;
+
+	init_result(&result);
 
-	if (SUCCEED == (ret = trx_tcp_recv_to(s, CONFIG_TIMEOUT)))
+	if (SUCCEED == process(key, PROCESS_WITH_ALIAS, &result))
 	{
-		trx_rtrim(s->buffer, "\r\n");
+		if (NULL != (value = GET_TEXT_RESULT(&result)))
+		{
+			treegix_log(LOG_LEVEL_DEBUG, "Sending back [%s]", *value);
+			ret = trx_tcp_send_to(s, *value, CONFIG_TIMEOUT);
+		}
+	}
+	else
+	{
+		value = GET_MSG_RESULT(&result);
+
+		if (NULL != value)
+		{
+			static char	*buffer = NULL;
+			static size_t	buffer_alloc = 256;
+			size_t		buffer_offset = 0;
 
-		treegix_log(LOG_LEVEL_DEBUG, "Requested [%s]", s->buffer);
+			treegix_log(LOG_LEVEL_DEBUG, "Sending back [" TRX_NOTSUPPORTED ": %s]", *value);
+
+			if (NULL == buffer)
+				buffer = (char *)trx_malloc(buffer, buffer_alloc);
+
+			trx_strncpy_alloc(&buffer, &buffer_alloc, &buffer_offset,
+					TRX_NOTSUPPORTED, TRX_CONST_STRLEN(TRX_NOTSUPPORTED));
+			buffer_offset++;
+			trx_strcpy_alloc(&buffer, &buffer_alloc, &buffer_offset, *value);
+
+			ret = trx_tcp_send_bytes_to(s, buffer, buffer_offset, CONFIG_TIMEOUT);
+		}
+		else
+		{
+			treegix_log(LOG_LEVEL_DEBUG, "Sending back [" TRX_NOTSUPPORTED "]");
+
+			ret = trx_tcp_send_to(s, TRX_NOTSUPPORTED, CONFIG_TIMEOUT);
+		}
+	}
+
+	free_result(&result);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: is_passive_checks_request                                        *
+ *                                                                            *
+ * Purpose: check if the received data is a batch of passive checks           *
+ *                                                                            *
+ * Comments: Item keys cannot start with '{', so plain key requests are never *
+ *           mistaken for JSON ones.                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	is_passive_checks_request(const char *data, struct trx_json_parse *jp)
+{
+	char	request[MAX_STRING_LEN];
+
+	if ('{' != *data || SUCCEED != trx_json_open(data, jp))
+		return FAIL;
+
+	if (SUCCEED != trx_json_value_by_name(jp, TRX_PROTO_TAG_REQUEST, request, sizeof(request)) ||
+			0 != strcmp(request, TRX_PROTO_VALUE_PASSIVE_CHECKS))
+	{
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: process_passive_checks                                           *
+ *                                                                            *
+ * Purpose: process batch of passive checks and send back values in the       *
+ *          order of requested keys                                           *
+ *                                                                            *
+ * Parameters: s  - [IN] the connection to server                             *
+ *             jp - [IN] the request                                          *
+ *                                                                            *
+ * Return value: SUCCEED - the response was sent                              *
+ *               FAIL    - the response could not be sent                     *
+ *                                                                            *
+ * Comments: request:                                                         *
+ *             {"request":"passive checks","data":[{"key":"..."},...]}        *
+ *           response:                                                        *
+ *             {"response":"success","data":[{"value":"..."},                 *
+ *                     {"error":"..."},...]}                                  *
+ *           Keys are not processed after Timeout seconds since the start of  *
+ *           the batch, they are answered with error instead, so the whole    *
+ *           batch takes at most twice the Timeout.                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	process_passive_checks(trx_socket_t *s, const struct trx_json_parse *jp)
+{
+	struct trx_json_parse	jp_data, jp_row;
+	struct trx_json		j;
+	AGENT_RESULT		result;
+	const char		*p = NULL;
+	char			*key = NULL, **value;
+	size_t			key_alloc = 0;
+	int			ret;
+	time_t			start;
+
+	start = time(NULL);
+	trx_json_init(&j, TRX_JSON_STAT_BUF_LEN);
+
+	if (SUCCEED != trx_json_brackets_by_name(jp, TRX_PROTO_TAG_DATA, &jp_data))
+	{
+		trx_json_addstring(&j, TRX_PROTO_TAG_RESPONSE, TRX_PROTO_VALUE_FAILED, TRX_JSON_TYPE_STRING);
+		trx_json_addstring(&j, TRX_PROTO_TAG_INFO, trx_json_strerror(), TRX_JSON_TYPE_STRING);
+		goto out;
+	}
+
+	trx_json_addstring(&j, TRX_PROTO_TAG_RESPONSE, TRX_PROTO_VALUE_SUCCESS, TRX_JSON_TYPE_STRING);
+	trx_json_addarray(&j, TRX_PROTO_TAG_DATA);
+
+	while (NULL != (p = trx_json_next(&jp_data, p)))
+	{
+		trx_json_addobject(&j, NULL);
+
+		if (SUCCEED != trx_json_brackets_open(p, &jp_row) ||
+				SUCCEED != trx_json_value_by_name_dyn(&jp_row, TRX_PROTO_TAG_KEY, &key, &key_alloc))
+		{
+			trx_json_addstring(&j, TRX_PROTO_TAG_ERROR, "Cannot parse item key.", TRX_JSON_TYPE_STRING);
+			trx_json_close(&j);
+			continue;
+		}
+
+		treegix_log(LOG_LEVEL_DEBUG, "Requested [%s]", key);
+
+		if (CONFIG_TIMEOUT <= time(NULL) - start)
+		{
+			trx_json_addstring(&j, TRX_PROTO_TAG_ERROR, "Timeout while processing batch of passive checks.",
+					TRX_JSON_TYPE_STRING);
+			trx_json_close(&j);
+			continue;
+		}
 
 		init_result(&result);
 
-		if (SUCCEED == process(s->buffer, PROCESS_WITH_ALIAS, &result))
+		if (SUCCEED == process(key, PROCESS_WITH_ALIAS, &result) && NULL != (value = GET_TEXT_RESULT(&result)))
 		{
-			if (NULL != (value = GET_TEXT_RESULT(&result)))
-			{
-				treegix_log(LOG_LEVEL_DEBUG, "Sending back [%s]", *value);
-				ret = trx_tcp_send_to(s, *value, CONFIG_TIMEOUT);
-			}
+			trx_json_addstring(&j, TRX_PROTO_TAG_VALUE, *value, TRX_JSON_TYPE_STRING);
 		}
 		else
 		{
 			value = GET_MSG_RESULT(&result);
+			trx_json_addstring(&j, TRX_PROTO_TAG_ERROR, NULL != value ? *value :
+					"Not supported by Treegix Agent", TRX_JSON_TYPE_STRING);
+		}
 
-			if (NULL != value)
-			{
-				static char	*buffer = NULL;
-				static size_t	buffer_alloc = 256;
-				size_t		buffer_offset = 0;
+		free_result(&result);
+		trx_json_close(&j);
+	}
+
+	trx_free(key);
+out:
+	treegix_log(LOG_LEVEL_DEBUG, "Sending back [%s]", j.buffer);
 
-				treegix_log(LOG_LEVEL_DEBUG, "Sending back [" TRX_NOTSUPPORTED ": %s]", *value);
+	ret = trx_tcp_send_to(s, j.buffer, CONFIG_TIMEOUT);
+	trx_json_free(&j);
 
-				if (NULL == buffer)
-					buffer = (char *)trx_malloc(buffer, buffer_alloc);
+	return ret;
+}
 
-				trx_strncpy_alloc(&buffer, &buffer_alloc, &buffer_offset,
-						TRX_NOTSUPPORTED, TRX_CONST_STRLEN(TRX_NOTSUPPORTED));
-				buffer_offset++;
-				trx_strcpy_alloc(&buffer, &buffer_alloc, &buffer_offset, *value);
+/******************************************************************************
+ *                                                                            *
+ * Function: process_listener                                                 *
+ *                                                                            *
+ * Purpose: process server requests on accepted connection                    *
+ *                                                                            *
+ * Comments: Plain key request is answered and the connection is closed.      *
+ *           Server sending batches of passive checks keeps the connection    *
+ *           open for the next batch, it is closed when server does not send  *
+ *           anything for a few seconds (but not longer than Timeout), so     *
+ *           idle connections do not hold the listener.                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	process_listener(trx_socket_t *s)
+{
+	struct trx_json_parse	jp;
+	int			ret;
 
-				ret = trx_tcp_send_bytes_to(s, buffer, buffer_offset, CONFIG_TIMEOUT);
-			}
-			else
-			{
-				treegix_log(LOG_LEVEL_DEBUG, "Sending back [" TRX_NOTSUPPORTED "]");
+	if (SUCCEED != (ret = trx_tcp_recv_to(s, CONFIG_TIMEOUT)))
+		goto out;
 
-				ret = trx_tcp_send_to(s, TRX_NOTSUPPORTED, CONFIG_TIMEOUT);
-			}
-		}
+	trx_rtrim(s->buffer, "\r\n");
 
-		free_result(&result);
+	treegix_log(LOG_LEVEL_DEBUG, "Requested [%s]", s->buffer);
+
+	if (SUCCEED != is_passive_checks_request(s->buffer, &jp))
+	{
+		ret = process_passive_check(s, s->buffer);
+		goto out;
 	}
 
+	while (SUCCEED == (ret = process_passive_checks(s, &jp)))
+	{
+		trx_setproctitle("listener #%d [waiting for next request]", process_num);
+
+		/* idle connection timing out or being closed by server is not an error */
+		if (0 >= trx_tcp_recv_ext(s, MIN(CONFIG_TIMEOUT, TRX_PASSIVE_CHECKS_IDLE_TIMEOUT)))
+			break;
+
+		trx_setproctitle("listener #%d [processing request]", process_num);
+
+		if (SUCCEED != is_passive_checks_request(s->buffer, &jp))
+		{
+			treegix_log(LOG_LEVEL_DEBUG, "unexpected request on persistent connection: [%s]", s->buffer);
+			break;
+		}
+	}
+out:
 	if (FAIL == ret)
 		treegix_log(LOG_LEVEL_DEBUG, "Process listener error: %s", trx_socket_strerror());
 }
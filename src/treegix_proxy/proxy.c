@@ -27,6 +27,7 @@
 #include "housekeeper/housekeeper.h"
 #include "../treegix_server/pinger/pinger.h"
 #include "../treegix_server/poller/poller.h"
+#include "../treegix_server/poller/async_poller.h"
 #include "../treegix_server/trapper/trapper.h"
 #include "../treegix_server/trapper/proxydata.h"
 #include "../treegix_server/snmptrapper/snmptrapper.h"
@@ -41,6 +42,7 @@
 #include "trxipcservice.h"
 #include "../treegix_server/preprocessor/preproc_manager.h"
 #include "../treegix_server/preprocessor/preproc_worker.h"
+#include "preproc.h"
 
 
 #ifdef HAVE_OPENIPMI
@@ -79,12 +81,14 @@ const char	*help_message[] = {
 	"",
 	"      Log level control targets:",
 	"        process-type             All processes of specified type",
-	"                                 (configuration syncer, data sender, discoverer,",
-	"                                 heartbeat sender, history syncer, housekeeper,",
-	"                                 http poller, icmp pinger, ipmi manager,",
-	"                                 ipmi poller, java poller, poller,",
-	"                                 self-monitoring, snmp trapper, task manager,",
-	"                                 trapper, unreachable poller, vmware collector)",
+	"                                 (agent poller, configuration syncer,",
+	"                                 data sender, discoverer, heartbeat sender,",
+	"                                 history syncer, housekeeper,",
+	"                                 http agent poller, http poller, icmp pinger,",
+	"                                 ipmi manager, ipmi poller,",
+	"                                 java poller, poller, self-monitoring,",
+	"                                 snmp trapper, task manager, trapper,",
+	"                                 unreachable poller, vmware collector)",
 	"        process-type,N           Process type and number (e.g., poller,3)",
 	"        pid                      Process identifier, up to 65535. For larger",
 	"                                 values specify target as \"process-type,N\"",
@@ -142,6 +146,8 @@ int	CONFIG_IPMIPOLLER_FORKS		= 0;
 int	CONFIG_TRAPPER_FORKS		= 5;
 int	CONFIG_SNMPTRAPPER_FORKS	= 0;
 int	CONFIG_JAVAPOLLER_FORKS		= 0;
+int	CONFIG_AGENTPOLLER_FORKS	= 0;
+int	CONFIG_HTTPAGENT_POLLER_FORKS	= 0;
 int	CONFIG_SELFMON_FORKS		= 1;
 int	CONFIG_PROXYPOLLER_FORKS	= 0;
 int	CONFIG_ESCALATOR_FORKS		= 0;
@@ -160,6 +166,10 @@ int	CONFIG_LLDMANAGER_FORKS		= 0;
 int	CONFIG_LLDWORKER_FORKS		= 0;
 int	CONFIG_ALERTDB_FORKS		= 0;
 
+int	CONFIG_MAX_CONCURRENT_CHECKS_PER_POLLER		= 1000;
+int	CONFIG_MAX_CONCURRENT_CHECKS_PER_INTERFACE	= 3;
+int	CONFIG_MAX_CONCURRENT_HTTP_CHECKS_PER_HOST	= 10;
+
 int	CONFIG_LISTEN_PORT		= TRX_DEFAULT_SERVER_PORT;
 char	*CONFIG_LISTEN_IP		= NULL;
 char	*CONFIG_SOURCE_IP		= NULL;
@@ -186,8 +196,13 @@ int	CONFIG_VMWARE_TIMEOUT		= 10;
 trx_uint64_t	CONFIG_CONF_CACHE_SIZE		= 8 * TRX_MEBIBYTE;
 trx_uint64_t	CONFIG_HISTORY_CACHE_SIZE	= 16 * TRX_MEBIBYTE;
 trx_uint64_t	CONFIG_HISTORY_INDEX_CACHE_SIZE	= 4 * TRX_MEBIBYTE;
+int		CONFIG_HISTORY_CACHE_SHARDS	= 1;
+trx_uint64_t	CONFIG_HISTORY_RING_SIZE	= 0;
+trx_uint64_t	CONFIG_PREPROCESSING_RING_SIZE	= 0;
 trx_uint64_t	CONFIG_TRENDS_CACHE_SIZE	= 0;
 trx_uint64_t	CONFIG_VALUE_CACHE_SIZE		= 0;
+char		*CONFIG_VALUE_CACHE_SNAPSHOT_FILE	= NULL;
+int		CONFIG_VALUE_CACHE_SNAPSHOT_FREQUENCY	= 0;
 trx_uint64_t	CONFIG_VMWARE_CACHE_SIZE	= 8 * TRX_MEBIBYTE;
 trx_uint64_t	CONFIG_EXPORT_FILE_SIZE;
 
@@ -259,6 +274,9 @@ static char	*CONFIG_SOCKET_PATH	= NULL;
 char	*CONFIG_HISTORY_STORAGE_URL		= NULL;
 char	*CONFIG_HISTORY_STORAGE_OPTS		= NULL;
 int	CONFIG_HISTORY_STORAGE_PIPELINES	= 0;
+char	*CONFIG_HISTORY_STORAGE_PATH		= NULL;
+int	CONFIG_HISTORY_STORAGE_RETENTION	= 0;
+int	CONFIG_HISTORY_PIPELINING		= 0;
 
 char	*CONFIG_STATS_ALLOWED_IP	= NULL;
 
@@ -323,6 +341,16 @@ int	get_process_info_by_thread(int local_server_num, unsigned char *local_proces
 		*local_process_type = TRX_PROCESS_TYPE_JAVAPOLLER;
 		*local_process_num = local_server_num - server_count + CONFIG_JAVAPOLLER_FORKS;
 	}
+	else if (local_server_num <= (server_count += CONFIG_AGENTPOLLER_FORKS))
+	{
+		*local_process_type = TRX_PROCESS_TYPE_AGENTPOLLER;
+		*local_process_num = local_server_num - server_count + CONFIG_AGENTPOLLER_FORKS;
+	}
+	else if (local_server_num <= (server_count += CONFIG_HTTPAGENT_POLLER_FORKS))
+	{
+		*local_process_type = TRX_PROCESS_TYPE_HTTPAGENT_POLLER;
+		*local_process_num = local_server_num - server_count + CONFIG_HTTPAGENT_POLLER_FORKS;
+	}
 	else if (local_server_num <= (server_count += CONFIG_SNMPTRAPPER_FORKS))
 	{
 		*local_process_type = TRX_PROCESS_TYPE_SNMPTRAPPER;
@@ -501,10 +529,40 @@ static void	trx_validate_config(TRX_TASK_EX *task)
 		err = 1;
 	}
 
-	if (0 == CONFIG_UNREACHABLE_POLLER_FORKS && 0 != CONFIG_POLLER_FORKS + CONFIG_JAVAPOLLER_FORKS)
+	if (0 == CONFIG_UNREACHABLE_POLLER_FORKS &&
+			0 != CONFIG_POLLER_FORKS + CONFIG_JAVAPOLLER_FORKS + CONFIG_AGENTPOLLER_FORKS)
 	{
 		treegix_log(LOG_LEVEL_CRIT, "\"StartPollersUnreachable\" configuration parameter must not be 0"
-				" if regular or Java pollers are started");
+				" if regular, agent or Java pollers are started");
+		err = 1;
+	}
+
+	if (128 * TRX_KIBIBYTE > CONFIG_HISTORY_CACHE_SIZE / CONFIG_HISTORY_CACHE_SHARDS ||
+			128 * TRX_KIBIBYTE > CONFIG_HISTORY_INDEX_CACHE_SIZE / CONFIG_HISTORY_CACHE_SHARDS)
+	{
+		treegix_log(LOG_LEVEL_CRIT, "\"HistoryCacheSize\" and \"HistoryIndexCacheSize\" configuration parameters"
+				" must be at least 128KB per each of \"HistoryCacheShards\" shards");
+		err = 1;
+	}
+
+	if (0 != CONFIG_HISTORY_RING_SIZE && TRX_MEBIBYTE > CONFIG_HISTORY_RING_SIZE)
+	{
+		treegix_log(LOG_LEVEL_CRIT, "\"HistoryRingSize\" configuration parameter must be either 0"
+				" or greater than 1MB");
+		err = 1;
+	}
+
+	if (0 != CONFIG_PREPROCESSING_RING_SIZE && TRX_MEBIBYTE > CONFIG_PREPROCESSING_RING_SIZE)
+	{
+		treegix_log(LOG_LEVEL_CRIT, "\"PreprocessingRingSize\" configuration parameter must be either 0"
+				" or greater than 1MB");
+		err = 1;
+	}
+
+	if (CONFIG_PREPROCMAN_FORKS > CONFIG_PREPROCESSOR_FORKS)
+	{
+		treegix_log(LOG_LEVEL_CRIT, "\"StartPreprocessingManagers\" configuration parameter must not be"
+				" greater than \"StartPreprocessors\"");
 		err = 1;
 	}
 
@@ -623,6 +681,16 @@ static void	trx_load_config(TRX_TASK_EX *task)
 			PARM_OPT,	0,			1000},
 		{"StartJavaPollers",		&CONFIG_JAVAPOLLER_FORKS,		TYPE_INT,
 			PARM_OPT,	0,			1000},
+		{"StartAgentPollers",		&CONFIG_AGENTPOLLER_FORKS,		TYPE_INT,
+			PARM_OPT,	0,			1000},
+		{"StartHTTPAgentPollers",	&CONFIG_HTTPAGENT_POLLER_FORKS,	TYPE_INT,
+			PARM_OPT,	0,			1000},
+		{"MaxConcurrentChecksPerPoller",	&CONFIG_MAX_CONCURRENT_CHECKS_PER_POLLER,	TYPE_INT,
+			PARM_OPT,	1,			10000},
+		{"MaxConcurrentChecksPerInterface",	&CONFIG_MAX_CONCURRENT_CHECKS_PER_INTERFACE,	TYPE_INT,
+			PARM_OPT,	1,			1000},
+		{"MaxConcurrentHTTPChecksPerHost",	&CONFIG_MAX_CONCURRENT_HTTP_CHECKS_PER_HOST,	TYPE_INT,
+			PARM_OPT,	1,			1000},
 		{"JavaGateway",			&CONFIG_JAVA_GATEWAY,			TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"JavaGatewayPort",		&CONFIG_JAVA_GATEWAY_PORT,		TYPE_INT,
@@ -637,6 +705,10 @@ static void	trx_load_config(TRX_TASK_EX *task)
 			PARM_OPT,	128 * TRX_KIBIBYTE,	__UINT64_C(2) * TRX_GIBIBYTE},
 		{"HistoryIndexCacheSize",	&CONFIG_HISTORY_INDEX_CACHE_SIZE,	TYPE_UINT64,
 			PARM_OPT,	128 * TRX_KIBIBYTE,	__UINT64_C(2) * TRX_GIBIBYTE},
+		{"HistoryCacheShards",		&CONFIG_HISTORY_CACHE_SHARDS,		TYPE_INT,
+			PARM_OPT,	1,			16},
+		{"HistoryRingSize",		&CONFIG_HISTORY_RING_SIZE,		TYPE_UINT64,
+			PARM_OPT,	0,			__UINT64_C(1) * TRX_GIBIBYTE},
 		{"HousekeepingFrequency",	&CONFIG_HOUSEKEEPING_FREQUENCY,		TYPE_INT,
 			PARM_OPT,	0,			24},
 		{"ProxyLocalBuffer",		&CONFIG_PROXY_LOCAL_BUFFER,		TYPE_INT,
@@ -755,6 +827,10 @@ static void	trx_load_config(TRX_TASK_EX *task)
 			PARM_OPT,	0,			0},
 		{"StartPreprocessors",		&CONFIG_PREPROCESSOR_FORKS,		TYPE_INT,
 			PARM_OPT,	1,			1000},
+		{"StartPreprocessingManagers",	&CONFIG_PREPROCMAN_FORKS,		TYPE_INT,
+			PARM_OPT,	1,			100},
+		{"PreprocessingRingSize",	&CONFIG_PREPROCESSING_RING_SIZE,	TYPE_UINT64,
+			PARM_OPT,	0,			__UINT64_C(1) * TRX_GIBIBYTE},
 		{NULL}
 	};
 
@@ -1006,6 +1082,13 @@ int	MAIN_TREEGIX_ENTRY(int flags)
 		exit(EXIT_FAILURE);
 	}
 
+	if (SUCCEED != trx_preprocessor_init_rings(&error))
+	{
+		treegix_log(LOG_LEVEL_CRIT, "cannot initialize preprocessing rings: %s", error);
+		trx_free(error);
+		exit(EXIT_FAILURE);
+	}
+
 	if (SUCCEED != init_selfmon_collector(&error))
 	{
 		treegix_log(LOG_LEVEL_CRIT, "cannot initialize self-monitoring: %s", error);
@@ -1053,7 +1136,8 @@ int	MAIN_TREEGIX_ENTRY(int flags)
 			+ CONFIG_DISCOVERER_FORKS + CONFIG_HISTSYNCER_FORKS + CONFIG_IPMIPOLLER_FORKS
 			+ CONFIG_JAVAPOLLER_FORKS + CONFIG_SNMPTRAPPER_FORKS + CONFIG_SELFMON_FORKS
 			+ CONFIG_VMWARE_FORKS + CONFIG_IPMIMANAGER_FORKS + CONFIG_TASKMANAGER_FORKS
-			+ CONFIG_PREPROCMAN_FORKS + CONFIG_PREPROCESSOR_FORKS;
+			+ CONFIG_PREPROCMAN_FORKS + CONFIG_PREPROCESSOR_FORKS + CONFIG_AGENTPOLLER_FORKS
+			+ CONFIG_HTTPAGENT_POLLER_FORKS;
 
 	threads = (pid_t *)trx_calloc(threads, threads_num, sizeof(pid_t));
 	threads_flags = (int *)trx_calloc(threads_flags, threads_num, sizeof(int));
@@ -1132,6 +1216,16 @@ int	MAIN_TREEGIX_ENTRY(int flags)
 				thread_args.args = &poller_type;
 				trx_thread_start(poller_thread, &thread_args, &threads[i]);
 				break;
+			case TRX_PROCESS_TYPE_AGENTPOLLER:
+				poller_type = TRX_POLLER_TYPE_AGENT;
+				thread_args.args = &poller_type;
+				trx_thread_start(async_poller_thread, &thread_args, &threads[i]);
+				break;
+			case TRX_PROCESS_TYPE_HTTPAGENT_POLLER:
+				poller_type = TRX_POLLER_TYPE_HTTPAGENT;
+				thread_args.args = &poller_type;
+				trx_thread_start(async_poller_thread, &thread_args, &threads[i]);
+				break;
 			case TRX_PROCESS_TYPE_SNMPTRAPPER:
 				trx_thread_start(snmptrapper_thread, &thread_args, &threads[i]);
 				break;
@@ -10,8 +10,11 @@
 #include "dbcache.h"
 #include "dbsyncer.h"
 #include "export.h"
+#include "../../libs/trxdbcache/valuecache.h"
 
 extern int		CONFIG_HISTSYNCER_FREQUENCY;
+extern char		*CONFIG_VALUE_CACHE_SNAPSHOT_FILE;
+extern int		CONFIG_VALUE_CACHE_SNAPSHOT_FREQUENCY;
 extern unsigned char	process_type, program_type;
 extern int		server_num, process_num;
 static sigset_t		orig_mask;
@@ -66,7 +69,7 @@ TRX_THREAD_ENTRY(dbsyncer_thread, args)
 {
 	int		sleeptime = -1, total_values_num = 0, values_num, more, total_triggers_num = 0, triggers_num;
 	double		sec, total_sec = 0.0;
-	time_t		last_stat_time;
+	time_t		last_stat_time, last_snapshot_time;
 	char		*stats = NULL;
 	const char	*process_name;
 	size_t		stats_alloc = 0, stats_offset = 0;
@@ -82,7 +85,7 @@ TRX_THREAD_ENTRY(dbsyncer_thread, args)
 				/* once in STAT_INTERVAL seconds */
 
 	trx_setproctitle("%s #%d [connecting to the database]", process_name, process_num);
-	last_stat_time = time(NULL);
+	last_stat_time = last_snapshot_time = time(NULL);
 
 	trx_strcpy_alloc(&stats, &stats_alloc, &stats_offset, "started");
 
@@ -147,6 +150,24 @@ TRX_THREAD_ENTRY(dbsyncer_thread, args)
 			last_stat_time = time(NULL);
 		}
 
+		/* the first history syncer periodically saves value cache snapshot */
+		if (1 == process_num && NULL != CONFIG_VALUE_CACHE_SNAPSHOT_FILE &&
+				0 != CONFIG_VALUE_CACHE_SNAPSHOT_FREQUENCY && TRX_IS_RUNNING() &&
+				CONFIG_VALUE_CACHE_SNAPSHOT_FREQUENCY <= time(NULL) - last_snapshot_time)
+		{
+			char	*error = NULL;
+
+			trx_setproctitle("%s #%d [%s, saving value cache snapshot]", process_name, process_num, stats);
+
+			if (SUCCEED != trx_vc_save_snapshot(CONFIG_VALUE_CACHE_SNAPSHOT_FILE, &error))
+			{
+				treegix_log(LOG_LEVEL_WARNING, "cannot save value cache snapshot: %s", error);
+				trx_free(error);
+			}
+
+			last_snapshot_time = time(NULL);
+		}
+
 		if (TRX_SYNC_MORE == more)
 			continue;
 
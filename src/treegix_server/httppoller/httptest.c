@@ -686,6 +686,10 @@ static void	process_httptest(DC_HOST *host, trx_httptest_t *httptest)
 		goto clean;
 	}
 
+	/* cookies stay in the scenario handle, only connections and resolved addresses are shared */
+	if (SUCCEED != trx_http_prepare_share(easyhandle, &err_str))
+		goto clean;
+
 	httpstep.httptest = httptest;
 	httpstep.httpstep = &db_httpstep;
 
@@ -20,6 +20,9 @@
 #define MAX_SIZE	65507
 #define MIN_TIMEOUT	50
 
+/* the maximum number of items pinged in one cycle, taken from the queue by MAX_PINGER_ITEMS */
+#define MAX_PINGER_CYCLE_ITEMS	16384
+
 extern unsigned char	process_type, program_type;
 extern int		server_num, process_num;
 
@@ -109,7 +112,8 @@ static void	process_values(icmpitem_t *items, int first_index, int last_index, T
 
 	treegix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	for (h = 0; h < hosts_count; h++)
+	/* items are sorted by address in the same order as hosts */
+	for (h = 0, i = first_index; h < hosts_count; h++)
 	{
 		const TRX_FPING_HOST	*host = &hosts[h];
 
@@ -124,13 +128,10 @@ static void	process_values(icmpitem_t *items, int first_index, int last_index, T
 					host->addr, host->cnt, host->rcv, host->min, host->max, host->sum);
 		}
 
-		for (i = first_index; i < last_index; i++)
+		for (; i < last_index && 0 == strcmp(items[i].addr, host->addr); i++)
 		{
 			const icmpitem_t	*item = &items[i];
 
-			if (0 != strcmp(item->addr, host->addr))
-				continue;
-
 			if (NOTSUPPORTED == ping_result)
 			{
 				process_value(item->itemid, NULL, NULL, ts, NOTSUPPORTED, error);
@@ -300,64 +301,36 @@ out:
 	return ret;
 }
 
-static int	get_icmpping_nearestindex(icmpitem_t *items, int items_count, int count, int interval, int size, int timeout)
+static int	icmpitem_compare(const void *d1, const void *d2)
 {
-	int		first_index, last_index, index;
-	icmpitem_t	*item;
+	const icmpitem_t	*i1 = (const icmpitem_t *)d1;
+	const icmpitem_t	*i2 = (const icmpitem_t *)d2;
 
-	if (items_count == 0)
-		return 0;
+	TRX_RETURN_IF_NOT_EQUAL(i1->count, i2->count);
+	TRX_RETURN_IF_NOT_EQUAL(i1->interval, i2->interval);
+	TRX_RETURN_IF_NOT_EQUAL(i1->size, i2->size);
+	TRX_RETURN_IF_NOT_EQUAL(i1->timeout, i2->timeout);
 
-	first_index = 0;
-	last_index = items_count - 1;
-	while (1)
-	{
-		index = first_index + (last_index - first_index) / 2;
-		item = &items[index];
-
-		if (item->count == count && item->interval == interval && item->size == size && item->timeout == timeout)
-			return index;
-		else if (last_index == first_index)
-		{
-			if (item->count < count ||
-					(item->count == count && item->interval < interval) ||
-					(item->count == count && item->interval == interval && item->size < size) ||
-					(item->count == count && item->interval == interval && item->size == size && item->timeout < timeout))
-				index++;
-			return index;
-		}
-		else if (item->count < count ||
-				(item->count == count && item->interval < interval) ||
-				(item->count == count && item->interval == interval && item->size < size) ||
-				(item->count == count && item->interval == interval && item->size == size && item->timeout < timeout))
-			first_index = index + 1;
-		else
-			last_index = index;
-	}
+	return strcmp(i1->addr, i2->addr);
 }
 
 static void	add_icmpping_item(icmpitem_t **items, int *items_alloc, int *items_count, int count, int interval,
 		int size, int timeout, trx_uint64_t itemid, char *addr, icmpping_t icmpping, icmppingsec_type_t type)
 {
-	int		index;
 	icmpitem_t	*item;
 	size_t		sz;
 
 	treegix_log(LOG_LEVEL_DEBUG, "In %s() addr:'%s' count:%d interval:%d size:%d timeout:%d",
 			__func__, addr, count, interval, size, timeout);
 
-	index = get_icmpping_nearestindex(*items, *items_count, count, interval, size, timeout);
-
 	if (*items_alloc == *items_count)
 	{
-		*items_alloc += 4;
+		*items_alloc *= 2;
 		sz = *items_alloc * sizeof(icmpitem_t);
 		*items = (icmpitem_t *)trx_realloc(*items, sz);
 	}
 
-	memmove(&(*items)[index + 1], &(*items)[index], sizeof(icmpitem_t) * (*items_count - index));
-
-	item = &(*items)[index];
+	item = &(*items)[*items_count];
 	item->count	= count;
 	item->interval	= interval;
 	item->size	= size;
@@ -398,42 +371,48 @@ static void	get_pinger_hosts(icmpitem_t **icmp_items, int *icmp_items_alloc, int
 
 	treegix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	num = DCconfig_get_poller_items(TRX_POLLER_TYPE_PINGER, items);
-
-	for (i = 0; i < num; i++)
+	do
 	{
-		TRX_STRDUP(items[i].key, items[i].key_orig);
-		rc = substitute_key_macros(&items[i].key, NULL, &items[i], NULL, NULL, MACRO_TYPE_ITEM_KEY, error,
-				sizeof(error));
+		num = DCconfig_get_poller_items(TRX_POLLER_TYPE_PINGER, items);
 
-		if (SUCCEED == rc)
+		for (i = 0; i < num; i++)
 		{
-			rc = parse_key_params(items[i].key, items[i].interface.addr, &icmpping, &addr, &count,
-					&interval, &size, &timeout, &type, error, sizeof(error));
-		}
+			TRX_STRDUP(items[i].key, items[i].key_orig);
+			rc = substitute_key_macros(&items[i].key, NULL, &items[i], NULL, NULL, MACRO_TYPE_ITEM_KEY,
+					error, sizeof(error));
 
-		if (SUCCEED == rc)
-		{
-			add_icmpping_item(icmp_items, icmp_items_alloc, icmp_items_count, count, interval, size,
-				timeout, items[i].itemid, addr, icmpping, type);
-		}
-		else
-		{
-			trx_timespec_t	ts;
+			if (SUCCEED == rc)
+			{
+				rc = parse_key_params(items[i].key, items[i].interface.addr, &icmpping, &addr, &count,
+						&interval, &size, &timeout, &type, error, sizeof(error));
+			}
 
-			trx_timespec(&ts);
+			if (SUCCEED == rc)
+			{
+				add_icmpping_item(icmp_items, icmp_items_alloc, icmp_items_count, count, interval, size,
+					timeout, items[i].itemid, addr, icmpping, type);
+			}
+			else
+			{
+				trx_timespec_t	ts;
 
-			items[i].state = ITEM_STATE_NOTSUPPORTED;
-			trx_preprocess_item_value(items[i].itemid, items[i].value_type, items[i].flags, NULL, &ts,
-					items[i].state, error);
+				trx_timespec(&ts);
 
-			DCrequeue_items(&items[i].itemid, &items[i].state, &ts.sec, &errcode, 1);
+				items[i].state = ITEM_STATE_NOTSUPPORTED;
+				trx_preprocess_item_value(items[i].itemid, items[i].value_type, items[i].flags, NULL,
+						&ts, items[i].state, error);
+
+				DCrequeue_items(&items[i].itemid, &items[i].state, &ts.sec, &errcode, 1);
+			}
+
+			trx_free(items[i].key);
 		}
 
-		trx_free(items[i].key);
+		DCconfig_clean_items(items, NULL, num);
 	}
+	while (MAX_PINGER_ITEMS == num && MAX_PINGER_CYCLE_ITEMS > *icmp_items_count);
 
-	DCconfig_clean_items(items, NULL, num);
+	qsort(*icmp_items, *icmp_items_count, sizeof(icmpitem_t), icmpitem_compare);
 
 	trx_preprocessor_flush();
 
@@ -452,23 +431,20 @@ static void	free_hosts(icmpitem_t **items, int *items_count)
 
 static void	add_pinger_host(TRX_FPING_HOST **hosts, int *hosts_alloc, int *hosts_count, char *addr)
 {
-	int		i;
 	size_t		sz;
 	TRX_FPING_HOST	*h;
 
 	treegix_log(LOG_LEVEL_DEBUG, "In %s() addr:'%s'", __func__, addr);
 
-	for (i = 0; i < *hosts_count; i++)
-	{
-		if (0 == strcmp(addr, (*hosts)[i].addr))
-			return;
-	}
+	/* items are sorted by address, the same address can only be the last one added */
+	if (0 != *hosts_count && 0 == strcmp(addr, (*hosts)[*hosts_count - 1].addr))
+		return;
 
 	(*hosts_count)++;
 
 	if (*hosts_alloc < *hosts_count)
 	{
-		*hosts_alloc += 4;
+		*hosts_alloc *= 2;
 		sz = *hosts_alloc * sizeof(TRX_FPING_HOST);
 		*hosts = (TRX_FPING_HOST *)trx_realloc(*hosts, sz);
 	}
@@ -0,0 +1,1099 @@
+
+
+#include "common.h"
+
+#include <event.h>
+#if defined(LIBEVENT_VERSION_NUMBER) && LIBEVENT_VERSION_NUMBER >= 0x2000000
+#	include <event2/dns.h>
+#	define HAVE_ASYNC_DNS
+#endif
+
+#include "comms.h"
+#include "log.h"
+#include "trxjson.h"
+
+#include "async_agent.h"
+#include "checks_agent.h"
+
+#define ASYNC_AGENT_STATE_RESOLVE	0
+#define ASYNC_AGENT_STATE_CONNECT	1
+#define ASYNC_AGENT_STATE_TLS		2
+#define ASYNC_AGENT_STATE_SEND		3
+#define ASYNC_AGENT_STATE_RECV		4
+#define ASYNC_AGENT_STATE_IDLE		5
+
+#define ASYNC_AGENT_PROTOCOL_UNKNOWN	0
+#define ASYNC_AGENT_PROTOCOL_KEY	1	/* single key per connection */
+#define ASYNC_AGENT_PROTOCOL_BATCH	2	/* batches of keys on persistent connection */
+
+/* the maximum number of keys sent in one request */
+#define ASYNC_AGENT_BATCH_MAX		64
+
+/* agents without batch support are probed again after this period in case they were upgraded */
+#define ASYNC_AGENT_PROTOCOL_TTL	SEC_PER_HOUR
+
+/* the time connection is kept open for the next batch of the interface, seconds */
+#define ASYNC_AGENT_KEEP_TIMEOUT	1
+
+/* passive agent check of one or more items of the same interface */
+typedef struct
+{
+	trx_async_poller_t	*poller;
+	trx_uint64_t		interfaceid;
+
+	/* the checked items, trx_async_item_t */
+	trx_vector_ptr_t	items;
+
+	/* the first item without result, items are checked one by one with single key protocol */
+	int			item_index;
+
+	unsigned char		state;
+	unsigned char		protocol;
+
+	/* 1 if the socket is open */
+	unsigned char		connected;
+
+	/* 1 if the connection was kept open after the previous batch */
+	unsigned char		reused;
+
+	double			deadline;
+
+	char			*addr;
+	unsigned short		port;
+	unsigned char		tls_connect;
+	char			*tls_arg1;
+	char			*tls_arg2;
+
+	trx_socket_t		s;
+	struct event		ev;
+
+	char			*buf;
+	size_t			buf_alloc;
+	size_t			buf_offset;
+	size_t			buf_sent;
+}
+trx_async_agent_t;
+
+/* the agent protocol supported by interface and the connection kept open for the next batch */
+typedef struct
+{
+	trx_uint64_t		interfaceid;
+	unsigned char		protocol;
+	int			protocol_checked;
+	int			lastaccess;
+	trx_async_agent_t	*idle;
+}
+trx_async_agent_interface_t;
+
+static trx_hashset_t	agent_interfaces;
+
+static void	async_agent_resolve(trx_async_agent_t *agent);
+
+static const char	*async_agent_state_string(unsigned char state)
+{
+	switch (state)
+	{
+		case ASYNC_AGENT_STATE_RESOLVE:
+			return "resolving address";
+		case ASYNC_AGENT_STATE_CONNECT:
+			return "connecting";
+		case ASYNC_AGENT_STATE_TLS:
+			return "establishing TLS connection";
+		case ASYNC_AGENT_STATE_SEND:
+			return "sending request";
+		case ASYNC_AGENT_STATE_RECV:
+			return "receiving response";
+		default:
+			return "unknown";
+	}
+}
+
+static void	async_agent_free_task(trx_async_agent_t *agent)
+{
+	trx_vector_ptr_destroy(&agent->items);
+	trx_free(agent->addr);
+	trx_free(agent->tls_arg1);
+	trx_free(agent->tls_arg2);
+	trx_free(agent->buf);
+	trx_free(agent);
+}
+
+static void	async_agent_close(trx_async_agent_t *agent)
+{
+	if (0 == agent->connected)
+		return;
+
+	trx_tcp_close(&agent->s);
+	agent->connected = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_get_interface                                        *
+ *                                                                            *
+ * Purpose: get protocol data of interface, removing data of interfaces not   *
+ *          checked for a long time                                           *
+ *                                                                            *
+ ******************************************************************************/
+static trx_async_agent_interface_t	*async_agent_get_interface(trx_uint64_t interfaceid)
+{
+	static int			housekeeping_time;
+	trx_async_agent_interface_t	*iface, iface_local;
+	trx_hashset_iter_t		iter;
+	int				now;
+
+	now = (int)time(NULL);
+
+	if (SEC_PER_HOUR <= now - housekeeping_time)
+	{
+		trx_hashset_iter_reset(&agent_interfaces, &iter);
+
+		while (NULL != (iface = (trx_async_agent_interface_t *)trx_hashset_iter_next(&iter)))
+		{
+			if (NULL == iface->idle && SEC_PER_HOUR <= now - iface->lastaccess)
+				trx_hashset_iter_remove(&iter);
+		}
+
+		housekeeping_time = now;
+	}
+
+	if (NULL == (iface = (trx_async_agent_interface_t *)trx_hashset_search(&agent_interfaces, &interfaceid)))
+	{
+		iface_local.interfaceid = interfaceid;
+		iface_local.protocol = ASYNC_AGENT_PROTOCOL_UNKNOWN;
+		iface_local.protocol_checked = 0;
+		iface_local.idle = NULL;
+
+		iface = (trx_async_agent_interface_t *)trx_hashset_insert(&agent_interfaces, &iface_local,
+				sizeof(iface_local));
+	}
+
+	iface->lastaccess = now;
+
+	return iface;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_interface_protocol                                   *
+ *                                                                            *
+ * Purpose: get the protocol to use for the next request to interface         *
+ *                                                                            *
+ * Comments: Batch requests are sent to agents until they are found to not    *
+ *           support them.                                                    *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned char	async_agent_interface_protocol(const trx_async_agent_interface_t *iface)
+{
+	if (ASYNC_AGENT_PROTOCOL_KEY == iface->protocol &&
+			ASYNC_AGENT_PROTOCOL_TTL > time(NULL) - iface->protocol_checked)
+	{
+		return ASYNC_AGENT_PROTOCOL_KEY;
+	}
+
+	return ASYNC_AGENT_PROTOCOL_BATCH;
+}
+
+static void	async_agent_item_done(trx_async_agent_t *agent, trx_async_item_t *item, int ret)
+{
+	treegix_log(LOG_LEVEL_DEBUG, "%s() itemid:" TRX_FS_UI64 " key:'%s':%s", __func__, item->itemid,
+			item->key, trx_result_string(ret));
+
+	item->ret = ret;
+	async_poller_item_done(agent->poller, item);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_finish                                               *
+ *                                                                            *
+ * Purpose: complete the check and pass the items without result back to      *
+ *          poller                                                            *
+ *                                                                            *
+ * Parameters: agent - [IN] the check                                         *
+ *             ret   - [IN] the check result (SUCCEED, NETWORK_ERROR, ...)    *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_agent_finish(trx_async_agent_t *agent, int ret)
+{
+	int	i;
+
+	for (i = agent->item_index; i < agent->items.values_num; i++)
+		async_agent_item_done(agent, (trx_async_item_t *)agent->items.values[i], ret);
+
+	async_poller_check_done(agent->poller, agent->interfaceid, ret);
+
+	async_agent_close(agent);
+	async_agent_free_task(agent);
+}
+
+static void	async_agent_set_error(trx_async_agent_t *agent, const char *error)
+{
+	int	i;
+
+	for (i = agent->item_index; i < agent->items.values_num; i++)
+		SET_MSG_RESULT(&((trx_async_item_t *)agent->items.values[i])->result, trx_strdup(NULL, error));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_fail                                                 *
+ *                                                                            *
+ * Purpose: fail the check, unless it can be retried on a new connection      *
+ *                                                                            *
+ * Comments: Agent can close kept connection at the same time the next batch  *
+ *           is sent, such batch is sent again on a new connection.           *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_agent_fail(trx_async_agent_t *agent, int ret, const char *error)
+{
+	char	*msg;
+
+	if (0 != agent->reused && NETWORK_ERROR == ret && (ASYNC_AGENT_STATE_SEND == agent->state ||
+			(ASYNC_AGENT_STATE_RECV == agent->state && 0 == agent->buf_offset)))
+	{
+		treegix_log(LOG_LEVEL_DEBUG, "kept connection to [%s] was closed: %s", agent->addr, error);
+
+		async_agent_close(agent);
+		agent->reused = 0;
+		async_agent_resolve(agent);
+		return;
+	}
+
+	msg = trx_dsprintf(NULL, "Get value from agent failed: %s", error);
+	async_agent_set_error(agent, msg);
+	trx_free(msg);
+
+	async_agent_finish(agent, ret);
+}
+
+static void	async_agent_event_cb(evutil_socket_t fd, short what, void *arg);
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_wait                                                 *
+ *                                                                            *
+ * Purpose: wait until the socket is ready for the next step of the check     *
+ *                                                                            *
+ * Parameters: agent - [IN] the check                                         *
+ *             want  - [IN] TRX_SOCKET_WANT_READ and/or TRX_SOCKET_WANT_WRITE *
+ *                                                                            *
+ * Comments: Each wait uses the time remaining till the deadline of the       *
+ *           current check step.                                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_agent_wait(trx_async_agent_t *agent, int want)
+{
+	struct timeval	tv;
+	double		timeout;
+	short		what = 0;
+
+	if (0 != (want & TRX_SOCKET_WANT_READ))
+		what |= EV_READ;
+
+	if (0 != (want & TRX_SOCKET_WANT_WRITE))
+		what |= EV_WRITE;
+
+	if (0 > (timeout = agent->deadline - trx_time()))
+		timeout = 0;
+
+	tv.tv_sec = (time_t)timeout;
+	tv.tv_usec = (suseconds_t)((timeout - tv.tv_sec) * 1000000);
+
+	event_set(&agent->ev, agent->s.socket, what, async_agent_event_cb, agent);
+	event_base_set(agent->poller->base, &agent->ev);
+	event_add(&agent->ev, &tv);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_process_value                                        *
+ *                                                                            *
+ * Purpose: set item result from single key response                          *
+ *                                                                            *
+ * Parameters: item - [IN/OUT] the item                                       *
+ *             data - [IN] the response                                       *
+ *             len  - [IN] the response length                                *
+ *                                                                            *
+ * Return value: the check result, same as returned by get_value_agent()      *
+ *                                                                            *
+ ******************************************************************************/
+static int	async_agent_process_value(trx_async_item_t *item, char *data, size_t len)
+{
+	treegix_log(LOG_LEVEL_DEBUG, "get value from agent result: '%s'", data);
+
+	if (0 == strcmp(data, TRX_NOTSUPPORTED))
+	{
+		/* 'TRX_NOTSUPPORTED\0<error message>' */
+		if (sizeof(TRX_NOTSUPPORTED) < len)
+			SET_MSG_RESULT(&item->result, trx_dsprintf(NULL, "%s", data + sizeof(TRX_NOTSUPPORTED)));
+		else
+			SET_MSG_RESULT(&item->result, trx_strdup(NULL, "Not supported by Treegix Agent"));
+
+		return NOTSUPPORTED;
+	}
+
+	if (0 == strcmp(data, TRX_ERROR))
+	{
+		SET_MSG_RESULT(&item->result, trx_strdup(NULL, "Treegix Agent non-critical error"));
+		return AGENT_ERROR;
+	}
+
+	set_result_type(&item->result, ITEM_VALUE_TYPE_TEXT, data);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_keep                                                 *
+ *                                                                            *
+ * Purpose: keep connection open for the next batch of the interface          *
+ *                                                                            *
+ * Comments: Only one connection per interface is kept. Kept connection is    *
+ *           closed when agent closes it or when the next batch is not        *
+ *           started shortly, so agent listeners are not held by idle         *
+ *           connections until the next check of the interface is due.        *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_agent_keep(trx_async_agent_t *agent, trx_async_agent_interface_t *iface)
+{
+	async_poller_check_done(agent->poller, agent->interfaceid, SUCCEED);
+
+	if (NULL != iface->idle)
+	{
+		async_agent_close(agent);
+		async_agent_free_task(agent);
+		return;
+	}
+
+	trx_vector_ptr_clear(&agent->items);
+	agent->item_index = 0;
+	agent->state = ASYNC_AGENT_STATE_IDLE;
+	agent->deadline = trx_time() + ASYNC_AGENT_KEEP_TIMEOUT;
+
+	iface->idle = agent;
+	async_agent_wait(agent, TRX_SOCKET_WANT_READ);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_process_batch                                        *
+ *                                                                            *
+ * Purpose: set item results from batch response                              *
+ *                                                                            *
+ * Parameters: agent - [IN] the check                                         *
+ *             data  - [IN] the response                                      *
+ *                                                                            *
+ * Comments: Agents without batch support reply with not supported value and  *
+ *           close connection, the items are checked one by one then.         *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_agent_process_batch(trx_async_agent_t *agent, const char *data)
+{
+	struct trx_json_parse		jp, jp_data, jp_row;
+	trx_async_agent_interface_t	*iface;
+	trx_async_item_t		*item;
+	const char			*p = NULL;
+	char				response[MAX_STRING_LEN], *value = NULL, *error;
+	size_t				value_alloc = 0;
+	int				i, ret;
+
+	iface = async_agent_get_interface(agent->interfaceid);
+
+	if ('{' != *data)
+	{
+		treegix_log(LOG_LEVEL_DEBUG, "agent at [%s] does not support batch requests", agent->addr);
+
+		iface->protocol = ASYNC_AGENT_PROTOCOL_KEY;
+		iface->protocol_checked = (int)time(NULL);
+
+		async_agent_close(agent);
+		agent->protocol = ASYNC_AGENT_PROTOCOL_KEY;
+		agent->reused = 0;
+		async_agent_resolve(agent);
+		return;
+	}
+
+	if (SUCCEED != trx_json_open(data, &jp) ||
+			SUCCEED != trx_json_value_by_name(&jp, TRX_PROTO_TAG_RESPONSE, response, sizeof(response)))
+	{
+		async_agent_fail(agent, NETWORK_ERROR, "invalid response");
+		return;
+	}
+
+	if (0 != strcmp(response, TRX_PROTO_VALUE_SUCCESS))
+	{
+		if (SUCCEED != trx_json_value_by_name_dyn(&jp, TRX_PROTO_TAG_INFO, &value, &value_alloc))
+			value = trx_strdup(value, "unknown error");
+
+		error = trx_dsprintf(NULL, "batch request failed: %s", value);
+		async_agent_fail(agent, NETWORK_ERROR, error);
+		trx_free(error);
+		trx_free(value);
+		return;
+	}
+
+	if (SUCCEED != trx_json_brackets_by_name(&jp, TRX_PROTO_TAG_DATA, &jp_data) ||
+			agent->items.values_num != trx_json_count(&jp_data))
+	{
+		async_agent_fail(agent, NETWORK_ERROR, "invalid number of values in response");
+		return;
+	}
+
+	iface->protocol = ASYNC_AGENT_PROTOCOL_BATCH;
+
+	for (i = 0; i < agent->items.values_num; i++)
+	{
+		item = (trx_async_item_t *)agent->items.values[i];
+		p = trx_json_next(&jp_data, p);
+
+		if (SUCCEED == trx_json_brackets_open(p, &jp_row) &&
+				SUCCEED == trx_json_value_by_name_dyn(&jp_row, TRX_PROTO_TAG_VALUE, &value, &value_alloc))
+		{
+			set_result_type(&item->result, ITEM_VALUE_TYPE_TEXT, value);
+			ret = SUCCEED;
+		}
+		else if (SUCCEED == trx_json_brackets_open(p, &jp_row) &&
+				SUCCEED == trx_json_value_by_name_dyn(&jp_row, TRX_PROTO_TAG_ERROR, &value, &value_alloc))
+		{
+			SET_MSG_RESULT(&item->result, trx_strdup(NULL, value));
+			ret = NOTSUPPORTED;
+		}
+		else
+		{
+			SET_MSG_RESULT(&item->result, trx_strdup(NULL, "Not supported by Treegix Agent"));
+			ret = NOTSUPPORTED;
+		}
+
+		async_agent_item_done(agent, item, ret);
+	}
+
+	trx_free(value);
+
+	agent->item_index = agent->items.values_num;
+	async_agent_keep(agent, iface);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_process_response                                     *
+ *                                                                            *
+ * Purpose: process the whole agent response                                  *
+ *                                                                            *
+ * Parameters: agent - [IN] the check                                         *
+ *             data  - [IN] the response                                      *
+ *             len   - [IN] the response length                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_agent_process_response(trx_async_agent_t *agent, char *data, size_t len)
+{
+	trx_async_item_t	*item;
+	char			*error;
+
+	if (0 == len)
+	{
+		error = trx_dsprintf(NULL, "Received empty response from Treegix Agent at [%s]."
+				" Assuming that agent dropped connection because of access permissions.",
+				agent->addr);
+		async_agent_set_error(agent, error);
+		trx_free(error);
+
+		async_agent_finish(agent, NETWORK_ERROR);
+		return;
+	}
+
+	if (ASYNC_AGENT_PROTOCOL_BATCH == agent->protocol)
+	{
+		async_agent_process_batch(agent, data);
+		return;
+	}
+
+	async_agent_close(agent);
+
+	item = (trx_async_item_t *)agent->items.values[agent->item_index++];
+	async_agent_item_done(agent, item, async_agent_process_value(item, data, len));
+
+	if (agent->item_index < agent->items.values_num)
+	{
+		async_agent_resolve(agent);
+		return;
+	}
+
+	async_agent_finish(agent, SUCCEED);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_send                                                 *
+ *                                                                            *
+ * Purpose: send request to agent                                             *
+ *                                                                            *
+ * Comments: Agent processes batched keys one by one, so the response is      *
+ *           waited for Timeout seconds per requested key.                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_agent_send(trx_async_agent_t *agent)
+{
+	ssize_t	n;
+	int	want;
+
+	while (agent->buf_sent < agent->buf_offset)
+	{
+		if (TRX_PROTO_ERROR == (n = trx_tcp_write_nonblocking(&agent->s, agent->buf + agent->buf_sent,
+				agent->buf_offset - agent->buf_sent, &want)))
+		{
+			async_agent_fail(agent, NETWORK_ERROR, trx_socket_strerror());
+			return;
+		}
+
+		if (0 != want)
+		{
+			async_agent_wait(agent, want);
+			return;
+		}
+
+		agent->buf_sent += (size_t)n;
+	}
+
+	/* reuse the buffer for response */
+	agent->buf_offset = 0;
+	agent->state = ASYNC_AGENT_STATE_RECV;
+
+	/* agent stops processing batch keys after Timeout seconds, so the last processed key */
+	/* can take at most another Timeout seconds regardless of the batch size              */
+	if (ASYNC_AGENT_PROTOCOL_BATCH == agent->protocol && 1 < agent->items.values_num)
+		agent->deadline = trx_time() + CONFIG_TIMEOUT * 2;
+	else
+		agent->deadline = trx_time() + CONFIG_TIMEOUT;
+
+	async_agent_wait(agent, TRX_SOCKET_WANT_READ);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_request                                              *
+ *                                                                            *
+ * Purpose: pack the request for connected agent and start sending it         *
+ *                                                                            *
+ * Comments: batch request:                                                   *
+ *             {"request":"passive checks","data":[{"key":"..."},...]}        *
+ *           single key request is the item key                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_agent_request(trx_async_agent_t *agent)
+{
+	trx_async_item_t	*item;
+	struct trx_json		j;
+	int			i;
+
+	agent->buf_offset = 0;
+	agent->buf_sent = 0;
+
+	if (ASYNC_AGENT_PROTOCOL_BATCH == agent->protocol)
+	{
+		trx_json_init(&j, TRX_JSON_STAT_BUF_LEN);
+		trx_json_addstring(&j, TRX_PROTO_TAG_REQUEST, TRX_PROTO_VALUE_PASSIVE_CHECKS, TRX_JSON_TYPE_STRING);
+		trx_json_addarray(&j, TRX_PROTO_TAG_DATA);
+
+		for (i = 0; i < agent->items.values_num; i++)
+		{
+			item = (trx_async_item_t *)agent->items.values[i];
+
+			trx_json_addobject(&j, NULL);
+			trx_json_addstring(&j, TRX_PROTO_TAG_KEY, item->key, TRX_JSON_TYPE_STRING);
+			trx_json_close(&j);
+		}
+
+		trx_tcp_pack_message(&agent->buf, &agent->buf_alloc, &agent->buf_offset, j.buffer, j.buffer_size);
+		trx_json_free(&j);
+	}
+	else
+	{
+		item = (trx_async_item_t *)agent->items.values[agent->item_index];
+		trx_tcp_pack_message(&agent->buf, &agent->buf_alloc, &agent->buf_offset, item->key, strlen(item->key));
+	}
+
+	agent->state = ASYNC_AGENT_STATE_SEND;
+	async_agent_send(agent);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_recv                                                 *
+ *                                                                            *
+ * Purpose: receive agent response                                            *
+ *                                                                            *
+ * Comments: Responses with protocol header are processed as soon as the      *
+ *           whole message is received. Responses without header are read     *
+ *           until agent closes connection, as trx_tcp_recv() does.           *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_agent_recv(trx_async_agent_t *agent)
+{
+	ssize_t	n;
+	int	want;
+	char	*data = NULL;
+	size_t	message_len, data_len;
+
+	while (1)
+	{
+		if (TRX_STAT_BUF_LEN > agent->buf_alloc - agent->buf_offset)
+		{
+			agent->buf_alloc += TRX_STAT_BUF_LEN;
+			agent->buf = (char *)trx_realloc(agent->buf, agent->buf_alloc);
+		}
+
+		/* keep space for terminating zero */
+		if (TRX_PROTO_ERROR == (n = trx_tcp_read_nonblocking(&agent->s, agent->buf + agent->buf_offset,
+				agent->buf_alloc - agent->buf_offset - 1, &want)))
+		{
+			async_agent_fail(agent, NETWORK_ERROR, trx_socket_strerror());
+			return;
+		}
+
+		if (0 != want)
+		{
+			async_agent_wait(agent, want);
+			return;
+		}
+
+		if (0 == n)
+			break;
+
+		agent->buf_offset += (size_t)n;
+
+		if (TRX_MAX_RECV_DATA_SIZE < agent->buf_offset)
+		{
+			async_agent_fail(agent, NETWORK_ERROR, "message size exceeds the maximum size");
+			return;
+		}
+
+		if (0 != strncmp(agent->buf, TRX_TCP_HEADER_DATA, MIN(agent->buf_offset, TRX_TCP_HEADER_LEN)))
+			continue;
+
+		if (FAIL == trx_tcp_unpack_message(agent->buf, agent->buf_offset, &message_len, &data, &data_len))
+		{
+			async_agent_fail(agent, NETWORK_ERROR, trx_socket_strerror());
+			return;
+		}
+
+		if (0 != message_len)
+		{
+			async_agent_process_response(agent, data, data_len);
+			trx_free(data);
+			return;
+		}
+	}
+
+	/* connection was closed by agent */
+	if (0 == agent->buf_offset && 0 != agent->reused)
+	{
+		async_agent_fail(agent, NETWORK_ERROR, "connection closed by agent");
+		return;
+	}
+
+	if (0 != agent->buf_offset && 0 == strncmp(agent->buf, TRX_TCP_HEADER_DATA,
+			MIN(agent->buf_offset, TRX_TCP_HEADER_LEN)))
+	{
+		async_agent_fail(agent, NETWORK_ERROR, "connection closed before the whole message was received");
+		return;
+	}
+
+	agent->buf[agent->buf_offset] = '\0';
+	async_agent_process_response(agent, agent->buf, agent->buf_offset);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_drop                                                 *
+ *                                                                            *
+ * Purpose: close kept connection after agent closed it or it timed out       *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_agent_drop(trx_async_agent_t *agent)
+{
+	trx_async_agent_interface_t	*iface;
+
+	treegix_log(LOG_LEVEL_DEBUG, "%s() addr:'%s'", __func__, agent->addr);
+
+	if (NULL != (iface = (trx_async_agent_interface_t *)trx_hashset_search(&agent_interfaces,
+			&agent->interfaceid)) && agent == iface->idle)
+	{
+		iface->idle = NULL;
+	}
+
+	async_agent_close(agent);
+	async_agent_free_task(agent);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_event_cb                                             *
+ *                                                                            *
+ * Purpose: advance the check when socket is ready or the check timed out     *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_agent_event_cb(evutil_socket_t fd, short what, void *arg)
+{
+	trx_async_agent_t	*agent = (trx_async_agent_t *)arg;
+	int			want;
+	char			*error;
+
+	TRX_UNUSED(fd);
+
+	/* kept connection must not receive anything until the next request */
+	if (ASYNC_AGENT_STATE_IDLE == agent->state)
+	{
+		async_agent_drop(agent);
+		return;
+	}
+
+	if (0 != (what & EV_TIMEOUT))
+	{
+		error = trx_dsprintf(NULL, "timeout while %s", async_agent_state_string(agent->state));
+		async_agent_fail(agent, TIMEOUT_ERROR, error);
+		trx_free(error);
+		return;
+	}
+
+	switch (agent->state)
+	{
+		case ASYNC_AGENT_STATE_CONNECT:
+			if (SUCCEED != trx_tcp_connect_check(&agent->s))
+			{
+				async_agent_fail(agent, NETWORK_ERROR, trx_socket_strerror());
+				return;
+			}
+
+			if (TRX_TCP_SEC_UNENCRYPTED == agent->tls_connect)
+			{
+				async_agent_request(agent);
+				return;
+			}
+
+			agent->state = ASYNC_AGENT_STATE_TLS;
+			TRX_FALLTHROUGH;
+		case ASYNC_AGENT_STATE_TLS:
+			if (SUCCEED != trx_tcp_tls_connect_nonblocking(&agent->s, agent->tls_connect, agent->tls_arg1,
+					agent->tls_arg2, &want))
+			{
+				async_agent_fail(agent, NETWORK_ERROR, trx_socket_strerror());
+				return;
+			}
+
+			if (0 != want)
+			{
+				async_agent_wait(agent, want);
+				return;
+			}
+
+			async_agent_request(agent);
+			return;
+		case ASYNC_AGENT_STATE_SEND:
+			async_agent_send(agent);
+			return;
+		case ASYNC_AGENT_STATE_RECV:
+			async_agent_recv(agent);
+			return;
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			async_agent_fail(agent, NETWORK_ERROR, "invalid check state");
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_connect                                              *
+ *                                                                            *
+ * Purpose: start connecting to the resolved agent address                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_agent_connect(trx_async_agent_t *agent, const struct sockaddr *addr, socklen_t addrlen)
+{
+	if (SUCCEED != trx_tcp_connect_nonblocking(&agent->s, CONFIG_SOURCE_IP, addr, addrlen, agent->addr))
+	{
+		async_agent_fail(agent, NETWORK_ERROR, trx_socket_strerror());
+		return;
+	}
+
+	agent->connected = 1;
+	agent->state = ASYNC_AGENT_STATE_CONNECT;
+	async_agent_wait(agent, TRX_SOCKET_WANT_WRITE);
+}
+
+#ifdef HAVE_ASYNC_DNS
+static void	async_agent_dns_cb(int result, struct evutil_addrinfo *ai, void *arg)
+{
+	trx_async_agent_t	*agent = (trx_async_agent_t *)arg;
+	char			*error;
+
+	if (0 != result)
+	{
+		error = trx_dsprintf(NULL, "cannot resolve [%s]: %s", agent->addr, evutil_gai_strerror(result));
+		async_agent_fail(agent, EVUTIL_EAI_CANCEL == result ? TIMEOUT_ERROR : NETWORK_ERROR, error);
+		trx_free(error);
+		return;
+	}
+
+	async_agent_connect(agent, ai->ai_addr, (socklen_t)ai->ai_addrlen);
+	evutil_freeaddrinfo(ai);
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_resolve                                              *
+ *                                                                            *
+ * Purpose: start new connection to agent by resolving its address            *
+ *                                                                            *
+ * Comments: Connecting, including TLS handshake, is limited by Timeout       *
+ *           configuration parameter.                                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_agent_resolve(trx_async_agent_t *agent)
+{
+	char			service[MAX_ID_LEN];
+	struct addrinfo		hints, *ai = NULL;
+#ifndef HAVE_ASYNC_DNS
+	int			res;
+#endif
+
+	agent->state = ASYNC_AGENT_STATE_RESOLVE;
+	agent->deadline = trx_time() + CONFIG_TIMEOUT;
+
+	trx_snprintf(service, sizeof(service), "%hu", agent->port);
+
+	memset(&hints, 0, sizeof(hints));
+#ifdef HAVE_IPV6
+	hints.ai_family = PF_UNSPEC;
+#else
+	hints.ai_family = PF_INET;
+#endif
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+
+	/* IP addresses are most common, do not involve resolver for them */
+	if (0 == getaddrinfo(agent->addr, service, &hints, &ai))
+	{
+		async_agent_connect(agent, ai->ai_addr, ai->ai_addrlen);
+		freeaddrinfo(ai);
+		return;
+	}
+#ifdef HAVE_ASYNC_DNS
+	{
+		struct evutil_addrinfo	evhints;
+
+		memset(&evhints, 0, sizeof(evhints));
+		evhints.ai_family = hints.ai_family;
+		evhints.ai_socktype = SOCK_STREAM;
+		evhints.ai_flags = EVUTIL_AI_NUMERICSERV;
+
+		/* the callback can be called before returning, the check must not be accessed afterwards */
+		evdns_getaddrinfo(agent->poller->dnsbase, agent->addr, service, &evhints, async_agent_dns_cb, agent);
+	}
+#else
+	hints.ai_flags = AI_NUMERICSERV;
+
+	if (0 != (res = getaddrinfo(agent->addr, service, &hints, &ai)))
+	{
+		char	*error;
+
+		error = trx_dsprintf(NULL, "cannot resolve [%s]: %s", agent->addr, gai_strerror(res));
+		async_agent_fail(agent, NETWORK_ERROR, error);
+		trx_free(error);
+		return;
+	}
+
+	async_agent_connect(agent, ai->ai_addr, ai->ai_addrlen);
+	freeaddrinfo(ai);
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_init                                                 *
+ *                                                                            *
+ * Purpose: initialize agent protocol data of interfaces                      *
+ *                                                                            *
+ ******************************************************************************/
+void	async_agent_init(void)
+{
+	trx_hashset_create(&agent_interfaces, 100, TRX_DEFAULT_UINT64_HASH_FUNC, TRX_DEFAULT_UINT64_COMPARE_FUNC);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_prepare                                              *
+ *                                                                            *
+ * Purpose: prepare passive agent check of the item                           *
+ *                                                                            *
+ * Parameters: item    - [IN/OUT] the item                                    *
+ *             dc_item - [IN] the item with host and interface data           *
+ *                                                                            *
+ * Return value: SUCCEED - the check is prepared and must be started with     *
+ *                         async_agent_start()                                *
+ *               FAIL    - the check was completed without waiting, item      *
+ *                         result is set                                      *
+ *                                                                            *
+ * Comments: TLS connections are established without blocking only with       *
+ *           OpenSSL. With other TLS libraries the items of encrypted hosts   *
+ *           are routed to regular pollers by configuration cache and can get *
+ *           here only before their poller type is updated, such items are    *
+ *           reported as not supported until the next check.                  *
+ *                                                                            *
+ ******************************************************************************/
+int	async_agent_prepare(trx_async_item_t *item, DC_ITEM *dc_item)
+{
+	trx_async_agent_t	*agent;
+
+	if (TRX_TCP_SEC_UNENCRYPTED != dc_item->host.tls_connect)
+	{
+#if defined(HAVE_OPENSSL)
+		if (TRX_TCP_SEC_TLS_CERT != dc_item->host.tls_connect &&
+				TRX_TCP_SEC_TLS_PSK != dc_item->host.tls_connect)
+#endif
+		{
+			SET_MSG_RESULT(&item->result, trx_strdup(NULL, "Item cannot be checked by asynchronous agent"
+					" poller."));
+			item->ret = CONFIG_ERROR;
+
+			return FAIL;
+		}
+	}
+
+	agent = (trx_async_agent_t *)trx_malloc(NULL, sizeof(trx_async_agent_t));
+	memset(agent, 0, sizeof(trx_async_agent_t));
+
+	trx_vector_ptr_create(&agent->items);
+	agent->addr = trx_strdup(NULL, dc_item->interface.addr);
+	agent->port = dc_item->interface.port;
+	agent->tls_connect = dc_item->host.tls_connect;
+#if defined(HAVE_OPENSSL)
+	switch (agent->tls_connect)
+	{
+		case TRX_TCP_SEC_TLS_CERT:
+			agent->tls_arg1 = trx_strdup(NULL, dc_item->host.tls_issuer);
+			agent->tls_arg2 = trx_strdup(NULL, dc_item->host.tls_subject);
+			break;
+		case TRX_TCP_SEC_TLS_PSK:
+			agent->tls_arg1 = trx_strdup(NULL, dc_item->host.tls_psk_identity);
+			agent->tls_arg2 = trx_strdup(NULL, dc_item->host.tls_psk);
+			break;
+	}
+#endif
+	item->task = agent;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_batch_max                                            *
+ *                                                                            *
+ * Purpose: get the maximum number of items to check in one request to        *
+ *          interface                                                         *
+ *                                                                            *
+ ******************************************************************************/
+int	async_agent_batch_max(trx_uint64_t interfaceid)
+{
+	trx_async_agent_interface_t	*iface;
+
+	if (NULL != (iface = (trx_async_agent_interface_t *)trx_hashset_search(&agent_interfaces, &interfaceid)) &&
+			ASYNC_AGENT_PROTOCOL_KEY == async_agent_interface_protocol(iface))
+	{
+		return 1;
+	}
+
+	return ASYNC_AGENT_BATCH_MAX;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_start                                                *
+ *                                                                            *
+ * Purpose: start prepared passive agent checks of the same interface         *
+ *                                                                            *
+ * Parameters: poller    - [IN] the poller                                    *
+ *             items     - [IN] the items                                     *
+ *             items_num - [IN] the number of items, not more than returned   *
+ *                              by async_agent_batch_max()                    *
+ *                                                                            *
+ * Comments: The items are passed back to poller with                         *
+ *           async_poller_item_done() and the end of the check is reported    *
+ *           with async_poller_check_done(), possibly before returning from   *
+ *           this function.                                                   *
+ *                                                                            *
+ *           The items are sent in one batch request on connection kept from  *
+ *           the previous batch if possible.                                  *
+ *                                                                            *
+ ******************************************************************************/
+void	async_agent_start(trx_async_poller_t *poller, trx_async_item_t **items, int items_num)
+{
+	trx_async_agent_t		*agent = (trx_async_agent_t *)items[0]->task, *idle;
+	trx_async_agent_interface_t	*iface;
+	int				i;
+
+	treegix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' addr:'%s' items:%d conn:'%s'", __func__, items[0]->host,
+			agent->addr, items_num, trx_tcp_connection_type_name(agent->tls_connect));
+
+	/* the items of the same interface share the connection data of the first one */
+	items[0]->task = NULL;
+
+	for (i = 1; i < items_num; i++)
+		async_agent_free(items[i]);
+
+	iface = async_agent_get_interface(items[0]->interfaceid);
+
+	if (NULL != (idle = iface->idle))
+	{
+		iface->idle = NULL;
+		event_del(&idle->ev);
+
+		if (ASYNC_AGENT_PROTOCOL_BATCH == async_agent_interface_protocol(iface) &&
+				0 == strcmp(idle->addr, agent->addr) && idle->port == agent->port &&
+				idle->tls_connect == agent->tls_connect)
+		{
+			async_agent_free_task(agent);
+
+			agent = idle;
+			agent->reused = 1;
+		}
+		else
+		{
+			async_agent_close(idle);
+			async_agent_free_task(idle);
+		}
+	}
+
+	agent->poller = poller;
+	agent->interfaceid = items[0]->interfaceid;
+	agent->protocol = async_agent_interface_protocol(iface);
+
+	for (i = 0; i < items_num; i++)
+		trx_vector_ptr_append(&agent->items, items[i]);
+
+	if (0 != agent->connected)
+	{
+		agent->deadline = trx_time() + CONFIG_TIMEOUT;
+		async_agent_request(agent);
+	}
+	else
+		async_agent_resolve(agent);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_agent_free                                                 *
+ *                                                                            *
+ * Purpose: free prepared check that was not started                          *
+ *                                                                            *
+ ******************************************************************************/
+void	async_agent_free(trx_async_item_t *item)
+{
+	if (NULL == item->task)
+		return;
+
+	async_agent_free_task((trx_async_agent_t *)item->task);
+	item->task = NULL;
+}
@@ -0,0 +1,17 @@
+
+
+#ifndef TREEGIX_ASYNC_AGENT_H
+#define TREEGIX_ASYNC_AGENT_H
+
+#include "async_poller.h"
+
+extern char	*CONFIG_SOURCE_IP;
+extern int	CONFIG_TIMEOUT;
+
+void	async_agent_init(void);
+int	async_agent_prepare(trx_async_item_t *item, DC_ITEM *dc_item);
+int	async_agent_batch_max(trx_uint64_t interfaceid);
+void	async_agent_start(trx_async_poller_t *poller, trx_async_item_t **items, int items_num);
+void	async_agent_free(trx_async_item_t *item);
+
+#endif
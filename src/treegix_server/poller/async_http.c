@@ -0,0 +1,382 @@
+
+
+#include "common.h"
+
+#include <event.h>
+
+#include "log.h"
+#include "dbcache.h"
+
+#include "poller.h"
+#include "async_http.h"
+#include "checks_http.h"
+
+#ifdef HAVE_LIBCURL
+
+/* the HTTP agent check in progress */
+typedef struct
+{
+	trx_async_poller_t	*poller;
+	trx_http_context_t	context;
+}
+trx_async_http_t;
+
+static struct event_base	*http_base;
+static CURLM			*http_multi;
+static struct event		http_timer;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_http_check_transfers                                       *
+ *                                                                            *
+ * Purpose: set results of items with completed transfers                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_http_check_transfers(void)
+{
+	CURLMsg			*msg;
+	trx_async_item_t	*item;
+	trx_async_http_t	*task;
+	char			*private_data;
+	int			msgs_num;
+
+	while (NULL != (msg = curl_multi_info_read(http_multi, &msgs_num)))
+	{
+		if (CURLMSG_DONE != msg->msg)
+			continue;
+
+		if (CURLE_OK != curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &private_data))
+		{
+			THIS_SHOULD_NEVER_HAPPEN;
+			curl_multi_remove_handle(http_multi, msg->easy_handle);
+			continue;
+		}
+
+		item = (trx_async_item_t *)private_data;
+		task = (trx_async_http_t *)item->task;
+
+		/* removing the handle frees the message, so the transfer result is processed first */
+		item->ret = trx_http_context_process(&task->context, msg->data.result, &item->result);
+		curl_multi_remove_handle(http_multi, task->context.easyhandle);
+
+		treegix_log(LOG_LEVEL_DEBUG, "%s() itemid:" TRX_FS_UI64 " key:'%s':%s", __func__, item->itemid,
+				item->key, trx_result_string(item->ret));
+
+		/* the destination key only limits concurrent checks, a failed URL must not make the waiting */
+		/* checks of other URLs of the same host requeued as unreachable                             */
+		async_poller_check_done(task->poller, item->interfaceid, SUCCEED);
+		async_poller_item_done(task->poller, item);
+		async_http_free(item);
+	}
+}
+
+static void	async_http_event_cb(evutil_socket_t fd, short what, void *arg)
+{
+	int	action = 0, running;
+
+	TRX_UNUSED(arg);
+
+	if (0 != (what & EV_READ))
+		action |= CURL_CSELECT_IN;
+
+	if (0 != (what & EV_WRITE))
+		action |= CURL_CSELECT_OUT;
+
+	curl_multi_socket_action(http_multi, fd, action, &running);
+	async_http_check_transfers();
+}
+
+static void	async_http_timer_cb(evutil_socket_t fd, short what, void *arg)
+{
+	int	running;
+
+	TRX_UNUSED(fd);
+	TRX_UNUSED(what);
+	TRX_UNUSED(arg);
+
+	curl_multi_socket_action(http_multi, CURL_SOCKET_TIMEOUT, 0, &running);
+	async_http_check_transfers();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_http_socket_cb                                             *
+ *                                                                            *
+ * Purpose: watch the transfer socket for events cURL is waiting for          *
+ *                                                                            *
+ * Comments: The socket event is kept as socket data assigned to the socket   *
+ *           in multi handle.                                                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	async_http_socket_cb(CURL *easyhandle, curl_socket_t s, int what, void *userp, void *socketp)
+{
+	struct event	*ev = (struct event *)socketp;
+	short		events = EV_PERSIST;
+
+	TRX_UNUSED(easyhandle);
+	TRX_UNUSED(userp);
+
+	if (CURL_POLL_REMOVE == what)
+	{
+		if (NULL != ev)
+		{
+			event_del(ev);
+			trx_free(ev);
+		}
+
+		return 0;
+	}
+
+	if (NULL == ev)
+	{
+		ev = (struct event *)trx_malloc(NULL, sizeof(struct event));
+		curl_multi_assign(http_multi, s, ev);
+	}
+	else
+		event_del(ev);
+
+	if (0 != (what & CURL_POLL_IN))
+		events |= EV_READ;
+
+	if (0 != (what & CURL_POLL_OUT))
+		events |= EV_WRITE;
+
+	event_set(ev, s, events, async_http_event_cb, NULL);
+	event_base_set(http_base, ev);
+	event_add(ev, NULL);
+
+	return 0;
+}
+
+static int	async_http_multi_timer_cb(CURLM *multi, long timeout_ms, void *userp)
+{
+	struct timeval	tv;
+
+	TRX_UNUSED(multi);
+	TRX_UNUSED(userp);
+
+	evtimer_del(&http_timer);
+
+	if (0 > timeout_ms)
+		return 0;
+
+	tv.tv_sec = timeout_ms / 1000;
+	tv.tv_usec = (timeout_ms % 1000) * 1000;
+	evtimer_add(&http_timer, &tv);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_http_destination                                           *
+ *                                                                            *
+ * Purpose: get the key of URL scheme, host and port to limit concurrent      *
+ *          checks of the same destination                                    *
+ *                                                                            *
+ * Parameters: url - [IN] the item URL with macros resolved                   *
+ *                                                                            *
+ * Return value: the hash of URL scheme and authority without user            *
+ *               credentials                                                  *
+ *                                                                            *
+ ******************************************************************************/
+static trx_uint64_t	async_http_destination(const char *url)
+{
+	const char	*host, *end, *ptr;
+	trx_hash_t	hash;
+
+	/* the scheme is optional, cURL assumes HTTP without it */
+	if (NULL != (ptr = strstr(url, "://")) && ptr < url + strcspn(url, "/?#"))
+		host = ptr + 3;
+	else
+		host = url;
+
+	hash = TRX_DEFAULT_STRING_HASH_ALGO(url, host - url, TRX_DEFAULT_HASH_SEED);
+	end = host + strcspn(host, "/?#");
+
+	for (ptr = host; ptr < end; ptr++)
+	{
+		if ('@' == *ptr)
+			host = ptr + 1;
+	}
+
+	return TRX_DEFAULT_STRING_HASH_ALGO(host, end - host, hash);
+}
+#endif	/* HAVE_LIBCURL */
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_http_init                                                  *
+ *                                                                            *
+ * Purpose: create cURL multi handle driven by the poller event loop          *
+ *                                                                            *
+ ******************************************************************************/
+void	async_http_init(trx_async_poller_t *poller)
+{
+#ifdef HAVE_LIBCURL
+	http_base = poller->base;
+
+	if (NULL == (http_multi = curl_multi_init()))
+	{
+		treegix_log(LOG_LEVEL_CRIT, "cannot initialize cURL multi handle");
+		exit(EXIT_FAILURE);
+	}
+
+	curl_multi_setopt(http_multi, CURLMOPT_SOCKETFUNCTION, async_http_socket_cb);
+	curl_multi_setopt(http_multi, CURLMOPT_TIMERFUNCTION, async_http_multi_timer_cb);
+
+	evtimer_set(&http_timer, async_http_timer_cb, NULL);
+	event_base_set(http_base, &http_timer);
+#else
+	TRX_UNUSED(poller);
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_http_prepare                                               *
+ *                                                                            *
+ * Purpose: prepare HTTP agent check of the item                              *
+ *                                                                            *
+ * Parameters: item    - [IN/OUT] the item                                    *
+ *             dc_item - [IN] the item with host data                         *
+ *                                                                            *
+ * Return value: SUCCEED - the check is prepared and must be started with     *
+ *                         async_http_start()                                 *
+ *               FAIL    - the check was completed without waiting, item      *
+ *                         result is set                                      *
+ *                                                                            *
+ * Comments: HTTP agent items do not need host interface, so the concurrent   *
+ *           checks are limited per host and port of item URL instead, with   *
+ *           MaxConcurrentHTTPChecksPerHost.                                  *
+ *                                                                            *
+ ******************************************************************************/
+int	async_http_prepare(trx_async_item_t *item, DC_ITEM *dc_item)
+{
+#ifdef HAVE_LIBCURL
+	trx_async_http_t	*task;
+	int			ret = FAIL;
+
+	if (SUCCEED != (item->ret = trx_prepare_httpagent_item(dc_item, &item->result)))
+		goto out;
+
+	task = (trx_async_http_t *)trx_malloc(NULL, sizeof(trx_async_http_t));
+	task->poller = NULL;
+
+	if (SUCCEED != trx_http_context_prepare(&task->context, dc_item, &item->result))
+	{
+		item->ret = NOTSUPPORTED;
+		trx_http_context_clean(&task->context);
+		trx_free(task);
+		goto out;
+	}
+
+	item->interfaceid = async_http_destination(dc_item->url);
+	item->task = task;
+	ret = SUCCEED;
+out:
+	trx_clean_httpagent_item(dc_item);
+
+	return ret;
+#else
+	TRX_UNUSED(dc_item);
+
+	SET_MSG_RESULT(&item->result, trx_strdup(NULL, "Support for HTTP agent checks was not compiled in."));
+	item->ret = CONFIG_ERROR;
+
+	return FAIL;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_http_batch_max                                             *
+ *                                                                            *
+ * Purpose: get the maximum number of items to check in one request           *
+ *                                                                            *
+ * Comments: Each item is a separate request, the requests to the same host   *
+ *           reuse connections instead.                                       *
+ *                                                                            *
+ ******************************************************************************/
+int	async_http_batch_max(trx_uint64_t interfaceid)
+{
+	TRX_UNUSED(interfaceid);
+
+	return 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_http_start                                                 *
+ *                                                                            *
+ * Purpose: start prepared HTTP agent check                                   *
+ *                                                                            *
+ * Parameters: poller    - [IN] the poller                                    *
+ *             items     - [IN] the item                                      *
+ *             items_num - [IN] the number of items, always 1                 *
+ *                                                                            *
+ * Comments: The item is passed back to poller with async_poller_item_done()  *
+ *           and the end of the check is reported with                        *
+ *           async_poller_check_done() when the transfer is completed.        *
+ *                                                                            *
+ ******************************************************************************/
+void	async_http_start(trx_async_poller_t *poller, trx_async_item_t **items, int items_num)
+{
+#ifdef HAVE_LIBCURL
+	trx_async_item_t	*item = items[0];
+	trx_async_http_t	*task = (trx_async_http_t *)item->task;
+	CURLMcode		merr;
+	CURLcode		err;
+
+	TRX_UNUSED(items_num);
+
+	treegix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' itemid:" TRX_FS_UI64, __func__, item->host, item->itemid);
+
+	task->poller = poller;
+
+	if (CURLE_OK != (err = curl_easy_setopt(task->context.easyhandle, CURLOPT_PRIVATE, item)))
+	{
+		SET_MSG_RESULT(&item->result, trx_dsprintf(NULL, "Cannot set private data: %s",
+				curl_easy_strerror(err)));
+		goto fail;
+	}
+
+	if (CURLM_OK != (merr = curl_multi_add_handle(http_multi, task->context.easyhandle)))
+	{
+		SET_MSG_RESULT(&item->result, trx_dsprintf(NULL, "Cannot perform request: %s",
+				curl_multi_strerror(merr)));
+		goto fail;
+	}
+
+	return;
+fail:
+	item->ret = NOTSUPPORTED;
+	async_poller_check_done(poller, item->interfaceid, SUCCEED);
+	async_poller_item_done(poller, item);
+	async_http_free(item);
+#else
+	TRX_UNUSED(poller);
+	TRX_UNUSED(items);
+	TRX_UNUSED(items_num);
+
+	THIS_SHOULD_NEVER_HAPPEN;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_http_free                                                  *
+ *                                                                            *
+ * Purpose: free check data of the item                                       *
+ *                                                                            *
+ ******************************************************************************/
+void	async_http_free(trx_async_item_t *item)
+{
+	if (NULL == item->task)
+		return;
+#ifdef HAVE_LIBCURL
+	trx_http_context_clean(&((trx_async_http_t *)item->task)->context);
+	trx_free(item->task);
+#endif
+	item->task = NULL;
+}
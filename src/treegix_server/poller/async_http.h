@@ -0,0 +1,14 @@
+
+
+#ifndef TREEGIX_ASYNC_HTTP_H
+#define TREEGIX_ASYNC_HTTP_H
+
+#include "async_poller.h"
+
+void	async_http_init(trx_async_poller_t *poller);
+int	async_http_prepare(trx_async_item_t *item, DC_ITEM *dc_item);
+int	async_http_batch_max(trx_uint64_t interfaceid);
+void	async_http_start(trx_async_poller_t *poller, trx_async_item_t **items, int items_num);
+void	async_http_free(trx_async_item_t *item);
+
+#endif
@@ -0,0 +1,613 @@
+
+
+#include "common.h"
+
+#include <event.h>
+#if defined(LIBEVENT_VERSION_NUMBER) && LIBEVENT_VERSION_NUMBER >= 0x2000000
+#	include <event2/dns.h>
+#	define HAVE_ASYNC_DNS
+#endif
+
+#include "db.h"
+#include "dbcache.h"
+#include "daemon.h"
+#include "log.h"
+#include "trxserver.h"
+#include "trxself.h"
+#include "preproc.h"
+#include "../../libs/trxcrypto/tls.h"
+
+#include "poller.h"
+#include "async_poller.h"
+#include "async_agent.h"
+#include "async_http.h"
+
+extern unsigned char	process_type, program_type;
+extern int		server_num, process_num;
+
+/* the interface checks, limited by MaxConcurrentChecksPerInterface, or the checks of URL host and port */
+/* limited by MaxConcurrentHTTPChecksPerHost for HTTP agent checks                                      */
+typedef struct
+{
+	trx_uint64_t	interfaceid;
+
+	/* the number of checks in progress */
+	int		checks_num;
+
+	/* prepared checks waiting until a check in progress is completed */
+	trx_queue_ptr_t	queue;
+}
+trx_async_interface_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_poller_item_done                                           *
+ *                                                                            *
+ * Purpose: accept the item of completed check                                *
+ *                                                                            *
+ * Comments: The check callbacks run inside event loop, so the items are only *
+ *           collected here and processed after the event loop iteration.     *
+ *                                                                            *
+ ******************************************************************************/
+void	async_poller_item_done(trx_async_poller_t *poller, trx_async_item_t *item)
+{
+	trx_vector_ptr_append(&poller->done, item);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_poller_check_done                                          *
+ *                                                                            *
+ * Purpose: release the interface slot of completed check                     *
+ *                                                                            *
+ * Parameters: poller      - [IN] the poller                                  *
+ *             interfaceid - [IN] the checked interface                       *
+ *             ret         - [IN] the check result, network errors make the   *
+ *                                waiting checks of interface requeued as     *
+ *                                unreachable                                 *
+ *                                                                            *
+ ******************************************************************************/
+void	async_poller_check_done(trx_async_poller_t *poller, trx_uint64_t interfaceid, int ret)
+{
+	trx_uint64_pair_t	pair;
+
+	pair.first = interfaceid;
+	pair.second = (NETWORK_ERROR == ret || TIMEOUT_ERROR == ret ? 1 : 0);
+
+	trx_vector_uint64_pair_append(&poller->released, pair);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_poller_prepare_check                                       *
+ *                                                                            *
+ * Purpose: prepare the check of item with the engine of poller type          *
+ *                                                                            *
+ * Return value: SUCCEED - the check is prepared and must be queued           *
+ *               FAIL    - the check was completed without waiting, item      *
+ *                         result is set                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	async_poller_prepare_check(trx_async_poller_t *poller, trx_async_item_t *item, DC_ITEM *dc_item)
+{
+	if (TRX_POLLER_TYPE_HTTPAGENT == poller->poller_type)
+		return async_http_prepare(item, dc_item);
+
+	return async_agent_prepare(item, dc_item);
+}
+
+static int	async_poller_batch_max(trx_async_poller_t *poller, trx_uint64_t interfaceid)
+{
+	if (TRX_POLLER_TYPE_HTTPAGENT == poller->poller_type)
+		return async_http_batch_max(interfaceid);
+
+	return async_agent_batch_max(interfaceid);
+}
+
+static void	async_poller_start_check(trx_async_poller_t *poller, trx_async_item_t **items, int items_num)
+{
+	if (TRX_POLLER_TYPE_HTTPAGENT == poller->poller_type)
+		async_http_start(poller, items, items_num);
+	else
+		async_agent_start(poller, items, items_num);
+}
+
+static void	async_poller_item_free(trx_async_poller_t *poller, trx_async_item_t *item)
+{
+	if (TRX_POLLER_TYPE_HTTPAGENT == poller->poller_type)
+		async_http_free(item);
+	else
+		async_agent_free(item);
+
+	trx_free(item->host);
+	trx_free(item->key_orig);
+	trx_free(item->key);
+	free_result(&item->result);
+	trx_free(item);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_poller_queue_check                                         *
+ *                                                                            *
+ * Purpose: add prepared check to the queue of its interface                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_poller_queue_check(trx_async_poller_t *poller, trx_async_item_t *item)
+{
+	trx_async_interface_t	*interface, interface_local;
+
+	if (NULL == (interface = (trx_async_interface_t *)trx_hashset_search(&poller->interfaces,
+			&item->interfaceid)))
+	{
+		interface_local.interfaceid = item->interfaceid;
+		interface_local.checks_num = 0;
+		interface = (trx_async_interface_t *)trx_hashset_insert(&poller->interfaces, &interface_local,
+				sizeof(interface_local));
+		trx_queue_ptr_create(&interface->queue);
+	}
+
+	trx_queue_ptr_push(&interface->queue, item);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_poller_start_checks                                        *
+ *                                                                            *
+ * Purpose: start the queued checks of interface in batches, as many as the   *
+ *          interface limit allows                                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_poller_start_checks(trx_async_poller_t *poller, trx_async_interface_t *interface)
+{
+	trx_vector_ptr_t	batch;
+	trx_async_item_t	*item;
+	int			batch_max;
+
+	trx_vector_ptr_create(&batch);
+
+	while (poller->interface_checks_max > interface->checks_num &&
+			SUCCEED != trx_queue_ptr_empty(&interface->queue))
+	{
+		batch_max = async_poller_batch_max(poller, interface->interfaceid);
+
+		while (batch.values_num < batch_max && NULL != (item = (trx_async_item_t *)trx_queue_ptr_pop(
+				&interface->queue)))
+		{
+			trx_vector_ptr_append(&batch, item);
+		}
+
+		interface->checks_num++;
+		async_poller_start_check(poller, (trx_async_item_t **)batch.values, batch.values_num);
+
+		trx_vector_ptr_clear(&batch);
+	}
+
+	trx_vector_ptr_destroy(&batch);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_poller_get_items                                           *
+ *                                                                            *
+ * Purpose: take due items from configuration cache and start their checks    *
+ *                                                                            *
+ * Parameters: poller   - [IN] the poller                                     *
+ *             items    - [IN] buffer for items taken from configuration      *
+ *                             cache, MAX_POLLER_ITEMS in size                *
+ *             more     - [OUT] 1 if there can be more due items in queue,    *
+ *                              0 otherwise                                   *
+ *                                                                            *
+ * Return value: the number of items taken                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	async_poller_get_items(trx_async_poller_t *poller, DC_ITEM *items, int *more)
+{
+	int			i, num, max_items;
+	char			*port = NULL, error[ITEM_ERROR_LEN_MAX];
+	trx_async_item_t	*item;
+	trx_async_interface_t	*interface;
+	trx_vector_uint64_t	interfaceids;
+
+	*more = 0;
+
+	if (0 >= (max_items = MIN(MAX_POLLER_ITEMS, CONFIG_MAX_CONCURRENT_CHECKS_PER_POLLER - poller->items_num)))
+		return 0;
+
+	if (0 == (num = DCconfig_get_async_poller_items(poller->poller_type, items, max_items)))
+		return 0;
+
+	if (num == max_items)
+		*more = 1;
+
+	poller->items_num += num;
+
+	trx_vector_uint64_create(&interfaceids);
+
+	for (i = 0; i < num; i++)
+	{
+		item = (trx_async_item_t *)trx_malloc(NULL, sizeof(trx_async_item_t));
+
+		item->itemid = items[i].itemid;
+		item->hostid = items[i].host.hostid;
+		item->interfaceid = items[i].interface.interfaceid;
+		item->host = trx_strdup(NULL, items[i].host.host);
+		item->key_orig = trx_strdup(NULL, items[i].key_orig);
+		item->key = NULL;
+		item->type = items[i].type;
+		item->value_type = items[i].value_type;
+		item->flags = items[i].flags;
+		item->state = items[i].state;
+		item->availability.flags = 0;
+		item->availability.available = items[i].host.available;
+		item->availability.error = NULL;
+		item->availability.errors_from = items[i].host.errors_from;
+		item->availability.disable_until = items[i].host.disable_until;
+		item->task = NULL;
+		item->ret = SUCCEED;
+		init_result(&item->result);
+
+		TRX_STRDUP(items[i].key, items[i].key_orig);
+		if (SUCCEED != substitute_key_macros(&items[i].key, NULL, &items[i], NULL, NULL,
+				MACRO_TYPE_ITEM_KEY, error, sizeof(error)))
+		{
+			SET_MSG_RESULT(&item->result, trx_strdup(NULL, error));
+			item->ret = CONFIG_ERROR;
+		}
+
+		/* the key is owned by async item, DCconfig_clean_items() does not free it */
+		item->key = items[i].key;
+
+		/* HTTP agent items can be checked without host interface */
+		if (SUCCEED == item->ret && ITEM_TYPE_HTTPAGENT != items[i].type)
+		{
+			TRX_STRDUP(port, items[i].interface.port_orig);
+			substitute_simple_macros(NULL, NULL, NULL, NULL, &items[i].host.hostid, NULL, NULL, NULL,
+					NULL, &port, MACRO_TYPE_COMMON, NULL, 0);
+
+			if (FAIL == is_ushort(port, &items[i].interface.port))
+			{
+				SET_MSG_RESULT(&item->result, trx_dsprintf(NULL, "Invalid port number [%s]",
+						items[i].interface.port_orig));
+				item->ret = CONFIG_ERROR;
+			}
+		}
+
+		if (SUCCEED != item->ret || SUCCEED != async_poller_prepare_check(poller, item, &items[i]))
+		{
+			trx_vector_ptr_append(&poller->results, item);
+			continue;
+		}
+
+		async_poller_queue_check(poller, item);
+		trx_vector_uint64_append(&interfaceids, item->interfaceid);
+	}
+
+	trx_free(port);
+
+	DCconfig_clean_items(items, NULL, num);
+
+	/* start checks after all items are queued, so the due items of interface are batched together */
+	trx_vector_uint64_sort(&interfaceids, TRX_DEFAULT_UINT64_COMPARE_FUNC);
+	trx_vector_uint64_uniq(&interfaceids, TRX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	for (i = 0; i < interfaceids.values_num; i++)
+	{
+		if (NULL != (interface = (trx_async_interface_t *)trx_hashset_search(&poller->interfaces,
+				&interfaceids.values[i])))
+		{
+			async_poller_start_checks(poller, interface);
+		}
+	}
+
+	trx_vector_uint64_destroy(&interfaceids);
+
+	return num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_poller_requeue_unreachable                                 *
+ *                                                                            *
+ * Purpose: return the checks waiting for interface back to queue when the    *
+ *          interface is not reachable                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_poller_requeue_unreachable(trx_async_poller_t *poller, trx_async_interface_t *interface)
+{
+	trx_vector_uint64_t	itemids;
+	trx_async_item_t	*item;
+
+	if (SUCCEED == trx_queue_ptr_empty(&interface->queue))
+		return;
+
+	trx_vector_uint64_create(&itemids);
+
+	while (NULL != (item = (trx_async_item_t *)trx_queue_ptr_pop(&interface->queue)))
+	{
+		trx_vector_uint64_append(&itemids, item->itemid);
+		async_poller_item_free(poller, item);
+	}
+
+	trx_dc_requeue_unreachable_items(itemids.values, itemids.values_num);
+	poller->items_num -= itemids.values_num;
+
+	trx_vector_uint64_destroy(&itemids);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_poller_process_done                                        *
+ *                                                                            *
+ * Purpose: release interface slots of completed checks and start the checks  *
+ *          waiting for them                                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_poller_process_done(trx_async_poller_t *poller)
+{
+	int			i;
+	trx_uint64_pair_t	pair;
+	trx_async_interface_t	*interface;
+
+	/* starting next checks can complete them immediately, extending the vector */
+	for (i = 0; i < poller->released.values_num; i++)
+	{
+		pair = poller->released.values[i];
+
+		if (NULL == (interface = (trx_async_interface_t *)trx_hashset_search(&poller->interfaces,
+				&pair.first)))
+		{
+			THIS_SHOULD_NEVER_HAPPEN;
+			continue;
+		}
+
+		interface->checks_num--;
+
+		if (0 != pair.second)
+			async_poller_requeue_unreachable(poller, interface);
+
+		async_poller_start_checks(poller, interface);
+
+		if (0 == interface->checks_num)
+		{
+			trx_queue_ptr_destroy(&interface->queue);
+			trx_hashset_remove_direct(&poller->interfaces, interface);
+		}
+	}
+
+	trx_vector_uint64_pair_clear(&poller->released);
+
+	trx_vector_ptr_append_array(&poller->results, poller->done.values, poller->done.values_num);
+	trx_vector_ptr_clear(&poller->done);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_poller_process_results                                     *
+ *                                                                            *
+ * Purpose: update host availability, pass values to preprocessing and        *
+ *          requeue the items of completed checks                             *
+ *                                                                            *
+ * Return value: the number of processed items                                *
+ *                                                                            *
+ ******************************************************************************/
+static int	async_poller_process_results(trx_async_poller_t *poller)
+{
+	int			i, num, nextcheck, *lastclocks, *errcodes;
+	trx_uint64_t		*itemids;
+	unsigned char		*states;
+	trx_timespec_t		timespec;
+	trx_async_item_t	*item;
+
+	async_poller_process_done(poller);
+
+	if (0 == (num = poller->results.values_num))
+		return 0;
+
+	itemids = (trx_uint64_t *)trx_malloc(NULL, sizeof(trx_uint64_t) * num);
+	states = (unsigned char *)trx_malloc(NULL, sizeof(unsigned char) * num);
+	lastclocks = (int *)trx_malloc(NULL, sizeof(int) * num);
+	errcodes = (int *)trx_malloc(NULL, sizeof(int) * num);
+
+	trx_timespec(&timespec);
+
+	for (i = 0; i < num; i++)
+	{
+		item = (trx_async_item_t *)poller->results.values[i];
+
+		switch (item->ret)
+		{
+			case SUCCEED:
+			case NOTSUPPORTED:
+			case AGENT_ERROR:
+				trx_activate_host_agent(item->hostid, item->host, item->type, &item->availability,
+						&timespec);
+				break;
+			case NETWORK_ERROR:
+			case GATEWAY_ERROR:
+			case TIMEOUT_ERROR:
+				trx_deactivate_host_agent(item->hostid, item->host, item->type, item->key_orig,
+						&item->availability, &timespec, item->result.msg);
+				break;
+			case CONFIG_ERROR:
+				/* nothing to do */
+				break;
+			default:
+				trx_error("unknown response code returned: %d", item->ret);
+				THIS_SHOULD_NEVER_HAPPEN;
+		}
+
+		if (SUCCEED == item->ret)
+		{
+			item->state = ITEM_STATE_NORMAL;
+			trx_preprocess_item_value(item->itemid, item->value_type, item->flags, &item->result,
+					&timespec, item->state, NULL);
+		}
+		else if (NOTSUPPORTED == item->ret || AGENT_ERROR == item->ret || CONFIG_ERROR == item->ret)
+		{
+			item->state = ITEM_STATE_NOTSUPPORTED;
+			trx_preprocess_item_value(item->itemid, item->value_type, item->flags, NULL, &timespec,
+					item->state, item->result.msg);
+		}
+
+		itemids[i] = item->itemid;
+		states[i] = item->state;
+		lastclocks[i] = timespec.sec;
+		errcodes[i] = item->ret;
+
+		async_poller_item_free(poller, item);
+	}
+
+	DCpoller_requeue_items(itemids, states, lastclocks, errcodes, num, poller->poller_type, &nextcheck);
+	trx_preprocessor_flush();
+
+	poller->items_num -= num;
+	trx_vector_ptr_clear(&poller->results);
+
+	trx_free(errcodes);
+	trx_free(lastclocks);
+	trx_free(states);
+	trx_free(itemids);
+
+	return num;
+}
+
+static void	async_poller_timer_cb(evutil_socket_t fd, short what, void *arg)
+{
+	TRX_UNUSED(fd);
+	TRX_UNUSED(what);
+	TRX_UNUSED(arg);
+}
+
+static void	async_poller_init(trx_async_poller_t *poller, unsigned char poller_type)
+{
+	poller->poller_type = poller_type;
+	poller->items_num = 0;
+
+	poller->base = event_base_new();
+#ifdef HAVE_ASYNC_DNS
+	{
+		char	timeout[MAX_ID_LEN];
+
+		poller->dnsbase = evdns_base_new(poller->base, 1);
+
+		/* resolving is a part of the check and must fit in the same timeout */
+		trx_snprintf(timeout, sizeof(timeout), "%d", CONFIG_TIMEOUT);
+		evdns_base_set_option(poller->dnsbase, "timeout:", timeout);
+		evdns_base_set_option(poller->dnsbase, "attempts:", "1");
+	}
+#else
+	poller->dnsbase = NULL;
+#endif
+	if (TRX_POLLER_TYPE_HTTPAGENT == poller_type)
+		poller->interface_checks_max = CONFIG_MAX_CONCURRENT_HTTP_CHECKS_PER_HOST;
+	else
+		poller->interface_checks_max = CONFIG_MAX_CONCURRENT_CHECKS_PER_INTERFACE;
+
+	if (TRX_POLLER_TYPE_AGENT == poller_type)
+		async_agent_init();
+	else if (TRX_POLLER_TYPE_HTTPAGENT == poller_type)
+		async_http_init(poller);
+
+	trx_hashset_create(&poller->interfaces, 100, TRX_DEFAULT_UINT64_HASH_FUNC, TRX_DEFAULT_UINT64_COMPARE_FUNC);
+	trx_vector_ptr_create(&poller->done);
+	trx_vector_uint64_pair_create(&poller->released);
+	trx_vector_ptr_create(&poller->results);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: async_poller_thread                                              *
+ *                                                                            *
+ * Purpose: poll items of the poller type keeping many checks in progress at  *
+ *          the same time                                                     *
+ *                                                                            *
+ * Comments: Passive agent checks and HTTP agent checks are polled           *
+ *           asynchronously.                                                  *
+ *                                                                            *
+ ******************************************************************************/
+TRX_THREAD_ENTRY(async_poller_thread, args)
+{
+	trx_async_poller_t	poller;
+	DC_ITEM			*items;
+	struct event		timer;
+	struct timeval		tv;
+	int			nextcheck, sleeptime, more, processed = 0;
+	double			sec, time_stat, time_idle = 0;
+	unsigned char		poller_type;
+
+#define	STAT_INTERVAL	5	/* if a process is busy and does not sleep then update status not faster than */
+				/* once in STAT_INTERVAL seconds */
+
+	poller_type = *(unsigned char *)((trx_thread_args_t *)args)->args;
+	process_type = ((trx_thread_args_t *)args)->process_type;
+
+	server_num = ((trx_thread_args_t *)args)->server_num;
+	process_num = ((trx_thread_args_t *)args)->process_num;
+
+	treegix_log(LOG_LEVEL_INFORMATION, "%s #%d started [%s #%d]", get_program_type_string(program_type),
+			server_num, get_process_type_string(process_type), process_num);
+
+#if defined(HAVE_POLARSSL) || defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+	trx_tls_init_child();
+#endif
+	trx_setproctitle("%s #%d [connecting to the database]", get_process_type_string(process_type), process_num);
+
+	DBconnect(TRX_DB_CONNECT_NORMAL);
+
+	async_poller_init(&poller, poller_type);
+	items = (DC_ITEM *)trx_malloc(NULL, sizeof(DC_ITEM) * MAX_POLLER_ITEMS);
+
+	evtimer_set(&timer, async_poller_timer_cb, NULL);
+	event_base_set(poller.base, &timer);
+
+	time_stat = trx_time();
+
+	while (TRX_IS_RUNNING())
+	{
+		sec = trx_time();
+		trx_update_env(sec);
+
+		if (STAT_INTERVAL <= sec - time_stat)
+		{
+			trx_setproctitle("%s #%d [got %d values, %d checks in progress, idle " TRX_FS_DBL " sec during "
+					TRX_FS_DBL " sec]", get_process_type_string(process_type), process_num,
+					processed, poller.items_num, time_idle, sec - time_stat);
+
+			processed = 0;
+			time_idle = 0;
+			time_stat = sec;
+		}
+
+		async_poller_get_items(&poller, items, &more);
+		processed += async_poller_process_results(&poller);
+
+		if (CONFIG_MAX_CONCURRENT_CHECKS_PER_POLLER <= poller.items_num)
+			sleeptime = POLLER_DELAY;
+		else if (0 != more)
+			sleeptime = 0;
+		else if (FAIL != (nextcheck = DCconfig_get_poller_nextcheck(poller_type)))
+			sleeptime = calculate_sleeptime(nextcheck, POLLER_DELAY);
+		else
+			sleeptime = POLLER_DELAY;
+
+		/* wait for check events, but not longer than until the next item is due */
+		tv.tv_sec = sleeptime;
+		tv.tv_usec = 0;
+		evtimer_add(&timer, &tv);
+
+		sec = trx_time();
+		update_selfmon_counter(TRX_PROCESS_STATE_IDLE);
+		event_base_loop(poller.base, EVLOOP_ONCE);
+		update_selfmon_counter(TRX_PROCESS_STATE_BUSY);
+		time_idle += trx_time() - sec;
+
+		evtimer_del(&timer);
+	}
+
+	trx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
+
+	while (1)
+		trx_sleep(SEC_PER_MIN);
+#undef STAT_INTERVAL
+}
@@ -0,0 +1,74 @@
+
+
+#ifndef TREEGIX_ASYNC_POLLER_H
+#define TREEGIX_ASYNC_POLLER_H
+
+#include "threads.h"
+#include "dbcache.h"
+#include "sysinfo.h"
+
+extern int	CONFIG_MAX_CONCURRENT_CHECKS_PER_POLLER;
+extern int	CONFIG_MAX_CONCURRENT_CHECKS_PER_INTERFACE;
+extern int	CONFIG_MAX_CONCURRENT_HTTP_CHECKS_PER_HOST;
+
+struct event_base;
+struct evdns_base;
+
+/* the item data kept while asynchronous check is in progress */
+typedef struct
+{
+	trx_uint64_t			itemid;
+	trx_uint64_t			hostid;
+	trx_uint64_t			interfaceid;
+	char				*host;
+	char				*key_orig;
+	char				*key;
+	unsigned char			type;
+	unsigned char			value_type;
+	unsigned char			flags;
+	unsigned char			state;
+
+	/* the agent availability at the time item was taken from configuration cache */
+	trx_agent_availability_t	availability;
+
+	AGENT_RESULT			result;
+	int				ret;
+
+	/* the check specific data, see async_agent_prepare() and async_http_prepare() */
+	void				*task;
+}
+trx_async_item_t;
+
+typedef struct
+{
+	unsigned char			poller_type;
+
+	struct event_base		*base;
+	struct evdns_base		*dnsbase;
+
+	/* the number of items taken from configuration cache and not yet requeued */
+	int				items_num;
+
+	/* the maximum number of checks of one interface in progress at the same time */
+	int				interface_checks_max;
+
+	/* interfaces with checks in progress, see trx_async_interface_t */
+	trx_hashset_t			interfaces;
+
+	/* items passed back by async_poller_item_done() */
+	trx_vector_ptr_t		done;
+
+	/* interfaces of checks reported by async_poller_check_done(), with 1 for unreachable ones */
+	trx_vector_uint64_pair_t	released;
+
+	/* items with results ready to be processed and requeued */
+	trx_vector_ptr_t		results;
+}
+trx_async_poller_t;
+
+void	async_poller_item_done(trx_async_poller_t *poller, trx_async_item_t *item);
+void	async_poller_check_done(trx_async_poller_t *poller, trx_uint64_t interfaceid, int ret);
+
+TRX_THREAD_ENTRY(async_poller_thread, args);
+
+#endif
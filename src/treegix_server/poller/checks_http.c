@@ -14,14 +14,6 @@
 #define HTTP_STORE_RAW		0
 #define HTTP_STORE_JSON		1
 
-typedef struct
-{
-	char	*data;
-	size_t	allocated;
-	size_t	offset;
-}
-trx_http_response_t;
-
 static const char	*trx_request_string(int result)
 {
 	switch (result)
@@ -189,28 +181,49 @@ static void	http_output_json(unsigned char retrieve_mode, char **buffer, trx_htt
 	trx_json_free(&json);
 }
 
-int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_http_context_prepare                                         *
+ *                                                                            *
+ * Purpose: create and set up cURL easy handle for HTTP agent item request    *
+ *                                                                            *
+ * Parameters: context - [OUT] the request context                            *
+ *             item    - [IN] the item with resolved macros                   *
+ *             result  - [OUT] the error message on failure                   *
+ *                                                                            *
+ * Return value: SUCCEED - the request is ready to be performed               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The context does not refer to item data, so it can outlive the   *
+ *           item. It must be freed with trx_http_context_clean() also when   *
+ *           preparing fails.                                                 *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_http_context_prepare(trx_http_context_t *context, const DC_ITEM *item, AGENT_RESULT *result)
 {
-	CURL			*easyhandle;
-	CURLcode		err;
-	char			url[ITEM_URL_LEN_MAX], errbuf[CURL_ERROR_SIZE], *error = NULL, *headers, *line, *buffer;
-	int			ret = NOTSUPPORTED, timeout_seconds, found = FAIL;
-	long			response_code;
-	struct curl_slist	*headers_slist = NULL;
-	struct trx_json		json;
-	trx_http_response_t	body = {0}, header = {0};
-	size_t			(*curl_body_cb)(void *ptr, size_t size, size_t nmemb, void *userdata);
-	char			application_json[] = {"Content-Type: application/json"};
-	char			application_xml[] = {"Content-Type: application/xml"};
+	CURLcode	err;
+	char		url[ITEM_URL_LEN_MAX], *error = NULL, *headers, *line;
+	int		timeout_seconds, found = FAIL;
+	size_t		(*curl_body_cb)(void *ptr, size_t size, size_t nmemb, void *userdata);
+	char		application_json[] = {"Content-Type: application/json"};
+	char		application_xml[] = {"Content-Type: application/xml"};
 
 	treegix_log(LOG_LEVEL_DEBUG, "In %s() request method '%s' URL '%s%s' headers '%s' message body '%s'",
 			__func__, trx_request_string(item->request_method), item->url, item->query_fields,
 			item->headers, item->posts);
 
-	if (NULL == (easyhandle = curl_easy_init()))
+	memset(context, 0, sizeof(trx_http_context_t));
+
+	/* cURL does not copy the POST data, the item can be freed before the request is performed */
+	context->posts = trx_strdup(NULL, item->posts);
+	context->status_codes = trx_strdup(NULL, item->status_codes);
+	context->retrieve_mode = item->retrieve_mode;
+	context->output_format = item->output_format;
+
+	if (NULL == (context->easyhandle = curl_easy_init()))
 	{
 		SET_MSG_RESULT(result, trx_strdup(NULL, "Cannot initialize cURL library"));
-		goto clean;
+		return FAIL;
 	}
 
 	switch (item->retrieve_mode)
@@ -225,97 +238,104 @@ int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
 		default:
 			THIS_SHOULD_NEVER_HAPPEN;
 			SET_MSG_RESULT(result, trx_dsprintf(NULL, "Invalid retrieve mode"));
-			goto clean;
+			return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HEADERFUNCTION, curl_write_cb)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_HEADERFUNCTION, curl_write_cb)))
 	{
 		SET_MSG_RESULT(result, trx_dsprintf(NULL, "Cannot set header function: %s",
 				curl_easy_strerror(err)));
-		goto clean;
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HEADERDATA, &header)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_HEADERDATA, &context->header)))
 	{
 		SET_MSG_RESULT(result, trx_dsprintf(NULL, "Cannot set header callback: %s",
 				curl_easy_strerror(err)));
-		goto clean;
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_WRITEFUNCTION, curl_body_cb)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_WRITEFUNCTION, curl_body_cb)))
 	{
 		SET_MSG_RESULT(result, trx_dsprintf(NULL, "Cannot set write function: %s", curl_easy_strerror(err)));
-		goto clean;
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_WRITEDATA, &body)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_WRITEDATA, &context->body)))
 	{
 		SET_MSG_RESULT(result, trx_dsprintf(NULL, "Cannot set write callback: %s", curl_easy_strerror(err)));
-		goto clean;
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_ERRORBUFFER, errbuf)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_ERRORBUFFER, context->errbuf)))
 	{
 		SET_MSG_RESULT(result, trx_dsprintf(NULL, "Cannot set error buffer: %s", curl_easy_strerror(err)));
-		goto clean;
+		return FAIL;
+	}
+
+	if (SUCCEED != trx_http_prepare_share(context->easyhandle, &error))
+	{
+		SET_MSG_RESULT(result, error);
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_PROXY, item->http_proxy)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_PROXY, item->http_proxy)))
 	{
 		SET_MSG_RESULT(result, trx_dsprintf(NULL, "Cannot set proxy: %s", curl_easy_strerror(err)));
-		goto clean;
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_FOLLOWLOCATION,
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_FOLLOWLOCATION,
 			0 == item->follow_redirects ? 0L : 1L)))
 	{
 		SET_MSG_RESULT(result, trx_dsprintf(NULL, "Cannot set follow redirects: %s", curl_easy_strerror(err)));
-		goto clean;
+		return FAIL;
 	}
 
-	if (0 != item->follow_redirects &&
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_MAXREDIRS, TRX_CURLOPT_MAXREDIRS)))
+	if (0 != item->follow_redirects && CURLE_OK != (err = curl_easy_setopt(context->easyhandle,
+			CURLOPT_MAXREDIRS, TRX_CURLOPT_MAXREDIRS)))
 	{
 		SET_MSG_RESULT(result, trx_dsprintf(NULL, "Cannot set number of redirects allowed: %s",
 				curl_easy_strerror(err)));
-		goto clean;
+		return FAIL;
 	}
 
 	if (FAIL == is_time_suffix(item->timeout, &timeout_seconds, strlen(item->timeout)))
 	{
 		SET_MSG_RESULT(result, trx_dsprintf(NULL, "Invalid timeout: %s", item->timeout));
-		goto clean;
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_TIMEOUT, (long)timeout_seconds)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_TIMEOUT, (long)timeout_seconds)))
 	{
 		SET_MSG_RESULT(result, trx_dsprintf(NULL, "Cannot specify timeout: %s", curl_easy_strerror(err)));
-		goto clean;
+		return FAIL;
 	}
 
-	if (SUCCEED != trx_http_prepare_ssl(easyhandle, item->ssl_cert_file, item->ssl_key_file, item->ssl_key_password,
-			item->verify_peer, item->verify_host, &error))
+	if (SUCCEED != trx_http_prepare_ssl(context->easyhandle, item->ssl_cert_file, item->ssl_key_file,
+			item->ssl_key_password, item->verify_peer, item->verify_host, &error))
 	{
 		SET_MSG_RESULT(result, error);
-		goto clean;
+		return FAIL;
 	}
 
-	if (SUCCEED != trx_http_prepare_auth(easyhandle, item->authtype, item->username, item->password, &error))
+	if (SUCCEED != trx_http_prepare_auth(context->easyhandle, item->authtype, item->username, item->password,
+			&error))
 	{
 		SET_MSG_RESULT(result, error);
-		goto clean;
+		return FAIL;
 	}
 
-	if (SUCCEED != http_prepare_request(easyhandle, item->posts, item->request_method, &error))
+	if (SUCCEED != http_prepare_request(context->easyhandle, context->posts, item->request_method, &error))
 	{
 		SET_MSG_RESULT(result, error);
-		goto clean;
+		return FAIL;
 	}
 
 	headers = item->headers;
 	while (NULL != (line = trx_http_get_header(&headers)))
 	{
-		headers_slist = curl_slist_append(headers_slist, line);
+		context->headers_slist = curl_slist_append(context->headers_slist, line);
 
 		if (FAIL == found && 0 == strncmp(line, "Content-Type:", TRX_CONST_STRLEN("Content-Type:")))
 			found = SUCCEED;
@@ -326,99 +346,123 @@ int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
 	if (FAIL == found)
 	{
 		if (TRX_POSTTYPE_JSON == item->post_type)
-			headers_slist = curl_slist_append(headers_slist, application_json);
+			context->headers_slist = curl_slist_append(context->headers_slist, application_json);
 		else if (TRX_POSTTYPE_XML == item->post_type)
-			headers_slist = curl_slist_append(headers_slist, application_xml);
+			context->headers_slist = curl_slist_append(context->headers_slist, application_xml);
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HTTPHEADER, headers_slist)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_HTTPHEADER, context->headers_slist)))
 	{
 		SET_MSG_RESULT(result, trx_dsprintf(NULL, "Cannot specify headers: %s", curl_easy_strerror(err)));
-		goto clean;
+		return FAIL;
 	}
 
 #if LIBCURL_VERSION_NUM >= 0x071304
 	/* CURLOPT_PROTOCOLS is supported starting with version 7.19.4 (0x071304) */
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_PROTOCOLS, CURLPROTO_HTTP | CURLPROTO_HTTPS)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_PROTOCOLS,
+			(long)(CURLPROTO_HTTP | CURLPROTO_HTTPS))))
 	{
 		SET_MSG_RESULT(result, trx_dsprintf(NULL, "Cannot set allowed protocols: %s", curl_easy_strerror(err)));
-		goto clean;
+		return FAIL;
 	}
 #endif
 
 	trx_snprintf(url, sizeof(url),"%s%s", item->url, item->query_fields);
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_URL, url)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_URL, url)))
 	{
 		SET_MSG_RESULT(result, trx_dsprintf(NULL, "Cannot specify URL: %s", curl_easy_strerror(err)));
-		goto clean;
+		return FAIL;
 	}
 
-	*errbuf = '\0';
+	*context->errbuf = '\0';
+
+	return SUCCEED;
+}
 
-	if (CURLE_OK != (err = curl_easy_perform(easyhandle)))
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_http_context_process                                         *
+ *                                                                            *
+ * Purpose: check the response of performed request and set item result       *
+ *                                                                            *
+ * Parameters: context - [IN] the request context                             *
+ *             err     - [IN] the transfer result                             *
+ *             result  - [OUT] the item value or error message                *
+ *                                                                            *
+ * Return value: SUCCEED      - the value is set                              *
+ *               NOTSUPPORTED - otherwise                                     *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_http_context_process(trx_http_context_t *context, CURLcode err, AGENT_RESULT *result)
+{
+	char		*headers, *line, *buffer;
+	long		response_code;
+	struct trx_json	json;
+
+	if (CURLE_OK != err)
 	{
 		SET_MSG_RESULT(result, trx_dsprintf(NULL, "Cannot perform request: %s",
-				'\0' == *errbuf ? curl_easy_strerror(err) : errbuf));
-		goto clean;
+				'\0' == *context->errbuf ? curl_easy_strerror(err) : context->errbuf));
+		return NOTSUPPORTED;
 	}
 
-	if (CURLE_OK != (err = curl_easy_getinfo(easyhandle, CURLINFO_RESPONSE_CODE, &response_code)))
+	if (CURLE_OK != (err = curl_easy_getinfo(context->easyhandle, CURLINFO_RESPONSE_CODE, &response_code)))
 	{
 		SET_MSG_RESULT(result, trx_dsprintf(NULL, "Cannot get the response code: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	if ('\0' != *item->status_codes && FAIL == int_in_list(item->status_codes, response_code))
+	if ('\0' != *context->status_codes && FAIL == int_in_list(context->status_codes, response_code))
 	{
 		SET_MSG_RESULT(result, trx_dsprintf(NULL, "Response code \"%ld\" did not match any of the"
-				" required status codes \"%s\"", response_code, item->status_codes));
-		goto clean;
+				" required status codes \"%s\"", response_code, context->status_codes));
+		return NOTSUPPORTED;
 	}
 
-	if (NULL == header.data)
+	if (NULL == context->header.data)
 	{
 		SET_MSG_RESULT(result, trx_dsprintf(NULL, "Server returned empty header"));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	switch (item->retrieve_mode)
+	switch (context->retrieve_mode)
 	{
 		case TRX_RETRIEVE_MODE_CONTENT:
-			if (NULL == body.data)
+			if (NULL == context->body.data)
 			{
 				SET_MSG_RESULT(result, trx_dsprintf(NULL, "Server returned empty content"));
-				goto clean;
+				return NOTSUPPORTED;
 			}
 
-			if (FAIL == trx_is_utf8(body.data))
+			if (FAIL == trx_is_utf8(context->body.data))
 			{
 				SET_MSG_RESULT(result, trx_dsprintf(NULL, "Server returned invalid UTF-8 sequence"));
-				goto clean;
+				return NOTSUPPORTED;
 			}
 
-			if (HTTP_STORE_JSON == item->output_format)
+			if (HTTP_STORE_JSON == context->output_format)
 			{
-				http_output_json(item->retrieve_mode, &buffer, &header, &body);
+				http_output_json(context->retrieve_mode, &buffer, &context->header, &context->body);
 				SET_TEXT_RESULT(result, buffer);
 			}
 			else
 			{
-				SET_TEXT_RESULT(result, body.data);
-				body.data = NULL;
+				SET_TEXT_RESULT(result, context->body.data);
+				context->body.data = NULL;
 			}
 			break;
 		case TRX_RETRIEVE_MODE_HEADERS:
-			if (FAIL == trx_is_utf8(header.data))
+			if (FAIL == trx_is_utf8(context->header.data))
 			{
 				SET_MSG_RESULT(result, trx_dsprintf(NULL, "Server returned invalid UTF-8 sequence"));
-				goto clean;
+				return NOTSUPPORTED;
 			}
 
-			if (HTTP_STORE_JSON == item->output_format)
+			if (HTTP_STORE_JSON == context->output_format)
 			{
 				trx_json_init(&json, TRX_JSON_STAT_BUF_LEN);
 				trx_json_addobject(&json, "header");
-				headers = header.data;
+				headers = context->header.data;
 				while (NULL != (line = trx_http_get_header(&headers)))
 				{
 					http_add_json_header(&json, line);
@@ -429,38 +473,70 @@ int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
 			}
 			else
 			{
-				SET_TEXT_RESULT(result, header.data);
-				header.data = NULL;
+				SET_TEXT_RESULT(result, context->header.data);
+				context->header.data = NULL;
 			}
 			break;
 		case TRX_RETRIEVE_MODE_BOTH:
-			if (FAIL == trx_is_utf8(header.data) || (NULL != body.data && FAIL == trx_is_utf8(body.data)))
+			if (FAIL == trx_is_utf8(context->header.data) ||
+					(NULL != context->body.data && FAIL == trx_is_utf8(context->body.data)))
 			{
 				SET_MSG_RESULT(result, trx_dsprintf(NULL, "Server returned invalid UTF-8 sequence"));
-				goto clean;
+				return NOTSUPPORTED;
 			}
 
-			if (HTTP_STORE_JSON == item->output_format)
+			if (HTTP_STORE_JSON == context->output_format)
 			{
-				http_output_json(item->retrieve_mode, &buffer, &header, &body);
+				http_output_json(context->retrieve_mode, &buffer, &context->header, &context->body);
 				SET_TEXT_RESULT(result, buffer);
 			}
 			else
 			{
-				trx_strncpy_alloc(&header.data, &header.allocated, &header.offset,
-						body.data, body.offset);
-				SET_TEXT_RESULT(result, header.data);
-				header.data = NULL;
+				trx_strncpy_alloc(&context->header.data, &context->header.allocated,
+						&context->header.offset, context->body.data, context->body.offset);
+				SET_TEXT_RESULT(result, context->header.data);
+				context->header.data = NULL;
 			}
 			break;
 	}
 
-	ret = SUCCEED;
-clean:
-	curl_slist_free_all(headers_slist);	/* must be called after curl_easy_perform() */
-	curl_easy_cleanup(easyhandle);
-	trx_free(body.data);
-	trx_free(header.data);
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_http_context_clean                                           *
+ *                                                                            *
+ * Purpose: free the request context                                          *
+ *                                                                            *
+ * Comments: The easy handle must be removed from multi handle, if it was     *
+ *           added to one, before calling this function.                      *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_http_context_clean(trx_http_context_t *context)
+{
+	if (NULL != context->easyhandle)
+		curl_easy_cleanup(context->easyhandle);
+
+	curl_slist_free_all(context->headers_slist);	/* must be called after curl_easy_perform() */
+	trx_free(context->body.data);
+	trx_free(context->header.data);
+	trx_free(context->status_codes);
+	trx_free(context->posts);
+}
+
+int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
+{
+	trx_http_context_t	context;
+	int			ret = NOTSUPPORTED;
+
+	treegix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (SUCCEED == trx_http_context_prepare(&context, item, result))
+		ret = trx_http_context_process(&context, curl_easy_perform(context.easyhandle), result);
+
+	trx_http_context_clean(&context);
+
 	treegix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, trx_result_string(ret));
 
 	return ret;
@@ -8,6 +8,33 @@
 #ifdef HAVE_LIBCURL
 #include "dbcache.h"
 
+typedef struct
+{
+	char	*data;
+	size_t	allocated;
+	size_t	offset;
+}
+trx_http_response_t;
+
+/* the HTTP agent item request, kept until the transfer is completed */
+typedef struct
+{
+	CURL			*easyhandle;
+	struct curl_slist	*headers_slist;
+	trx_http_response_t	body;
+	trx_http_response_t	header;
+	char			errbuf[CURL_ERROR_SIZE];
+	char			*posts;
+	char			*status_codes;
+	unsigned char		retrieve_mode;
+	unsigned char		output_format;
+}
+trx_http_context_t;
+
+int	trx_http_context_prepare(trx_http_context_t *context, const DC_ITEM *item, AGENT_RESULT *result);
+int	trx_http_context_process(trx_http_context_t *context, CURLcode err, AGENT_RESULT *result);
+void	trx_http_context_clean(trx_http_context_t *context);
+
 int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result);
 #endif
 
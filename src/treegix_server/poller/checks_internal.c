@@ -576,6 +576,18 @@ int	get_value_internal(DC_ITEM *item, AGENT_RESULT *result)
 				goto out;
 			}
 		}
+		else if (0 == strcmp(tmp, "sync"))
+		{
+			if (NULL == tmp1 || '\0' == *tmp1 || 0 == strcmp(tmp1, "batch"))
+				SET_UI64_RESULT(result, *(trx_uint64_t *)DCget_stats(TRX_STATS_HISTORY_SYNC_BATCH));
+			else if (0 == strcmp(tmp1, "latency"))
+				SET_DBL_RESULT(result, *(double *)DCget_stats(TRX_STATS_HISTORY_SYNC_LATENCY));
+			else
+			{
+				SET_MSG_RESULT(result, trx_strdup(NULL, "Invalid third parameter."));
+				goto out;
+			}
+		}
 		else
 		{
 			SET_MSG_RESULT(result, trx_strdup(NULL, "Invalid second parameter."));
@@ -611,6 +623,16 @@ int	get_value_internal(DC_ITEM *item, AGENT_RESULT *result)
 				goto out;
 			}
 		}
+		else if (0 == strcmp(tmp, "lock"))
+		{
+			if (NULL == tmp1 || '\0' == *tmp1 || 0 == strcmp(tmp1, "max"))
+				SET_DBL_RESULT(result, *(double *)DCconfig_get_stats(TRX_CONFSTATS_SYNC_LOCK_MAX));
+			else
+			{
+				SET_MSG_RESULT(result, trx_strdup(NULL, "Invalid third parameter."));
+				goto out;
+			}
+		}
 		else
 		{
 			SET_MSG_RESULT(result, trx_strdup(NULL, "Invalid second parameter."));
@@ -787,6 +809,53 @@ int	get_value_internal(DC_ITEM *item, AGENT_RESULT *result)
 
 		SET_UI64_RESULT(result, trx_preprocessor_get_queue_size());
 	}
+	else if (0 == strcmp(tmp, "preprocessing_cache"))	/* treegix["preprocessing_cache",<type>,<mode>] */
+	{
+		trx_preproc_cache_stats_t	stats;
+		trx_uint64_t			hits, misses;
+
+		if (3 != nparams)
+		{
+			SET_MSG_RESULT(result, trx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		trx_preprocessor_get_cache_stats(&stats);
+
+		tmp = get_rparam(&request, 1);
+
+		if (0 == strcmp(tmp, "jsonpath"))
+		{
+			hits = stats.jsonpath_hits;
+			misses = stats.jsonpath_misses;
+		}
+		else if (0 == strcmp(tmp, "regexp"))
+		{
+			hits = stats.regexp_hits;
+			misses = stats.regexp_misses;
+		}
+		else
+		{
+			SET_MSG_RESULT(result, trx_strdup(NULL, "Invalid second parameter."));
+			goto out;
+		}
+
+		tmp = get_rparam(&request, 2);
+
+		if (0 == strcmp(tmp, "hits"))
+		{
+			SET_UI64_RESULT(result, hits);
+		}
+		else if (0 == strcmp(tmp, "misses"))
+		{
+			SET_UI64_RESULT(result, misses);
+		}
+		else
+		{
+			SET_MSG_RESULT(result, trx_strdup(NULL, "Invalid third parameter."));
+			goto out;
+		}
+	}
 	else
 	{
 		SET_MSG_RESULT(result, trx_strdup(NULL, "Invalid first parameter."));
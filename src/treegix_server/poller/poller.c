@@ -209,6 +209,114 @@ static unsigned char	host_availability_agent_by_item_type(unsigned char type)
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: host_activate                                                    *
+ *                                                                            *
+ * Purpose: make host available for the agent type of a successful check      *
+ *                                                                            *
+ * Parameters: hostid     - [IN] the host identifier                          *
+ *             host       - [IN] the host name                                *
+ *             item_type  - [IN] the type of checked item                     *
+ *             agent_type - [IN] the agent type (see TRX_AGENT_* defines)     *
+ *             ts         - [IN] the check timestamp                          *
+ *             in         - [IN/OUT] the host availability before the check   *
+ *             out        - [OUT] the host availability after changes         *
+ *                                                                            *
+ * Return value: SUCCEED - host availability was changed                      *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	host_activate(trx_uint64_t hostid, const char *host, unsigned char item_type, unsigned char agent_type,
+		const trx_timespec_t *ts, trx_host_availability_t *in, trx_host_availability_t *out)
+{
+	if (FAIL == DChost_activate(hostid, agent_type, ts, &in->agents[agent_type], &out->agents[agent_type]))
+		return FAIL;
+
+	if (FAIL == db_host_update_availability(out))
+		return FAIL;
+
+	if (HOST_AVAILABLE_TRUE == in->agents[agent_type].available)
+	{
+		treegix_log(LOG_LEVEL_WARNING, "resuming %s checks on host \"%s\": connection restored",
+				trx_agent_type_string(item_type), host);
+	}
+	else
+	{
+		treegix_log(LOG_LEVEL_WARNING, "enabling %s checks on host \"%s\": host became available",
+				trx_agent_type_string(item_type), host);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: host_deactivate                                                  *
+ *                                                                            *
+ * Purpose: register network error of a check, make host unavailable for the  *
+ *          agent type when unreachable period is over                        *
+ *                                                                            *
+ * Parameters: hostid     - [IN] the host identifier                          *
+ *             host       - [IN] the host name                                *
+ *             item_type  - [IN] the type of checked item                     *
+ *             key_orig   - [IN] the key of checked item                      *
+ *             agent_type - [IN] the agent type (see TRX_AGENT_* defines)     *
+ *             ts         - [IN] the check timestamp                          *
+ *             in         - [IN/OUT] the host availability before the check   *
+ *             out        - [OUT] the host availability after changes         *
+ *             error      - [IN] the error message                            *
+ *                                                                            *
+ * Return value: SUCCEED - host availability was changed                      *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	host_deactivate(trx_uint64_t hostid, const char *host, unsigned char item_type, const char *key_orig,
+		unsigned char agent_type, const trx_timespec_t *ts, trx_host_availability_t *in,
+		trx_host_availability_t *out, const char *error)
+{
+	if (FAIL == DChost_deactivate(hostid, agent_type, ts, &in->agents[agent_type], &out->agents[agent_type],
+			error))
+	{
+		return FAIL;
+	}
+
+	if (FAIL == db_host_update_availability(out))
+		return FAIL;
+
+	if (0 == in->agents[agent_type].errors_from)
+	{
+		treegix_log(LOG_LEVEL_WARNING, "%s item \"%s\" on host \"%s\" failed:"
+				" first network error, wait for %d seconds",
+				trx_agent_type_string(item_type), key_orig, host,
+				out->agents[agent_type].disable_until - ts->sec);
+	}
+	else
+	{
+		if (HOST_AVAILABLE_FALSE != in->agents[agent_type].available)
+		{
+			if (HOST_AVAILABLE_FALSE != out->agents[agent_type].available)
+			{
+				treegix_log(LOG_LEVEL_WARNING, "%s item \"%s\" on host \"%s\" failed:"
+						" another network error, wait for %d seconds",
+						trx_agent_type_string(item_type), key_orig, host,
+						out->agents[agent_type].disable_until - ts->sec);
+			}
+			else
+			{
+				treegix_log(LOG_LEVEL_WARNING, "temporarily disabling %s checks on host \"%s\":"
+						" host unavailable",
+						trx_agent_type_string(item_type), host);
+			}
+		}
+	}
+
+	treegix_log(LOG_LEVEL_DEBUG, "%s() errors_from:%d available:%d", __func__,
+			out->agents[agent_type].errors_from, out->agents[agent_type].available);
+
+	return SUCCEED;
+}
+
 void	trx_activate_item_host(DC_ITEM *item, trx_timespec_t *ts)
 {
 	trx_host_availability_t	in, out;
@@ -226,24 +334,8 @@ void	trx_activate_item_host(DC_ITEM *item, trx_timespec_t *ts)
 	if (FAIL == host_get_availability(&item->host, agent_type, &in))
 		goto out;
 
-	if (FAIL == DChost_activate(item->host.hostid, agent_type, ts, &in.agents[agent_type], &out.agents[agent_type]))
-		goto out;
-
-	if (FAIL == db_host_update_availability(&out))
-		goto out;
-
-	host_set_availability(&item->host, agent_type, &out);
-
-	if (HOST_AVAILABLE_TRUE == in.agents[agent_type].available)
-	{
-		treegix_log(LOG_LEVEL_WARNING, "resuming %s checks on host \"%s\": connection restored",
-				trx_agent_type_string(item->type), item->host.host);
-	}
-	else
-	{
-		treegix_log(LOG_LEVEL_WARNING, "enabling %s checks on host \"%s\": host became available",
-				trx_agent_type_string(item->type), item->host.host);
-	}
+	if (SUCCEED == host_activate(item->host.hostid, item->host.host, item->type, agent_type, ts, &in, &out))
+		host_set_availability(&item->host, agent_type, &out);
 out:
 	trx_host_availability_clean(&out);
 	trx_host_availability_clean(&in);
@@ -268,46 +360,97 @@ void	trx_deactivate_item_host(DC_ITEM *item, trx_timespec_t *ts, const char *err
 	if (FAIL == host_get_availability(&item->host, agent_type, &in))
 		goto out;
 
-	if (FAIL == DChost_deactivate(item->host.hostid, agent_type, ts, &in.agents[agent_type],
-			&out.agents[agent_type], error))
+	if (SUCCEED == host_deactivate(item->host.hostid, item->host.host, item->type, item->key_orig, agent_type, ts,
+			&in, &out, error))
 	{
-		goto out;
+		host_set_availability(&item->host, agent_type, &out);
 	}
+out:
+	trx_host_availability_clean(&out);
+	trx_host_availability_clean(&in);
+
+	treegix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_activate_host_agent                                          *
+ *                                                                            *
+ * Purpose: make host available after successful check without having the     *
+ *          whole host structure at hand                                      *
+ *                                                                            *
+ * Parameters: hostid       - [IN] the host identifier                        *
+ *             host         - [IN] the host name                              *
+ *             item_type    - [IN] the type of checked item                   *
+ *             availability - [IN] the agent availability taken when the item *
+ *                                 was fetched from configuration cache       *
+ *             ts           - [IN] the check timestamp                        *
+ *                                                                            *
+ * Comments: Used by asynchronous pollers that keep only the essential item   *
+ *           data while the check is in progress.                             *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_activate_host_agent(trx_uint64_t hostid, const char *host, unsigned char item_type,
+		const trx_agent_availability_t *availability, const trx_timespec_t *ts)
+{
+	trx_host_availability_t	in, out;
+	unsigned char		agent_type;
+
+	treegix_log(LOG_LEVEL_DEBUG, "In %s() hostid:" TRX_FS_UI64 " type:%d", __func__, hostid, (int)item_type);
+
+	trx_host_availability_init(&in, hostid);
+	trx_host_availability_init(&out, hostid);
 
-	if (FAIL == db_host_update_availability(&out))
+	if (TRX_AGENT_UNKNOWN == (agent_type = host_availability_agent_by_item_type(item_type)))
 		goto out;
 
-	host_set_availability(&item->host, agent_type, &out);
+	in.agents[agent_type].available = availability->available;
+	in.agents[agent_type].errors_from = availability->errors_from;
 
-	if (0 == in.agents[agent_type].errors_from)
-	{
-		treegix_log(LOG_LEVEL_WARNING, "%s item \"%s\" on host \"%s\" failed:"
-				" first network error, wait for %d seconds",
-				trx_agent_type_string(item->type), item->key_orig, item->host.host,
-				out.agents[agent_type].disable_until - ts->sec);
-	}
-	else
-	{
-		if (HOST_AVAILABLE_FALSE != in.agents[agent_type].available)
-		{
-			if (HOST_AVAILABLE_FALSE != out.agents[agent_type].available)
-			{
-				treegix_log(LOG_LEVEL_WARNING, "%s item \"%s\" on host \"%s\" failed:"
-						" another network error, wait for %d seconds",
-						trx_agent_type_string(item->type), item->key_orig, item->host.host,
-						out.agents[agent_type].disable_until - ts->sec);
-			}
-			else
-			{
-				treegix_log(LOG_LEVEL_WARNING, "temporarily disabling %s checks on host \"%s\":"
-						" host unavailable",
-						trx_agent_type_string(item->type), item->host.host);
-			}
-		}
-	}
+	host_activate(hostid, host, item_type, agent_type, ts, &in, &out);
+out:
+	trx_host_availability_clean(&out);
+	trx_host_availability_clean(&in);
 
-	treegix_log(LOG_LEVEL_DEBUG, "%s() errors_from:%d available:%d", __func__,
-			out.agents[agent_type].errors_from, out.agents[agent_type].available);
+	treegix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_deactivate_host_agent                                        *
+ *                                                                            *
+ * Purpose: register network error of a check without having the whole host   *
+ *          structure at hand                                                 *
+ *                                                                            *
+ * Parameters: hostid       - [IN] the host identifier                        *
+ *             host         - [IN] the host name                              *
+ *             item_type    - [IN] the type of checked item                   *
+ *             key_orig     - [IN] the key of checked item                    *
+ *             availability - [IN] the agent availability taken when the item *
+ *                                 was fetched from configuration cache       *
+ *             ts           - [IN] the check timestamp                        *
+ *             error        - [IN] the error message                          *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_deactivate_host_agent(trx_uint64_t hostid, const char *host, unsigned char item_type,
+		const char *key_orig, const trx_agent_availability_t *availability, const trx_timespec_t *ts,
+		const char *error)
+{
+	trx_host_availability_t	in, out;
+	unsigned char		agent_type;
+
+	treegix_log(LOG_LEVEL_DEBUG, "In %s() hostid:" TRX_FS_UI64 " type:%d", __func__, hostid, (int)item_type);
+
+	trx_host_availability_init(&in, hostid);
+	trx_host_availability_init(&out, hostid);
+
+	if (TRX_AGENT_UNKNOWN == (agent_type = host_availability_agent_by_item_type(item_type)))
+		goto out;
+
+	in.agents[agent_type].available = availability->available;
+	in.agents[agent_type].errors_from = availability->errors_from;
+
+	host_deactivate(hostid, host, item_type, key_orig, agent_type, ts, &in, &out, error);
 out:
 	trx_host_availability_clean(&out);
 	trx_host_availability_clean(&in);
@@ -463,6 +606,118 @@ static int	parse_query_fields(const DC_ITEM *item, char **query_fields)
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_prepare_httpagent_item                                       *
+ *                                                                            *
+ * Purpose: resolve macros in HTTP agent item fields before the request is    *
+ *          performed                                                         *
+ *                                                                            *
+ * Parameters: item   - [IN/OUT] the HTTP agent item                          *
+ *             result - [OUT] the error message on failure                    *
+ *                                                                            *
+ * Return value: SUCCEED - the item is ready to be checked                    *
+ *               CONFIG_ERROR - the item configuration is invalid             *
+ *                                                                            *
+ * Comments: the allocated fields must be freed with                          *
+ *           trx_clean_httpagent_item()                                       *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_prepare_httpagent_item(DC_ITEM *item, AGENT_RESULT *result)
+{
+	char	error[ITEM_ERROR_LEN_MAX];
+
+	TRX_STRDUP(item->timeout, item->timeout_orig);
+	TRX_STRDUP(item->url, item->url_orig);
+	TRX_STRDUP(item->status_codes, item->status_codes_orig);
+	TRX_STRDUP(item->http_proxy, item->http_proxy_orig);
+	TRX_STRDUP(item->ssl_cert_file, item->ssl_cert_file_orig);
+	TRX_STRDUP(item->ssl_key_file, item->ssl_key_file_orig);
+	TRX_STRDUP(item->ssl_key_password, item->ssl_key_password_orig);
+	TRX_STRDUP(item->username, item->username_orig);
+	TRX_STRDUP(item->password, item->password_orig);
+
+	substitute_simple_macros(NULL, NULL, NULL, NULL, &item->host.hostid, NULL,
+			NULL, NULL, NULL, &item->timeout, MACRO_TYPE_COMMON, NULL, 0);
+	substitute_simple_macros(NULL, NULL, NULL,NULL, NULL, &item->host, item, NULL,
+			NULL, &item->url, MACRO_TYPE_HTTP_RAW, NULL, 0);
+
+	if (SUCCEED != trx_http_punycode_encode_url(&item->url))
+	{
+		SET_MSG_RESULT(result, trx_strdup(NULL, "Cannot encode URL into punycode"));
+		return CONFIG_ERROR;
+	}
+
+	if (FAIL == parse_query_fields(item, &item->query_fields))
+	{
+		SET_MSG_RESULT(result, trx_strdup(NULL, "Invalid query fields"));
+		return CONFIG_ERROR;
+	}
+
+	switch (item->post_type)
+	{
+		case TRX_POSTTYPE_XML:
+			if (SUCCEED != substitute_macros_xml(&item->posts, item, NULL,
+					NULL, error, sizeof(error)))
+			{
+				SET_MSG_RESULT(result, trx_dsprintf(NULL, "%s.", error));
+				return CONFIG_ERROR;
+			}
+			break;
+		case TRX_POSTTYPE_JSON:
+			substitute_simple_macros(NULL, NULL, NULL,NULL, NULL, &item->host,
+					item, NULL, NULL, &item->posts,
+					MACRO_TYPE_HTTP_JSON, NULL, 0);
+			break;
+		default:
+			substitute_simple_macros(NULL, NULL, NULL,NULL, NULL, &item->host,
+					item, NULL, NULL, &item->posts,
+					MACRO_TYPE_HTTP_RAW, NULL, 0);
+			break;
+	}
+
+	substitute_simple_macros(NULL, NULL, NULL,NULL, NULL, &item->host, item, NULL,
+			NULL, &item->headers, MACRO_TYPE_HTTP_RAW, NULL, 0);
+	substitute_simple_macros(NULL, NULL, NULL, NULL, &item->host.hostid, NULL,
+			NULL, NULL, NULL, &item->status_codes, MACRO_TYPE_COMMON, NULL, 0);
+	substitute_simple_macros(NULL, NULL, NULL, NULL, &item->host.hostid, NULL,
+			NULL, NULL, NULL, &item->http_proxy, MACRO_TYPE_COMMON, NULL, 0);
+	substitute_simple_macros(NULL, NULL, NULL,NULL, NULL, &item->host, item, NULL,
+			NULL, &item->ssl_cert_file, MACRO_TYPE_HTTP_RAW, NULL, 0);
+	substitute_simple_macros(NULL, NULL, NULL,NULL, NULL, &item->host, item, NULL,
+			NULL, &item->ssl_key_file, MACRO_TYPE_HTTP_RAW, NULL, 0);
+	substitute_simple_macros(NULL, NULL, NULL, NULL, &item->host.hostid, NULL, NULL,
+			NULL, NULL, &item->ssl_key_password, MACRO_TYPE_COMMON, NULL, 0);
+	substitute_simple_macros(NULL, NULL, NULL, NULL, &item->host.hostid, NULL,
+			NULL, NULL, NULL, &item->username, MACRO_TYPE_COMMON, NULL, 0);
+	substitute_simple_macros(NULL, NULL, NULL, NULL, &item->host.hostid, NULL,
+			NULL, NULL, NULL, &item->password, MACRO_TYPE_COMMON, NULL, 0);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_clean_httpagent_item                                         *
+ *                                                                            *
+ * Purpose: free HTTP agent item fields allocated by                          *
+ *          trx_prepare_httpagent_item()                                      *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_clean_httpagent_item(DC_ITEM *item)
+{
+	trx_free(item->timeout);
+	trx_free(item->url);
+	trx_free(item->query_fields);
+	trx_free(item->status_codes);
+	trx_free(item->http_proxy);
+	trx_free(item->ssl_cert_file);
+	trx_free(item->ssl_key_file);
+	trx_free(item->ssl_key_password);
+	trx_free(item->username);
+	trx_free(item->password);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: get_values                                                       *
@@ -606,74 +861,8 @@ static int	get_values(unsigned char poller_type, int *nextcheck)
 						NULL, NULL, &items[i].jmx_endpoint, MACRO_TYPE_JMX_ENDPOINT, NULL, 0);
 				break;
 			case ITEM_TYPE_HTTPAGENT:
-				TRX_STRDUP(items[i].timeout, items[i].timeout_orig);
-				TRX_STRDUP(items[i].url, items[i].url_orig);
-				TRX_STRDUP(items[i].status_codes, items[i].status_codes_orig);
-				TRX_STRDUP(items[i].http_proxy, items[i].http_proxy_orig);
-				TRX_STRDUP(items[i].ssl_cert_file, items[i].ssl_cert_file_orig);
-				TRX_STRDUP(items[i].ssl_key_file, items[i].ssl_key_file_orig);
-				TRX_STRDUP(items[i].ssl_key_password, items[i].ssl_key_password_orig);
-				TRX_STRDUP(items[i].username, items[i].username_orig);
-				TRX_STRDUP(items[i].password, items[i].password_orig);
-
-				substitute_simple_macros(NULL, NULL, NULL, NULL, &items[i].host.hostid, NULL,
-						NULL, NULL, NULL, &items[i].timeout, MACRO_TYPE_COMMON, NULL, 0);
-				substitute_simple_macros(NULL, NULL, NULL,NULL, NULL, &items[i].host, &items[i], NULL,
-						NULL, &items[i].url, MACRO_TYPE_HTTP_RAW, NULL, 0);
-
-				if (SUCCEED != trx_http_punycode_encode_url(&items[i].url))
-				{
-					SET_MSG_RESULT(&results[i], trx_strdup(NULL, "Cannot encode URL into punycode"));
-					errcodes[i] = CONFIG_ERROR;
+				if (SUCCEED != (errcodes[i] = trx_prepare_httpagent_item(&items[i], &results[i])))
 					continue;
-				}
-
-				if (FAIL == parse_query_fields(&items[i], &items[i].query_fields))
-				{
-					SET_MSG_RESULT(&results[i], trx_strdup(NULL, "Invalid query fields"));
-					errcodes[i] = CONFIG_ERROR;
-					continue;
-				}
-
-				switch (items[i].post_type)
-				{
-					case TRX_POSTTYPE_XML:
-						if (SUCCEED != substitute_macros_xml(&items[i].posts, &items[i], NULL,
-								NULL, error, sizeof(error)))
-						{
-							SET_MSG_RESULT(&results[i], trx_dsprintf(NULL, "%s.", error));
-							errcodes[i] = CONFIG_ERROR;
-							continue;
-						}
-						break;
-					case TRX_POSTTYPE_JSON:
-						substitute_simple_macros(NULL, NULL, NULL,NULL, NULL, &items[i].host,
-								&items[i], NULL, NULL, &items[i].posts,
-								MACRO_TYPE_HTTP_JSON, NULL, 0);
-						break;
-					default:
-						substitute_simple_macros(NULL, NULL, NULL,NULL, NULL, &items[i].host,
-								&items[i], NULL, NULL, &items[i].posts,
-								MACRO_TYPE_HTTP_RAW, NULL, 0);
-						break;
-				}
-
-				substitute_simple_macros(NULL, NULL, NULL,NULL, NULL, &items[i].host, &items[i], NULL,
-						NULL, &items[i].headers, MACRO_TYPE_HTTP_RAW, NULL, 0);
-				substitute_simple_macros(NULL, NULL, NULL, NULL, &items[i].host.hostid, NULL,
-						NULL, NULL, NULL, &items[i].status_codes, MACRO_TYPE_COMMON, NULL, 0);
-				substitute_simple_macros(NULL, NULL, NULL, NULL, &items[i].host.hostid, NULL,
-						NULL, NULL, NULL, &items[i].http_proxy, MACRO_TYPE_COMMON, NULL, 0);
-				substitute_simple_macros(NULL, NULL, NULL,NULL, NULL, &items[i].host, &items[i], NULL,
-						NULL, &items[i].ssl_cert_file, MACRO_TYPE_HTTP_RAW, NULL, 0);
-				substitute_simple_macros(NULL, NULL, NULL,NULL, NULL, &items[i].host, &items[i], NULL,
-						NULL, &items[i].ssl_key_file, MACRO_TYPE_HTTP_RAW, NULL, 0);
-				substitute_simple_macros(NULL, NULL, NULL, NULL, &items[i].host.hostid, NULL, NULL,
-						NULL, NULL, &items[i].ssl_key_password, MACRO_TYPE_COMMON, NULL, 0);
-				substitute_simple_macros(NULL, NULL, NULL, NULL, &items[i].host.hostid, NULL,
-						NULL, NULL, NULL, &items[i].username, MACRO_TYPE_COMMON, NULL, 0);
-				substitute_simple_macros(NULL, NULL, NULL, NULL, &items[i].host.hostid, NULL,
-						NULL, NULL, NULL, &items[i].password, MACRO_TYPE_COMMON, NULL, 0);
 				break;
 		}
 	}
@@ -815,16 +1004,7 @@ static int	get_values(unsigned char poller_type, int *nextcheck)
 				trx_free(items[i].snmp_oid);
 				break;
 			case ITEM_TYPE_HTTPAGENT:
-				trx_free(items[i].timeout);
-				trx_free(items[i].url);
-				trx_free(items[i].query_fields);
-				trx_free(items[i].status_codes);
-				trx_free(items[i].http_proxy);
-				trx_free(items[i].ssl_cert_file);
-				trx_free(items[i].ssl_key_file);
-				trx_free(items[i].ssl_key_password);
-				trx_free(items[i].username);
-				trx_free(items[i].password);
+				trx_clean_httpagent_item(&items[i]);
 				break;
 			case ITEM_TYPE_SSH:
 				trx_free(items[i].publickey);
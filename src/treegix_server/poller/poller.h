@@ -14,5 +14,13 @@ TRX_THREAD_ENTRY(poller_thread, args);
 
 void	trx_activate_item_host(DC_ITEM *item, trx_timespec_t *ts);
 void	trx_deactivate_item_host(DC_ITEM *item, trx_timespec_t *ts, const char *error);
+void	trx_activate_host_agent(trx_uint64_t hostid, const char *host, unsigned char item_type,
+		const trx_agent_availability_t *availability, const trx_timespec_t *ts);
+void	trx_deactivate_host_agent(trx_uint64_t hostid, const char *host, unsigned char item_type,
+		const char *key_orig, const trx_agent_availability_t *availability, const trx_timespec_t *ts,
+		const char *error);
+
+int	trx_prepare_httpagent_item(DC_ITEM *item, AGENT_RESULT *result);
+void	trx_clean_httpagent_item(DC_ITEM *item);
 
 #endif
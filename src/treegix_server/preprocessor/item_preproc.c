@@ -20,6 +20,307 @@
 
 extern trx_es_t	es_engine;
 
+/* maximum number of compiled expressions kept by preprocessing worker */
+#define TRX_PREPROC_CACHE_MAX	1000
+
+#define TRX_PREPROC_CACHE_JSONPATH	0
+#define TRX_PREPROC_CACHE_REGEXP	1	/* regular expression compiled for matching */
+#define TRX_PREPROC_CACHE_REGSUB	2	/* regular expression compiled for substitution */
+
+/* compiled expression cache entry */
+typedef struct trx_preproc_cache_entry
+{
+	char				*pattern;
+	unsigned char			type;
+
+	union
+	{
+		trx_jsonpath_t	jsonpath;
+		trx_regexp_t	*regexp;
+	}
+	data;
+
+	/* least recently used list, the head is the most recently used entry */
+	struct trx_preproc_cache_entry	*prev;
+	struct trx_preproc_cache_entry	*next;
+}
+trx_preproc_cache_entry_t;
+
+typedef struct
+{
+	trx_hashset_t			entries;
+	trx_preproc_cache_entry_t	*head;
+	trx_preproc_cache_entry_t	*tail;
+	trx_preproc_cache_stats_t	stats;
+	int				init;
+}
+trx_preproc_cache_t;
+
+static trx_preproc_cache_t	preproc_cache;
+
+/* the last json document queried by jsonpath steps - it's kept with its index */
+/* so that other jsonpath steps on the same document (for example of the      */
+/* dependent items of the same master item) do not have to parse it again.    */
+/* The document is copied and indexed only when it's queried the second time, */
+/* before that only its size and hash are remembered                          */
+typedef struct
+{
+	char			*data;
+	size_t			size;
+	struct trx_json_parse	jp;
+	trx_jsonpath_index_t	*index;
+
+	/* the size and hash of the last document queried without caching it */
+	size_t			last_size;
+	trx_hash_t		last_hash;
+}
+trx_preproc_json_doc_t;
+
+static trx_preproc_json_doc_t	preproc_json_doc;
+
+static trx_hash_t	preproc_cache_entry_hash(const void *data)
+{
+	const trx_preproc_cache_entry_t	*entry = (const trx_preproc_cache_entry_t *)data;
+
+	return TRX_DEFAULT_STRING_HASH_ALGO(entry->pattern, strlen(entry->pattern), entry->type);
+}
+
+static int	preproc_cache_entry_compare(const void *d1, const void *d2)
+{
+	const trx_preproc_cache_entry_t	*e1 = (const trx_preproc_cache_entry_t *)d1;
+	const trx_preproc_cache_entry_t	*e2 = (const trx_preproc_cache_entry_t *)d2;
+
+	TRX_RETURN_IF_NOT_EQUAL(e1->type, e2->type);
+
+	return strcmp(e1->pattern, e2->pattern);
+}
+
+static void	preproc_cache_entry_clear(trx_preproc_cache_entry_t *entry)
+{
+	if (TRX_PREPROC_CACHE_JSONPATH == entry->type)
+		trx_jsonpath_clear(&entry->data.jsonpath);
+	else
+		trx_regexp_free(entry->data.regexp);
+
+	trx_free(entry->pattern);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preproc_cache_unlink                                             *
+ *                                                                            *
+ * Purpose: remove cache entry from the least recently used list              *
+ *                                                                            *
+ ******************************************************************************/
+static void	preproc_cache_unlink(trx_preproc_cache_entry_t *entry)
+{
+	if (NULL != entry->prev)
+		entry->prev->next = entry->next;
+	else
+		preproc_cache.head = entry->next;
+
+	if (NULL != entry->next)
+		entry->next->prev = entry->prev;
+	else
+		preproc_cache.tail = entry->prev;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preproc_cache_link_head                                          *
+ *                                                                            *
+ * Purpose: add cache entry at the head of least recently used list           *
+ *                                                                            *
+ ******************************************************************************/
+static void	preproc_cache_link_head(trx_preproc_cache_entry_t *entry)
+{
+	entry->prev = NULL;
+
+	if (NULL != (entry->next = preproc_cache.head))
+		preproc_cache.head->prev = entry;
+	else
+		preproc_cache.tail = entry;
+
+	preproc_cache.head = entry;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preproc_cache_get                                                *
+ *                                                                            *
+ * Purpose: get compiled expression from cache, compiling it if necessary     *
+ *                                                                            *
+ * Parameters: type    - [IN] the expression type (TRX_PREPROC_CACHE_*)       *
+ *             pattern - [IN] the expression                                  *
+ *             error   - [OUT] the regular expression compilation error       *
+ *                                                                            *
+ * Return value: the cache entry or NULL if the expression cannot be compiled *
+ *                                                                            *
+ * Comments: The jsonpath compilation error is available with                 *
+ *           trx_json_strerror() function.                                    *
+ *           When the cache is full the least recently used entry is removed. *
+ *                                                                            *
+ ******************************************************************************/
+static trx_preproc_cache_entry_t	*preproc_cache_get(unsigned char type, const char *pattern, const char **error)
+{
+	trx_preproc_cache_entry_t	entry_local, *entry;
+	int				ret;
+
+	if (0 == preproc_cache.init)
+	{
+		trx_hashset_create_ext(&preproc_cache.entries, TRX_PREPROC_CACHE_MAX, preproc_cache_entry_hash,
+				preproc_cache_entry_compare, (trx_clean_func_t)preproc_cache_entry_clear,
+				TRX_DEFAULT_MEM_MALLOC_FUNC, TRX_DEFAULT_MEM_REALLOC_FUNC, TRX_DEFAULT_MEM_FREE_FUNC);
+		preproc_cache.init = 1;
+	}
+
+	entry_local.pattern = (char *)pattern;
+	entry_local.type = type;
+
+	if (NULL != (entry = (trx_preproc_cache_entry_t *)trx_hashset_search(&preproc_cache.entries, &entry_local)))
+	{
+		if (TRX_PREPROC_CACHE_JSONPATH == type)
+			preproc_cache.stats.jsonpath_hits++;
+		else
+			preproc_cache.stats.regexp_hits++;
+
+		if (entry != preproc_cache.head)
+		{
+			preproc_cache_unlink(entry);
+			preproc_cache_link_head(entry);
+		}
+
+		return entry;
+	}
+
+	switch (type)
+	{
+		case TRX_PREPROC_CACHE_JSONPATH:
+			preproc_cache.stats.jsonpath_misses++;
+			ret = trx_jsonpath_compile(pattern, &entry_local.data.jsonpath);
+			break;
+		case TRX_PREPROC_CACHE_REGEXP:
+			preproc_cache.stats.regexp_misses++;
+			ret = trx_regexp_compile(pattern, &entry_local.data.regexp, error);
+			break;
+		default:
+			preproc_cache.stats.regexp_misses++;
+			/* PCRE_MULTILINE is not used here */
+			ret = trx_regexp_compile_ext(pattern, &entry_local.data.regexp, 0, error);
+			break;
+	}
+
+	if (SUCCEED != ret)
+		return NULL;
+
+	if (TRX_PREPROC_CACHE_MAX <= preproc_cache.entries.num_data)
+	{
+		entry = preproc_cache.tail;
+		preproc_cache_unlink(entry);
+		trx_hashset_remove_direct(&preproc_cache.entries, entry);
+	}
+
+	entry_local.pattern = trx_strdup(NULL, pattern);
+	entry = (trx_preproc_cache_entry_t *)trx_hashset_insert(&preproc_cache.entries, &entry_local,
+			sizeof(entry_local));
+	preproc_cache_link_head(entry);
+
+	return entry;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preproc_json_doc_clear                                           *
+ *                                                                            *
+ * Purpose: free the cached json document and its index                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	preproc_json_doc_clear(void)
+{
+	if (NULL == preproc_json_doc.data)
+		return;
+
+	trx_jsonpath_index_free(preproc_json_doc.index);
+	trx_free(preproc_json_doc.data);
+	memset(&preproc_json_doc, 0, sizeof(preproc_json_doc));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preproc_json_doc_open                                            *
+ *                                                                            *
+ * Purpose: open json document, reusing the cached document if it's the same  *
+ *                                                                            *
+ * Parameters: data  - [IN] the json document                                 *
+ *             jp    - [OUT] the json document to query                       *
+ *             index - [OUT] the document index, NULL if the document is not  *
+ *                           cached                                           *
+ *                                                                            *
+ * Return value: SUCCEED - the json document was opened                       *
+ *               FAIL    - the data is not valid json                         *
+ *                                                                            *
+ * Comments: The document is queried directly the first time. Only when the   *
+ *           same document is queried again it's copied and indexed for the   *
+ *           following queries.                                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	preproc_json_doc_open(const char *data, struct trx_json_parse *jp, trx_jsonpath_index_t **index)
+{
+	size_t		size;
+	trx_hash_t	hash;
+
+	size = strlen(data);
+
+	if (NULL != preproc_json_doc.data && size == preproc_json_doc.size &&
+			0 == memcmp(data, preproc_json_doc.data, size))
+	{
+		*jp = preproc_json_doc.jp;
+		*index = preproc_json_doc.index;
+		return SUCCEED;
+	}
+
+	if (FAIL == trx_json_open(data, jp))
+		return FAIL;
+
+	hash = TRX_DEFAULT_STRING_HASH_ALGO(data, size, TRX_DEFAULT_HASH_SEED);
+
+	if (size != preproc_json_doc.last_size || hash != preproc_json_doc.last_hash)
+	{
+		preproc_json_doc.last_size = size;
+		preproc_json_doc.last_hash = hash;
+		*index = NULL;
+		return SUCCEED;
+	}
+
+	preproc_json_doc_clear();
+
+	preproc_json_doc.data = (char *)trx_malloc(NULL, size + 1);
+	memcpy(preproc_json_doc.data, data, size + 1);
+	preproc_json_doc.size = size;
+	preproc_json_doc.jp.start = preproc_json_doc.data + (jp->start - data);
+	preproc_json_doc.jp.end = preproc_json_doc.data + (jp->end - data);
+	preproc_json_doc.index = trx_jsonpath_index_create();
+
+	*jp = preproc_json_doc.jp;
+	*index = preproc_json_doc.index;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_item_preproc_cache_get_stats                                 *
+ *                                                                            *
+ * Purpose: get compiled expression cache statistics                          *
+ *                                                                            *
+ * Parameters: stats - [OUT] the cache statistics                             *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_item_preproc_cache_get_stats(trx_preproc_cache_stats_t *stats)
+{
+	*stats = preproc_cache.stats;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: str_printable_dyn                                                *
@@ -804,10 +1105,10 @@ static int	item_preproc_hex2dec(trx_variant_t *value, char **errmsg)
  ******************************************************************************/
 static int	item_preproc_regsub_op(trx_variant_t *value, const char *params, char **errmsg)
 {
-	char		pattern[ITEM_PREPROC_PARAMS_LEN * TRX_MAX_BYTES_IN_UTF8_CHAR + 1];
-	char		*output, *new_value = NULL;
-	const char	*regex_error;
-	trx_regexp_t	*regex = NULL;
+	char				pattern[ITEM_PREPROC_PARAMS_LEN * TRX_MAX_BYTES_IN_UTF8_CHAR + 1];
+	char				*output, *new_value = NULL;
+	const char			*regex_error;
+	trx_preproc_cache_entry_t	*regex;
 
 	if (FAIL == item_preproc_convert_value(value, TRX_VARIANT_STR, errmsg))
 		return FAIL;
@@ -822,24 +1123,22 @@ static int	item_preproc_regsub_op(trx_variant_t *value, const char *params, char
 
 	*output++ = '\0';
 
-	if (FAIL == trx_regexp_compile_ext(pattern, &regex, 0, &regex_error))	/* PCRE_MULTILINE is not used here */
+	if (NULL == (regex = preproc_cache_get(TRX_PREPROC_CACHE_REGSUB, pattern, &regex_error)))
 	{
 		*errmsg = trx_dsprintf(*errmsg, "invalid regular expression: %s", regex_error);
 		return FAIL;
 	}
 
-	if (FAIL == trx_mregexp_sub_precompiled(value->data.str, regex, output, TRX_MAX_RECV_DATA_SIZE, &new_value))
+	if (FAIL == trx_mregexp_sub_precompiled(value->data.str, regex->data.regexp, output, TRX_MAX_RECV_DATA_SIZE,
+			&new_value))
 	{
 		*errmsg = trx_strdup(*errmsg, "pattern does not match");
-		trx_regexp_free(regex);
 		return FAIL;
 	}
 
 	trx_variant_clear(value);
 	trx_variant_set_str(value, new_value);
 
-	trx_regexp_free(regex);
-
 	return SUCCEED;
 }
 
@@ -894,13 +1193,17 @@ static int	item_preproc_regsub(trx_variant_t *value, const char *params, char **
  ******************************************************************************/
 static int	item_preproc_jsonpath_op(trx_variant_t *value, const char *params, char **errmsg)
 {
-	struct trx_json_parse	jp;
-	char			*data = NULL;
+	struct trx_json_parse		jp;
+	trx_jsonpath_index_t		*index;
+	char				*data = NULL;
+	trx_preproc_cache_entry_t	*jsonpath;
 
 	if (FAIL == item_preproc_convert_value(value, TRX_VARIANT_STR, errmsg))
 		return FAIL;
 
-	if (FAIL == trx_json_open(value->data.str, &jp) || FAIL == trx_jsonpath_query(&jp, params, &data))
+	if (FAIL == preproc_json_doc_open(value->data.str, &jp, &index) ||
+			NULL == (jsonpath = preproc_cache_get(TRX_PREPROC_CACHE_JSONPATH, params, NULL)) ||
+			FAIL == trx_jsonpath_query_compiled(&jp, &jsonpath->data.jsonpath, index, &data))
 	{
 		*errmsg = trx_strdup(*errmsg, trx_json_strerror());
 		return FAIL;
@@ -1178,11 +1481,11 @@ out:
  ******************************************************************************/
 static int	item_preproc_validate_regex(const trx_variant_t *value, const char *params, char **error)
 {
-	trx_variant_t	value_str;
-	int		ret = FAIL;
-	trx_regexp_t	*regex;
-	const char	*errptr = NULL;
-	char		*errmsg;
+	trx_variant_t			value_str;
+	int				ret = FAIL;
+	trx_preproc_cache_entry_t	*regex;
+	const char			*errptr = NULL;
+	char				*errmsg;
 
 	trx_variant_copy(&value_str, value);
 
@@ -1192,18 +1495,16 @@ static int	item_preproc_validate_regex(const trx_variant_t *value, const char *p
 		goto out;
 	}
 
-	if (FAIL == trx_regexp_compile(params, &regex, &errptr))
+	if (NULL == (regex = preproc_cache_get(TRX_PREPROC_CACHE_REGEXP, params, &errptr)))
 	{
 		errmsg = trx_dsprintf(NULL, "invalid regular expression pattern: %s", errptr);
 		goto out;
 	}
 
-	if (0 != trx_regexp_match_precompiled(value_str.data.str, regex))
+	if (0 != trx_regexp_match_precompiled(value_str.data.str, regex->data.regexp))
 		errmsg = trx_strdup(NULL, "value does not match regular expression");
 	else
 		ret = SUCCEED;
-
-	trx_regexp_free(regex);
 out:
 	trx_variant_clear(&value_str);
 
@@ -1234,11 +1535,11 @@ out:
  ******************************************************************************/
 static int	item_preproc_validate_not_regex(const trx_variant_t *value, const char *params, char **error)
 {
-	trx_variant_t	value_str;
-	int		ret = FAIL;
-	trx_regexp_t	*regex;
-	const char	*errptr = NULL;
-	char		*errmsg;
+	trx_variant_t			value_str;
+	int				ret = FAIL;
+	trx_preproc_cache_entry_t	*regex;
+	const char			*errptr = NULL;
+	char				*errmsg;
 
 	trx_variant_copy(&value_str, value);
 
@@ -1248,20 +1549,18 @@ static int	item_preproc_validate_not_regex(const trx_variant_t *value, const cha
 		goto out;
 	}
 
-	if (FAIL == trx_regexp_compile(params, &regex, &errptr))
+	if (NULL == (regex = preproc_cache_get(TRX_PREPROC_CACHE_REGEXP, params, &errptr)))
 	{
 		errmsg = trx_dsprintf(NULL, "invalid regular expression pattern: %s", errptr);
 		goto out;
 	}
 
-	if (0 == trx_regexp_match_precompiled(value_str.data.str, regex))
+	if (0 == trx_regexp_match_precompiled(value_str.data.str, regex->data.regexp))
 	{
 		errmsg = trx_strdup(NULL, "value matches regular expression");
 	}
 	else
 		ret = SUCCEED;
-
-	trx_regexp_free(regex);
 out:
 	trx_variant_clear(&value_str);
 
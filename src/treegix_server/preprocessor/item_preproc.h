@@ -18,4 +18,6 @@ int	trx_item_preproc_test(unsigned char value_type, trx_variant_t *value, const
 		trx_preproc_op_t *steps, int steps_num, trx_vector_ptr_t *history_in, trx_vector_ptr_t *history_out,
 		trx_preproc_result_t *results, int *results_num, char **error);
 
+void	trx_item_preproc_cache_get_stats(trx_preproc_cache_stats_t *stats);
+
 #endif
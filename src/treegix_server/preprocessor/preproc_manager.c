@@ -18,10 +18,19 @@
 #include "preproc_history.h"
 
 extern unsigned char	process_type, program_type;
-extern int		server_num, process_num, CONFIG_PREPROCESSOR_FORKS;
+extern int		server_num, process_num;
 
 #define TRX_PREPROCESSING_MANAGER_DELAY	1
 
+/* the interval of requesting compiled expression cache statistics from workers, in seconds */
+#define TRX_PREPROCESSING_STATS_DELAY	1
+
+/* maximum number of ring requests read before returning to socket messages */
+#define TRX_PREPROCESSING_RING_REQUESTS_MAX	100000
+
+/* maximum number of values sent to preprocessing worker in one batch */
+#define TRX_PREPROCESSING_BATCH_MAX		64
+
 #define TRX_PREPROC_PRIORITY_NONE	0
 #define TRX_PREPROC_PRIORITY_FIRST	1
 
@@ -51,8 +60,12 @@ trx_preprocessing_request_t;
 /* preprocessing worker data */
 typedef struct
 {
-	trx_ipc_client_t	*client;	/* the connected preprocessing worker client */
-	void			*task;		/* the current task data */
+	trx_ipc_client_t		*client;	/* the connected preprocessing worker client */
+	void				*task;		/* the current task data */
+	trx_vector_ptr_t		tasks;		/* the current batch of queued tasks */
+	trx_preproc_cache_stats_t	stats;		/* compiled expression cache statistics */
+	unsigned char			stats_outdated;	/* values were processed since the last */
+							/* statistics request                   */
 }
 trx_preprocessing_worker_t;
 
@@ -77,6 +90,7 @@ typedef struct
 {
 	trx_preprocessing_worker_t	*workers;	/* preprocessing worker array */
 	int				worker_count;	/* preprocessing worker count */
+	int				worker_max;	/* number of workers assigned to manager */
 	trx_list_t			queue;		/* queue of item values */
 	trx_hashset_t			item_config;	/* item configuration L2 cache */
 	trx_hashset_t			history_cache;	/* item value history cache */
@@ -254,6 +268,47 @@ static	void	preprocessor_set_request_state_done(trx_preprocessing_manager_t *man
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_check_request                                       *
+ *                                                                            *
+ * Purpose: check if queued request can be sent to worker                     *
+ *                                                                            *
+ * Parameters: manager    - [IN] preprocessing manager                        *
+ *             request    - [IN] preprocessing request                        *
+ *             queue_item - [IN] queued item                                  *
+ *                                                                            *
+ * Return value: SUCCEED - the request must be preprocessed                   *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Requests with not supported values are marked as done without    *
+ *           preprocessing and the item value history is reset.               *
+ *                                                                            *
+ ******************************************************************************/
+static int	preprocessor_check_request(trx_preprocessing_manager_t *manager,
+		trx_preprocessing_request_t *request, const trx_list_item_t *queue_item)
+{
+	trx_preproc_history_t	*vault;
+
+	if (REQUEST_STATE_QUEUED != request->state)
+		return FAIL;
+
+	if (ITEM_STATE_NOTSUPPORTED != request->value.state)
+		return SUCCEED;
+
+	if (NULL != (vault = (trx_preproc_history_t *) trx_hashset_search(&manager->history_cache,
+			&request->value.itemid)))
+	{
+		trx_vector_ptr_clear_ext(&vault->history, (trx_clean_func_t) trx_preproc_op_history_free);
+		trx_vector_ptr_destroy(&vault->history);
+		trx_hashset_remove_direct(&manager->history_cache, vault);
+	}
+
+	preprocessor_set_request_state_done(manager, request, queue_item);
+
+	return FAIL;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: preprocessor_get_next_task                                       *
@@ -288,25 +343,8 @@ static void	*preprocessor_get_next_task(trx_preprocessing_manager_t *manager, tr
 	{
 		trx_list_iterator_peek(&iterator, (void **)&request);
 
-		if (REQUEST_STATE_QUEUED != request->state)
-			continue;
-
-		if (ITEM_STATE_NOTSUPPORTED == request->value.state)
-		{
-			trx_preproc_history_t	*vault;
-
-			if (NULL != (vault = (trx_preproc_history_t *) trx_hashset_search(&manager->history_cache,
-					&request->value.itemid)))
-			{
-				trx_vector_ptr_clear_ext(&vault->history,
-						(trx_clean_func_t) trx_preproc_op_history_free);
-				trx_vector_ptr_destroy(&vault->history);
-				trx_hashset_remove_direct(&manager->history_cache, vault);
-			}
-
-			preprocessor_set_request_state_done(manager, request, iterator.current);
+		if (SUCCEED != preprocessor_check_request(manager, request, iterator.current))
 			continue;
-		}
 
 		task = iterator.current;
 		request->state = REQUEST_STATE_PROCESSING;
@@ -321,6 +359,77 @@ out:
 	return task;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_get_next_batch                                      *
+ *                                                                            *
+ * Purpose: gets next batch of queued tasks to be sent to worker              *
+ *                                                                            *
+ * Parameters: manager   - [IN] preprocessing manager                         *
+ *             batch_max - [IN] the maximum number of tasks in batch          *
+ *             tasks     - [OUT] the queue items of batched tasks             *
+ *             message   - [OUT] the serialized tasks to be sent, each        *
+ *                               prefixed with its size                       *
+ *                                                                            *
+ * Return value: the number of tasks in batch                                 *
+ *                                                                            *
+ * Comments: A batch can contain several values of the same item. Only values *
+ *           of items with steps using previous value (delta, throttling)     *
+ *           depend on each other - the next value of such item is pending    *
+ *           until the previous one is processed, so it's never batched       *
+ *           together with the previous value.                                *
+ *                                                                            *
+ ******************************************************************************/
+static int	preprocessor_get_next_batch(trx_preprocessing_manager_t *manager, int batch_max,
+		trx_vector_ptr_t *tasks, trx_ipc_message_t *message)
+{
+	trx_list_iterator_t		iterator;
+	trx_preprocessing_request_t	*request = NULL;
+	unsigned char			*task;
+	trx_uint32_t			task_size;
+	size_t				data_alloc = 0, data_offset = 0;
+
+	treegix_log(LOG_LEVEL_DEBUG, "In %s() batch_max:%d", __func__, batch_max);
+
+	message->data = NULL;
+
+	trx_list_iterator_init(&manager->queue, &iterator);
+	while (tasks->values_num < batch_max && SUCCEED == trx_list_iterator_next(&iterator))
+	{
+		trx_list_iterator_peek(&iterator, (void **)&request);
+
+		if (SUCCEED != preprocessor_check_request(manager, request, iterator.current))
+			continue;
+
+		request->state = REQUEST_STATE_PROCESSING;
+		task_size = preprocessor_create_task(manager, request, &task);
+		request_free_steps(request);
+
+		if (data_alloc < data_offset + sizeof(trx_uint32_t) + task_size)
+		{
+			while (data_alloc < data_offset + sizeof(trx_uint32_t) + task_size)
+				data_alloc += TRX_KIBIBYTE * 64;
+
+			message->data = (unsigned char *)trx_realloc(message->data, data_alloc);
+		}
+
+		memcpy(message->data + data_offset, &task_size, sizeof(trx_uint32_t));
+		data_offset += sizeof(trx_uint32_t);
+		memcpy(message->data + data_offset, task, task_size);
+		data_offset += task_size;
+		trx_free(task);
+
+		trx_vector_ptr_append(tasks, iterator.current);
+	}
+
+	message->code = TRX_IPC_PREPROCESSOR_BATCH_REQUEST;
+	message->size = data_offset;
+
+	treegix_log(LOG_LEVEL_DEBUG, "End of %s() tasks:%d", __func__, tasks->values_num);
+
+	return tasks->values_num;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: preprocessor_get_worker_by_client                                *
@@ -374,7 +483,7 @@ static trx_preprocessing_worker_t	*preprocessor_get_free_worker(trx_preprocessin
 
 	for (i = 0; i < manager->worker_count; i++)
 	{
-		if (NULL == manager->workers[i].task)
+		if (NULL == manager->workers[i].task && 0 == manager->workers[i].tasks.values_num)
 			return &manager->workers[i];
 	}
 
@@ -393,21 +502,33 @@ static trx_preprocessing_worker_t	*preprocessor_get_free_worker(trx_preprocessin
 static void	preprocessor_assign_tasks(trx_preprocessing_manager_t *manager)
 {
 	trx_preprocessing_worker_t	*worker;
-	void				*data;
 	trx_ipc_message_t		message;
+	int				batch_max;
 
 	treegix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	while (NULL != (worker = preprocessor_get_free_worker(manager)) &&
-			NULL != (data = preprocessor_get_next_task(manager, &message)))
+	while (NULL != (worker = preprocessor_get_free_worker(manager)))
 	{
+		/* batch size grows with queue depth to reduce worker round-trips under load */
+		batch_max = MIN(TRX_PREPROCESSING_BATCH_MAX, (int)(manager->preproc_num / manager->worker_count));
+
+		if (NULL == manager->direct_queue.head && 1 < batch_max)
+		{
+			if (0 == preprocessor_get_next_batch(manager, batch_max, &worker->tasks, &message))
+			{
+				trx_free(message.data);
+				break;
+			}
+		}
+		else if (NULL == (worker->task = preprocessor_get_next_task(manager, &message)))
+			break;
+
 		if (FAIL == trx_ipc_client_send(worker->client, message.code, message.data, message.size))
 		{
 			treegix_log(LOG_LEVEL_CRIT, "cannot send data to preprocessing worker");
 			exit(EXIT_FAILURE);
 		}
 
-		worker->task = data;
 		trx_ipc_message_clean(&message);
 	}
 
@@ -816,6 +937,63 @@ static void	preprocessor_add_request(trx_preprocessing_manager_t *manager, trx_i
 	treegix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+#ifdef HAVE_TRX_RINGBUF
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_add_ring_requests                                   *
+ *                                                                            *
+ * Purpose: handle new preprocessing requests written into shared memory ring *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *             ring    - [IN] the preprocessing manager ring                  *
+ *                                                                            *
+ * Comments: The values are unpacked into manager memory like the values      *
+ *           received through socket, the ring saves only the socket          *
+ *           transfer and message buffer reallocations.                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_add_ring_requests(trx_preprocessing_manager_t *manager, trx_ipc_ring_t *ring)
+{
+	trx_uint32_t			offset, code, size;
+	trx_preproc_item_value_t	value;
+	unsigned char			*data;
+	int				read_num, requests_num = 0;
+
+	do
+	{
+		for (read_num = 0; NULL != (data = trx_ipc_ring_read(ring, &code, &size)); read_num++)
+		{
+			if (TRX_IPC_PREPROCESSOR_REQUEST != code)
+				continue;
+
+			if (0 == requests_num++)
+			{
+				treegix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+				preprocessor_sync_configuration(manager);
+			}
+
+			/* values are unpacked into local memory, so the ring data can be released afterwards */
+			for (offset = 0; offset < size;)
+			{
+				offset += trx_preprocessor_unpack_value(&value, data + offset);
+				preprocessor_enqueue(manager, &value, NULL);
+			}
+		}
+
+		trx_ipc_ring_release(ring);
+	}
+	while (0 != read_num && TRX_PREPROCESSING_RING_REQUESTS_MAX > requests_num);
+
+	if (0 != requests_num)
+	{
+		preprocessor_assign_tasks(manager);
+		preprocessing_flush_queue(manager);
+
+		treegix_log(LOG_LEVEL_DEBUG, "End of %s() requests:%d", __func__, requests_num);
+	}
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: preprocessor_add_test_request                                    *
@@ -955,34 +1133,28 @@ out:
 
 /******************************************************************************
  *                                                                            *
- * Function: preprocessor_add_result                                          *
+ * Function: preprocessor_set_task_result                                     *
  *                                                                            *
- * Purpose: handle preprocessing result                                       *
+ * Purpose: apply preprocessing result to the queued request                  *
  *                                                                            *
  * Parameters: manager - [IN] preprocessing manager                           *
- *             client  - [IN] IPC client                                      *
- *             message - [IN] packed preprocessing result                     *
+ *             node    - [IN] the queue item of preprocessing request         *
+ *             data    - [IN] packed preprocessing result                     *
  *                                                                            *
  ******************************************************************************/
-static void	preprocessor_add_result(trx_preprocessing_manager_t *manager, trx_ipc_client_t *client,
-		trx_ipc_message_t *message)
+static void	preprocessor_set_task_result(trx_preprocessing_manager_t *manager, trx_list_item_t *node,
+		const unsigned char *data)
 {
-	trx_preprocessing_worker_t	*worker;
 	trx_preprocessing_request_t	*request;
 	trx_variant_t			value;
 	char				*error;
 	trx_vector_ptr_t		history;
 	trx_preproc_history_t		*vault;
-	trx_list_item_t			*node;
-
-	treegix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	worker = preprocessor_get_worker_by_client(manager, client);
-	node = (trx_list_item_t *)worker->task;
 	request = (trx_preprocessing_request_t *)node->data;
 
 	trx_vector_ptr_create(&history);
-	trx_preprocessor_unpack_result(&value, &history, &error, message->data);
+	trx_preprocessor_unpack_result(&value, &history, &error, data);
 
 	if (NULL != (vault = (trx_preproc_history_t *)trx_hashset_search(&manager->history_cache,
 			&request->value.itemid)))
@@ -1014,20 +1186,90 @@ static void	preprocessor_add_result(trx_preprocessing_manager_t *manager, trx_ip
 		}
 	}
 
-	preprocessor_set_request_state_done(manager, request, worker->task);
+	preprocessor_set_request_state_done(manager, request, node);
 
 	if (FAIL != preprocessor_set_variant_result(request, &value, error))
-		preprocessor_enqueue_dependent(manager, &request->value, worker->task);
+		preprocessor_enqueue_dependent(manager, &request->value, node);
 
-	worker->task = NULL;
 	trx_variant_clear(&value);
 
 	manager->preproc_num--;
 
+	trx_vector_ptr_destroy(&history);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_add_result                                          *
+ *                                                                            *
+ * Purpose: handle preprocessing result                                       *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *             client  - [IN] IPC client                                      *
+ *             message - [IN] packed preprocessing result                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_add_result(trx_preprocessing_manager_t *manager, trx_ipc_client_t *client,
+		trx_ipc_message_t *message)
+{
+	trx_preprocessing_worker_t	*worker;
+
+	treegix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	worker = preprocessor_get_worker_by_client(manager, client);
+
+	preprocessor_set_task_result(manager, (trx_list_item_t *)worker->task, message->data);
+	worker->task = NULL;
+	worker->stats_outdated = 1;
+
 	preprocessor_assign_tasks(manager);
 	preprocessing_flush_queue(manager);
 
-	trx_vector_ptr_destroy(&history);
+	treegix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_add_batch_result                                    *
+ *                                                                            *
+ * Purpose: handle preprocessing results of batched tasks                     *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *             client  - [IN] IPC client                                      *
+ *             message - [IN] packed preprocessing results, each prefixed     *
+ *                            with its size                                   *
+ *                                                                            *
+ * Comments: The worker is kept busy until all results are applied, so the    *
+ *           tasks assigned while enqueuing dependent items go to other       *
+ *           workers.                                                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_add_batch_result(trx_preprocessing_manager_t *manager, trx_ipc_client_t *client,
+		trx_ipc_message_t *message)
+{
+	trx_preprocessing_worker_t	*worker;
+	trx_uint32_t			offset = 0, size;
+	int				i;
+
+	treegix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	worker = preprocessor_get_worker_by_client(manager, client);
+
+	for (i = 0; i < worker->tasks.values_num; i++)
+	{
+		memcpy(&size, message->data + offset, sizeof(trx_uint32_t));
+		offset += sizeof(trx_uint32_t);
+
+		preprocessor_set_task_result(manager, (trx_list_item_t *)worker->tasks.values[i],
+				message->data + offset);
+		offset += size;
+	}
+
+	trx_vector_ptr_clear(&worker->tasks);
+	worker->stats_outdated = 1;
+
+	preprocessor_assign_tasks(manager);
+	preprocessing_flush_queue(manager);
 
 	treegix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -1062,6 +1304,7 @@ static void	preprocessor_flush_test_result(trx_preprocessing_manager_t *manager,
 		trx_ipc_client_send(direct_request->client, message->code, message->data, message->size);
 
 	worker->task = NULL;
+	worker->stats_outdated = 1;
 	preprocessor_free_direct_request(direct_request);
 
 	preprocessor_assign_tasks(manager);
@@ -1070,6 +1313,89 @@ static void	preprocessor_flush_test_result(trx_preprocessing_manager_t *manager,
 	treegix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_set_worker_stats                                    *
+ *                                                                            *
+ * Purpose: update compiled expression cache statistics of worker             *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *             client  - [IN] IPC client                                      *
+ *             message - [IN] the worker statistics                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_set_worker_stats(trx_preprocessing_manager_t *manager, trx_ipc_client_t *client,
+		const trx_ipc_message_t *message)
+{
+	trx_preprocessing_worker_t	*worker;
+
+	worker = preprocessor_get_worker_by_client(manager, client);
+	memcpy(&worker->stats, message->data, sizeof(worker->stats));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_request_worker_stats                                *
+ *                                                                            *
+ * Purpose: request compiled expression cache statistics from the workers     *
+ *          that processed values since the last request                      *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *                                                                            *
+ * Comments: The statistics are requested by manager, so the final statistics *
+ *           of workers that went idle are received too. Workers reply only   *
+ *           if the statistics have changed.                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_request_worker_stats(trx_preprocessing_manager_t *manager)
+{
+	int	i;
+
+	for (i = 0; i < manager->worker_count; i++)
+	{
+		trx_preprocessing_worker_t	*worker = &manager->workers[i];
+
+		if (0 == worker->stats_outdated)
+			continue;
+
+		if (FAIL == trx_ipc_client_send(worker->client, TRX_IPC_PREPROCESSOR_WORKER_STATS, NULL, 0))
+		{
+			treegix_log(LOG_LEVEL_CRIT, "cannot send data to preprocessing worker");
+			exit(EXIT_FAILURE);
+		}
+
+		worker->stats_outdated = 0;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_send_cache_stats                                    *
+ *                                                                            *
+ * Purpose: send compiled expression cache statistics of all workers          *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *             client  - [IN] IPC client requesting statistics                *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_send_cache_stats(trx_preprocessing_manager_t *manager, trx_ipc_client_t *client)
+{
+	trx_preproc_cache_stats_t	stats;
+	int				i;
+
+	memset(&stats, 0, sizeof(stats));
+
+	for (i = 0; i < manager->worker_count; i++)
+	{
+		stats.jsonpath_hits += manager->workers[i].stats.jsonpath_hits;
+		stats.jsonpath_misses += manager->workers[i].stats.jsonpath_misses;
+		stats.regexp_hits += manager->workers[i].stats.regexp_hits;
+		stats.regexp_misses += manager->workers[i].stats.regexp_misses;
+	}
+
+	trx_ipc_client_send(client, TRX_IPC_PREPROCESSOR_CACHE_STATS, (unsigned char *)&stats, sizeof(stats));
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: preprocessor_init_manager                                        *
@@ -1081,11 +1407,16 @@ static void	preprocessor_flush_test_result(trx_preprocessing_manager_t *manager,
  ******************************************************************************/
 static void	preprocessor_init_manager(trx_preprocessing_manager_t *manager)
 {
-	treegix_log(LOG_LEVEL_DEBUG, "In %s() workers: %d", __func__, CONFIG_PREPROCESSOR_FORKS);
+	int	worker_max;
+
+	worker_max = trx_preprocessor_manager_workers_num(process_num);
+
+	treegix_log(LOG_LEVEL_DEBUG, "In %s() workers: %d", __func__, worker_max);
 
 	memset(manager, 0, sizeof(trx_preprocessing_manager_t));
 
-	manager->workers = (trx_preprocessing_worker_t *)trx_calloc(NULL, CONFIG_PREPROCESSOR_FORKS,
+	manager->worker_max = worker_max;
+	manager->workers = (trx_preprocessing_worker_t *)trx_calloc(NULL, worker_max,
 			sizeof(trx_preprocessing_worker_t));
 	trx_list_create(&manager->queue);
 	trx_list_create(&manager->direct_queue);
@@ -1127,7 +1458,7 @@ static void preprocessor_register_worker(trx_preprocessing_manager_t *manager, t
 	}
 	else
 	{
-		if (CONFIG_PREPROCESSOR_FORKS == manager->worker_count)
+		if (manager->worker_max == manager->worker_count)
 		{
 			THIS_SHOULD_NEVER_HAPPEN;
 			exit(EXIT_FAILURE);
@@ -1135,6 +1466,7 @@ static void preprocessor_register_worker(trx_preprocessing_manager_t *manager, t
 
 		worker = (trx_preprocessing_worker_t *)&manager->workers[manager->worker_count++];
 		worker->client = client;
+		trx_vector_ptr_create(&worker->tasks);
 
 		preprocessor_assign_tasks(manager);
 	}
@@ -1155,6 +1487,10 @@ static void	preprocessor_destroy_manager(trx_preprocessing_manager_t *manager)
 {
 	trx_preprocessing_request_t		*request;
 	trx_preprocessing_direct_request_t	*direct_request;
+	int					i;
+
+	for (i = 0; i < manager->worker_count; i++)
+		trx_vector_ptr_destroy(&manager->workers[i].tasks);
 
 	trx_free(manager->workers);
 
@@ -1182,7 +1518,11 @@ TRX_THREAD_ENTRY(preprocessing_manager_thread, args)
 	trx_ipc_message_t		*message;
 	trx_preprocessing_manager_t	manager;
 	int				ret;
-	double				time_stat, time_idle = 0, time_now, time_flush, sec;
+	double				time_stat, time_idle = 0, time_now, time_flush, time_stats, sec;
+	char				service_name[MAX_STRING_LEN];
+#ifdef HAVE_TRX_RINGBUF
+	trx_ipc_ring_t			*ring;
+#endif
 
 #define	STAT_INTERVAL	5	/* if a process is busy and does not sleep then update status not faster than */
 				/* once in STAT_INTERVAL seconds */
@@ -1196,7 +1536,10 @@ TRX_THREAD_ENTRY(preprocessing_manager_thread, args)
 	treegix_log(LOG_LEVEL_INFORMATION, "%s #%d started [%s #%d]", get_program_type_string(program_type),
 			server_num, get_process_type_string(process_type), process_num);
 
-	if (FAIL == trx_ipc_service_start(&service, TRX_IPC_SERVICE_PREPROCESSING, &error))
+	/* each preprocessing manager processes values of its own partition of items */
+	trx_preprocessor_service_name(process_num, service_name, sizeof(service_name));
+
+	if (FAIL == trx_ipc_service_start(&service, service_name, &error))
 	{
 		treegix_log(LOG_LEVEL_CRIT, "cannot start preprocessing service: %s", error);
 		trx_free(error);
@@ -1204,10 +1547,14 @@ TRX_THREAD_ENTRY(preprocessing_manager_thread, args)
 	}
 
 	preprocessor_init_manager(&manager);
+#ifdef HAVE_TRX_RINGBUF
+	ring = trx_preprocessor_get_ring(process_num);
+#endif
 
 	/* initialize statistics */
 	time_stat = trx_time();
 	time_flush = time_stat;
+	time_stats = time_stat;
 
 	trx_setproctitle("%s #%d started", get_process_type_string(process_type), process_num);
 
@@ -1251,6 +1598,9 @@ TRX_THREAD_ENTRY(preprocessing_manager_thread, args)
 				case TRX_IPC_PREPROCESSOR_RESULT:
 					preprocessor_add_result(&manager, client, message);
 					break;
+				case TRX_IPC_PREPROCESSOR_BATCH_RESULT:
+					preprocessor_add_batch_result(&manager, client, message);
+					break;
 				case TRX_IPC_PREPROCESSOR_QUEUE:
 					trx_ipc_client_send(client, message->code, (unsigned char *)&manager.queued_num,
 							sizeof(trx_uint64_t));
@@ -1261,10 +1611,21 @@ TRX_THREAD_ENTRY(preprocessing_manager_thread, args)
 				case TRX_IPC_PREPROCESSOR_TEST_RESULT:
 					preprocessor_flush_test_result(&manager, client, message);
 					break;
+				case TRX_IPC_PREPROCESSOR_WORKER_STATS:
+					preprocessor_set_worker_stats(&manager, client, message);
+					break;
+				case TRX_IPC_PREPROCESSOR_CACHE_STATS:
+					preprocessor_send_cache_stats(&manager, client);
+					break;
 			}
 
 			trx_ipc_message_free(message);
 		}
+#ifdef HAVE_TRX_RINGBUF
+		/* ring notifications carry no data, the ring is checked after every received message */
+		if (NULL != ring)
+			preprocessor_add_ring_requests(&manager, ring);
+#endif
 
 		if (NULL != client)
 			trx_ipc_client_release(client);
@@ -1274,6 +1635,12 @@ TRX_THREAD_ENTRY(preprocessing_manager_thread, args)
 			dc_flush_history();
 			time_flush = time_now;
 		}
+
+		if (TRX_PREPROCESSING_STATS_DELAY <= time_now - time_stats)
+		{
+			preprocessor_request_worker_stats(&manager);
+			time_stats = time_now;
+		}
 	}
 
 	trx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
@@ -258,18 +258,20 @@ static int	worker_item_preproc_execute(unsigned char value_type, trx_variant_t *
 
 /******************************************************************************
  *                                                                            *
- * Function: worker_preprocess_value                                          *
+ * Function: worker_execute_task                                              *
  *                                                                            *
- * Purpose: handle item value preprocessing task                              *
+ * Purpose: execute item value preprocessing task                             *
  *                                                                            *
- * Parameters: socket  - [IN] IPC socket                                      *
- *             message - [IN] packed preprocessing task                       *
+ * Parameters: task - [IN] packed preprocessing task                          *
+ *             data - [OUT] packed preprocessing result                       *
+ *                                                                            *
+ * Return value: size of packed preprocessing result                          *
  *                                                                            *
  ******************************************************************************/
-static void	worker_preprocess_value(trx_ipc_socket_t *socket, trx_ipc_message_t *message)
+static trx_uint32_t	worker_execute_task(const unsigned char *task, unsigned char **data)
 {
-	trx_uint32_t		size = 0;
-	unsigned char		*data = NULL, value_type;
+	trx_uint32_t		size;
+	unsigned char		value_type;
 	trx_uint64_t		itemid;
 	trx_variant_t		value, value_start;
 	int			i, steps_num, results_num, ret;
@@ -282,8 +284,7 @@ static void	worker_preprocess_value(trx_ipc_socket_t *socket, trx_ipc_message_t
 	trx_vector_ptr_create(&history_in);
 	trx_vector_ptr_create(&history_out);
 
-	trx_preprocessor_unpack_task(&itemid, &value_type, &ts, &value, &history_in, &steps, &steps_num,
-			message->data);
+	trx_preprocessor_unpack_task(&itemid, &value_type, &ts, &value, &history_in, &steps, &steps_num, task);
 
 	trx_variant_copy(&value_start, &value);
 	results = (trx_preproc_result_t *)trx_malloc(NULL, sizeof(trx_preproc_result_t) * steps_num);
@@ -312,20 +313,12 @@ static void	worker_preprocess_value(trx_ipc_socket_t *socket, trx_ipc_message_t
 		treegix_log(LOG_LEVEL_DEBUG, "%s: %s %s",__func__,  trx_result_string(ret), result);
 	}
 
-	size = trx_preprocessor_pack_result(&data, &value, &history_out, error);
+	size = trx_preprocessor_pack_result(data, &value, &history_out, error);
 	trx_variant_clear(&value);
 	trx_free(error);
 	trx_free(ts);
 	trx_free(steps);
 
-	if (FAIL == trx_ipc_socket_write(socket, TRX_IPC_PREPROCESSOR_RESULT, data, size))
-	{
-		treegix_log(LOG_LEVEL_CRIT, "cannot send preprocessing result");
-		exit(EXIT_FAILURE);
-	}
-
-	trx_free(data);
-
 	trx_variant_clear(&value_start);
 
 	for (i = 0; i < results_num; i++)
@@ -337,6 +330,87 @@ static void	worker_preprocess_value(trx_ipc_socket_t *socket, trx_ipc_message_t
 
 	trx_vector_ptr_clear_ext(&history_in, (trx_clean_func_t)trx_preproc_op_history_free);
 	trx_vector_ptr_destroy(&history_in);
+
+	return size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: worker_preprocess_value                                          *
+ *                                                                            *
+ * Purpose: handle item value preprocessing task                              *
+ *                                                                            *
+ * Parameters: socket  - [IN] IPC socket                                      *
+ *             message - [IN] packed preprocessing task                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	worker_preprocess_value(trx_ipc_socket_t *socket, trx_ipc_message_t *message)
+{
+	trx_uint32_t	size;
+	unsigned char	*data = NULL;
+
+	size = worker_execute_task(message->data, &data);
+
+	if (FAIL == trx_ipc_socket_write(socket, TRX_IPC_PREPROCESSOR_RESULT, data, size))
+	{
+		treegix_log(LOG_LEVEL_CRIT, "cannot send preprocessing result");
+		exit(EXIT_FAILURE);
+	}
+
+	trx_free(data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: worker_preprocess_batch                                          *
+ *                                                                            *
+ * Purpose: handle batch of item value preprocessing tasks                    *
+ *                                                                            *
+ * Parameters: socket  - [IN] IPC socket                                      *
+ *             message - [IN] packed preprocessing tasks, each prefixed with  *
+ *                            its size                                        *
+ *                                                                            *
+ * Comments: The results are returned in the same order as tasks, each        *
+ *           prefixed with its size.                                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	worker_preprocess_batch(trx_ipc_socket_t *socket, trx_ipc_message_t *message)
+{
+	trx_uint32_t	task_size, result_size, offset = 0;
+	unsigned char	*result = NULL, *data = NULL;
+	size_t		data_alloc = 0, data_offset = 0;
+
+	while (offset < message->size)
+	{
+		memcpy(&task_size, message->data + offset, sizeof(trx_uint32_t));
+		offset += sizeof(trx_uint32_t);
+
+		result_size = worker_execute_task(message->data + offset, &result);
+		offset += task_size;
+
+		if (data_alloc < data_offset + sizeof(trx_uint32_t) + result_size)
+		{
+			while (data_alloc < data_offset + sizeof(trx_uint32_t) + result_size)
+				data_alloc += TRX_KIBIBYTE * 64;
+
+			data = (unsigned char *)trx_realloc(data, data_alloc);
+		}
+
+		memcpy(data + data_offset, &result_size, sizeof(trx_uint32_t));
+		data_offset += sizeof(trx_uint32_t);
+		memcpy(data + data_offset, result, result_size);
+		data_offset += result_size;
+
+		trx_free(result);
+	}
+
+	if (FAIL == trx_ipc_socket_write(socket, TRX_IPC_PREPROCESSOR_BATCH_RESULT, data, data_offset))
+	{
+		treegix_log(LOG_LEVEL_CRIT, "cannot send preprocessing result");
+		exit(EXIT_FAILURE);
+	}
+
+	trx_free(data);
 }
 
 /******************************************************************************
@@ -405,12 +479,43 @@ static void	worker_test_value(trx_ipc_socket_t *socket, trx_ipc_message_t *messa
 	trx_vector_ptr_destroy(&history_in);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: worker_send_stats                                                *
+ *                                                                            *
+ * Purpose: send compiled expression cache statistics to preprocessing        *
+ *          manager if they have changed since the last update                *
+ *                                                                            *
+ * Parameters: socket - [IN] IPC socket                                       *
+ *             stats  - [IN/OUT] the last sent statistics                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	worker_send_stats(trx_ipc_socket_t *socket, trx_preproc_cache_stats_t *stats)
+{
+	trx_preproc_cache_stats_t	stats_local;
+
+	trx_item_preproc_cache_get_stats(&stats_local);
+
+	if (0 == memcmp(stats, &stats_local, sizeof(stats_local)))
+		return;
+
+	if (FAIL == trx_ipc_socket_write(socket, TRX_IPC_PREPROCESSOR_WORKER_STATS, (unsigned char *)&stats_local,
+			sizeof(stats_local)))
+	{
+		treegix_log(LOG_LEVEL_CRIT, "cannot send preprocessing worker statistics");
+		exit(EXIT_FAILURE);
+	}
+
+	*stats = stats_local;
+}
+
 TRX_THREAD_ENTRY(preprocessing_worker_thread, args)
 {
-	pid_t			ppid;
-	char			*error = NULL;
-	trx_ipc_socket_t	socket;
-	trx_ipc_message_t	message;
+	pid_t				ppid;
+	char				*error = NULL, service_name[MAX_STRING_LEN];
+	trx_ipc_socket_t		socket;
+	trx_ipc_message_t		message;
+	trx_preproc_cache_stats_t	stats;
 
 	process_type = ((trx_thread_args_t *)args)->process_type;
 	server_num = ((trx_thread_args_t *)args)->server_num;
@@ -421,8 +526,12 @@ TRX_THREAD_ENTRY(preprocessing_worker_thread, args)
 	trx_es_init(&es_engine);
 
 	trx_ipc_message_init(&message);
+	memset(&stats, 0, sizeof(stats));
+
+	trx_preprocessor_service_name(trx_preprocessor_worker_manager_num(process_num), service_name,
+			sizeof(service_name));
 
-	if (FAIL == trx_ipc_socket_open(&socket, TRX_IPC_SERVICE_PREPROCESSING, SEC_PER_MIN, &error))
+	if (FAIL == trx_ipc_socket_open(&socket, service_name, SEC_PER_MIN, &error))
 	{
 		treegix_log(LOG_LEVEL_CRIT, "cannot connect to preprocessing service: %s", error);
 		trx_free(error);
@@ -457,9 +566,15 @@ TRX_THREAD_ENTRY(preprocessing_worker_thread, args)
 			case TRX_IPC_PREPROCESSOR_REQUEST:
 				worker_preprocess_value(&socket, &message);
 				break;
+			case TRX_IPC_PREPROCESSOR_BATCH_REQUEST:
+				worker_preprocess_batch(&socket, &message);
+				break;
 			case TRX_IPC_PREPROCESSOR_TEST_REQUEST:
 				worker_test_value(&socket, &message);
 				break;
+			case TRX_IPC_PREPROCESSOR_WORKER_STATS:
+				worker_send_stats(&socket, &stats);
+				break;
 		}
 
 		trx_ipc_message_clean(&message);
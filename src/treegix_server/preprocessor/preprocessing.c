@@ -6,6 +6,7 @@
 #include "trxserver.h"
 #include "trxserialize.h"
 #include "trxipcservice.h"
+#include "memalloc.h"
 
 #include "preproc.h"
 #include "preprocessing.h"
@@ -15,6 +16,8 @@
 #define PACKED_FIELD_STRING	1
 #define MAX_VALUES_LOCAL	256
 
+#define PREPROC_VALUE_FIELDS_MAX	23
+
 /* packed field data description */
 typedef struct
 {
@@ -27,8 +30,66 @@ trx_packed_field_t;
 #define PACKED_FIELD(value, size)	\
 		(trx_packed_field_t){(value), (size), (0 == (size) ? PACKED_FIELD_STRING : PACKED_FIELD_RAW)};
 
-static trx_ipc_message_t	cached_message;
-static int			cached_values;
+extern int		CONFIG_PREPROCMAN_FORKS, CONFIG_PREPROCESSOR_FORKS;
+extern trx_uint64_t	CONFIG_PREPROCESSING_RING_SIZE;
+
+/* connection to preprocessing manager and values cached locally before sending to it */
+typedef struct
+{
+	trx_ipc_socket_t	socket;
+	trx_ipc_message_t	cached_message;
+	int			cached_values;
+}
+trx_preprocessor_conn_t;
+
+static trx_preprocessor_conn_t	*preproc_conns;
+
+#ifdef HAVE_TRX_RINGBUF
+/* shared memory rings of preprocessing managers, created by main process before forking */
+static trx_ipc_ring_t		**preproc_rings;
+#endif
+
+/* values of items without preprocessing steps and dependent items are added directly to history cache */
+static int			direct_values;
+
+/* the identifiers of items which values must be sent to preprocessing manager, updated on flush */
+static trx_hashset_t		preproc_itemids;
+static int			preproc_itemids_ts = -1;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: message_pack_fields                                              *
+ *                                                                            *
+ * Purpose: packs data into buffer based on defined format                    *
+ *                                                                            *
+ * Parameters: offset - [OUT] the buffer, must be large enough to store data  *
+ *             fields - [IN] the definition of data to be packed with sizes   *
+ *                           calculated by message_pack_data()                *
+ *             count  - [IN] field count                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	message_pack_fields(unsigned char *offset, const trx_packed_field_t *fields, int count)
+{
+	int 		i;
+	trx_uint32_t	field_size;
+
+	for (i = 0; i < count; i++)
+	{
+		field_size = fields[i].size;
+
+		if (PACKED_FIELD_STRING == fields[i].type)
+		{
+			memcpy(offset, (trx_uint32_t *)&field_size, sizeof(trx_uint32_t));
+			if (0 != field_size && NULL != fields[i].value)
+				memcpy(offset + sizeof(trx_uint32_t), fields[i].value, field_size);
+			field_size += sizeof(trx_uint32_t);
+		}
+		else
+			memcpy(offset, fields[i].value, field_size);
+
+		offset += field_size;
+	}
+}
 
 /******************************************************************************
  *                                                                            *
@@ -48,7 +109,6 @@ static trx_uint32_t	message_pack_data(trx_ipc_message_t *message, trx_packed_fie
 {
 	int 		i;
 	trx_uint32_t	field_size, data_size = 0;
-	unsigned char	*offset = NULL;
 
 	if (NULL != message)
 	{
@@ -56,39 +116,24 @@ static trx_uint32_t	message_pack_data(trx_ipc_message_t *message, trx_packed_fie
 		data_size = message_pack_data(NULL, fields, count);
 		message->size += data_size;
 		message->data = (unsigned char *)trx_realloc(message->data, message->size);
-		offset = message->data + (message->size - data_size);
+		message_pack_fields(message->data + (message->size - data_size), fields, count);
+
+		return data_size;
 	}
 
+	/* size calculation */
 	for (i = 0; i < count; i++)
 	{
 		field_size = fields[i].size;
-		if (NULL != offset)
-		{
-			/* data packing */
-			if (PACKED_FIELD_STRING == fields[i].type)
-			{
-				memcpy(offset, (trx_uint32_t *)&field_size, sizeof(trx_uint32_t));
-				if (0 != field_size && NULL != fields[i].value)
-					memcpy(offset + sizeof(trx_uint32_t), fields[i].value, field_size);
-				field_size += sizeof(trx_uint32_t);
-			}
-			else
-				memcpy(offset, fields[i].value, field_size);
 
-			offset += field_size;
-		}
-		else
+		if (PACKED_FIELD_STRING == fields[i].type)
 		{
-			/* size calculation */
-			if (PACKED_FIELD_STRING == fields[i].type)
-			{
-				field_size = (NULL != fields[i].value) ? strlen((const char *)fields[i].value) + 1 : 0;
-				fields[i].size = field_size;
-				field_size += sizeof(trx_uint32_t);
-			}
-
-			data_size += field_size;
+			field_size = (NULL != fields[i].value) ? strlen((const char *)fields[i].value) + 1 : 0;
+			fields[i].size = field_size;
+			field_size += sizeof(trx_uint32_t);
 		}
+
+		data_size += field_size;
 	}
 
 	return data_size;
@@ -96,30 +141,33 @@ static trx_uint32_t	message_pack_data(trx_ipc_message_t *message, trx_packed_fie
 
 /******************************************************************************
  *                                                                            *
- * Function: preprocessor_pack_value                                          *
+ * Function: preprocessor_get_value_fields                                    *
  *                                                                            *
- * Purpose: pack item value data into a single buffer that can be used in IPC *
+ * Purpose: get definition of item value data to be packed                    *
  *                                                                            *
- * Parameters: message - [OUT] IPC message                                    *
+ * Parameters: fields  - [OUT] the data definition, must have space for       *
+ *                             PREPROC_VALUE_FIELDS_MAX fields                *
+ *             markers - [OUT] the timestamp, result and log markers          *
  *             value   - [IN]  value to be packed                             *
  *                                                                            *
- * Return value: size of packed data                                          *
+ * Return value: field count                                                  *
  *                                                                            *
  ******************************************************************************/
-static trx_uint32_t	preprocessor_pack_value(trx_ipc_message_t *message, trx_preproc_item_value_t *value)
+static int	preprocessor_get_value_fields(trx_packed_field_t *fields, unsigned char *markers,
+		const trx_preproc_item_value_t *value)
 {
-	trx_packed_field_t	fields[23], *offset = fields;	/* 23 - max field count */
-	unsigned char		ts_marker, result_marker, log_marker;
+	trx_packed_field_t	*offset = fields;
+	unsigned char		*ts_marker = &markers[0], *result_marker = &markers[1], *log_marker = &markers[2];
 
-	ts_marker = (NULL != value->ts);
-	result_marker = (NULL != value->result);
+	*ts_marker = (NULL != value->ts);
+	*result_marker = (NULL != value->result);
 
 	*offset++ = PACKED_FIELD(&value->itemid, sizeof(trx_uint64_t));
 	*offset++ = PACKED_FIELD(&value->item_value_type, sizeof(unsigned char));
 	*offset++ = PACKED_FIELD(&value->item_flags, sizeof(unsigned char));
 	*offset++ = PACKED_FIELD(&value->state, sizeof(unsigned char));
 	*offset++ = PACKED_FIELD(value->error, 0);
-	*offset++ = PACKED_FIELD(&ts_marker, sizeof(unsigned char));
+	*offset++ = PACKED_FIELD(ts_marker, sizeof(unsigned char));
 
 	if (NULL != value->ts)
 	{
@@ -127,7 +175,7 @@ static trx_uint32_t	preprocessor_pack_value(trx_ipc_message_t *message, trx_prep
 		*offset++ = PACKED_FIELD(&value->ts->ns, sizeof(int));
 	}
 
-	*offset++ = PACKED_FIELD(&result_marker, sizeof(unsigned char));
+	*offset++ = PACKED_FIELD(result_marker, sizeof(unsigned char));
 
 	if (NULL != value->result)
 	{
@@ -141,8 +189,8 @@ static trx_uint32_t	preprocessor_pack_value(trx_ipc_message_t *message, trx_prep
 		*offset++ = PACKED_FIELD(&value->result->type, sizeof(int));
 		*offset++ = PACKED_FIELD(&value->result->mtime, sizeof(int));
 
-		log_marker = (NULL != value->result->log);
-		*offset++ = PACKED_FIELD(&log_marker, sizeof(unsigned char));
+		*log_marker = (NULL != value->result->log);
+		*offset++ = PACKED_FIELD(log_marker, sizeof(unsigned char));
 		if (NULL != value->result->log)
 		{
 			*offset++ = PACKED_FIELD(value->result->log->value, 0);
@@ -153,7 +201,30 @@ static trx_uint32_t	preprocessor_pack_value(trx_ipc_message_t *message, trx_prep
 		}
 	}
 
-	return message_pack_data(message, fields, offset - fields);
+	return offset - fields;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_pack_value                                          *
+ *                                                                            *
+ * Purpose: pack item value data into a single buffer that can be used in IPC *
+ *                                                                            *
+ * Parameters: message - [OUT] IPC message                                    *
+ *             value   - [IN]  value to be packed                             *
+ *                                                                            *
+ * Return value: size of packed data                                          *
+ *                                                                            *
+ ******************************************************************************/
+static trx_uint32_t	preprocessor_pack_value(trx_ipc_message_t *message, trx_preproc_item_value_t *value)
+{
+	trx_packed_field_t	fields[PREPROC_VALUE_FIELDS_MAX];
+	unsigned char		markers[3];
+	int			count;
+
+	count = preprocessor_get_value_fields(fields, markers, value);
+
+	return message_pack_data(message, fields, count);
 }
 
 /******************************************************************************
@@ -757,44 +828,374 @@ void	trx_preprocessor_unpack_test_result(trx_vector_ptr_t *results, trx_vector_p
 }
 /******************************************************************************
  *                                                                            *
- * Function: preprocessor_send                                                *
+ * Function: trx_preprocessor_init_rings                                      *
  *                                                                            *
- * Purpose: sends command to preprocessor manager                             *
+ * Purpose: allocates shared memory rings used to pass item values to         *
+ *          preprocessing managers                                            *
+ *                                                                            *
+ * Parameters: error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the rings were allocated or are disabled           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Must be called by main process before forking.                   *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_preprocessor_init_rings(char **error)
+{
+#ifdef HAVE_TRX_RINGBUF
+	trx_mem_info_t	*ring_mem = NULL;
+	size_t		ring_size, mem_size;
+	int		i, ret;
+
+	if (0 == CONFIG_PREPROCESSING_RING_SIZE)
+		return SUCCEED;
+
+	/* ring size must be power of 2 */
+	for (ring_size = TRX_MEBIBYTE; ring_size * 2 <= CONFIG_PREPROCESSING_RING_SIZE; ring_size *= 2)
+		;
+
+	mem_size = trx_mem_required_size(CONFIG_PREPROCMAN_FORKS, "preprocessing ring", "PreprocessingRingSize") +
+			trx_ipc_ring_required_size(ring_size) * CONFIG_PREPROCMAN_FORKS;
+
+	if (SUCCEED != (ret = trx_mem_create(&ring_mem, mem_size, "preprocessing ring", "PreprocessingRingSize", 0,
+			error)))
+	{
+		return ret;
+	}
+
+	preproc_rings = (trx_ipc_ring_t **)trx_malloc(NULL, sizeof(trx_ipc_ring_t *) * CONFIG_PREPROCMAN_FORKS);
+
+	for (i = 0; i < CONFIG_PREPROCMAN_FORKS; i++)
+	{
+		preproc_rings[i] = trx_ipc_ring_init(trx_mem_malloc(ring_mem, NULL,
+				trx_ipc_ring_required_size(ring_size)), ring_size);
+	}
+
+	return SUCCEED;
+#else
+	if (0 == CONFIG_PREPROCESSING_RING_SIZE)
+		return SUCCEED;
+
+	*error = trx_strdup(*error, "preprocessing rings are not supported on this platform,"
+			" set \"PreprocessingRingSize\" configuration parameter to 0");
+
+	return FAIL;
+#endif
+}
+
+#ifdef HAVE_TRX_RINGBUF
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_preprocessor_get_ring                                        *
+ *                                                                            *
+ * Purpose: gets shared memory ring of the specified preprocessing manager    *
+ *                                                                            *
+ * Parameters: manager_num - [IN] the preprocessing manager number, starting  *
+ *                                with 1                                      *
+ *                                                                            *
+ * Return value: The ring or NULL if rings are disabled                       *
+ *                                                                            *
+ ******************************************************************************/
+trx_ipc_ring_t	*trx_preprocessor_get_ring(int manager_num)
+{
+	if (NULL == preproc_rings)
+		return NULL;
+
+	return preproc_rings[manager_num - 1];
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_preprocessor_service_name                                    *
+ *                                                                            *
+ * Purpose: gets IPC service name of the specified preprocessing manager      *
+ *                                                                            *
+ * Parameters: manager_num - [IN] the preprocessing manager number, starting  *
+ *                                with 1                                      *
+ *             name        - [OUT] the service name                           *
+ *             name_len    - [IN] the service name buffer size                *
+ *                                                                            *
+ * Comments: The first preprocessing manager uses the default service name,   *
+ *           so that test requests can be sent without knowing the number of  *
+ *           started managers.                                                *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_preprocessor_service_name(int manager_num, char *name, size_t name_len)
+{
+	if (1 == manager_num)
+		trx_strlcpy(name, TRX_IPC_SERVICE_PREPROCESSING, name_len);
+	else
+		trx_snprintf(name, name_len, TRX_IPC_SERVICE_PREPROCESSING "%d", manager_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_preprocessor_worker_manager_num                              *
+ *                                                                            *
+ * Purpose: gets number of preprocessing manager the specified preprocessing  *
+ *          worker must connect to                                            *
+ *                                                                            *
+ * Parameters: worker_num - [IN] the preprocessing worker number, starting    *
+ *                               with 1                                       *
+ *                                                                            *
+ * Return value: The preprocessing manager number                             *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_preprocessor_worker_manager_num(int worker_num)
+{
+	return (worker_num - 1) % CONFIG_PREPROCMAN_FORKS + 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_preprocessor_manager_workers_num                             *
+ *                                                                            *
+ * Purpose: gets number of preprocessing workers connecting to the specified  *
+ *          preprocessing manager                                             *
+ *                                                                            *
+ * Parameters: manager_num - [IN] the preprocessing manager number, starting  *
+ *                                with 1                                      *
+ *                                                                            *
+ * Return value: The number of preprocessing workers                          *
+ *                                                                            *
+ ******************************************************************************/
+int	trx_preprocessor_manager_workers_num(int manager_num)
+{
+	return CONFIG_PREPROCESSOR_FORKS / CONFIG_PREPROCMAN_FORKS +
+			(manager_num <= CONFIG_PREPROCESSOR_FORKS % CONFIG_PREPROCMAN_FORKS ? 1 : 0);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_get_conn                                            *
+ *                                                                            *
+ * Purpose: gets connection to the specified preprocessing manager            *
  *                                                                            *
- * Parameters: code     - [IN] message code                                   *
- *             data     - [IN] message data                                   *
- *             size     - [IN] message data size                              *
- *             response - [OUT] response message (can be NULL if response is  *
- *                              not requested)                                *
+ * Parameters: index - [IN] the preprocessing manager index, starting with 0  *
+ *                                                                            *
+ * Return value: The preprocessing manager connection                         *
  *                                                                            *
  ******************************************************************************/
-static void	preprocessor_send(trx_uint32_t code, unsigned char *data, trx_uint32_t size,
-		trx_ipc_message_t *response)
+static trx_preprocessor_conn_t	*preprocessor_get_conn(int index)
 {
-	char			*error = NULL;
-	static trx_ipc_socket_t	socket = {0};
+	if (NULL == preproc_conns)
+	{
+		preproc_conns = (trx_preprocessor_conn_t *)trx_calloc(NULL, CONFIG_PREPROCMAN_FORKS,
+				sizeof(trx_preprocessor_conn_t));
+	}
+
+	return &preproc_conns[index];
+}
 
-	/* each process has a permanent connection to preprocessing manager */
-	if (0 == socket.fd && FAIL == trx_ipc_socket_open(&socket, TRX_IPC_SERVICE_PREPROCESSING, SEC_PER_MIN,
-			&error))
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_connect                                             *
+ *                                                                            *
+ * Purpose: connects to preprocessing manager if not yet connected            *
+ *                                                                            *
+ * Parameters: conn        - [IN] the preprocessing manager connection        *
+ *             manager_num - [IN] the preprocessing manager number            *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_connect(trx_preprocessor_conn_t *conn, int manager_num)
+{
+	char	*error = NULL, service_name[MAX_STRING_LEN];
+
+	/* each process has a permanent connection to every preprocessing manager */
+	if (0 != conn->socket.fd)
+		return;
+
+	trx_preprocessor_service_name(manager_num, service_name, sizeof(service_name));
+
+	if (FAIL == trx_ipc_socket_open(&conn->socket, service_name, SEC_PER_MIN, &error))
 	{
 		treegix_log(LOG_LEVEL_CRIT, "cannot connect to preprocessing service: %s", error);
 		exit(EXIT_FAILURE);
 	}
+}
 
-	if (FAIL == trx_ipc_socket_write(&socket, code, data, size))
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_send                                                *
+ *                                                                            *
+ * Purpose: sends command to preprocessor manager                             *
+ *                                                                            *
+ * Parameters: conn        - [IN] the preprocessing manager connection        *
+ *             manager_num - [IN] the preprocessing manager number            *
+ *             code        - [IN] message code                                *
+ *             data        - [IN] message data                                *
+ *             size        - [IN] message data size                           *
+ *             response    - [OUT] response message (can be NULL if response  *
+ *                                 is not requested)                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_send(trx_preprocessor_conn_t *conn, int manager_num, trx_uint32_t code,
+		unsigned char *data, trx_uint32_t size, trx_ipc_message_t *response)
+{
+	preprocessor_connect(conn, manager_num);
+
+	if (FAIL == trx_ipc_socket_write(&conn->socket, code, data, size))
 	{
 		treegix_log(LOG_LEVEL_CRIT, "cannot send data to preprocessing service");
 		exit(EXIT_FAILURE);
 	}
 
-	if (NULL != response && FAIL == trx_ipc_socket_read(&socket, response))
+	if (NULL != response && FAIL == trx_ipc_socket_read(&conn->socket, response))
 	{
 		treegix_log(LOG_LEVEL_CRIT, "cannot receive data from preprocessing service");
 		exit(EXIT_FAILURE);
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_flush_conn                                          *
+ *                                                                            *
+ * Purpose: sends locally cached values to preprocessing manager              *
+ *                                                                            *
+ * Parameters: index - [IN] the preprocessing manager index, starting with 0  *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_flush_conn(int index)
+{
+	trx_preprocessor_conn_t	*conn;
+
+	conn = preprocessor_get_conn(index);
+#ifdef HAVE_TRX_RINGBUF
+	if (NULL != preproc_rings)
+	{
+		/* values are already in the ring, wake up preprocessing manager to read them */
+		if (0 != conn->cached_values)
+		{
+			if (SUCCEED != trx_ipc_ring_notify(preproc_rings[index], &conn->socket,
+					TRX_IPC_PREPROCESSOR_RING))
+			{
+				treegix_log(LOG_LEVEL_CRIT, "cannot send data to preprocessing service");
+				exit(EXIT_FAILURE);
+			}
+
+			conn->cached_values = 0;
+		}
+
+		return;
+	}
+#endif
+	if (0 < conn->cached_message.size)
+	{
+		preprocessor_send(conn, index + 1, TRX_IPC_PREPROCESSOR_REQUEST, conn->cached_message.data,
+				conn->cached_message.size, NULL);
+
+		trx_ipc_message_clean(&conn->cached_message);
+		trx_ipc_message_init(&conn->cached_message);
+		conn->cached_values = 0;
+	}
+}
+
+#ifdef HAVE_TRX_RINGBUF
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_ring_add_value                                      *
+ *                                                                            *
+ * Purpose: packs item value into preprocessing manager ring                  *
+ *                                                                            *
+ * Parameters: index - [IN] the preprocessing manager index, starting with 0  *
+ *             value - [IN] the value to write                                *
+ *                                                                            *
+ * Comments: Values too large for the ring are sent through socket after the  *
+ *           previously written values have been read by preprocessing        *
+ *           manager. Queue size request is used as a barrier to ensure the   *
+ *           value is processed before the next values written into the ring. *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_ring_add_value(int index, const trx_preproc_item_value_t *value)
+{
+	trx_preprocessor_conn_t	*conn;
+	trx_ipc_ring_t		*ring = preproc_rings[index];
+	trx_packed_field_t	fields[PREPROC_VALUE_FIELDS_MAX];
+	unsigned char		markers[3], *data;
+	int			count;
+	trx_uint32_t		size;
+	trx_ipc_message_t	message;
+
+	conn = preprocessor_get_conn(index);
+	preprocessor_connect(conn, index + 1);
+
+	count = preprocessor_get_value_fields(fields, markers, value);
+	size = message_pack_data(NULL, fields, count);
+
+	if (SUCCEED == trx_ipc_ring_reserve(ring, &conn->socket, TRX_IPC_PREPROCESSOR_RING,
+			TRX_IPC_PREPROCESSOR_REQUEST, size, &data))
+	{
+		message_pack_fields(data, fields, count);
+		trx_ipc_ring_commit(data);
+
+		if (MAX_VALUES_LOCAL < ++conn->cached_values)
+			preprocessor_flush_conn(index);
+
+		return;
+	}
+
+	if (SUCCEED != trx_ipc_ring_flush(ring, &conn->socket, TRX_IPC_PREPROCESSOR_RING))
+	{
+		treegix_log(LOG_LEVEL_CRIT, "cannot send data to preprocessing service");
+		exit(EXIT_FAILURE);
+	}
+
+	conn->cached_values = 0;
+
+	trx_ipc_message_init(&message);
+	message_pack_data(&message, fields, count);
+	preprocessor_send(conn, index + 1, TRX_IPC_PREPROCESSOR_REQUEST, message.data, message.size, NULL);
+	trx_ipc_message_clean(&message);
+
+	trx_ipc_message_init(&message);
+	preprocessor_send(conn, index + 1, TRX_IPC_PREPROCESSOR_QUEUE, NULL, 0, &message);
+	trx_ipc_message_clean(&message);
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_bypass_value                                        *
+ *                                                                            *
+ * Purpose: check if item value can be added directly to history cache        *
+ *          without passing it to preprocessing manager                       *
+ *                                                                            *
+ * Parameters: itemid     - [IN] the itemid                                   *
+ *             item_flags - [IN] the item flags (e. g. lld rule)              *
+ *                                                                            *
+ * Return value: SUCCEED - the item has no preprocessing steps and dependent  *
+ *                         items, value can be added to history cache         *
+ *               FAIL    - the value must be sent to preprocessing manager    *
+ *                                                                            *
+ * Comments: Low-level discovery rule values are always sent to preprocessing *
+ *           manager, which forwards them to LLD manager.                     *
+ *           The items are checked against local copy of preprocessable item  *
+ *           identifiers, updated from configuration cache when values are    *
+ *           flushed, so no configuration cache lock is taken per value.      *
+ *                                                                            *
+ ******************************************************************************/
+static int	preprocessor_bypass_value(trx_uint64_t itemid, unsigned char item_flags)
+{
+	if (0 != (item_flags & TRX_FLAG_DISCOVERY_RULE))
+		return FAIL;
+
+	if (-1 == preproc_itemids_ts)
+	{
+		trx_hashset_create(&preproc_itemids, 1000, TRX_DEFAULT_UINT64_HASH_FUNC,
+				TRX_DEFAULT_UINT64_COMPARE_FUNC);
+		preproc_itemids_ts = 0;
+		DCconfig_get_preprocessable_itemids(&preproc_itemids, &preproc_itemids_ts);
+	}
+
+	if (NULL != trx_hashset_search(&preproc_itemids, &itemid))
+		return FAIL;
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: trx_preprocess_item_value                                        *
@@ -817,14 +1218,40 @@ void	trx_preprocess_item_value(trx_uint64_t itemid, unsigned char item_value_typ
 {
 	trx_preproc_item_value_t	value = {.itemid = itemid, .item_value_type = item_value_type, .result = result,
 					.error = error, .item_flags = item_flags, .state = state, .ts = ts};
+	trx_preprocessor_conn_t		*conn;
+	int				index;
 
 	treegix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	preprocessor_pack_value(&cached_message, &value);
+	if (SUCCEED == preprocessor_bypass_value(itemid, item_flags))
+	{
+		dc_add_history(itemid, item_value_type, item_flags, result, ts, state, error);
 
-	if (MAX_VALUES_LOCAL < ++cached_values)
-		trx_preprocessor_flush();
+		if (MAX_VALUES_LOCAL < ++direct_values)
+		{
+			dc_flush_history();
+			direct_values = 0;
+		}
 
+		goto out;
+	}
+
+	/* values of an item and its dependent items are always processed by the same preprocessing manager */
+	index = (int)(itemid % (trx_uint64_t)CONFIG_PREPROCMAN_FORKS);
+#ifdef HAVE_TRX_RINGBUF
+	if (NULL != preproc_rings)
+	{
+		preprocessor_ring_add_value(index, &value);
+		goto out;
+	}
+#endif
+	conn = preprocessor_get_conn(index);
+
+	preprocessor_pack_value(&conn->cached_message, &value);
+
+	if (MAX_VALUES_LOCAL < ++conn->cached_values)
+		preprocessor_flush_conn(index);
+out:
 	treegix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
@@ -832,41 +1259,89 @@ void	trx_preprocess_item_value(trx_uint64_t itemid, unsigned char item_value_typ
  *                                                                            *
  * Function: trx_preprocessor_flush                                           *
  *                                                                            *
- * Purpose: send flush command to preprocessing manager                       *
+ * Purpose: send flush command to preprocessing manager and flush values      *
+ *          added directly to history cache                                   *
  *                                                                            *
  ******************************************************************************/
 void	trx_preprocessor_flush(void)
 {
-	if (0 < cached_message.size)
-	{
-		preprocessor_send(TRX_IPC_PREPROCESSOR_REQUEST, cached_message.data, cached_message.size, NULL);
+	int	i;
 
-		trx_ipc_message_clean(&cached_message);
-		trx_ipc_message_init(&cached_message);
-		cached_values = 0;
+	if (0 != direct_values)
+	{
+		dc_flush_history();
+		direct_values = 0;
 	}
+
+	/* pick up item configuration changes once per batch of values */
+	if (-1 != preproc_itemids_ts)
+		DCconfig_get_preprocessable_itemids(&preproc_itemids, &preproc_itemids_ts);
+
+	if (NULL == preproc_conns)
+		return;
+
+	for (i = 0; i < CONFIG_PREPROCMAN_FORKS; i++)
+		preprocessor_flush_conn(i);
 }
 
 /******************************************************************************
  *                                                                            *
  * Function: trx_preprocessor_get_queue_size                                  *
  *                                                                            *
- * Purpose: get queue size (enqueued value count) of preprocessing manager    *
+ * Purpose: get queue size (enqueued value count) of preprocessing managers   *
  *                                                                            *
  * Return value: enqueued item count                                          *
  *                                                                            *
  ******************************************************************************/
 trx_uint64_t	trx_preprocessor_get_queue_size(void)
 {
-	trx_uint64_t		size;
+	trx_uint64_t		size, total = 0;
 	trx_ipc_message_t	message;
+	int			i;
 
-	trx_ipc_message_init(&message);
-	preprocessor_send(TRX_IPC_PREPROCESSOR_QUEUE, NULL, 0, &message);
-	memcpy(&size, message.data, sizeof(trx_uint64_t));
-	trx_ipc_message_clean(&message);
+	for (i = 0; i < CONFIG_PREPROCMAN_FORKS; i++)
+	{
+		trx_ipc_message_init(&message);
+		preprocessor_send(preprocessor_get_conn(i), i + 1, TRX_IPC_PREPROCESSOR_QUEUE, NULL, 0, &message);
+		memcpy(&size, message.data, sizeof(trx_uint64_t));
+		trx_ipc_message_clean(&message);
 
-	return size;
+		total += size;
+	}
+
+	return total;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trx_preprocessor_get_cache_stats                                 *
+ *                                                                            *
+ * Purpose: get compiled expression cache statistics of preprocessing workers *
+ *                                                                            *
+ * Parameters: stats - [OUT] the cache statistics summed over all workers     *
+ *                                                                            *
+ ******************************************************************************/
+void	trx_preprocessor_get_cache_stats(trx_preproc_cache_stats_t *stats)
+{
+	trx_preproc_cache_stats_t	stats_local;
+	trx_ipc_message_t		message;
+	int				i;
+
+	memset(stats, 0, sizeof(trx_preproc_cache_stats_t));
+
+	for (i = 0; i < CONFIG_PREPROCMAN_FORKS; i++)
+	{
+		trx_ipc_message_init(&message);
+		preprocessor_send(preprocessor_get_conn(i), i + 1, TRX_IPC_PREPROCESSOR_CACHE_STATS, NULL, 0,
+				&message);
+		memcpy(&stats_local, message.data, sizeof(stats_local));
+		trx_ipc_message_clean(&message);
+
+		stats->jsonpath_hits += stats_local.jsonpath_hits;
+		stats->jsonpath_misses += stats_local.jsonpath_misses;
+		stats->regexp_hits += stats_local.regexp_hits;
+		stats->regexp_misses += stats_local.regexp_misses;
+	}
 }
 
 /******************************************************************************
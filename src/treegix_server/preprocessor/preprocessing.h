@@ -8,6 +8,7 @@
 #include "dbcache.h"
 #include "preproc.h"
 #include "trxalgo.h"
+#include "trxipcservice.h"
 
 #define TRX_IPC_SERVICE_PREPROCESSING	"preprocessing"
 
@@ -17,6 +18,11 @@
 #define TRX_IPC_PREPROCESSOR_QUEUE		4
 #define TRX_IPC_PREPROCESSOR_TEST_REQUEST	5
 #define TRX_IPC_PREPROCESSOR_TEST_RESULT	6
+#define TRX_IPC_PREPROCESSOR_RING		7
+#define TRX_IPC_PREPROCESSOR_BATCH_REQUEST	8
+#define TRX_IPC_PREPROCESSOR_BATCH_RESULT	9
+#define TRX_IPC_PREPROCESSOR_WORKER_STATS	10
+#define TRX_IPC_PREPROCESSOR_CACHE_STATS	11
 
 /* item value data used in preprocessing manager */
 typedef struct
@@ -53,4 +59,12 @@ trx_uint32_t	trx_preprocessor_pack_test_result(unsigned char **data, const trx_p
 void	trx_preprocessor_unpack_test_result(trx_vector_ptr_t *results, trx_vector_ptr_t *history,
 		char **error, const unsigned char *data);
 
+void	trx_preprocessor_service_name(int manager_num, char *name, size_t name_len);
+int	trx_preprocessor_worker_manager_num(int worker_num);
+int	trx_preprocessor_manager_workers_num(int manager_num);
+
+#ifdef HAVE_TRX_RINGBUF
+trx_ipc_ring_t	*trx_preprocessor_get_ring(int manager_num);
+#endif
+
 #endif /* TREEGIX_PREPROCESSING_H */
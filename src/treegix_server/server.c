@@ -34,6 +34,7 @@
 #include "housekeeper/housekeeper.h"
 #include "pinger/pinger.h"
 #include "poller/poller.h"
+#include "poller/async_poller.h"
 #include "timer/timer.h"
 #include "trapper/trapper.h"
 #include "snmptrapper/snmptrapper.h"
@@ -44,6 +45,7 @@
 #include "taskmanager/taskmanager.h"
 #include "preprocessor/preproc_manager.h"
 #include "preprocessor/preproc_worker.h"
+#include "preproc.h"
 #include "lld/lld_manager.h"
 #include "lld/lld_worker.h"
 #include "events.h"
@@ -90,9 +92,10 @@ const char	*help_message[] = {
 	"",
 	"      Log level control targets:",
 	"        process-type             All processes of specified type",
-	"                                 (alerter, alert manager, configuration syncer,",
-	"                                 discoverer, escalator, history syncer,",
-	"                                 housekeeper, http poller, icmp pinger,",
+	"                                 (agent poller, alerter, alert manager,",
+	"                                 configuration syncer, discoverer, escalator,",
+	"                                 history syncer, housekeeper,",
+	"                                 http agent poller, http poller, icmp pinger,",
 	"                                 ipmi manager, ipmi poller, java poller,",
 	"                                 poller, preprocessing manager,",
 	"                                 preprocessing worker, proxy poller,",
@@ -156,6 +159,8 @@ int	CONFIG_TIMER_FORKS		= 1;
 int	CONFIG_TRAPPER_FORKS		= 5;
 int	CONFIG_SNMPTRAPPER_FORKS	= 0;
 int	CONFIG_JAVAPOLLER_FORKS		= 0;
+int	CONFIG_AGENTPOLLER_FORKS	= 0;
+int	CONFIG_HTTPAGENT_POLLER_FORKS	= 0;
 int	CONFIG_ESCALATOR_FORKS		= 1;
 int	CONFIG_SELFMON_FORKS		= 1;
 int	CONFIG_DATASENDER_FORKS		= 0;
@@ -172,6 +177,10 @@ int	CONFIG_LLDMANAGER_FORKS		= 1;
 int	CONFIG_LLDWORKER_FORKS		= 2;
 int	CONFIG_ALERTDB_FORKS		= 1;
 
+int	CONFIG_MAX_CONCURRENT_CHECKS_PER_POLLER		= 1000;
+int	CONFIG_MAX_CONCURRENT_CHECKS_PER_INTERFACE	= 3;
+int	CONFIG_MAX_CONCURRENT_HTTP_CHECKS_PER_HOST	= 10;
+
 int	CONFIG_LISTEN_PORT		= TRX_DEFAULT_SERVER_PORT;
 char	*CONFIG_LISTEN_IP		= NULL;
 char	*CONFIG_SOURCE_IP		= NULL;
@@ -193,8 +202,13 @@ int	CONFIG_VMWARE_TIMEOUT		= 10;
 trx_uint64_t	CONFIG_CONF_CACHE_SIZE		= 8 * TRX_MEBIBYTE;
 trx_uint64_t	CONFIG_HISTORY_CACHE_SIZE	= 16 * TRX_MEBIBYTE;
 trx_uint64_t	CONFIG_HISTORY_INDEX_CACHE_SIZE	= 4 * TRX_MEBIBYTE;
+int		CONFIG_HISTORY_CACHE_SHARDS	= 1;
+trx_uint64_t	CONFIG_HISTORY_RING_SIZE	= 0;
+trx_uint64_t	CONFIG_PREPROCESSING_RING_SIZE	= 0;
 trx_uint64_t	CONFIG_TRENDS_CACHE_SIZE	= 4 * TRX_MEBIBYTE;
 trx_uint64_t	CONFIG_VALUE_CACHE_SIZE		= 8 * TRX_MEBIBYTE;
+char		*CONFIG_VALUE_CACHE_SNAPSHOT_FILE	= NULL;
+int		CONFIG_VALUE_CACHE_SNAPSHOT_FREQUENCY	= SEC_PER_HOUR;
 trx_uint64_t	CONFIG_VMWARE_CACHE_SIZE	= 8 * TRX_MEBIBYTE;
 trx_uint64_t	CONFIG_EXPORT_FILE_SIZE		= TRX_GIBIBYTE;
 
@@ -270,6 +284,9 @@ static char	*CONFIG_SOCKET_PATH	= NULL;
 char	*CONFIG_HISTORY_STORAGE_URL		= NULL;
 char	*CONFIG_HISTORY_STORAGE_OPTS		= NULL;
 int	CONFIG_HISTORY_STORAGE_PIPELINES	= 0;
+char	*CONFIG_HISTORY_STORAGE_PATH		= NULL;
+int	CONFIG_HISTORY_STORAGE_RETENTION	= 0;
+int	CONFIG_HISTORY_PIPELINING		= 0;
 
 char	*CONFIG_STATS_ALLOWED_IP	= NULL;
 
@@ -334,6 +351,16 @@ int	get_process_info_by_thread(int local_server_num, unsigned char *local_proces
 		*local_process_type = TRX_PROCESS_TYPE_JAVAPOLLER;
 		*local_process_num = local_server_num - server_count + CONFIG_JAVAPOLLER_FORKS;
 	}
+	else if (local_server_num <= (server_count += CONFIG_AGENTPOLLER_FORKS))
+	{
+		*local_process_type = TRX_PROCESS_TYPE_AGENTPOLLER;
+		*local_process_num = local_server_num - server_count + CONFIG_AGENTPOLLER_FORKS;
+	}
+	else if (local_server_num <= (server_count += CONFIG_HTTPAGENT_POLLER_FORKS))
+	{
+		*local_process_type = TRX_PROCESS_TYPE_HTTPAGENT_POLLER;
+		*local_process_num = local_server_num - server_count + CONFIG_HTTPAGENT_POLLER_FORKS;
+	}
 	else if (local_server_num <= (server_count += CONFIG_SNMPTRAPPER_FORKS))
 	{
 		*local_process_type = TRX_PROCESS_TYPE_SNMPTRAPPER;
@@ -465,10 +492,9 @@ static void	trx_set_defaults(void)
 
 	if (NULL == CONFIG_SSL_KEY_LOCATION)
 		CONFIG_SSL_KEY_LOCATION = trx_strdup(CONFIG_SSL_KEY_LOCATION, DEFAULT_SSL_KEY_LOCATION);
-
+#endif
 	if (NULL == CONFIG_HISTORY_STORAGE_OPTS)
 		CONFIG_HISTORY_STORAGE_OPTS = trx_strdup(CONFIG_HISTORY_STORAGE_OPTS, "uint,dbl,str,log,text");
-#endif
 
 #ifdef HAVE_SQLITE3
 	CONFIG_MAX_HOUSEKEEPER_DELETE = 0;
@@ -498,10 +524,11 @@ static void	trx_validate_config(TRX_TASK_EX *task)
 	char	*ch_error;
 	int	err = 0;
 
-	if (0 == CONFIG_UNREACHABLE_POLLER_FORKS && 0 != CONFIG_POLLER_FORKS + CONFIG_JAVAPOLLER_FORKS)
+	if (0 == CONFIG_UNREACHABLE_POLLER_FORKS &&
+			0 != CONFIG_POLLER_FORKS + CONFIG_JAVAPOLLER_FORKS + CONFIG_AGENTPOLLER_FORKS)
 	{
 		treegix_log(LOG_LEVEL_CRIT, "\"StartPollersUnreachable\" configuration parameter must not be 0"
-				" if regular or Java pollers are started");
+				" if regular, agent or Java pollers are started");
 		err = 1;
 	}
 
@@ -511,6 +538,35 @@ static void	trx_validate_config(TRX_TASK_EX *task)
 		err = 1;
 	}
 
+	if (128 * TRX_KIBIBYTE > CONFIG_HISTORY_CACHE_SIZE / CONFIG_HISTORY_CACHE_SHARDS ||
+			128 * TRX_KIBIBYTE > CONFIG_HISTORY_INDEX_CACHE_SIZE / CONFIG_HISTORY_CACHE_SHARDS)
+	{
+		treegix_log(LOG_LEVEL_CRIT, "\"HistoryCacheSize\" and \"HistoryIndexCacheSize\" configuration parameters"
+				" must be at least 128KB per each of \"HistoryCacheShards\" shards");
+		err = 1;
+	}
+
+	if (0 != CONFIG_HISTORY_RING_SIZE && TRX_MEBIBYTE > CONFIG_HISTORY_RING_SIZE)
+	{
+		treegix_log(LOG_LEVEL_CRIT, "\"HistoryRingSize\" configuration parameter must be either 0"
+				" or greater than 1MB");
+		err = 1;
+	}
+
+	if (0 != CONFIG_PREPROCESSING_RING_SIZE && TRX_MEBIBYTE > CONFIG_PREPROCESSING_RING_SIZE)
+	{
+		treegix_log(LOG_LEVEL_CRIT, "\"PreprocessingRingSize\" configuration parameter must be either 0"
+				" or greater than 1MB");
+		err = 1;
+	}
+
+	if (CONFIG_PREPROCMAN_FORKS > CONFIG_PREPROCESSOR_FORKS)
+	{
+		treegix_log(LOG_LEVEL_CRIT, "\"StartPreprocessingManagers\" configuration parameter must not be"
+				" greater than \"StartPreprocessors\"");
+		err = 1;
+	}
+
 	if (0 != CONFIG_VALUE_CACHE_SIZE && 128 * TRX_KIBIBYTE > CONFIG_VALUE_CACHE_SIZE)
 	{
 		treegix_log(LOG_LEVEL_CRIT, "\"ValueCacheSize\" configuration parameter must be either 0"
@@ -524,6 +580,19 @@ static void	trx_validate_config(TRX_TASK_EX *task)
 		err = 1;
 	}
 
+	if (NULL != CONFIG_HISTORY_STORAGE_URL && NULL != CONFIG_HISTORY_STORAGE_PATH)
+	{
+		treegix_log(LOG_LEVEL_CRIT, "\"HistoryStorageURL\" and \"HistoryStoragePath\" configuration parameters"
+				" cannot be used together");
+		err = 1;
+	}
+
+	if (NULL != CONFIG_HISTORY_STORAGE_PATH && '/' != *CONFIG_HISTORY_STORAGE_PATH)
+	{
+		treegix_log(LOG_LEVEL_CRIT, "\"HistoryStoragePath\" configuration parameter must be an absolute path");
+		err = 1;
+	}
+
 	if (NULL != CONFIG_STATS_ALLOWED_IP && FAIL == trx_validate_peer_list(CONFIG_STATS_ALLOWED_IP, &ch_error))
 	{
 		treegix_log(LOG_LEVEL_CRIT, "invalid entry in \"StatsAllowedIP\" configuration parameter: %s", ch_error);
@@ -538,10 +607,12 @@ static void	trx_validate_config(TRX_TASK_EX *task)
 	err |= (FAIL == check_cfg_feature_str("SSLCertLocation", CONFIG_SSL_CERT_LOCATION, "cURL library"));
 	err |= (FAIL == check_cfg_feature_str("SSLKeyLocation", CONFIG_SSL_KEY_LOCATION, "cURL library"));
 	err |= (FAIL == check_cfg_feature_str("HistoryStorageURL", CONFIG_HISTORY_STORAGE_URL, "cURL library"));
-	err |= (FAIL == check_cfg_feature_str("HistoryStorageTypes", CONFIG_HISTORY_STORAGE_OPTS, "cURL library"));
 	err |= (FAIL == check_cfg_feature_int("HistoryStorageDateIndex", CONFIG_HISTORY_STORAGE_PIPELINES,
 			"cURL library"));
 #endif
+#if !defined(HAVE_POSTGRESQL)
+	err |= (FAIL == check_cfg_feature_int("HistoryPipelining", CONFIG_HISTORY_PIPELINING, "PostgreSQL database"));
+#endif
 
 #if !defined(HAVE_LIBXML2) || !defined(HAVE_LIBCURL)
 	err |= (FAIL == check_cfg_feature_int("StartVMwareCollectors", CONFIG_VMWARE_FORKS, "VMware support"));
@@ -608,6 +679,16 @@ static void	trx_load_config(TRX_TASK_EX *task)
 			PARM_OPT,	0,			1000},
 		{"StartJavaPollers",		&CONFIG_JAVAPOLLER_FORKS,		TYPE_INT,
 			PARM_OPT,	0,			1000},
+		{"StartAgentPollers",		&CONFIG_AGENTPOLLER_FORKS,		TYPE_INT,
+			PARM_OPT,	0,			1000},
+		{"StartHTTPAgentPollers",	&CONFIG_HTTPAGENT_POLLER_FORKS,	TYPE_INT,
+			PARM_OPT,	0,			1000},
+		{"MaxConcurrentChecksPerPoller",	&CONFIG_MAX_CONCURRENT_CHECKS_PER_POLLER,	TYPE_INT,
+			PARM_OPT,	1,			10000},
+		{"MaxConcurrentChecksPerInterface",	&CONFIG_MAX_CONCURRENT_CHECKS_PER_INTERFACE,	TYPE_INT,
+			PARM_OPT,	1,			1000},
+		{"MaxConcurrentHTTPChecksPerHost",	&CONFIG_MAX_CONCURRENT_HTTP_CHECKS_PER_HOST,	TYPE_INT,
+			PARM_OPT,	1,			1000},
 		{"StartEscalators",		&CONFIG_ESCALATOR_FORKS,		TYPE_INT,
 			PARM_OPT,	1,			100},
 		{"JavaGateway",			&CONFIG_JAVA_GATEWAY,			TYPE_STRING,
@@ -624,10 +705,18 @@ static void	trx_load_config(TRX_TASK_EX *task)
 			PARM_OPT,	128 * TRX_KIBIBYTE,	__UINT64_C(2) * TRX_GIBIBYTE},
 		{"HistoryIndexCacheSize",	&CONFIG_HISTORY_INDEX_CACHE_SIZE,	TYPE_UINT64,
 			PARM_OPT,	128 * TRX_KIBIBYTE,	__UINT64_C(2) * TRX_GIBIBYTE},
+		{"HistoryCacheShards",		&CONFIG_HISTORY_CACHE_SHARDS,		TYPE_INT,
+			PARM_OPT,	1,			16},
+		{"HistoryRingSize",		&CONFIG_HISTORY_RING_SIZE,		TYPE_UINT64,
+			PARM_OPT,	0,			__UINT64_C(1) * TRX_GIBIBYTE},
 		{"TrendCacheSize",		&CONFIG_TRENDS_CACHE_SIZE,		TYPE_UINT64,
 			PARM_OPT,	128 * TRX_KIBIBYTE,	__UINT64_C(2) * TRX_GIBIBYTE},
 		{"ValueCacheSize",		&CONFIG_VALUE_CACHE_SIZE,		TYPE_UINT64,
 			PARM_OPT,	0,			__UINT64_C(64) * TRX_GIBIBYTE},
+		{"ValueCacheSnapshotFile",	&CONFIG_VALUE_CACHE_SNAPSHOT_FILE,	TYPE_STRING,
+			PARM_OPT,	0,			0},
+		{"ValueCacheSnapshotFrequency",	&CONFIG_VALUE_CACHE_SNAPSHOT_FREQUENCY,	TYPE_INT,
+			PARM_OPT,	0,			SEC_PER_DAY},
 		{"CacheUpdateFrequency",	&CONFIG_CONFSYNCER_FREQUENCY,		TYPE_INT,
 			PARM_OPT,	1,			SEC_PER_HOUR},
 		{"HousekeepingFrequency",	&CONFIG_HOUSEKEEPING_FREQUENCY,		TYPE_INT,
@@ -732,12 +821,22 @@ static void	trx_load_config(TRX_TASK_EX *task)
 			PARM_OPT,	1,			100},
 		{"StartPreprocessors",		&CONFIG_PREPROCESSOR_FORKS,		TYPE_INT,
 			PARM_OPT,	1,			1000},
+		{"StartPreprocessingManagers",	&CONFIG_PREPROCMAN_FORKS,		TYPE_INT,
+			PARM_OPT,	1,			100},
+		{"PreprocessingRingSize",	&CONFIG_PREPROCESSING_RING_SIZE,	TYPE_UINT64,
+			PARM_OPT,	0,			__UINT64_C(1) * TRX_GIBIBYTE},
 		{"HistoryStorageURL",		&CONFIG_HISTORY_STORAGE_URL,		TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"HistoryStorageTypes",		&CONFIG_HISTORY_STORAGE_OPTS,		TYPE_STRING_LIST,
 			PARM_OPT,	0,			0},
 		{"HistoryStorageDateIndex",	&CONFIG_HISTORY_STORAGE_PIPELINES,	TYPE_INT,
 			PARM_OPT,	0,			1},
+		{"HistoryStoragePath",		&CONFIG_HISTORY_STORAGE_PATH,		TYPE_STRING,
+			PARM_OPT,	0,			0},
+		{"HistoryStorageRetention",	&CONFIG_HISTORY_STORAGE_RETENTION,	TYPE_INT,
+			PARM_OPT,	0,			3650},
+		{"HistoryPipelining",		&CONFIG_HISTORY_PIPELINING,		TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"ExportDir",			&CONFIG_EXPORT_DIR,			TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"ExportFileSize",		&CONFIG_EXPORT_FILE_SIZE,		TYPE_UINT64,
@@ -995,6 +1094,13 @@ int	MAIN_TREEGIX_ENTRY(int flags)
 		exit(EXIT_FAILURE);
 	}
 
+	if (SUCCEED != trx_preprocessor_init_rings(&error))
+	{
+		treegix_log(LOG_LEVEL_CRIT, "cannot initialize preprocessing rings: %s", error);
+		trx_free(error);
+		exit(EXIT_FAILURE);
+	}
+
 	if (SUCCEED != init_selfmon_collector(&error))
 	{
 		treegix_log(LOG_LEVEL_CRIT, "cannot initialize self-monitoring: %s", error);
@@ -1058,6 +1164,13 @@ int	MAIN_TREEGIX_ENTRY(int flags)
 	/* make initial configuration sync before worker processes are forked */
 	DCsync_configuration(TRX_DBSYNC_INIT);
 
+	if (NULL != CONFIG_VALUE_CACHE_SNAPSHOT_FILE &&
+			SUCCEED != trx_vc_load_snapshot(CONFIG_VALUE_CACHE_SNAPSHOT_FILE, &error))
+	{
+		treegix_log(LOG_LEVEL_WARNING, "cannot load value cache snapshot: %s", error);
+		trx_free(error);
+	}
+
 	if (SUCCEED != trx_check_postinit_tasks(&error))
 	{
 		treegix_log(LOG_LEVEL_CRIT, "cannot complete post initialization tasks: %s", error);
@@ -1080,7 +1193,8 @@ int	MAIN_TREEGIX_ENTRY(int flags)
 			+ CONFIG_SNMPTRAPPER_FORKS + CONFIG_PROXYPOLLER_FORKS + CONFIG_SELFMON_FORKS
 			+ CONFIG_VMWARE_FORKS + CONFIG_TASKMANAGER_FORKS + CONFIG_IPMIMANAGER_FORKS
 			+ CONFIG_ALERTMANAGER_FORKS + CONFIG_PREPROCMAN_FORKS + CONFIG_PREPROCESSOR_FORKS
-			+ CONFIG_LLDMANAGER_FORKS + CONFIG_LLDWORKER_FORKS + CONFIG_ALERTDB_FORKS;
+			+ CONFIG_LLDMANAGER_FORKS + CONFIG_LLDWORKER_FORKS + CONFIG_ALERTDB_FORKS
+			+ CONFIG_AGENTPOLLER_FORKS + CONFIG_HTTPAGENT_POLLER_FORKS;
 	threads = (pid_t *)trx_calloc(threads, threads_num, sizeof(pid_t));
 	threads_flags = (int *)trx_calloc(threads_flags, threads_num, sizeof(int));
 
@@ -1161,6 +1275,16 @@ int	MAIN_TREEGIX_ENTRY(int flags)
 				thread_args.args = &poller_type;
 				trx_thread_start(poller_thread, &thread_args, &threads[i]);
 				break;
+			case TRX_PROCESS_TYPE_AGENTPOLLER:
+				poller_type = TRX_POLLER_TYPE_AGENT;
+				thread_args.args = &poller_type;
+				trx_thread_start(async_poller_thread, &thread_args, &threads[i]);
+				break;
+			case TRX_PROCESS_TYPE_HTTPAGENT_POLLER:
+				poller_type = TRX_POLLER_TYPE_HTTPAGENT;
+				thread_args.args = &poller_type;
+				trx_thread_start(async_poller_thread, &thread_args, &threads[i]);
+				break;
 			case TRX_PROCESS_TYPE_SNMPTRAPPER:
 				trx_thread_start(snmptrapper_thread, &thread_args, &threads[i]);
 				break;
@@ -1255,6 +1379,18 @@ void	trx_on_exit(int ret)
 
 	free_configuration_cache();
 
+	/* the value cache might be inconsistent after a child process crash, keep the previous snapshot then */
+	if (SUCCEED == ret && NULL != CONFIG_VALUE_CACHE_SNAPSHOT_FILE)
+	{
+		char	*error = NULL;
+
+		if (SUCCEED != trx_vc_save_snapshot(CONFIG_VALUE_CACHE_SNAPSHOT_FILE, &error))
+		{
+			treegix_log(LOG_LEVEL_WARNING, "cannot save value cache snapshot: %s", error);
+			trx_free(error);
+		}
+	}
+
 	/* free history value cache */
 	trx_vc_destroy();
 